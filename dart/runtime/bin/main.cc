@@ -35,6 +35,11 @@ extern const uint8_t* snapshot_buffer;
 static bool generate_script_snapshot = false;
 static File* snapshot_file = NULL;
 
+// Global flag that is used to indicate that the script is run before its
+// snapshot is generated, so that the functions it made hot start warm when
+// the snapshot is loaded.
+static bool train_script_snapshot = false;
+
 
 // Global state that indicates whether there is a debug breakpoint.
 // This pointer points into an argv buffer and does not need to be
@@ -238,6 +243,16 @@ static bool ProcessGenScriptSnapshotOption(const char* filename) {
 }
 
 
+static bool ProcessTrainScriptSnapshotOption(const char* arg) {
+  ASSERT(arg != NULL);
+  if (*arg != '\0') {
+    return false;
+  }
+  train_script_snapshot = true;
+  return true;
+}
+
+
 static bool ProcessEnableVmServiceOption(const char* port) {
   ASSERT(port != NULL);
   vm_service_server_port = -1;
@@ -284,6 +299,7 @@ static struct {
   { "--compile_all", ProcessCompileAllOption },
   { "--debug", ProcessDebugOption },
   { "--snapshot=", ProcessGenScriptSnapshotOption },
+  { "--train-snapshot", ProcessTrainScriptSnapshotOption },
   { "--print-script", ProcessPrintScriptOption },
   { "--enable-vm-service", ProcessEnableVmServiceOption },
   { "--trace-debug-protocol", ProcessTraceDebugProtocolOption },
@@ -632,6 +648,11 @@ static void PrintUsage() {
 "--snapshot=<file_name>\n"
 "  loads Dart script and generates a snapshot in the specified file\n"
 "\n"
+"--train-snapshot\n"
+"  runs the Dart script before generating its snapshot with --snapshot, so\n"
+"  that the functions it used often are optimized early when the snapshot is\n"
+"  run\n"
+"\n"
 "--print-script\n"
 "  generates Dart source code back and prints it after parsing a Dart script\n"
 "\n"
@@ -756,6 +777,84 @@ static Dart_Handle GenerateScriptSource() {
 }
 
 
+static void RunMainIsolate(const char* script_name,
+                           CommandLineOptions* dart_options) {
+  Dart_Handle result;
+
+  // Lookup the library of the root script.
+  Dart_Handle root_lib = Dart_RootLibrary();
+  // Import the root library into the builtin library so that we can easily
+  // lookup the main entry point exported from the root library.
+  Dart_Handle builtin_lib =
+      Builtin::LoadAndCheckLibrary(Builtin::kBuiltinLibrary);
+  result = Dart_LibraryImportLibrary(builtin_lib, root_lib, Dart_Null());
+
+  if (has_compile_all) {
+    result = Dart_CompileAll();
+    DartExitOnError(result);
+  }
+
+  if (Dart_IsNull(root_lib)) {
+    ErrorExit(kErrorExitCode,
+              "Unable to find root library for '%s'\n",
+              script_name);
+  }
+  if (has_print_script) {
+    result = GenerateScriptSource();
+    DartExitOnError(result);
+  } else {
+    // The helper function _getMainClosure creates a closure for the main
+    // entry point which is either explicitly or implictly exported from the
+    // root library.
+    Dart_Handle main_closure = Dart_Invoke(
+        builtin_lib, Dart_NewStringFromCString("_getMainClosure"), 0, NULL);
+    DartExitOnError(main_closure);
+
+    // Set debug breakpoint if specified on the command line before calling
+    // the main function.
+    if (breakpoint_at != NULL) {
+      result = SetBreakpoint(breakpoint_at, root_lib);
+      if (Dart_IsError(result)) {
+        ErrorExit(kErrorExitCode,
+                  "Error setting breakpoint at '%s': %s\n",
+                  breakpoint_at,
+                  Dart_GetError(result));
+      }
+    }
+
+    // Call _startIsolate in the isolate library to enable dispatching the
+    // initial startup message.
+    Dart_Handle isolate_args[2];
+    isolate_args[0] = main_closure;
+    isolate_args[1] = Dart_True();
+
+    Dart_Handle isolate_lib = Dart_LookupLibrary(
+        Dart_NewStringFromCString("dart:isolate"));
+    result = Dart_Invoke(isolate_lib,
+                         Dart_NewStringFromCString("_startIsolate"),
+                         2, isolate_args);
+
+    // Setup the arguments in the initial startup message and leave the
+    // replyTo and message fields empty.
+    Dart_Handle initial_startup_msg = Dart_NewList(3);
+    result = Dart_ListSetAt(initial_startup_msg, 1,
+                            CreateRuntimeOptions(dart_options));
+    DartExitOnError(result);
+    Dart_Port main_port = Dart_GetMainPortId();
+    bool posted = Dart_Post(main_port, initial_startup_msg);
+    if (!posted) {
+      ErrorExit(kErrorExitCode,
+                "Failed posting startup message to main "
+                "isolate control port.");
+    }
+
+    // Keep handling messages until the last active receive port is closed.
+    result = Dart_RunLoop();
+    DartExitOnError(result);
+  }
+}
+
+
 void main(int argc, char** argv) {
   char* script_name;
   CommandLineOptions vm_options(argc);
@@ -863,15 +962,45 @@ void main(int argc, char** argv) {
   Dart_EnterIsolate(isolate);
   ASSERT(isolate == Dart_CurrentIsolate());
   ASSERT(isolate != NULL);
-  Dart_Handle result;
 
   Dart_EnterScope();
 
   if (generate_script_snapshot) {
-    // First create a snapshot.
     Dart_Handle result;
     uint8_t* buffer = NULL;
     intptr_t size = 0;
+    if (train_script_snapshot) {
+      // A script snapshot can only be created before any dart code has
+      // executed, so record the profile of the training run and apply it to
+      // the script loaded again in a fresh isolate.
+      RunMainIsolate(script_name, &dart_options);
+      result = Dart_CreateScriptProfile(&buffer, &size);
+      DartExitOnError(result);
+      uint8_t* profile = reinterpret_cast<uint8_t*>(malloc(size));
+      memmove(profile, buffer, size);
+      intptr_t profile_size = size;
+      Dart_ExitScope();
+      Dart_ShutdownIsolate();
+
+      isolate = CreateIsolateAndSetupHelper(script_name,
+                                            "main",
+                                            new IsolateData(script_name),
+                                            &error,
+                                            &is_compile_error);
+      if (isolate == NULL) {
+        Log::PrintErr("%s\n", error);
+        free(error);
+        free(profile);
+        exit(is_compile_error ? kCompilationErrorExitCode : kErrorExitCode);
+      }
+      Dart_EnterIsolate(isolate);
+      Dart_EnterScope();
+      result = Dart_ApplyScriptProfile(profile, profile_size);
+      free(profile);
+      DartExitOnError(result);
+    }
+
+    // First create a snapshot.
     result = Dart_CreateScriptSnapshot(&buffer, &size);
     DartExitOnError(result);
 
@@ -883,77 +1012,7 @@ void main(int argc, char** argv) {
     ASSERT(bytes_written);
     delete snapshot_file;
   } else {
-    // Lookup the library of the root script.
-    Dart_Handle root_lib = Dart_RootLibrary();
-    // Import the root library into the builtin library so that we can easily
-    // lookup the main entry point exported from the root library.
-    Dart_Handle builtin_lib =
-        Builtin::LoadAndCheckLibrary(Builtin::kBuiltinLibrary);
-    result = Dart_LibraryImportLibrary(builtin_lib, root_lib, Dart_Null());
-
-    if (has_compile_all) {
-      result = Dart_CompileAll();
-      DartExitOnError(result);
-    }
-
-    if (Dart_IsNull(root_lib)) {
-      ErrorExit(kErrorExitCode,
-                "Unable to find root library for '%s'\n",
-                script_name);
-    }
-    if (has_print_script) {
-      result = GenerateScriptSource();
-      DartExitOnError(result);
-    } else {
-      // The helper function _getMainClosure creates a closure for the main
-      // entry point which is either explicitly or implictly exported from the
-      // root library.
-      Dart_Handle main_closure = Dart_Invoke(
-          builtin_lib, Dart_NewStringFromCString("_getMainClosure"), 0, NULL);
-      DartExitOnError(main_closure);
-
-      // Set debug breakpoint if specified on the command line before calling
-      // the main function.
-      if (breakpoint_at != NULL) {
-        result = SetBreakpoint(breakpoint_at, root_lib);
-        if (Dart_IsError(result)) {
-          ErrorExit(kErrorExitCode,
-                    "Error setting breakpoint at '%s': %s\n",
-                    breakpoint_at,
-                    Dart_GetError(result));
-        }
-      }
-
-      // Call _startIsolate in the isolate library to enable dispatching the
-      // initial startup message.
-      Dart_Handle isolate_args[2];
-      isolate_args[0] = main_closure;
-      isolate_args[1] = Dart_True();
-
-      Dart_Handle isolate_lib = Dart_LookupLibrary(
-          Dart_NewStringFromCString("dart:isolate"));
-      result = Dart_Invoke(isolate_lib,
-                           Dart_NewStringFromCString("_startIsolate"),
-                           2, isolate_args);
-
-      // Setup the arguments in the initial startup message and leave the
-      // replyTo and message fields empty.
-      Dart_Handle initial_startup_msg = Dart_NewList(3);
-      result = Dart_ListSetAt(initial_startup_msg, 1,
-                              CreateRuntimeOptions(&dart_options));
-      DartExitOnError(result);
-      Dart_Port main_port = Dart_GetMainPortId();
-      bool posted = Dart_Post(main_port, initial_startup_msg);
-      if (!posted) {
-        ErrorExit(kErrorExitCode,
-                  "Failed posting startup message to main "
-                  "isolate control port.");
-      }
-
-      // Keep handling messages until the last active receive port is closed.
-      result = Dart_RunLoop();
-      DartExitOnError(result);
-    }
+    RunMainIsolate(script_name, &dart_options);
   }
 
   Dart_ExitScope();
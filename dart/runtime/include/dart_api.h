@@ -886,6 +886,33 @@ DART_EXPORT void Dart_ExitIsolate();
 DART_EXPORT Dart_Handle Dart_CreateSnapshot(uint8_t** buffer,
                                             intptr_t* size);
 
+/**
+ * Creates a heap image snapshot from a full snapshot.
+ *
+ * A heap image snapshot holds the heap pages of an isolate which has just
+ * read a full snapshot, laid out so that the file can be mapped read only.
+ * An isolate created from it copies the pages instead of reading the full
+ * snapshot object by object. A heap image snapshot can be passed to
+ * Dart_CreateIsolate wherever the full snapshot it was created from can, and
+ * falls back to it if it was written by a different VM.
+ *
+ * The heap image is captured by the first isolate created from the full
+ * snapshot with --clone_isolate_heap.
+ *
+ * Requires there to be a current isolate.
+ *
+ * \param snapshot The full snapshot, as passed to Dart_CreateIsolate.
+ * \param buffer Returns a pointer to a buffer containing the
+ *   snapshot. This buffer is scope allocated and is only valid
+ *   until the next call to Dart_ExitScope.
+ * \param size Returns the size of the buffer.
+ *
+ * \return A valid handle if no error occurs during the operation.
+ */
+DART_EXPORT Dart_Handle Dart_CreateHeapImageSnapshot(const uint8_t* snapshot,
+                                                     uint8_t** buffer,
+                                                     intptr_t* size);
+
 /**
  * Creates a snapshot of the application script loaded in the isolate.
  *
@@ -905,6 +932,38 @@ DART_EXPORT Dart_Handle Dart_CreateSnapshot(uint8_t** buffer,
 DART_EXPORT Dart_Handle Dart_CreateScriptSnapshot(uint8_t** buffer,
                                                   intptr_t* size);
 
+/**
+ * Creates a profile of the functions of the application script loaded in the
+ * isolate, holding how often they were invoked.
+ *
+ * A profile created after a training run of the script can be applied to
+ * another isolate which loaded the same script, before a script snapshot of
+ * it is created. The functions which were hot in the training run are then
+ * optimized shortly after the script is loaded from the snapshot.
+ *
+ * \param buffer Returns a pointer to a buffer containing
+ *   the profile. This buffer is scope allocated and is only valid
+ *   until the next call to Dart_ExitScope.
+ * \param size Returns the size of the buffer.
+ *
+ * \return A valid handle if no error occurs during the operation.
+ */
+DART_EXPORT Dart_Handle Dart_CreateScriptProfile(uint8_t** buffer,
+                                                 intptr_t* size);
+
+/**
+ * Applies a profile created by Dart_CreateScriptProfile to the functions of
+ * the application script loaded in the isolate. No dart code may have
+ * executed in the isolate.
+ *
+ * \param buffer A buffer containing the profile.
+ * \param size The size of the buffer.
+ *
+ * \return A valid handle if no error occurs during the operation.
+ */
+DART_EXPORT Dart_Handle Dart_ApplyScriptProfile(const uint8_t* buffer,
+                                                intptr_t size);
+
 /**
  * Schedules an interrupt for the specified isolate.
  *
@@ -1722,6 +1781,34 @@ DART_EXPORT Dart_Handle Dart_NewExternalTypedData(Dart_TypedData_Type type,
                                                   void* data,
                                                   intptr_t length);
 
+/**
+ * Makes an external TypedData object transferable. The data of a
+ * transferable object is not copied when the object is sent to another
+ * isolate: the data and its finalizer move into the message, the object in
+ * the sending isolate is left with a length of 0 and the receiving isolate
+ * gets an external TypedData object referencing the same data.
+ *
+ * \param object An external TypedData object, as returned by
+ *   Dart_NewExternalTypedData.
+ * \param peer An external pointer to associate with the data.
+ * \param callback A function called with the peer once the data is no
+ *   longer referenced by the isolate owning it. It is passed a NULL handle
+ *   if a message transferring the data is dropped before being delivered,
+ *   otherwise it needs to delete the handle using
+ *   Dart_DeleteWeakPersistentHandle.
+ *
+ * A native port receives the transferred data as a
+ * Dart_CObject_kExternalTypedData object. The message still owns the data,
+ * which is finalized when the native message handler returns. The handler
+ * must not keep the data or pointers into it, it has to copy what it needs.
+ *
+ * \return A valid handle if no error occurs during the operation.
+ */
+DART_EXPORT Dart_Handle Dart_MakeTransferable(
+    Dart_Handle object,
+    void* peer,
+    Dart_WeakPersistentHandleFinalizer callback);
+
 /**
  * Acquires access to the internal data address of a TypedData object.
  *
@@ -5,6 +5,7 @@
 #include "platform/assert.h"
 #include "vm/bootstrap_natives.h"
 #include "vm/class_finalizer.h"
+#include "vm/compact_message.h"
 #include "vm/dart.h"
 #include "vm/dart_api_impl.h"
 #include "vm/dart_entry.h"
@@ -100,14 +101,20 @@ DEFINE_NATIVE_ENTRY(SendPortImpl_sendInternal_, 2) {
   // TODO(iposva): Allow for arbitrary messages to be sent.
   GET_NON_NULL_NATIVE_ARGUMENT(Instance, obj, arguments->NativeArgAt(1));
 
-  uint8_t* data = NULL;
-  MessageWriter writer(&data, &allocator);
-  writer.WriteMessage(obj);
-
+  Message* message = CompactMessage::New(send_id.Value(), obj,
+                                         Message::kNormalPriority);
+  if (message == NULL) {
+    uint8_t* data = NULL;
+    MessageWriter writer(&data, &allocator, true);
+    writer.WriteMessage(obj);
+
+    message = new Message(send_id.Value(), Message::kIllegalPort,
+                          data, writer.BytesWritten(),
+                          Message::kNormalPriority);
+    writer.TransferTo(message);
+  }
   // TODO(turnidge): Throw an exception when the return value is false?
-  PortMap::PostMessage(new Message(send_id.Value(), Message::kIllegalPort,
-                                   data, writer.BytesWritten(),
-                                   Message::kNormalPriority));
+  PortMap::PostMessage(message);
   return Object::null();
 }
 
@@ -1399,6 +1399,12 @@ void Assembler::orl(Register dst, const Address& address) {
 }
 
 
+void Assembler::orl(const Address& address, const Immediate& imm) {
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitComplex(1, address, imm);
+}
+
+
 void Assembler::xorl(Register dst, Register src) {
   AssemblerBuffer::EnsureCapacity ensured(&buffer_);
   EmitUint8(0x33);
@@ -2053,17 +2059,45 @@ void Assembler::StoreIntoObject(Register object,
   ASSERT(object != value);
   movl(dest, value);
   Label done;
-  if (can_value_be_smi) {
+  if (FLAG_concurrent_mark) {
+    // Old objects stored into old space go through the marking barrier, which
+    // only records them while concurrent marking is in progress.
+    Label store_buffer;
+    if (can_value_be_smi) {
+      testl(value, Immediate(kSmiTagMask));
+      j(ZERO, &done);
+    }
+    testl(object, Immediate(kNewObjectAlignmentOffset));
+    j(NOT_ZERO, &done);
+    testl(value, Immediate(kNewObjectAlignmentOffset));
+    j(NOT_ZERO, &store_buffer);
+    if (value != EAX) {
+      pushl(EAX);  // Preserve EAX.
+      movl(EAX, value);
+    }
+    call(&StubCode::UpdateMarkingBufferLabel());
+    if (value != EAX) popl(EAX);  // Restore EAX.
+    jmp(&done);
+    Bind(&store_buffer);
+  } else if (can_value_be_smi) {
     StoreIntoObjectFilter(object, value, &done);
   } else {
     StoreIntoObjectFilterNoSmi(object, value, &done);
   }
-  // A store buffer update is required.
+  // A store buffer update is required. The stub also receives the updated
+  // slot on the stack, for objects remembered in a card table.
   if (value != EAX) pushl(EAX);  // Preserve EAX.
+  pushl(EAX);  // Reserve the slot argument.
+  leal(EAX, dest);
+  movl(Address(ESP, 0), EAX);
   if (object != EAX) {
     movl(EAX, object);
+  } else {
+    // The object is not the value, so EAX was preserved above.
+    movl(EAX, Address(ESP, kWordSize));
   }
   call(&StubCode::UpdateStoreBufferLabel());
+  addl(ESP, Immediate(kWordSize));  // Drop the slot argument.
   if (value != EAX) popl(EAX);  // Restore EAX.
   Bind(&done);
 }
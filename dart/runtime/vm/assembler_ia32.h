@@ -534,6 +534,7 @@ class Assembler : public ValueObject {
   void orl(Register dst, const Immediate& imm);
   void orl(Register dst, Register src);
   void orl(Register dst, const Address& address);
+  void orl(const Address& address, const Immediate& imm);
 
   void xorl(Register dst, const Immediate& imm);
   void xorl(Register dst, Register src);
@@ -389,6 +389,21 @@ ASSEMBLER_TEST_RUN(Bitwise, test) {
 }
 
 
+ASSEMBLER_TEST_GENERATE(LockedOr, assembler) {
+  __ pushl(Immediate(0x3));
+  __ lock();
+  __ orl(Address(ESP, 0), Immediate(0x10));
+  __ popl(EAX);
+  __ ret();
+}
+
+
+ASSEMBLER_TEST_RUN(LockedOr, test) {
+  typedef int (*LockedOr)();
+  EXPECT_EQ(0x13, reinterpret_cast<LockedOr>(test->entry())());
+}
+
+
 ASSEMBLER_TEST_GENERATE(LogicalOps, assembler) {
   Label donetest1;
   __ movl(EAX, Immediate(4));
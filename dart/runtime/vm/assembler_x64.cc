@@ -556,6 +556,28 @@ void Assembler::movd(Register dst, XmmRegister src) {
 }
 
 
+void Assembler::movq(XmmRegister dst, Register src) {
+  ASSERT(dst <= XMM15);
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitREX_RB(dst, src, REX_W);
+  EmitUint8(0x0F);
+  EmitUint8(0x6E);
+  EmitOperand(dst & 7, Operand(src));
+}
+
+
+void Assembler::movq(Register dst, XmmRegister src) {
+  ASSERT(src <= XMM15);
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  EmitUint8(0x66);
+  EmitREX_RB(src, dst, REX_W);
+  EmitUint8(0x0F);
+  EmitUint8(0x7E);
+  EmitOperand(src & 7, Operand(dst));
+}
+
+
 void Assembler::addss(XmmRegister dst, XmmRegister src) {
   ASSERT(src <= XMM15);
   ASSERT(dst <= XMM15);
@@ -1579,6 +1601,15 @@ void Assembler::orq(Register dst, const Immediate& imm) {
 }
 
 
+void Assembler::orq(const Address& address, const Immediate& imm) {
+  ASSERT(imm.is_int32());
+  AssemblerBuffer::EnsureCapacity ensured(&buffer_);
+  Operand operand(address);
+  EmitOperandREX(1, operand, REX_W);
+  EmitComplex(1, operand, imm);
+}
+
+
 void Assembler::OrImmediate(Register dst, const Immediate& imm, Register pp) {
   if (CanLoadImmediateFromPool(imm, pp)) {
     ASSERT(dst != TMP);
@@ -2553,17 +2584,41 @@ void Assembler::StoreIntoObject(Register object,
   ASSERT(object != value);
   movq(dest, value);
   Label done;
-  if (can_value_be_smi) {
+  if (FLAG_concurrent_mark) {
+    // Old objects stored into old space go through the marking barrier, which
+    // only records them while concurrent marking is in progress.
+    Label store_buffer;
+    if (can_value_be_smi) {
+      testq(value, Immediate(kSmiTagMask));
+      j(ZERO, &done);
+    }
+    testq(object, Immediate(kNewObjectAlignmentOffset));
+    j(NOT_ZERO, &done);
+    testq(value, Immediate(kNewObjectAlignmentOffset));
+    j(NOT_ZERO, &store_buffer);
+    if (value != RAX) {
+      pushq(RAX);
+      movq(RAX, value);
+    }
+    Call(&StubCode::UpdateMarkingBufferLabel(), PP);
+    if (value != RAX) popq(RAX);
+    jmp(&done);
+    Bind(&store_buffer);
+  } else if (can_value_be_smi) {
     StoreIntoObjectFilter(object, value, &done);
   } else {
     StoreIntoObjectFilterNoSmi(object, value, &done);
   }
-  // A store buffer update is required.
+  // A store buffer update is required. The stub also receives the updated
+  // slot on the stack, for objects remembered in a card table.
+  leaq(TMP, dest);
   if (value != RAX) pushq(RAX);
+  pushq(TMP);
   if (object != RAX) {
     movq(RAX, object);
   }
   Call(&StubCode::UpdateStoreBufferLabel(), PP);
+  addq(RSP, Immediate(kWordSize));
   if (value != RAX) popq(RAX);
   Bind(&done);
 }
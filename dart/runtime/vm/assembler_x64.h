@@ -407,6 +407,9 @@ class Assembler : public ValueObject {
   void movd(XmmRegister dst, Register src);
   void movd(Register dst, XmmRegister src);
 
+  void movq(XmmRegister dst, Register src);
+  void movq(Register dst, XmmRegister src);
+
   void addss(XmmRegister dst, XmmRegister src);
   void subss(XmmRegister dst, XmmRegister src);
   void mulss(XmmRegister dst, XmmRegister src);
@@ -518,6 +521,7 @@ class Assembler : public ValueObject {
   void orq(Register dst, Register src);
   void orq(Register dst, const Address& address);
   void orq(Register dst, const Immediate& imm);
+  void orq(const Address& address, const Immediate& imm);
   void OrImmediate(Register dst, const Immediate& imm, Register pp);
 
   void xorq(Register dst, Register src);
@@ -1241,6 +1241,21 @@ ASSEMBLER_TEST_RUN(CompareSwapNEQ, test) {
 }
 
 
+ASSEMBLER_TEST_GENERATE(LockedOr, assembler) {
+  __ pushq(Immediate(0x3));
+  __ lock();
+  __ orq(Address(RSP, 0), Immediate(0x10));
+  __ popq(RAX);
+  __ ret();
+}
+
+
+ASSEMBLER_TEST_RUN(LockedOr, test) {
+  typedef int (*LockedOrCode)();
+  EXPECT_EQ(0x13, reinterpret_cast<LockedOrCode>(test->entry())());
+}
+
+
 ASSEMBLER_TEST_GENERATE(Exchange, assembler) {
   __ movq(RAX, Immediate(kLargeConstant));
   __ movq(RDX, Immediate(kAnotherLargeConstant));
@@ -1416,6 +1431,29 @@ ASSEMBLER_TEST_RUN(SingleFPMoves2, test) {
 }
 
 
+ASSEMBLER_TEST_GENERATE(Int64XmmMoves, assembler) {
+  __ movq(RAX, Immediate(kLargeConstant));
+  __ movq(XMM0, RAX);
+  __ movq(XMM8, RAX);
+  __ movq(RAX, Immediate(0));
+  __ movsd(XMM9, XMM8);
+  __ movq(R10, XMM9);
+  __ movq(RAX, XMM0);
+  __ subq(RAX, R10);
+  __ movq(XMM1, R10);
+  __ movq(R10, XMM1);
+  __ addq(RAX, R10);
+  __ ret();
+}
+
+
+ASSEMBLER_TEST_RUN(Int64XmmMoves, test) {
+  typedef int64_t (*Int64XmmMovesCode)();
+  EXPECT_EQ(kLargeConstant,
+            reinterpret_cast<Int64XmmMovesCode>(test->entry())());
+}
+
+
 ASSEMBLER_TEST_GENERATE(SingleFPOperations, assembler) {
   __ pushq(RBX);
   __ pushq(RCX);
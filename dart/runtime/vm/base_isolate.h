@@ -108,6 +108,24 @@ class BaseIsolate {
   static void AssertCurrent(BaseIsolate* isolate);
 #endif
 
+#if defined(DEBUG)
+  // While GC helper threads work on behalf of this isolate, the debug-only
+  // scope bookkeeping (e.g. NoHandleScope) is suspended as it is not thread
+  // safe.
+  void IncrementGCHelperDepth() {
+    gc_helper_depth_ += 1;
+  }
+
+  void DecrementGCHelperDepth() {
+    ASSERT(gc_helper_depth_ > 0);
+    gc_helper_depth_ -= 1;
+  }
+
+  bool gc_helpers_active() const {
+    return gc_helper_depth_ > 0;
+  }
+#endif
+
  protected:
   BaseIsolate()
       : top_resource_(NULL),
@@ -117,6 +135,7 @@ class BaseIsolate {
         no_handle_scope_depth_(0),
         no_gc_scope_depth_(0),
         reusable_handle_scope_active_(false),
+        gc_helper_depth_(0),
 #endif
         no_callback_scope_depth_(0)
   {}
@@ -132,6 +151,7 @@ class BaseIsolate {
   int32_t no_handle_scope_depth_;
   int32_t no_gc_scope_depth_;
   bool reusable_handle_scope_active_;
+  int32_t gc_helper_depth_;
 #endif
   int32_t no_callback_scope_depth_;
 
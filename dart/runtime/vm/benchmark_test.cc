@@ -472,4 +472,50 @@ BENCHMARK(CreateMirrorSystem) {
   benchmark->set_score(elapsed_time);
 }
 
+
+//
+// Measure loops summing and copying arrays, whose bounds checks are hoisted
+// out of the loops when optimized.
+//
+BENCHMARK(ArraySumAndCopy) {
+  const char* kScriptChars =
+      "int sum(List<int> list, int n) {\n"
+      "  var result = 0;\n"
+      "  for (var i = 0; i < n; i++) result += list[i];\n"
+      "  return result;\n"
+      "}\n"
+      "\n"
+      "void copy(List<int> to, List<int> from, int n) {\n"
+      "  for (var i = 0; i < n; i++) to[i] = from[i];\n"
+      "}\n"
+      "\n"
+      "int run(int iterations) {\n"
+      "  var from = new List<int>(1000);\n"
+      "  var to = new List<int>(1000);\n"
+      "  for (var i = 0; i < from.length; i++) from[i] = i;\n"
+      "  var result = 0;\n"
+      "  for (var i = 0; i < iterations; i++) {\n"
+      "    copy(to, from, from.length);\n"
+      "    result += sum(to, to.length);\n"
+      "  }\n"
+      "  return result;\n"
+      "}\n";
+  const int64_t kNumIterations = 10000;
+
+  Dart_Handle lib = TestCase::LoadTestScript(kScriptChars, NULL);
+  // Optimize the loops before measuring them.
+  Dart_Handle args[1] = { Dart_NewInteger(kNumIterations) };
+  EXPECT_VALID(Dart_Invoke(lib, NewString("run"), 1, args));
+
+  Timer timer(true, "Array sum and copy benchmark");
+  timer.Start();
+  Dart_Handle result = Dart_Invoke(lib, NewString("run"), 1, args);
+  timer.Stop();
+  int64_t value = 0;
+  EXPECT_VALID(Dart_IntegerToInt64(result, &value));
+  EXPECT_EQ(kNumIterations * 999 * 1000 / 2, value);
+  int64_t elapsed_time = timer.TotalElapsedTime();
+  benchmark->set_score(elapsed_time);
+}
+
 }  // namespace dart
@@ -12,19 +12,33 @@
 namespace dart {
 
 DEFINE_FLAG(bool, print_class_table, false, "Print initial class table.");
+DEFINE_FLAG(bool, pretenure, false,
+            "Allocate the instances of classes which survive scavenges in the "
+            "old space.");
+DEFINE_FLAG(int, pretenure_threshold, 90,
+            "The percentage of the instances of a class which need to survive "
+            "their first scavenge for the class to be pretenured.");
+DEFINE_FLAG(bool, trace_pretenuring, false, "Trace pretenuring decisions.");
 
 ClassTable::ClassTable()
-    : top_(kNumPredefinedCids), capacity_(0), table_(NULL) {
+    : top_(kNumPredefinedCids),
+      capacity_(0),
+      table_(NULL),
+      pretenure_stats_(NULL) {
   if (Dart::vm_isolate() == NULL) {
     capacity_ = initial_capacity_;
     table_ = reinterpret_cast<RawClass**>(
         calloc(capacity_, sizeof(RawClass*)));  // NOLINT
+    pretenure_stats_ = reinterpret_cast<PretenureStats*>(
+        calloc(capacity_, sizeof(PretenureStats)));  // NOLINT
   } else {
     // Duplicate the class table from the VM isolate.
     ClassTable* vm_class_table = Dart::vm_isolate()->class_table();
     capacity_ = vm_class_table->capacity_;
     table_ = reinterpret_cast<RawClass**>(
         calloc(capacity_, sizeof(RawClass*)));  // NOLINT
+    pretenure_stats_ = reinterpret_cast<PretenureStats*>(
+        calloc(capacity_, sizeof(PretenureStats)));  // NOLINT
     for (intptr_t i = kObjectCid; i < kInstanceCid; i++) {
       table_[i] = vm_class_table->At(i);
     }
@@ -37,6 +51,7 @@ ClassTable::ClassTable()
 
 ClassTable::~ClassTable() {
   free(table_);
+  free(pretenure_stats_);
 }
 
 
@@ -58,15 +73,23 @@ void ClassTable::Register(const Class& cls) {
     }
   } else {
     if (top_ == capacity_) {
-      // Grow the capacity of the class table.
+      // Grow the capacity of the class table. The concurrent marker and
+      // sweeper look up classes in the table.
+      PauseConcurrentGCScope pause_gc;
       intptr_t new_capacity = capacity_ + capacity_increment_;
       RawClass** new_table = reinterpret_cast<RawClass**>(
           realloc(table_, new_capacity * sizeof(RawClass*)));  // NOLINT
       for (intptr_t i = capacity_; i < new_capacity; i++) {
         new_table[i] = NULL;
       }
+      PretenureStats* new_stats = reinterpret_cast<PretenureStats*>(
+          realloc(pretenure_stats_,
+                  new_capacity * sizeof(PretenureStats)));  // NOLINT
+      memset(&new_stats[capacity_], 0,
+             (new_capacity - capacity_) * sizeof(PretenureStats));
       capacity_ = new_capacity;
       table_ = new_table;
+      pretenure_stats_ = new_stats;
     }
     ASSERT(top_ < capacity_);
     cls.set_id(top_);
@@ -76,6 +99,48 @@ void ClassTable::Register(const Class& cls) {
 }
 
 
+void ClassTable::UpdateSurvival(intptr_t cid,
+                                intptr_t allocated,
+                                intptr_t survived) {
+  ASSERT(IsValidIndex(cid));
+  ASSERT(survived <= allocated);
+  PretenureStats* stats = &pretenure_stats_[cid];
+  if (stats->pretenure) {
+    return;
+  }
+  stats->allocated += allocated;
+  stats->survived += survived;
+  if (stats->allocated < kPretenureSampleSize) {
+    return;
+  }
+  if ((stats->survived * 100) >=
+      (stats->allocated * FLAG_pretenure_threshold)) {
+    stats->pretenure = true;
+    stats->stale_allocation_stub = true;
+    if (FLAG_trace_pretenuring) {
+      OS::Print("Pretenuring class %" Pd ": %" Pd " of %" Pd " instances "
+                "survived.\n", cid, stats->survived, stats->allocated);
+    }
+  } else {
+    // Halve the counts, so that the decision follows a change in the
+    // lifetime of the instances, e.g. once the program has started up.
+    stats->allocated /= 2;
+    stats->survived /= 2;
+  }
+}
+
+
+bool ClassTable::TakeStaleAllocationStub(intptr_t cid) {
+  ASSERT(IsValidIndex(cid));
+  PretenureStats* stats = &pretenure_stats_[cid];
+  if (!stats->stale_allocation_stub) {
+    return false;
+  }
+  stats->stale_allocation_stub = false;
+  return true;
+}
+
+
 void ClassTable::VisitObjectPointers(ObjectPointerVisitor* visitor) {
   ASSERT(visitor != NULL);
   visitor->VisitPointers(reinterpret_cast<RawObject**>(&table_[0]), top_);
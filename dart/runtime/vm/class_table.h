@@ -6,10 +6,13 @@
 #define VM_CLASS_TABLE_H_
 
 #include "platform/assert.h"
+#include "vm/flags.h"
 #include "vm/globals.h"
 
 namespace dart {
 
+DECLARE_FLAG(bool, pretenure);
+
 class Class;
 class ObjectPointerVisitor;
 class RawClass;
@@ -38,6 +41,21 @@ class ClassTable {
 
   void Register(const Class& cls);
 
+  // Pretenuring feedback, see --pretenure. A scavenge reports how many of the
+  // instances of a class in the new space had not survived a scavenge before,
+  // and how many of those survived.
+  void UpdateSurvival(intptr_t cid, intptr_t allocated, intptr_t survived);
+
+  // Whether the instances of the class are allocated in the old space.
+  bool ShouldPretenure(intptr_t cid) const {
+    ASSERT(IsValidIndex(cid));
+    return pretenure_stats_[cid].pretenure;
+  }
+
+  // Returns true once after the class started to be pretenured, when its
+  // allocation stub still allocates in the new space.
+  bool TakeStaleAllocationStub(intptr_t cid);
+
   void VisitObjectPointers(ObjectPointerVisitor* visitor);
 
   void Print();
@@ -52,10 +70,21 @@ class ClassTable {
   static const int initial_capacity_ = 512;
   static const int capacity_increment_ = 256;
 
+  // The number of instances a pretenuring decision is based on.
+  static const intptr_t kPretenureSampleSize = 1024;
+
+  struct PretenureStats {
+    intptr_t allocated;
+    intptr_t survived;
+    bool pretenure;
+    bool stale_allocation_stub;
+  };
+
   intptr_t top_;
   intptr_t capacity_;
 
   RawClass** table_;
+  PretenureStats* pretenure_stats_;
 
   DISALLOW_COPY_AND_ASSIGN(ClassTable);
 };
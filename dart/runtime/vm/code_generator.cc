@@ -54,6 +54,7 @@ DEFINE_FLAG(bool, trace_runtime_calls, false, "Trace runtime calls");
 
 DECLARE_FLAG(int, deoptimization_counter_threshold);
 DECLARE_FLAG(bool, enable_type_checks);
+DECLARE_FLAG(bool, optimize_when_idle);
 DECLARE_FLAG(bool, report_usage_count);
 DECLARE_FLAG(bool, trace_type_checks);
 
@@ -109,7 +110,10 @@ DEFINE_RUNTIME_ENTRY(AllocateArray, 2) {
 // Return value: newly allocated object.
 DEFINE_RUNTIME_ENTRY(AllocateObject, 3) {
   const Class& cls = Class::CheckedHandle(arguments.ArgAt(0));
-  const Instance& instance = Instance::Handle(Instance::New(cls));
+  const Heap::Space space =
+      isolate->class_table()->ShouldPretenure(cls.id()) ? Heap::kOld
+                                                        : Heap::kNew;
+  const Instance& instance = Instance::Handle(Instance::New(cls, space));
   arguments.SetReturn(instance);
   if (cls.NumTypeArguments() == 0) {
     // No type arguments required for a non-parameterized type.
@@ -1313,6 +1317,12 @@ DEFINE_RUNTIME_ENTRY(StackOverflow, 0) {
     }
     isolate->heap()->CollectGarbage(Heap::kNew);
   }
+  if (interrupt_bits & Isolate::kConcurrentMarkingInterrupt) {
+    if (FLAG_verbose_gc) {
+      OS::PrintErr("Mark-sweep scheduled by the concurrent marker.\n");
+    }
+    isolate->heap()->FinishConcurrentMarking();
+  }
   if (interrupt_bits & Isolate::kMessageInterrupt) {
     isolate->message_handler()->HandleOOBMessages();
   }
@@ -1412,15 +1422,22 @@ DEFINE_RUNTIME_ENTRY(OptimizeInvokedFunction, 1) {
   ASSERT(function.HasCode());
 
   if (CanOptimizeFunction(function, isolate)) {
-    const Error& error =
-        Error::Handle(Compiler::CompileOptimizedFunction(function));
-    if (!error.IsNull()) {
-      Exceptions::PropagateError(error);
+    if (FLAG_optimize_when_idle &&
+        Compiler::QueueOptimizedCompilation(function)) {
+      // Keep running the current code until the isolate is idle. If the
+      // function gets hot again before, it is optimized then.
+      function.set_usage_counter(0);
+    } else {
+      const Error& error =
+          Error::Handle(Compiler::CompileOptimizedFunction(function));
+      if (!error.IsNull()) {
+        Exceptions::PropagateError(error);
+      }
+      const Code& optimized_code = Code::Handle(function.CurrentCode());
+      ASSERT(!optimized_code.IsNull());
+      // Reset usage counter for reoptimization.
+      function.set_usage_counter(0);
     }
-    const Code& optimized_code = Code::Handle(function.CurrentCode());
-    ASSERT(!optimized_code.IsNull());
-    // Reset usage counter for reoptimization.
-    function.set_usage_counter(0);
   }
   arguments.SetReturn(Code::Handle(function.CurrentCode()));
 }
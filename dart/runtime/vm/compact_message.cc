@@ -0,0 +1,603 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compact_message.h"
+
+#include "platform/utils.h"
+#include "vm/object.h"
+#include "vm/unicode.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool, compact_messages, true,
+            "Send messages which are trees of lists, strings, numbers and "
+            "typed data as compact messages.");
+
+// The typed data of the Dart_CObject graphs is aligned for its elements.
+static const intptr_t kTypedDataAlignment = 8;
+
+
+static uint8_t* allocator(uint8_t* ptr, intptr_t old_size, intptr_t new_size) {
+  void* new_ptr = realloc(reinterpret_cast<void*>(ptr), new_size);
+  return reinterpret_cast<uint8_t*>(new_ptr);
+}
+
+
+// Only the typed data classes with a Dart_TypedData_Type are written. Their
+// class ids and types are in the same order.
+static bool IsCompactTypedDataClassId(intptr_t cid) {
+  return (cid >= kTypedDataInt8ArrayCid) && (cid <= kTypedDataFloat64ArrayCid);
+}
+
+
+static intptr_t TypedDataClassId(intptr_t type) {
+  if ((type < Dart_TypedData_kInt8) || (type > Dart_TypedData_kFloat64)) {
+    return kIllegalCid;
+  }
+  return kTypedDataInt8ArrayCid + (type - Dart_TypedData_kInt8);
+}
+
+
+static Dart_TypedData_Type TypedDataType(intptr_t cid) {
+  ASSERT(IsCompactTypedDataClassId(cid));
+  return static_cast<Dart_TypedData_Type>(
+      Dart_TypedData_kInt8 + (cid - kTypedDataInt8ArrayCid));
+}
+
+
+static bool IsCompactClassId(intptr_t cid) {
+  switch (cid) {
+    case kNullCid:
+    case kBoolCid:
+    case kSmiCid:
+    case kMintCid:
+    case kDoubleCid:
+    case kOneByteStringCid:
+    case kArrayCid:
+    case kGrowableObjectArrayCid:
+      return true;
+    default:
+      return IsCompactTypedDataClassId(cid);
+  }
+}
+
+
+// The lists read from compact messages have no type arguments, which only
+// preserves the type of lists of dynamic elements.
+static bool HasDynamicTypeArguments(RawAbstractTypeArguments* raw) {
+  if (raw == AbstractTypeArguments::null()) {
+    return true;
+  }
+  const AbstractTypeArguments& type_args =
+      AbstractTypeArguments::Handle(raw);
+  return type_args.IsRaw(0, 1);
+}
+
+
+Message* CompactMessage::New(Dart_Port dest_port,
+                             const Object& obj,
+                             Message::Priority priority) {
+  // Avoid setting up a writer for messages which are obviously not trees.
+  if (!FLAG_compact_messages || !IsCompactClassId(obj.GetClassId())) {
+    return NULL;
+  }
+  uint8_t* data = NULL;
+  CompactMessageWriter writer(&data, &allocator);
+  if (!writer.WriteMessage(obj)) {
+    free(data);
+    return NULL;
+  }
+  Message* message = new Message(dest_port, Message::kIllegalPort,
+                                 data, writer.BytesWritten(), priority);
+  message->set_is_compact(true);
+  return message;
+}
+
+
+Message* CompactMessage::New(Dart_Port dest_port, Dart_CObject* obj) {
+  if (!FLAG_compact_messages) {
+    return NULL;
+  }
+  uint8_t* data = NULL;
+  CompactMessageWriter writer(&data, &allocator);
+  if (!writer.WriteCMessage(obj)) {
+    free(data);
+    return NULL;
+  }
+  Message* message = new Message(dest_port, Message::kIllegalPort,
+                                 data, writer.BytesWritten(),
+                                 Message::kNormalPriority);
+  message->set_is_compact(true);
+  return message;
+}
+
+
+bool CompactMessageWriter::WriteMessage(const Object& obj) {
+  // The lists are recorded by address.
+  NoGCScope no_gc;
+  return WriteObject(obj);
+}
+
+
+bool CompactMessageWriter::WriteCMessage(Dart_CObject* obj) {
+  return WriteCObject(obj);
+}
+
+
+static intptr_t ContainerHash(void* container) {
+  const uword key = reinterpret_cast<uword>(container) >> kWordSizeLog2;
+  return static_cast<intptr_t>(key ^ (key >> 12));
+}
+
+
+bool CompactMessageWriter::AddContainer(void* container) {
+  if (2 * (num_containers_ + 1) > containers_size_) {
+    GrowContainers();
+  }
+  const intptr_t mask = containers_size_ - 1;
+  intptr_t i = ContainerHash(container) & mask;
+  while (containers_[i] != NULL) {
+    if (containers_[i] == container) {
+      return false;
+    }
+    i = (i + 1) & mask;
+  }
+  containers_[i] = container;
+  num_containers_++;
+  return true;
+}
+
+
+void CompactMessageWriter::GrowContainers() {
+  static const intptr_t kInitialContainersSize = 16;
+  void** old_containers = containers_;
+  const intptr_t old_size = containers_size_;
+  containers_size_ = (old_size == 0) ? kInitialContainersSize : 2 * old_size;
+  containers_ = reinterpret_cast<void**>(
+      ::calloc(containers_size_, sizeof(containers_[0])));
+  const intptr_t mask = containers_size_ - 1;
+  for (intptr_t i = 0; i < old_size; i++) {
+    if (old_containers[i] != NULL) {
+      intptr_t j = ContainerHash(old_containers[i]) & mask;
+      while (containers_[j] != NULL) {
+        j = (j + 1) & mask;
+      }
+      containers_[j] = old_containers[i];
+    }
+  }
+  ::free(old_containers);
+}
+
+
+void CompactMessageWriter::WriteInteger(int64_t value) {
+  Write<uint8_t>(CompactMessage::kIntegerTag);
+  Write<int64_t>(value);
+}
+
+
+void CompactMessageWriter::WriteDouble(double value) {
+  Write<uint8_t>(CompactMessage::kDoubleTag);
+  WriteBytes(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+}
+
+
+bool CompactMessageWriter::WriteObject(const Object& obj) {
+  if (obj.IsNull()) {
+    Write<uint8_t>(CompactMessage::kNullTag);
+    return true;
+  }
+  if (obj.IsSmi()) {
+    WriteInteger(Smi::Cast(obj).Value());
+    return true;
+  }
+  const intptr_t cid = obj.GetClassId();
+  switch (cid) {
+    case kBoolCid:
+      Write<uint8_t>(Bool::Cast(obj).value() ? CompactMessage::kTrueTag
+                                             : CompactMessage::kFalseTag);
+      return true;
+    case kMintCid:
+      WriteInteger(Mint::Cast(obj).value());
+      return true;
+    case kDoubleCid:
+      WriteDouble(Double::Cast(obj).value());
+      return true;
+    case kOneByteStringCid: {
+      const String& str = String::Cast(obj);
+      const intptr_t len = str.Length();
+      Write<uint8_t>(CompactMessage::kStringTag);
+      WriteIntptrValue(len);
+      if (len > 0) {
+        WriteBytes(OneByteString::CharAddr(str, 0), len);
+      }
+      return true;
+    }
+    case kArrayCid: {
+      const Array& array = Array::Cast(obj);
+      if ((depth_ == kMaxDepth) ||
+          !HasDynamicTypeArguments(array.GetTypeArguments()) ||
+          !AddContainer(array.raw())) {
+        return false;
+      }
+      const intptr_t len = array.Length();
+      Write<uint8_t>(CompactMessage::kArrayTag);
+      WriteIntptrValue(len);
+      Object& element = Object::Handle();
+      depth_++;
+      for (intptr_t i = 0; i < len; i++) {
+        element = array.At(i);
+        if (!WriteObject(element)) {
+          return false;
+        }
+      }
+      depth_--;
+      return true;
+    }
+    case kGrowableObjectArrayCid: {
+      const GrowableObjectArray& array = GrowableObjectArray::Cast(obj);
+      if ((depth_ == kMaxDepth) ||
+          !HasDynamicTypeArguments(array.GetTypeArguments()) ||
+          !AddContainer(array.raw())) {
+        return false;
+      }
+      const intptr_t len = array.Length();
+      Write<uint8_t>(CompactMessage::kGrowableArrayTag);
+      WriteIntptrValue(len);
+      Object& element = Object::Handle();
+      depth_++;
+      for (intptr_t i = 0; i < len; i++) {
+        element = array.At(i);
+        if (!WriteObject(element)) {
+          return false;
+        }
+      }
+      depth_--;
+      return true;
+    }
+    default:
+      break;
+  }
+  if (!IsCompactTypedDataClassId(cid)) {
+    return false;
+  }
+  const TypedData& data = TypedData::Cast(obj);
+  if (!AddContainer(data.raw())) {
+    return false;
+  }
+  Write<uint8_t>(CompactMessage::kTypedDataTag);
+  Write<uint8_t>(TypedDataType(cid));
+  WriteIntptrValue(data.Length());
+  if (data.Length() > 0) {
+    WriteBytes(reinterpret_cast<const uint8_t*>(data.DataAddr(0)),
+               data.LengthInBytes());
+  }
+  return true;
+}
+
+
+bool CompactMessageWriter::WriteCObject(Dart_CObject* obj) {
+  switch (obj->type) {
+    case Dart_CObject_kNull:
+      Write<uint8_t>(CompactMessage::kNullTag);
+      return true;
+    case Dart_CObject_kBool:
+      Write<uint8_t>(obj->value.as_bool ? CompactMessage::kTrueTag
+                                        : CompactMessage::kFalseTag);
+      return true;
+    case Dart_CObject_kInt32:
+      WriteInteger(obj->value.as_int32);
+      return true;
+    case Dart_CObject_kInt64:
+      WriteInteger(obj->value.as_int64);
+      return true;
+    case Dart_CObject_kDouble:
+      WriteDouble(obj->value.as_double);
+      return true;
+    case Dart_CObject_kString: {
+      const uint8_t* utf8_str =
+          reinterpret_cast<const uint8_t*>(obj->value.as_string);
+      const intptr_t utf8_len = strlen(obj->value.as_string);
+      if (!Utf8::IsValid(utf8_str, utf8_len)) {
+        return false;
+      }
+      Utf8::Type type;
+      const intptr_t len = Utf8::CodeUnitCount(utf8_str, utf8_len, &type);
+      if ((type != Utf8::kLatin1) || (len > String::kMaxElements)) {
+        return false;
+      }
+      Write<uint8_t>(CompactMessage::kStringTag);
+      WriteIntptrValue(len);
+      if (len == utf8_len) {
+        // ASCII.
+        WriteBytes(utf8_str, len);
+        return true;
+      }
+      uint8_t* latin1_str = reinterpret_cast<uint8_t*>(::malloc(len));
+      bool success = Utf8::DecodeToLatin1(utf8_str, utf8_len, latin1_str, len);
+      ASSERT(success);
+      WriteBytes(latin1_str, len);
+      ::free(latin1_str);
+      return true;
+    }
+    case Dart_CObject_kArray: {
+      const intptr_t len = obj->value.as_array.length;
+      if ((depth_ == kMaxDepth) ||
+          (len < 0) ||
+          (len > Array::kMaxElements) ||
+          !AddContainer(obj)) {
+        return false;
+      }
+      Write<uint8_t>(CompactMessage::kArrayTag);
+      WriteIntptrValue(len);
+      depth_++;
+      for (intptr_t i = 0; i < len; i++) {
+        if (!WriteCObject(obj->value.as_array.values[i])) {
+          return false;
+        }
+      }
+      depth_--;
+      return true;
+    }
+    case Dart_CObject_kTypedData: {
+      const intptr_t cid = TypedDataClassId(obj->value.as_typed_data.type);
+      if (cid == kIllegalCid) {
+        return false;
+      }
+      // The length of a Dart_CObject typed data is in bytes.
+      const intptr_t element_size = TypedData::ElementSizeInBytes(cid);
+      const intptr_t len_in_bytes = obj->value.as_typed_data.length;
+      const intptr_t len = len_in_bytes / element_size;
+      if ((len_in_bytes < 0) ||
+          ((len_in_bytes % element_size) != 0) ||
+          (len > TypedData::MaxElements(cid)) ||
+          !AddContainer(obj)) {
+        return false;
+      }
+      Write<uint8_t>(CompactMessage::kTypedDataTag);
+      Write<uint8_t>(obj->value.as_typed_data.type);
+      WriteIntptrValue(len);
+      WriteBytes(obj->value.as_typed_data.values, len_in_bytes);
+      return true;
+    }
+    default:
+      // Big integers, external typed data and send ports.
+      return false;
+  }
+}
+
+
+RawObject* CompactMessageReader::ReadMessage() {
+  return ReadObject();
+}
+
+
+RawObject* CompactMessageReader::ReadObject() {
+  switch (Read<uint8_t>()) {
+    case CompactMessage::kNullTag:
+      return Object::null();
+    case CompactMessage::kTrueTag:
+      return Bool::True().raw();
+    case CompactMessage::kFalseTag:
+      return Bool::False().raw();
+    case CompactMessage::kIntegerTag:
+      return Integer::New(Read<int64_t>());
+    case CompactMessage::kDoubleTag: {
+      double value;
+      ReadBytes(reinterpret_cast<uint8_t*>(&value), sizeof(value));
+      return Double::New(value);
+    }
+    case CompactMessage::kStringTag: {
+      const intptr_t len = ReadIntptrValue();
+      const uint8_t* characters = CurrentBufferAddress();
+      Advance(len);
+      return OneByteString::New(characters, len, Heap::kNew);
+    }
+    case CompactMessage::kArrayTag: {
+      const intptr_t len = ReadIntptrValue();
+      const Array& array = Array::Handle(Array::New(len));
+      Object& element = Object::Handle();
+      for (intptr_t i = 0; i < len; i++) {
+        element = ReadObject();
+        array.SetAt(i, element);
+      }
+      return array.raw();
+    }
+    case CompactMessage::kGrowableArrayTag: {
+      const intptr_t len = ReadIntptrValue();
+      const GrowableObjectArray& array = GrowableObjectArray::Handle(
+          (len > 0) ? GrowableObjectArray::New(len)
+                    : GrowableObjectArray::New());
+      Object& element = Object::Handle();
+      for (intptr_t i = 0; i < len; i++) {
+        element = ReadObject();
+        array.Add(element);
+      }
+      return array.raw();
+    }
+    case CompactMessage::kTypedDataTag: {
+      const intptr_t cid = TypedDataClassId(Read<uint8_t>());
+      ASSERT(cid != kIllegalCid);
+      const intptr_t len = ReadIntptrValue();
+      const TypedData& data = TypedData::Handle(TypedData::New(cid, len));
+      const intptr_t len_in_bytes = data.LengthInBytes();
+      if (len_in_bytes > 0) {
+        NoGCScope no_gc;
+        memmove(data.DataAddr(0), CurrentBufferAddress(), len_in_bytes);
+      }
+      Advance(len_in_bytes);
+      return data.raw();
+    }
+    default:
+      UNREACHABLE();
+      return Object::null();
+  }
+}
+
+
+// Adds the size of the Dart_CObject graph of the next value of the message
+// to the number of Dart_CObject structures, the number of array elements and
+// the number of bytes of string characters and typed data it needs.
+static void SizeCompactObject(BaseReader* reader,
+                              intptr_t* num_objects,
+                              intptr_t* num_values,
+                              intptr_t* num_bytes) {
+  (*num_objects)++;
+  switch (reader->Read<uint8_t>()) {
+    case CompactMessage::kNullTag:
+    case CompactMessage::kTrueTag:
+    case CompactMessage::kFalseTag:
+      break;
+    case CompactMessage::kIntegerTag:
+      reader->Read<int64_t>();
+      break;
+    case CompactMessage::kDoubleTag:
+      reader->Advance(sizeof(double));
+      break;
+    case CompactMessage::kStringTag: {
+      // The Latin-1 characters above 0x7F take two bytes in UTF-8.
+      const intptr_t len = reader->ReadIntptrValue();
+      const uint8_t* characters = reader->CurrentBufferAddress();
+      intptr_t utf8_len = len;
+      for (intptr_t i = 0; i < len; i++) {
+        if (characters[i] > 0x7F) {
+          utf8_len++;
+        }
+      }
+      *num_bytes += utf8_len + 1;
+      reader->Advance(len);
+      break;
+    }
+    case CompactMessage::kArrayTag:
+    case CompactMessage::kGrowableArrayTag: {
+      const intptr_t len = reader->ReadIntptrValue();
+      *num_values += len;
+      for (intptr_t i = 0; i < len; i++) {
+        SizeCompactObject(reader, num_objects, num_values, num_bytes);
+      }
+      break;
+    }
+    case CompactMessage::kTypedDataTag: {
+      const intptr_t cid = TypedDataClassId(reader->Read<uint8_t>());
+      ASSERT(cid != kIllegalCid);
+      const intptr_t len_in_bytes =
+          reader->ReadIntptrValue() * TypedData::ElementSizeInBytes(cid);
+      *num_bytes = Utils::RoundUp(*num_bytes, kTypedDataAlignment) +
+          len_in_bytes;
+      reader->Advance(len_in_bytes);
+      break;
+    }
+    default:
+      UNREACHABLE();
+  }
+}
+
+
+Dart_CObject* CompactApiMessageReader::ReadMessage() {
+  BaseReader sizer(buffer_, length_);
+  intptr_t num_objects = 0;
+  intptr_t num_values = 0;
+  intptr_t num_bytes = 0;
+  SizeCompactObject(&sizer, &num_objects, &num_values, &num_bytes);
+  // The graph is laid out as the Dart_CObject structures, the array elements
+  // and the bytes, which start aligned as the typed data are aligned
+  // relative to their start.
+  const intptr_t values_offset = num_objects * sizeof(Dart_CObject);
+  const intptr_t bytes_offset =
+      values_offset + num_values * sizeof(Dart_CObject*);
+  const intptr_t size = bytes_offset + kTypedDataAlignment + num_bytes;
+  uint8_t* graph = alloc_(NULL, 0, size);
+  ASSERT(graph != NULL);
+  next_object_ = reinterpret_cast<Dart_CObject*>(graph);
+  next_value_ = reinterpret_cast<Dart_CObject**>(graph + values_offset);
+  next_byte_ = reinterpret_cast<uint8_t*>(Utils::RoundUp(
+      reinterpret_cast<uword>(graph + bytes_offset), kTypedDataAlignment));
+  Dart_CObject* result = ReadObject();
+  ASSERT(next_byte_ <= graph + size);
+  return result;
+}
+
+
+Dart_CObject* CompactApiMessageReader::ReadObject() {
+  Dart_CObject* value = next_object_++;
+  const uint8_t tag = Read<uint8_t>();
+  switch (tag) {
+    case CompactMessage::kNullTag:
+      value->type = Dart_CObject_kNull;
+      break;
+    case CompactMessage::kTrueTag:
+    case CompactMessage::kFalseTag:
+      value->type = Dart_CObject_kBool;
+      value->value.as_bool = (tag == CompactMessage::kTrueTag);
+      break;
+    case CompactMessage::kIntegerTag: {
+      const int64_t integer = Read<int64_t>();
+      if (Utils::IsInt(32, integer)) {
+        value->type = Dart_CObject_kInt32;
+        value->value.as_int32 = static_cast<int32_t>(integer);
+      } else {
+        value->type = Dart_CObject_kInt64;
+        value->value.as_int64 = integer;
+      }
+      break;
+    }
+    case CompactMessage::kDoubleTag:
+      value->type = Dart_CObject_kDouble;
+      ReadBytes(reinterpret_cast<uint8_t*>(&value->value.as_double),
+                sizeof(value->value.as_double));
+      break;
+    case CompactMessage::kStringTag: {
+      const intptr_t len = ReadIntptrValue();
+      const uint8_t* characters = CurrentBufferAddress();
+      char* p = reinterpret_cast<char*>(next_byte_);
+      value->type = Dart_CObject_kString;
+      value->value.as_string = p;
+      for (intptr_t i = 0; i < len; i++) {
+        p += Utf8::Encode(characters[i], p);
+      }
+      *p++ = '\0';
+      next_byte_ = reinterpret_cast<uint8_t*>(p);
+      Advance(len);
+      break;
+    }
+    case CompactMessage::kArrayTag:
+    case CompactMessage::kGrowableArrayTag: {
+      const intptr_t len = ReadIntptrValue();
+      Dart_CObject** values = next_value_;
+      next_value_ += len;
+      value->type = Dart_CObject_kArray;
+      value->value.as_array.length = len;
+      value->value.as_array.values = (len > 0) ? values : NULL;
+      for (intptr_t i = 0; i < len; i++) {
+        values[i] = ReadObject();
+      }
+      break;
+    }
+    case CompactMessage::kTypedDataTag: {
+      const Dart_TypedData_Type type =
+          static_cast<Dart_TypedData_Type>(Read<uint8_t>());
+      const intptr_t cid = TypedDataClassId(type);
+      ASSERT(cid != kIllegalCid);
+      const intptr_t len_in_bytes =
+          ReadIntptrValue() * TypedData::ElementSizeInBytes(cid);
+      next_byte_ = reinterpret_cast<uint8_t*>(Utils::RoundUp(
+          reinterpret_cast<uword>(next_byte_), kTypedDataAlignment));
+      value->type = Dart_CObject_kTypedData;
+      value->value.as_typed_data.type = type;
+      value->value.as_typed_data.length = len_in_bytes;
+      if (len_in_bytes > 0) {
+        value->value.as_typed_data.values = next_byte_;
+        ReadBytes(next_byte_, len_in_bytes);
+        next_byte_ += len_in_bytes;
+      } else {
+        value->value.as_typed_data.values = NULL;
+      }
+      break;
+    }
+    default:
+      UNREACHABLE();
+  }
+  return value;
+}
+
+}  // namespace dart
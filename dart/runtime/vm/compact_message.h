@@ -0,0 +1,151 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_COMPACT_MESSAGE_H_
+#define VM_COMPACT_MESSAGE_H_
+
+#include "include/dart_native_api.h"
+#include "vm/flags.h"
+#include "vm/globals.h"
+#include "vm/message.h"
+#include "vm/snapshot.h"
+
+namespace dart {
+
+DECLARE_FLAG(bool, compact_messages);
+
+// Forward declarations.
+class Object;
+class RawObject;
+
+// Compact messages are an alternative to message snapshots for the common
+// case of a message which is a tree of lists holding null, booleans,
+// integers, doubles, strings and typed data. Every value is written as a tag
+// byte followed by its payload, using the variable length encoding of the
+// snapshot streams for integers and lengths and the raw bytes for doubles,
+// string characters and typed data elements. There are no object ids, class
+// ids or headers. Messages which hold any other object, share a list or
+// typed data, are cyclic or nest lists too deeply cannot be written as compact
+// messages and are sent as message snapshots.
+class CompactMessage : public AllStatic {
+ public:
+  enum Tag {
+    kNullTag = 0,
+    kTrueTag,
+    kFalseTag,
+    kIntegerTag,
+    kDoubleTag,
+    kStringTag,  // Latin-1 characters.
+    kArrayTag,
+    kGrowableArrayTag,
+    kTypedDataTag,  // Dart_TypedData_Type, number of elements, bytes.
+  };
+
+  // Returns a compact message holding the object, or NULL if it cannot be
+  // written as a compact message or --compact_messages is false.
+  static Message* New(Dart_Port dest_port,
+                      const Object& obj,
+                      Message::Priority priority);
+  static Message* New(Dart_Port dest_port, Dart_CObject* obj);
+};
+
+
+// Writes an object or a Dart_CObject as a compact message.
+class CompactMessageWriter : public BaseWriter {
+ public:
+  static const intptr_t kInitialSize = 512;
+
+  // The depth of the lists a message can hold, which bounds the recursion of
+  // the writers and readers.
+  static const intptr_t kMaxDepth = 64;
+
+  CompactMessageWriter(uint8_t** buffer, ReAlloc alloc)
+      : BaseWriter(buffer, alloc, kInitialSize),
+        containers_(NULL),
+        containers_size_(0),
+        num_containers_(0),
+        depth_(0) { }
+  ~CompactMessageWriter() {
+    ::free(containers_);
+  }
+
+  // Return false if the object cannot be written as a compact message, in
+  // which case the contents of the buffer are undefined.
+  bool WriteMessage(const Object& obj);
+  bool WriteCMessage(Dart_CObject* obj);
+
+ private:
+  // Records a list or typed data. Returns false if it was already written,
+  // i.e. if it is shared or part of a cycle.
+  bool AddContainer(void* container);
+  void GrowContainers();
+  bool WriteObject(const Object& obj);
+  bool WriteCObject(Dart_CObject* obj);
+  void WriteInteger(int64_t value);
+  void WriteDouble(double value);
+
+  // Open addressing hash set of the lists and typed data written so far,
+  // whose size is a power of two.
+  void** containers_;
+  intptr_t containers_size_;
+  intptr_t num_containers_;
+  intptr_t depth_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompactMessageWriter);
+};
+
+
+// Reads a compact message into objects of the current isolate.
+class CompactMessageReader : public BaseReader {
+ public:
+  CompactMessageReader(const uint8_t* buffer, intptr_t length)
+      : BaseReader(buffer, length) { }
+  ~CompactMessageReader() { }
+
+  RawObject* ReadMessage();
+
+ private:
+  RawObject* ReadObject();
+
+  DISALLOW_COPY_AND_ASSIGN(CompactMessageReader);
+};
+
+
+// Reads a compact message into a Dart_CObject graph. A first pass over the
+// message computes the size of the graph, which is then allocated with a
+// single call of the allocator and filled by a second pass.
+class CompactApiMessageReader : public BaseReader {
+ public:
+  CompactApiMessageReader(const uint8_t* buffer,
+                          intptr_t length,
+                          ReAlloc alloc)
+      : BaseReader(buffer, length),
+        buffer_(buffer),
+        length_(length),
+        alloc_(alloc),
+        next_object_(NULL),
+        next_value_(NULL),
+        next_byte_(NULL) { }
+  ~CompactApiMessageReader() { }
+
+  Dart_CObject* ReadMessage();
+
+ private:
+  Dart_CObject* ReadObject();
+
+  const uint8_t* buffer_;
+  intptr_t length_;
+  ReAlloc alloc_;
+
+  // The parts of the graph not used yet.
+  Dart_CObject* next_object_;
+  Dart_CObject** next_value_;
+  uint8_t* next_byte_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompactApiMessageReader);
+};
+
+}  // namespace dart
+
+#endif  // VM_COMPACT_MESSAGE_H_
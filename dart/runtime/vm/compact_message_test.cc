@@ -0,0 +1,286 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/benchmark_test.h"
+#include "vm/compact_message.h"
+#include "vm/dart_api_impl.h"
+#include "vm/dart_api_message.h"
+#include "vm/dart_api_state.h"
+#include "vm/globals.h"
+#include "vm/snapshot.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+static uint8_t* malloc_allocator(
+    uint8_t* ptr, intptr_t old_size, intptr_t new_size) {
+  return reinterpret_cast<uint8_t*>(realloc(ptr, new_size));
+}
+
+
+static uint8_t* zone_allocator(
+    uint8_t* ptr, intptr_t old_size, intptr_t new_size) {
+  Zone* zone = Isolate::Current()->current_zone();
+  return zone->Realloc<uint8_t>(ptr, old_size, new_size);
+}
+
+
+static const char* kTreeScriptChars =
+    "import 'dart:typed_data';\n"
+    "getTree() {\n"
+    "  var shorts = new Int16List(3);\n"
+    "  shorts[0] = 1;\n"
+    "  shorts[1] = -2;\n"
+    "  shorts[2] = 30000;\n"
+    "  var fixed = new List(2);\n"
+    "  fixed[0] = 'a';\n"
+    "  return [null, true, false, 42, 0x7fffffffffffffff, 1.5, 'caf\\xe9',\n"
+    "          fixed, [], shorts];\n"
+    "}\n"
+    "checkTree(tree) {\n"
+    "  var expected = getTree();\n"
+    "  if ((tree is! List) || (tree.length != expected.length)) {\n"
+    "    return false;\n"
+    "  }\n"
+    "  for (var i = 0; i < 7; i++) {\n"
+    "    if (tree[i] != expected[i]) return false;\n"
+    "  }\n"
+    "  var shorts = tree[9];\n"
+    "  return (tree[7].length == 2) && (tree[7][0] == 'a') &&\n"
+    "         (tree[7][1] == null) && ((tree[8]..add(1)).length == 1) &&\n"
+    "         (shorts is Int16List) && (shorts.length == 3) &&\n"
+    "         (shorts[1] == -2) && (shorts[2] == 30000);\n"
+    "}\n"
+    "getShared() {\n"
+    "  var list = [1];\n"
+    "  return [list, list];\n"
+    "}\n"
+    "getCyclic() {\n"
+    "  var list = [];\n"
+    "  list.add(list);\n"
+    "  return list;\n"
+    "}\n"
+    "getDeep() {\n"
+    "  var list = [];\n"
+    "  for (var i = 0; i < 100; i++) {\n"
+    "    list = [list];\n"
+    "  }\n"
+    "  return list;\n"
+    "}\n"
+    "getTyped() => <int>[1, 2];\n"
+    "getInstance() => [new Object()];\n"
+    "getTwoByteString() => ['\\u{1F601}'];\n";
+
+
+static intptr_t WriteCompactMessage(Dart_Handle handle, uint8_t** buffer) {
+  Isolate* isolate = Isolate::Current();
+  DARTSCOPE(isolate);
+  const Object& obj = Object::Handle(isolate, Api::UnwrapHandle(handle));
+  CompactMessageWriter writer(buffer, &malloc_allocator);
+  if (!writer.WriteMessage(obj)) {
+    free(*buffer);
+    *buffer = NULL;
+    return 0;
+  }
+  return writer.BytesWritten();
+}
+
+
+TEST_CASE(CompactMessage_Roundtrip) {
+  Dart_Handle lib = TestCase::LoadTestScript(kTreeScriptChars, NULL);
+  EXPECT_VALID(lib);
+  Dart_Handle tree = Dart_Invoke(lib, NewString("getTree"), 0, NULL);
+  EXPECT_VALID(tree);
+  uint8_t* buffer = NULL;
+  intptr_t buffer_len = WriteCompactMessage(tree, &buffer);
+  EXPECT(buffer != NULL);
+
+  // Read the message into objects.
+  Dart_Handle result;
+  {
+    Isolate* isolate = Isolate::Current();
+    DARTSCOPE(isolate);
+    CompactMessageReader reader(buffer, buffer_len);
+    result = Api::NewHandle(isolate, reader.ReadMessage());
+  }
+  result = Dart_Invoke(lib, NewString("checkTree"), 1, &result);
+  EXPECT_VALID(result);
+  EXPECT(Dart_IdentityEquals(Dart_True(), result));
+
+  // Read the message into a Dart_CObject graph.
+  {
+    ApiNativeScope scope;
+    CompactApiMessageReader reader(buffer, buffer_len, &zone_allocator);
+    Dart_CObject* root = reader.ReadMessage();
+    EXPECT_EQ(Dart_CObject_kArray, root->type);
+    EXPECT_EQ(10, root->value.as_array.length);
+    Dart_CObject** values = root->value.as_array.values;
+    EXPECT_EQ(Dart_CObject_kNull, values[0]->type);
+    EXPECT_EQ(Dart_CObject_kBool, values[1]->type);
+    EXPECT(values[1]->value.as_bool);
+    EXPECT(!values[2]->value.as_bool);
+    EXPECT_EQ(Dart_CObject_kInt32, values[3]->type);
+    EXPECT_EQ(42, values[3]->value.as_int32);
+    EXPECT_EQ(Dart_CObject_kInt64, values[4]->type);
+    EXPECT_EQ(kMaxInt64, values[4]->value.as_int64);
+    EXPECT_EQ(Dart_CObject_kDouble, values[5]->type);
+    EXPECT_EQ(1.5, values[5]->value.as_double);
+    // Latin-1 strings are converted to UTF-8.
+    EXPECT_EQ(Dart_CObject_kString, values[6]->type);
+    EXPECT_STREQ("caf\xC3\xA9", values[6]->value.as_string);
+    EXPECT_EQ(Dart_CObject_kArray, values[7]->type);
+    EXPECT_EQ(2, values[7]->value.as_array.length);
+    EXPECT_STREQ("a", values[7]->value.as_array.values[0]->value.as_string);
+    EXPECT_EQ(Dart_CObject_kNull,
+              values[7]->value.as_array.values[1]->type);
+    EXPECT_EQ(Dart_CObject_kArray, values[8]->type);
+    EXPECT_EQ(0, values[8]->value.as_array.length);
+    EXPECT_EQ(Dart_CObject_kTypedData, values[9]->type);
+    EXPECT_EQ(Dart_TypedData_kInt16, values[9]->value.as_typed_data.type);
+    EXPECT_EQ(6, values[9]->value.as_typed_data.length);
+    uint8_t* shorts = values[9]->value.as_typed_data.values;
+    EXPECT(Utils::IsAligned(reinterpret_cast<uword>(shorts), sizeof(int16_t)));
+    EXPECT_EQ(-2, reinterpret_cast<int16_t*>(shorts)[1]);
+    EXPECT_EQ(30000, reinterpret_cast<int16_t*>(shorts)[2]);
+  }
+  free(buffer);
+}
+
+
+TEST_CASE(CompactMessage_CObjectRoundtrip) {
+  StackZone zone(Isolate::Current());
+  Dart_CObject null_object;
+  null_object.type = Dart_CObject_kNull;
+  Dart_CObject int64_object;
+  int64_object.type = Dart_CObject_kInt64;
+  int64_object.value.as_int64 = -kMaxInt64;
+  Dart_CObject string_object;
+  string_object.type = Dart_CObject_kString;
+  string_object.value.as_string = const_cast<char*>("Bl\xC3\xA5");
+  double doubles[] = { 0.5, -2.25 };
+  Dart_CObject typed_data_object;
+  typed_data_object.type = Dart_CObject_kTypedData;
+  typed_data_object.value.as_typed_data.type = Dart_TypedData_kFloat64;
+  typed_data_object.value.as_typed_data.length = sizeof(doubles);
+  typed_data_object.value.as_typed_data.values =
+      reinterpret_cast<uint8_t*>(doubles);
+  Dart_CObject* values[] = {
+    &null_object, &int64_object, &string_object, &typed_data_object
+  };
+  Dart_CObject root;
+  root.type = Dart_CObject_kArray;
+  root.value.as_array.length = ARRAY_SIZE(values);
+  root.value.as_array.values = values;
+
+  uint8_t* buffer = NULL;
+  CompactMessageWriter writer(&buffer, &malloc_allocator);
+  EXPECT(writer.WriteCMessage(&root));
+
+  CompactMessageReader reader(buffer, writer.BytesWritten());
+  const Array& array = Array::Handle(Array::RawCast(reader.ReadMessage()));
+  EXPECT_EQ(4, array.Length());
+  EXPECT(array.At(0) == Object::null());
+  Mint& mint = Mint::Handle();
+  mint ^= array.At(1);
+  EXPECT_EQ(-kMaxInt64, mint.value());
+  String& str = String::Handle();
+  str ^= array.At(2);
+  EXPECT(str.IsOneByteString());
+  EXPECT(str.Equals("Bl\xC3\xA5"));
+  TypedData& typed_data = TypedData::Handle();
+  typed_data ^= array.At(3);
+  EXPECT_EQ(kTypedDataFloat64ArrayCid, typed_data.GetClassId());
+  EXPECT_EQ(2, typed_data.Length());
+  EXPECT_EQ(-2.25, typed_data.GetFloat64(sizeof(double)));
+  free(buffer);
+
+  // Lists can only be written once.
+  values[0] = &root;
+  buffer = NULL;
+  CompactMessageWriter cyclic_writer(&buffer, &malloc_allocator);
+  EXPECT(!cyclic_writer.WriteCMessage(&root));
+  free(buffer);
+}
+
+
+TEST_CASE(CompactMessage_Unsupported) {
+  Dart_Handle lib = TestCase::LoadTestScript(kTreeScriptChars, NULL);
+  EXPECT_VALID(lib);
+  const char* kUnsupported[] = {
+    "getShared", "getCyclic", "getDeep", "getTyped", "getInstance",
+    "getTwoByteString"
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(kUnsupported); i++) {
+    Dart_Handle obj = Dart_Invoke(lib, NewString(kUnsupported[i]), 0, NULL);
+    EXPECT_VALID(obj);
+    uint8_t* buffer = NULL;
+    EXPECT_EQ(0, WriteCompactMessage(obj, &buffer));
+  }
+
+  // Messages are only written as compact messages with --compact_messages.
+  Dart_Handle tree = Dart_Invoke(lib, NewString("getTree"), 0, NULL);
+  EXPECT_VALID(tree);
+  Isolate* isolate = Isolate::Current();
+  DARTSCOPE(isolate);
+  const Object& obj = Object::Handle(isolate, Api::UnwrapHandle(tree));
+  Message* message =
+      CompactMessage::New(Message::kIllegalPort, obj, Message::kNormalPriority);
+  EXPECT(message != NULL);
+  EXPECT(message->is_compact());
+  delete message;
+  bool saved_compact_messages = FLAG_compact_messages;
+  FLAG_compact_messages = false;
+  EXPECT(CompactMessage::New(Message::kIllegalPort, obj,
+                             Message::kNormalPriority) == NULL);
+  FLAG_compact_messages = saved_compact_messages;
+}
+
+
+//
+// Measure writing and reading compact messages holding a list of integers,
+// doubles, strings and small lists.
+//
+BENCHMARK(CompactMessage) {
+  static const char* kScriptChars =
+      "getList(length) {\n"
+      "  var list = new List(length);\n"
+      "  for (var i = 0; i < length; i++) {\n"
+      "    switch (i % 4) {\n"
+      "      case 0: list[i] = i * 1000003; break;\n"
+      "      case 1: list[i] = i / 3; break;\n"
+      "      case 2: list[i] = 'element $i'; break;\n"
+      "      default: list[i] = [i, null, true];\n"
+      "    }\n"
+      "  }\n"
+      "  return list;\n"
+      "}\n";
+  const intptr_t kLength = 1000;
+  const intptr_t kNumIterations = 1000;
+  Isolate* isolate = Isolate::Current();
+  Dart_EnterScope();
+  Dart_Handle lib = TestCase::LoadTestScript(kScriptChars, NULL);
+  EXPECT_VALID(lib);
+  Dart_Handle length = Dart_NewInteger(kLength);
+  Dart_Handle list = Dart_Invoke(lib, NewString("getList"), 1, &length);
+  EXPECT_VALID(list);
+  const Object& obj = Object::Handle(isolate, Api::UnwrapHandle(list));
+  Timer timer(true, "Compact message benchmark");
+  timer.Start();
+  for (intptr_t i = 0; i < kNumIterations; i++) {
+    StackZone zone(isolate);
+    HandleScope scope(isolate);
+    uint8_t* buffer = NULL;
+    CompactMessageWriter writer(&buffer, &malloc_allocator);
+    EXPECT(writer.WriteMessage(obj));
+    CompactMessageReader reader(buffer, writer.BytesWritten());
+    EXPECT(reader.ReadMessage() != Object::null());
+    free(buffer);
+  }
+  timer.Stop();
+  Dart_ExitScope();
+  benchmark->set_score(timer.TotalElapsedTime());
+}
+
+}  // namespace dart
@@ -52,7 +52,12 @@ DEFINE_FLAG(int, deoptimization_counter_licm_threshold, 8,
     "How many times we allow deoptimization before we disable LICM.");
 DEFINE_FLAG(bool, use_inlining, true, "Enable call-site inlining");
 DEFINE_FLAG(bool, range_analysis, true, "Enable range analysis");
+DEFINE_FLAG(bool, vectorize_loops, true,
+    "Vectorize loops applying element-wise operations to typed data.");
 DEFINE_FLAG(bool, reorder_basic_blocks, true, "Enable basic-block reordering.");
+DEFINE_FLAG(bool, optimize_when_idle, false,
+    "Defer the optimizing compilation of hot functions until the isolate has "
+    "no messages to handle.");
 DEFINE_FLAG(bool, verify_compiler, false,
     "Enable compiler verification assertions");
 DECLARE_FLAG(bool, print_flow_graph);
@@ -474,6 +479,14 @@ static bool CompileParsedFunctionHelper(ParsedFunction* parsed_function,
           DEBUG_ASSERT(flow_graph->VerifyUseLists());
         }
 
+        if (FLAG_range_analysis &&
+            FLAG_vectorize_loops &&
+            FlowGraphCompiler::SupportsLoopVectorization()) {
+          // Vectorization relies on the ranges of the induction variables.
+          LoopVectorizer::Optimize(flow_graph);
+          DEBUG_ASSERT(flow_graph->VerifyUseLists());
+        }
+
         // Recompute types after code movement was done to ensure correct
         // reaching types for hoisted values.
         FlowGraphTypePropagator::Propagate(flow_graph);
@@ -834,6 +847,71 @@ RawError* Compiler::CompileOptimizedFunction(const Function& function,
 }
 
 
+bool Compiler::QueueOptimizedCompilation(const Function& function) {
+  Isolate* isolate = Isolate::Current();
+  // The queue holds pairs of a function and the code it ran when queued.
+  GrowableObjectArray& queue =
+      GrowableObjectArray::Handle(isolate, isolate->optimization_queue());
+  if (function.is_optimization_queued()) {
+    // The function got hot again before the isolate was idle.
+    return false;
+  }
+  if (queue.IsNull()) {
+    queue = GrowableObjectArray::New(Heap::kOld);
+    isolate->set_optimization_queue(queue.raw());
+  }
+  if (FLAG_trace_compiler) {
+    OS::Print("Queueing optimized compilation of '%s'\n",
+              function.ToFullyQualifiedCString());
+  }
+  queue.Add(function, Heap::kOld);
+  queue.Add(Code::Handle(isolate, function.CurrentCode()), Heap::kOld);
+  function.set_is_optimization_queued(true);
+  return true;
+}
+
+
+RawError* Compiler::CompileQueuedFunction() {
+  Isolate* isolate = Isolate::Current();
+  const GrowableObjectArray& queue =
+      GrowableObjectArray::Handle(isolate, isolate->optimization_queue());
+  if (queue.IsNull()) {
+    return Error::null();
+  }
+  // The functions are compiled in the order in which they got hot, so that
+  // the ones queued first do not wait behind the ones queued since. The
+  // entries before the head are done and dropped with the whole queue once
+  // it is drained.
+  const intptr_t head = isolate->optimization_queue_head();
+  Function& function = Function::Handle(isolate);
+  function ^= queue.At(head);
+  Code& code = Code::Handle(isolate);
+  code ^= queue.At(head + 1);
+  function.set_is_optimization_queued(false);
+  if (head + 2 == queue.Length()) {
+    isolate->set_optimization_queue(GrowableObjectArray::null());
+    isolate->set_optimization_queue_head(0);
+  } else {
+    queue.SetAt(head, Object::null_object());
+    queue.SetAt(head + 1, Object::null_object());
+    isolate->set_optimization_queue_head(head + 2);
+  }
+  // The function may have been optimized, deoptimized or lost its code since
+  // it was queued, or a breakpoint may have been set in it.
+  if ((function.CurrentCode() != code.raw()) ||
+      !function.is_optimizable() ||
+      isolate->debugger()->IsStepping() ||
+      isolate->debugger()->HasBreakpoint(function)) {
+    return Error::null();
+  }
+  const Error& error =
+      Error::Handle(isolate, CompileOptimizedFunction(function));
+  // Reset usage counter for reoptimization.
+  function.set_usage_counter(0);
+  return error.raw();
+}
+
+
 RawError* Compiler::CompileParsedFunction(
     ParsedFunction* parsed_function) {
   Isolate* isolate = Isolate::Current();
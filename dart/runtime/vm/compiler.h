@@ -48,6 +48,18 @@ class Compiler : public AllStatic {
       const Function& function,
       intptr_t osr_id = Isolate::kNoDeoptId);
 
+  // Defers the optimizing compilation of the function until the current
+  // isolate has no messages to handle (see --optimize_when_idle), the
+  // function continuing to run its current code meanwhile. Returns false if
+  // the function is already queued, in which case it should be optimized now.
+  static bool QueueOptimizedCompilation(const Function& function);
+
+  // Generates optimized code for the function which was queued first by the
+  // current isolate, unless its code changed since it was queued.
+  //
+  // Returns Error::null() if there is no compilation error.
+  static RawError* CompileQueuedFunction();
+
   // Generates code for given parsed function (without parsing it again) and
   // sets its code field.
   //
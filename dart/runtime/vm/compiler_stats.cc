@@ -60,6 +60,7 @@ intptr_t CompilerStats::num_tokens_consumed = 0;
 intptr_t CompilerStats::num_token_checks = 0;
 intptr_t CompilerStats::num_tokens_rewind = 0;
 intptr_t CompilerStats::num_tokens_lookahead = 0;
+intptr_t CompilerStats::num_loops_vectorized = 0;
 
 void CompilerStats::Print() {
   if (!FLAG_compiler_stats) {
@@ -130,6 +131,7 @@ void CompilerStats::Print() {
             code_allocated / 1024);
   OS::Print("Code density:       %" Pd " tokens per KB\n",
             num_tokens_total * 1024 / code_allocated);
+  OS::Print("Loops vectorized:   %" Pd "\n", num_loops_vectorized);
 }
 
 }  // namespace dart
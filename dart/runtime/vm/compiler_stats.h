@@ -25,6 +25,7 @@ class CompilerStats : AllStatic {
   static intptr_t num_token_checks;
   static intptr_t num_tokens_rewind;
   static intptr_t num_tokens_lookahead;
+  static intptr_t num_loops_vectorized;
 
   static intptr_t src_length;        // Total number of characters in source.
   static intptr_t code_allocated;    // Bytes allocated for generated code.
@@ -5,7 +5,9 @@
 #include "platform/assert.h"
 #include "vm/class_finalizer.h"
 #include "vm/compiler.h"
+#include "vm/compiler_stats.h"
 #include "vm/dart_api_impl.h"
+#include "vm/flow_graph_compiler.h"
 #include "vm/object.h"
 #include "vm/symbols.h"
 #include "vm/unit_test.h"
@@ -97,4 +99,89 @@ TEST_CASE(EvalExpression) {
   EXPECT_STREQ("Herr Nilsson 100.", val.ToCString());
 }
 
+
+TEST_CASE(CompileQueuedFunction) {
+  const char* kScriptChars =
+            "class A {\n"
+            "  static foo() { return 42; }\n"
+            "  static bar() { return 87; }\n"
+            "}\n";
+  String& url = String::Handle(String::New("dart-test:CompileQueuedFunction"));
+  String& source = String::Handle(String::New(kScriptChars));
+  Script& script = Script::Handle(Script::New(url,
+                                              source,
+                                              RawScript::kScriptTag));
+  Library& lib = Library::Handle(Library::CoreLibrary());
+  EXPECT(CompilerTest::TestCompileScript(lib, script));
+  EXPECT(ClassFinalizer::ProcessPendingClasses());
+  Class& cls = Class::Handle(
+      lib.LookupClass(String::Handle(Symbols::New("A"))));
+  EXPECT(!cls.IsNull());
+  Function& function_foo = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("foo"))));
+  Function& function_bar = Function::Handle(
+      cls.LookupStaticFunction(String::Handle(String::New("bar"))));
+  EXPECT(CompilerTest::TestCompileFunction(function_foo));
+  EXPECT(CompilerTest::TestCompileFunction(function_bar));
+
+  EXPECT(Compiler::QueueOptimizedCompilation(function_foo));
+  EXPECT(Compiler::QueueOptimizedCompilation(function_bar));
+  EXPECT(!function_foo.HasOptimizedCode());
+  EXPECT(!function_bar.HasOptimizedCode());
+  EXPECT(function_foo.is_optimization_queued());
+  EXPECT(function_bar.is_optimization_queued());
+  // A function which gets hot again before the isolate is idle is optimized
+  // right away.
+  EXPECT(!Compiler::QueueOptimizedCompilation(function_foo));
+  EXPECT(Error::Handle(
+      Compiler::CompileOptimizedFunction(function_foo)).IsNull());
+  EXPECT(function_foo.HasOptimizedCode());
+  const Code& code_foo = Code::Handle(function_foo.CurrentCode());
+
+  // The functions are compiled in the order in which they were queued.
+  // Functions whose code changed since they were queued are skipped.
+  EXPECT(Error::Handle(Compiler::CompileQueuedFunction()).IsNull());
+  EXPECT(function_foo.CurrentCode() == code_foo.raw());
+  EXPECT(!function_foo.is_optimization_queued());
+  EXPECT(!function_bar.HasOptimizedCode());
+  EXPECT(Error::Handle(Compiler::CompileQueuedFunction()).IsNull());
+  EXPECT(function_bar.HasOptimizedCode());
+  EXPECT(!function_bar.is_optimization_queued());
+  EXPECT(Isolate::Current()->optimization_queue() ==
+         GrowableObjectArray::null());
+  EXPECT_EQ(0, Isolate::Current()->optimization_queue_head());
+}
+
+
+TEST_CASE(CompileVectorizedLoop) {
+  const char* kScriptChars =
+      "import 'dart:typed_data';\n"
+      "add(Float32List c, Float32List a, Float32List b, int n) {\n"
+      "  for (var i = 0; i < n; i++) c[i] = a[i] + b[i];\n"
+      "}\n"
+      "main() {\n"
+      "  var a = new Float32List(16);\n"
+      "  for (var i = 0; i < 20; i++) add(a, a, a, 16);\n"
+      "}\n";
+  Dart_Handle lib = TestCase::LoadTestScript(kScriptChars, NULL);
+  Dart_Handle result = Dart_Invoke(lib, NewString("main"), 0, NULL);
+  EXPECT_VALID(result);
+  const Library& library = Library::CheckedHandle(Api::UnwrapHandle(lib));
+  const Function& function_add = Function::Handle(
+      library.LookupLocalFunction(String::Handle(Symbols::New("add"))));
+  EXPECT(!function_add.IsNull());
+
+  const bool saved_compiler_stats = FLAG_compiler_stats;
+  FLAG_compiler_stats = true;
+  const intptr_t num_loops_vectorized = CompilerStats::num_loops_vectorized;
+  EXPECT(Error::Handle(
+      Compiler::CompileOptimizedFunction(function_add)).IsNull());
+  EXPECT(function_add.HasOptimizedCode());
+  const intptr_t expected =
+      FlowGraphCompiler::SupportsLoopVectorization() ? 1 : 0;
+  EXPECT_EQ(num_loops_vectorized + expected,
+            CompilerStats::num_loops_vectorized);
+  FLAG_compiler_stats = saved_compiler_stats;
+}
+
 }  // namespace dart
@@ -11,6 +11,7 @@
 #include "vm/freelist.h"
 #include "vm/handles.h"
 #include "vm/heap.h"
+#include "vm/heap_image.h"
 #include "vm/isolate.h"
 #include "vm/object.h"
 #include "vm/object_store.h"
@@ -30,6 +31,7 @@ namespace dart {
 DEFINE_FLAG(bool, heap_profile_initialize, false,
             "Writes a heap profile on isolate initialization.");
 DECLARE_FLAG(bool, print_class_table);
+DECLARE_FLAG(bool, share_snapshot_symbols);
 DECLARE_FLAG(bool, trace_isolates);
 
 Isolate* Dart::vm_isolate_ = NULL;
@@ -93,6 +95,8 @@ const char* Dart::InitOnce(Dart_IsolateCreateCallback create,
   OS::InitOnce();
   VirtualMemory::InitOnce();
   Isolate::InitOnce();
+  ThreadPool::InitOnce();
+  HeapImage::InitOnce();
   PortMap::InitOnce();
   FreeListElement::InitOnce();
   Api::InitOnce();
@@ -204,19 +208,57 @@ RawError* Dart::InitializeIsolate(const uint8_t* snapshot_buffer, void* data) {
       return error.raw();
     }
   } else {
-    // Initialize from snapshot (this should replicate the functionality
-    // of Object::Init(..) in a regular isolate creation path.
-    Object::InitFromSnapshot(isolate);
-
     // TODO(turnidge): Remove once length is not part of the snapshot.
     const Snapshot* snapshot = Snapshot::SetupFromBuffer(snapshot_buffer);
-    ASSERT(snapshot->kind() == Snapshot::kFull);
-    if (FLAG_trace_isolates) {
-      OS::Print("Size of isolate snapshot = %d\n", snapshot->length());
+    const HeapImage* image = NULL;
+    if (snapshot->IsHeapImageSnapshot()) {
+      image = HeapImage::Lookup(snapshot_buffer);
+      if (image == NULL) {
+        const uint8_t* full_snapshot = NULL;
+        HeapImage* read = HeapImage::ReadSnapshot(snapshot, &full_snapshot);
+        if (read != NULL) {
+          image = HeapImage::Add(read);
+        } else {
+          // The image was written by another VM, read the full snapshot it
+          // was captured from instead.
+          snapshot_buffer = full_snapshot;
+          snapshot = Snapshot::SetupFromBuffer(snapshot_buffer);
+        }
+      }
+    } else if (FLAG_clone_isolate_heap) {
+      image = HeapImage::Lookup(snapshot_buffer);
+    }
+    if (image != NULL) {
+      // Copy the heap of the first isolate which read the full snapshot.
+      if (FLAG_trace_isolates) {
+        OS::Print("Size of isolate heap image = %" Pd " KB\n",
+                  (image->SizeInWords() << kWordSizeLog2) / KB);
+      }
+      image->Restore(isolate);
+    } else {
+      // Initialize from snapshot (this should replicate the functionality
+      // of Object::Init(..) in a regular isolate creation path.
+      Object::InitFromSnapshot(isolate);
+
+      ASSERT(snapshot->kind() == Snapshot::kFull);
+      if (FLAG_trace_isolates) {
+        OS::Print("Size of isolate snapshot = %d\n", snapshot->length());
+      }
+      {
+        SharedSymbolsScope shared_symbols(snapshot_buffer);
+        SnapshotReader reader(snapshot->content(), snapshot->length(),
+                              Snapshot::kFull, isolate);
+        reader.ReadFullSnapshot();
+      }
+      // An image referring to symbols shared through the VM isolate heap
+      // could not be written as a heap image snapshot.
+      if (FLAG_clone_isolate_heap && !FLAG_share_snapshot_symbols) {
+        HeapImage* captured = HeapImage::Capture(isolate, snapshot_buffer);
+        if (captured != NULL) {
+          HeapImage::Add(captured);
+        }
+      }
     }
-    SnapshotReader reader(snapshot->content(), snapshot->length(),
-                          Snapshot::kFull, isolate);
-    reader.ReadFullSnapshot();
     if (FLAG_trace_isolates) {
       isolate->heap()->PrintSizes();
       isolate->megamorphic_cache_table()->PrintSizes();
@@ -9,6 +9,7 @@
 #include "platform/assert.h"
 #include "vm/bigint_operations.h"
 #include "vm/class_finalizer.h"
+#include "vm/compact_message.h"
 #include "vm/compiler.h"
 #include "vm/dart.h"
 #include "vm/dart_api_impl.h"
@@ -19,6 +20,7 @@
 #include "vm/exceptions.h"
 #include "vm/flags.h"
 #include "vm/growable_array.h"
+#include "vm/heap_image.h"
 #include "vm/message.h"
 #include "vm/message_handler.h"
 #include "vm/native_entry.h"
@@ -27,6 +29,7 @@
 #include "vm/port.h"
 #include "vm/resolver.h"
 #include "vm/reusable_handles.h"
+#include "vm/script_profile.h"
 #include "vm/stack_frame.h"
 #include "vm/symbols.h"
 #include "vm/timer.h"
@@ -913,6 +916,32 @@ DART_EXPORT Dart_Handle Dart_CreateSnapshot(uint8_t** buffer,
 }
 
 
+DART_EXPORT Dart_Handle Dart_CreateHeapImageSnapshot(const uint8_t* snapshot,
+                                                     uint8_t** buffer,
+                                                     intptr_t* size) {
+  Isolate* isolate = Isolate::Current();
+  DARTSCOPE(isolate);
+  TIMERSCOPE(time_creating_snapshot);
+  if (snapshot == NULL) {
+    RETURN_NULL_ERROR(snapshot);
+  }
+  if (buffer == NULL) {
+    RETURN_NULL_ERROR(buffer);
+  }
+  if (size == NULL) {
+    RETURN_NULL_ERROR(size);
+  }
+  const HeapImage* image = HeapImage::Lookup(snapshot);
+  if ((image == NULL) || !image->is_captured()) {
+    return Api::NewError(
+        "%s expects a full snapshot from which an isolate was created with "
+        "--clone_isolate_heap.", CURRENT_FUNC);
+  }
+  *size = image->WriteSnapshot(buffer, ApiReallocate);
+  return Api::Success();
+}
+
+
 DART_EXPORT Dart_Handle Dart_CreateScriptSnapshot(uint8_t** buffer,
                                                   intptr_t* size) {
   Isolate* isolate = Isolate::Current();
@@ -942,6 +971,50 @@ DART_EXPORT Dart_Handle Dart_CreateScriptSnapshot(uint8_t** buffer,
 }
 
 
+DART_EXPORT Dart_Handle Dart_CreateScriptProfile(uint8_t** buffer,
+                                                 intptr_t* size) {
+  Isolate* isolate = Isolate::Current();
+  DARTSCOPE(isolate);
+  if (buffer == NULL) {
+    RETURN_NULL_ERROR(buffer);
+  }
+  if (size == NULL) {
+    RETURN_NULL_ERROR(size);
+  }
+  const Library& library =
+      Library::Handle(isolate, isolate->object_store()->root_library());
+  if (library.IsNull()) {
+    return
+        Api::NewError("%s expects the isolate to have a script loaded in it.",
+                      CURRENT_FUNC);
+  }
+  *size = ScriptProfile::Write(buffer, ApiReallocate);
+  return Api::Success();
+}
+
+
+DART_EXPORT Dart_Handle Dart_ApplyScriptProfile(const uint8_t* buffer,
+                                                intptr_t size) {
+  Isolate* isolate = Isolate::Current();
+  DARTSCOPE(isolate);
+  if (buffer == NULL) {
+    RETURN_NULL_ERROR(buffer);
+  }
+  const Library& library =
+      Library::Handle(isolate, isolate->object_store()->root_library());
+  if (library.IsNull()) {
+    return
+        Api::NewError("%s expects the isolate to have a script loaded in it.",
+                      CURRENT_FUNC);
+  }
+  if (!ScriptProfile::Apply(buffer, size)) {
+    return Api::NewError("%s expects parameter 'buffer' to be a profile "
+                         "created by Dart_CreateScriptProfile.", CURRENT_FUNC);
+  }
+  return Api::Success();
+}
+
+
 DART_EXPORT void Dart_InterruptIsolate(Dart_Isolate isolate) {
   TRACE_API_CALL(CURRENT_FUNC);
   if (isolate == NULL) {
@@ -1050,12 +1123,19 @@ DART_EXPORT bool Dart_Post(Dart_Port port_id, Dart_Handle handle) {
   Isolate* isolate = Isolate::Current();
   DARTSCOPE(isolate);
   const Object& object = Object::Handle(isolate, Api::UnwrapHandle(handle));
+  Message* message =
+      CompactMessage::New(port_id, object, Message::kNormalPriority);
+  if (message != NULL) {
+    return PortMap::PostMessage(message);
+  }
   uint8_t* data = NULL;
-  MessageWriter writer(&data, &allocator);
+  MessageWriter writer(&data, &allocator, true);
   writer.WriteMessage(object);
   intptr_t len = writer.BytesWritten();
-  return PortMap::PostMessage(new Message(
-      port_id, Message::kIllegalPort, data, len, Message::kNormalPriority));
+  message = new Message(
+      port_id, Message::kIllegalPort, data, len, Message::kNormalPriority);
+  writer.TransferTo(message);
+  return PortMap::PostMessage(message);
 }
 
 
@@ -2679,6 +2759,32 @@ DART_EXPORT Dart_Handle Dart_NewExternalTypedData(
 }
 
 
+DART_EXPORT Dart_Handle Dart_MakeTransferable(
+    Dart_Handle object,
+    void* peer,
+    Dart_WeakPersistentHandleFinalizer callback) {
+  Isolate* isolate = Isolate::Current();
+  DARTSCOPE(isolate);
+  const Object& obj = Object::Handle(isolate, Api::UnwrapHandle(object));
+  if (!obj.IsExternalTypedData()) {
+    RETURN_TYPE_ERROR(isolate, object, 'ExternalTypedData');
+  }
+  if (peer == NULL) {
+    RETURN_NULL_ERROR(peer);
+  }
+  if (callback == NULL) {
+    RETURN_NULL_ERROR(callback);
+  }
+  const ExternalTypedData& array = ExternalTypedData::Cast(obj);
+  if (array.IsTransferable()) {
+    return Api::NewError("%s: the object is already transferable.",
+                         CURRENT_FUNC);
+  }
+  array.MakeTransferable(peer, callback);
+  return Api::Success();
+}
+
+
 DART_EXPORT Dart_Handle Dart_TypedDataAcquireData(Dart_Handle object,
                                                   Dart_TypedData_Type* type,
                                                   void** data,
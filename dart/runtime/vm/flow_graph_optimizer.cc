@@ -6,6 +6,7 @@
 
 #include "vm/bit_vector.h"
 #include "vm/cha.h"
+#include "vm/compiler_stats.h"
 #include "vm/dart_entry.h"
 #include "vm/flow_graph_builder.h"
 #include "vm/flow_graph_compiler.h"
@@ -23,6 +24,8 @@ namespace dart {
 
 DEFINE_FLAG(bool, array_bounds_check_elimination, true,
     "Eliminate redundant bounds checks.");
+DEFINE_FLAG(bool, hoist_bounds_checks, true,
+    "Hoist the bounds checks of induction variables out of loops.");
 DEFINE_FLAG(bool, load_cse, true, "Use redundant load elimination.");
 DEFINE_FLAG(int, max_polymorphic_checks, 4,
     "Maximum number of polymorphic check, otherwise it is megamorphic.");
@@ -41,6 +44,7 @@ DEFINE_FLAG(bool, trace_load_optimization, false,
     "Print live sets for load optimization pass.");
 DEFINE_FLAG(bool, enable_simd_inline, true,
     "Enable inlining of SIMD related method calls.");
+DECLARE_FLAG(int, deoptimization_counter_licm_threshold);
 DECLARE_FLAG(bool, eliminate_type_checks);
 DECLARE_FLAG(bool, enable_type_checks);
 DECLARE_FLAG(bool, trace_type_check_elimination);
@@ -511,7 +515,8 @@ void FlowGraphOptimizer::InsertConversion(Representation from,
   Definition* converted = NULL;
   if ((from == kTagged) && (to == kUnboxedMint)) {
     ASSERT((deopt_target != NULL) ||
-           (use->Type()->ToCid() == kDoubleCid));
+           (use->Type()->ToCid() == kSmiCid) ||
+           (use->Type()->ToCid() == kMintCid));
     const intptr_t deopt_id = (deopt_target != NULL) ?
         deopt_target->DeoptimizationTarget() : Isolate::kNoDeoptId;
     converted = new UnboxIntegerInstr(use->CopyWithType(), deopt_id);
@@ -641,6 +646,29 @@ void FlowGraphOptimizer::InsertConversionsFor(Definition* def) {
 }
 
 
+// Returns true if the phi merges unboxed mints with smis and mints, all of
+// which can be unboxed in the predecessors without deoptimization. Only
+// done on x64, ia32 keeps the phis of mint operations boxed.
+static bool CanUnboxMintPhi(PhiInstr* phi) {
+#if defined(TARGET_ARCH_X64)
+  if (!FlowGraphCompiler::SupportsUnboxedMints()) return false;
+  bool has_unboxed_mint_input = false;
+  for (intptr_t i = 0; i < phi->InputCount(); i++) {
+    Value* input = phi->InputAt(i);
+    if (input->definition()->representation() == kUnboxedMint) {
+      has_unboxed_mint_input = true;
+    } else {
+      const intptr_t cid = input->Type()->ToCid();
+      if ((cid != kSmiCid) && (cid != kMintCid)) return false;
+    }
+  }
+  return has_unboxed_mint_input;
+#else
+  return false;
+#endif
+}
+
+
 // Returns true if phi's representation was changed.
 static bool UnboxPhi(PhiInstr* phi) {
   Representation current = phi->representation();
@@ -660,6 +688,11 @@ static bool UnboxPhi(PhiInstr* phi) {
         unboxed = kUnboxedInt32x4;
       }
       break;
+    default:
+      if (CanUnboxMintPhi(phi)) {
+        unboxed = kUnboxedMint;
+      }
+      break;
   }
 
   if (unboxed != current) {
@@ -673,7 +706,7 @@ static bool UnboxPhi(PhiInstr* phi) {
 
 void FlowGraphOptimizer::SelectRepresentations() {
   // Convervatively unbox all phis that were proven to be of Double,
-  // Float32x4, or Int32x4 type.
+  // Float32x4, or Int32x4 type, and the phis of unboxed mint operations.
   for (intptr_t i = 0; i < block_order_.length(); ++i) {
     JoinEntryInstr* join_entry = block_order_[i]->AsJoinEntry();
     if (join_entry != NULL) {
@@ -914,6 +947,13 @@ static bool CanUnboxInt32() {
 }
 
 
+static bool CanUnboxMintMultiplication() {
+  // Only 64-bit platforms multiply unboxed mints, with a single instruction
+  // which sets the overflow flag.
+  return (kSmiBits > 32) && FlowGraphCompiler::SupportsUnboxedMints();
+}
+
+
 static intptr_t MethodKindToCid(MethodRecognizer::Kind kind) {
   switch (kind) {
     case MethodRecognizer::kImmutableArrayGetIndexed:
@@ -1221,9 +1261,10 @@ bool FlowGraphOptimizer::TryInlineRecognizedMethod(intptr_t receiver_cid,
     case MethodRecognizer::kUint32ArraySetIndexed:
       if (!CanUnboxInt32()) return false;
       // Check that value is always smi or mint, if the platform has unboxed
-      // mints (ia32 with at least SSE 4.1).
+      // mints and its smis are too small to hold all int32 and uint32 values
+      // (ia32 with at least SSE 4.1).
       value_check = ic_data.AsUnaryClassChecksForArgNr(2);
-      if (FlowGraphCompiler::SupportsUnboxedMints()) {
+      if ((kSmiBits < 32) && FlowGraphCompiler::SupportsUnboxedMints()) {
         if (!HasOnlySmiOrMint(value_check)) {
           return false;
         }
@@ -1639,10 +1680,19 @@ bool FlowGraphOptimizer::TryReplaceWithBinaryOp(InstanceCallInstr* call,
     case Token::kMUL:
       if (HasOnlyTwoOf(ic_data, kSmiCid)) {
         // Don't generate smi code if the IC data is marked because of an
+        // overflow, nor mint code if the mint result overflowed as well.
+        if (ic_data.deopt_reason() == kDeoptBinaryMintOp) return false;
+        if (ic_data.deopt_reason() == kDeoptBinarySmiOp) {
+          if (!CanUnboxMintMultiplication()) return false;
+          operands_type = kMintCid;
+        } else {
+          operands_type = kSmiCid;
+        }
+      } else if (HasTwoMintOrSmi(ic_data) && CanUnboxMintMultiplication()) {
+        // Don't generate mint code if the IC data is marked because of an
         // overflow.
-        // TODO(fschneider): Add unboxed mint multiplication.
-        if (ic_data.deopt_reason() == kDeoptBinarySmiOp) return false;
-        operands_type = kSmiCid;
+        if (ic_data.deopt_reason() == kDeoptBinaryMintOp) return false;
+        operands_type = kMintCid;
       } else if (ShouldSpecializeForDouble(ic_data)) {
         operands_type = kDoubleCid;
       } else if (HasOnlyTwoOf(ic_data, kFloat32x4Cid)) {
@@ -3570,6 +3620,17 @@ bool FlowGraphOptimizer::TryInlineInstanceSetter(InstanceCallInstr* instr,
 }
 
 
+static BlockEntryInstr* FindPreHeader(BlockEntryInstr* header) {
+  for (intptr_t j = 0; j < header->PredecessorCount(); ++j) {
+    BlockEntryInstr* candidate = header->PredecessorAt(j);
+    if (header->dominator() == candidate) {
+      return candidate;
+    }
+  }
+  return NULL;
+}
+
+
 // Range analysis for smi values.
 class RangeAnalysis : public ValueObject {
  public:
@@ -3648,6 +3709,13 @@ class RangeAnalysis : public ValueObject {
   // unconstrained definitions.
   void RemoveConstraints();
 
+  // Replace the bounds checks of induction variables in loops by checks of
+  // their limits in the loop pre-headers.
+  void HoistBoundsChecks();
+  void InsertHoistedBoundsCheck(BlockEntryInstr* pre_header,
+                                Definition* length,
+                                Definition* limit);
+
   FlowGraph* flow_graph_;
 
   GrowableArray<Definition*> smi_values_;  // Value that are known to be smi.
@@ -3673,6 +3741,15 @@ void RangeAnalysis::Analyze() {
   InsertConstraints();
   InferRanges();
   RemoveConstraints();
+  // Hoisted checks deoptimize to the loop pre-header, which is only possible
+  // as long as LICM is.
+  if (FLAG_array_bounds_check_elimination &&
+      FLAG_hoist_bounds_checks &&
+      flow_graph_->is_licm_allowed() &&
+      (flow_graph_->parsed_function().function().deoptimization_counter() <
+       FLAG_deoptimization_counter_licm_threshold)) {
+    HoistBoundsChecks();
+  }
 }
 
 
@@ -4155,6 +4232,134 @@ void RangeAnalysis::RemoveConstraints() {
 }
 
 
+// Returns true if the block checks the class of the definition.
+static bool IsCheckedIn(BlockEntryInstr* block, Definition* defn) {
+  for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+    Instruction* current = it.Current();
+    if ((current->IsCheckSmi() || current->IsCheckClass()) &&
+        (current->InputAt(0)->definition() == defn)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// Every bounds check of the form CheckArrayBound(length, i) in the body of a
+// loop
+//
+//   for (var i = start; i < limit; ...) { ... }
+//
+// where i is a non-negative induction variable and length and limit are loop
+// invariant only passes if i < length. Since i < limit in the body, a single
+// check of limit <= length before the loop makes them redundant.
+void RangeAnalysis::HoistBoundsChecks() {
+  const ZoneGrowableArray<BlockEntryInstr*>& loop_headers =
+      flow_graph_->loop_headers();
+  for (intptr_t i = 0; i < loop_headers.length(); ++i) {
+    BlockEntryInstr* header = loop_headers[i];
+    BlockEntryInstr* pre_header = FindPreHeader(header);
+    if (pre_header == NULL) continue;
+
+    BranchInstr* branch = header->last_instruction()->AsBranch();
+    if (branch == NULL) continue;
+    RelationalOpInstr* compare = branch->comparison()->AsRelationalOp();
+    if ((compare == NULL) || (compare->operation_cid() != kSmiCid)) continue;
+    Value* index = NULL;
+    Value* limit = NULL;
+    if (compare->kind() == Token::kLT) {
+      index = compare->left();
+      limit = compare->right();
+    } else if (compare->kind() == Token::kGT) {
+      index = compare->right();
+      limit = compare->left();
+    } else {
+      continue;
+    }
+    PhiInstr* phi = index->definition()->AsPhi();
+    if ((phi == NULL) ||
+        (phi->block() != header) ||
+        (Range::ConstantMin(phi->range()).value() < 0)) {
+      continue;
+    }
+    // The limit has to be a smi before the loop, not only after checks in the
+    // header.
+    if ((limit->Type()->ToCid() != kSmiCid) ||
+        !limit->definition()->GetBlock()->Dominates(pre_header) ||
+        IsCheckedIn(header, limit->definition())) {
+      continue;
+    }
+    BlockEntryInstr* body = branch->true_successor();
+    if (!header->loop_info()->Contains(body->preorder_number())) continue;
+
+    GrowableArray<Definition*> hoisted_lengths;
+    for (BitVector::Iterator loop_it(header->loop_info());
+         !loop_it.Done();
+         loop_it.Advance()) {
+      BlockEntryInstr* block = flow_graph_->preorder()[loop_it.Current()];
+      if (!body->Dominates(block)) continue;
+      for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+        CheckArrayBoundInstr* check = it.Current()->AsCheckArrayBound();
+        if ((check == NULL) ||
+            (check->index()->definition() != phi) ||
+            !check->length()->definition()->GetBlock()->Dominates(
+                pre_header)) {
+          continue;
+        }
+        Definition* length = check->length()->definition();
+        bool is_hoisted = false;
+        for (intptr_t j = 0; j < hoisted_lengths.length(); ++j) {
+          if (hoisted_lengths[j] == length) {
+            is_hoisted = true;
+            break;
+          }
+        }
+        if (!is_hoisted) {
+          InsertHoistedBoundsCheck(pre_header, length, limit->definition());
+          hoisted_lengths.Add(length);
+        }
+        if (FLAG_trace_range_analysis) {
+          OS::Print("Hoisting bounds check of v%" Pd " from B%" Pd
+                    " to B%" Pd "\n",
+                    phi->ssa_temp_index(),
+                    block->block_id(),
+                    pre_header->block_id());
+        }
+        it.RemoveCurrentFromGraph();
+      }
+    }
+  }
+}
+
+
+// Checks that 0 <= limit <= length by checking limit against length + 1, and
+// deoptimizes to the loop entry otherwise. Like other instructions hoisted by
+// LICM the check can fail even if the loop does not run, e.g. when limit is
+// negative, in which case the function is eventually recompiled without LICM.
+void RangeAnalysis::InsertHoistedBoundsCheck(BlockEntryInstr* pre_header,
+                                             Definition* length,
+                                             Definition* limit) {
+  GotoInstr* last = pre_header->last_instruction()->AsGoto();
+  ASSERT(last != NULL);
+  BinarySmiOpInstr* bound = new BinarySmiOpInstr(
+      Token::kADD,
+      new Value(length),
+      new Value(flow_graph_->GetConstant(Smi::Handle(Smi::New(1)))),
+      Isolate::kNoDeoptId);
+  if (Range::ConstantMax(length->range()).value() < Smi::kMaxValue) {
+    bound->set_overflow(false);
+  }
+  flow_graph_->InsertBefore(last, bound, NULL, Definition::kValue);
+  bound->InheritDeoptTarget(last);
+  CheckArrayBoundInstr* check =
+      new CheckArrayBoundInstr(new Value(bound),
+                               new Value(limit),
+                               Isolate::kNoDeoptId);
+  flow_graph_->InsertBefore(last, check, NULL, Definition::kEffect);
+  check->InheritDeoptTarget(last);
+}
+
+
 void FlowGraphOptimizer::InferSmiRanges() {
   RangeAnalysis range_analysis(flow_graph_);
   range_analysis.Analyze();
@@ -4227,17 +4432,6 @@ void TryCatchAnalyzer::Optimize(FlowGraph* flow_graph) {
 }
 
 
-static BlockEntryInstr* FindPreHeader(BlockEntryInstr* header) {
-  for (intptr_t j = 0; j < header->PredecessorCount(); ++j) {
-    BlockEntryInstr* candidate = header->PredecessorAt(j);
-    if (header->dominator() == candidate) {
-      return candidate;
-    }
-  }
-  return NULL;
-}
-
-
 LICM::LICM(FlowGraph* flow_graph) : flow_graph_(flow_graph) {
   ASSERT(flow_graph->is_licm_allowed());
 }
@@ -4384,6 +4578,271 @@ void LICM::Optimize() {
 }
 
 
+// Returns kDoubleCid for typed data holding single precision floats,
+// kSmiCid for typed data holding 32-bit integers and kIllegalCid for other
+// classes. Only the elements of the same kind can be processed together.
+static intptr_t VectorElementCid(intptr_t class_id) {
+  switch (class_id) {
+    case kTypedDataFloat32ArrayCid:
+      return kDoubleCid;
+    case kTypedDataInt32ArrayCid:
+    case kTypedDataUint32ArrayCid:
+      return kSmiCid;
+    default:
+      return kIllegalCid;
+  }
+}
+
+
+static bool IsLoopInvariant(Definition* defn, BlockEntryInstr* pre_header) {
+  return defn->GetBlock()->Dominates(pre_header);
+}
+
+
+// Returns true if the access of typed data can be vectorized: the array is
+// loop invariant and not external and the element is the one at the index.
+static bool IsVectorizableAccess(Value* array,
+                                 Value* index,
+                                 intptr_t class_id,
+                                 PhiInstr* phi,
+                                 BlockEntryInstr* pre_header) {
+  return (VectorElementCid(class_id) != kIllegalCid) &&
+         (index->definition() == phi) &&
+         (array->definition()->representation() == kTagged) &&
+         IsLoopInvariant(array->definition(), pre_header);
+}
+
+
+static bool IsIncrementByOne(BinarySmiOpInstr* op, PhiInstr* phi) {
+  if (op->op_kind() != Token::kADD) return false;
+  Value* step = NULL;
+  if (op->left()->definition() == phi) {
+    step = op->right();
+  } else if (op->right()->definition() == phi) {
+    step = op->left();
+  } else {
+    return false;
+  }
+  return step->BindsToConstant() &&
+         step->BoundConstant().IsSmi() &&
+         (Smi::Cast(step->BoundConstant()).Value() == 1);
+}
+
+
+static bool IsVectorizableOp(Definition* defn, intptr_t element_cid) {
+  if (element_cid == kDoubleCid) {
+    if (!defn->IsBinaryDoubleOp()) return false;
+    switch (defn->AsBinaryDoubleOp()->op_kind()) {
+      case Token::kADD:
+      case Token::kSUB:
+      case Token::kMUL:
+      case Token::kDIV:
+        return true;
+      default:
+        return false;
+    }
+  }
+  ASSERT(element_cid == kSmiCid);
+  if (!defn->IsBinarySmiOp()) return false;
+  switch (defn->AsBinarySmiOp()->op_kind()) {
+    case Token::kADD:
+    case Token::kSUB:
+    case Token::kBIT_AND:
+    case Token::kBIT_OR:
+    case Token::kBIT_XOR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+void LoopVectorizer::Optimize(FlowGraph* flow_graph) {
+  const ZoneGrowableArray<BlockEntryInstr*>& loop_headers =
+      flow_graph->loop_headers();
+  for (intptr_t i = 0; i < loop_headers.length(); ++i) {
+    if (TryVectorize(flow_graph, loop_headers[i])) {
+      if (FLAG_compiler_stats) {
+        CompilerStats::num_loops_vectorized++;
+      }
+      if (FLAG_trace_optimization) {
+        OS::Print("Vectorized loop B%" Pd "\n", loop_headers[i]->block_id());
+      }
+    }
+  }
+}
+
+
+// Matches loops of the form
+//
+//   for (var i = start; i < n; i++) dest[i] = left[i] op right[i];
+//
+// after inlining of the typed data accesses, and inserts a
+// VectorizedLoopInstr running their first iterations into the pre-header.
+// Every iteration which the vectorized loop runs would have passed the bounds
+// checks of the original loop, which continues at the index where the
+// vectorized loop stopped.
+bool LoopVectorizer::TryVectorize(FlowGraph* flow_graph,
+                                  BlockEntryInstr* header) {
+  JoinEntryInstr* join = header->AsJoinEntry();
+  if ((join == NULL) || (join->PredecessorCount() != 2)) return false;
+  BlockEntryInstr* pre_header = FindPreHeader(header);
+  if (pre_header == NULL) return false;
+
+  // The loop consists of the header and a single body block.
+  BlockEntryInstr* body = NULL;
+  for (BitVector::Iterator it(header->loop_info()); !it.Done(); it.Advance()) {
+    BlockEntryInstr* block = flow_graph->preorder()[it.Current()];
+    if (block == header) continue;
+    if (body != NULL) return false;
+    body = block;
+  }
+  if (body == NULL) return false;
+
+  // The header only checks for interrupts and compares its single phi, a
+  // non-negative induction variable, with a loop invariant limit.
+  PhiInstr* index = NULL;
+  for (PhiIterator it(join); !it.Done(); it.Advance()) {
+    if (index != NULL) return false;
+    index = it.Current();
+  }
+  if ((index == NULL) || (Range::ConstantMin(index->range()).value() < 0)) {
+    return false;
+  }
+  for (ForwardInstructionIterator it(header); !it.Done(); it.Advance()) {
+    if (!it.Current()->IsCheckStackOverflow() && !it.Current()->IsBranch()) {
+      return false;
+    }
+  }
+  BranchInstr* branch = header->last_instruction()->AsBranch();
+  if ((branch == NULL) || (branch->true_successor() != body)) return false;
+  RelationalOpInstr* compare = branch->comparison()->AsRelationalOp();
+  if ((compare == NULL) || (compare->operation_cid() != kSmiCid)) {
+    return false;
+  }
+  Value* limit = NULL;
+  if ((compare->kind() == Token::kLT) &&
+      (compare->left()->definition() == index)) {
+    limit = compare->right();
+  } else if ((compare->kind() == Token::kGT) &&
+             (compare->right()->definition() == index)) {
+    limit = compare->left();
+  } else {
+    return false;
+  }
+  if ((limit->Type()->ToCid() != kSmiCid) ||
+      !IsLoopInvariant(limit->definition(), pre_header)) {
+    return false;
+  }
+
+  // The back edge increments the index by one.
+  const intptr_t pre_header_index = join->IndexOfPredecessor(pre_header);
+  BinarySmiOpInstr* increment =
+      index->InputAt(1 - pre_header_index)->definition()->AsBinarySmiOp();
+  if ((increment == NULL) ||
+      (increment->GetBlock() != body) ||
+      !IsIncrementByOne(increment, index)) {
+    return false;
+  }
+
+  // The body only checks the bounds of, loads and stores the elements at the
+  // index, computes the stored value and increments the index.
+  GrowableArray<Definition*> lengths;
+  StoreIndexedInstr* store = NULL;
+  intptr_t load_count = 0;
+  intptr_t op_count = 0;
+  for (ForwardInstructionIterator it(body); !it.Done(); it.Advance()) {
+    Instruction* current = it.Current();
+    if ((current == increment) || current->IsGoto()) continue;
+    if (current->IsCheckArrayBound()) {
+      CheckArrayBoundInstr* check = current->AsCheckArrayBound();
+      if ((check->index()->definition() != index) ||
+          !IsLoopInvariant(check->length()->definition(), pre_header)) {
+        return false;
+      }
+      lengths.Add(check->length()->definition());
+    } else if (current->IsLoadIndexed()) {
+      LoadIndexedInstr* load = current->AsLoadIndexed();
+      if (!IsVectorizableAccess(load->array(),
+                                load->index(),
+                                load->class_id(),
+                                index,
+                                pre_header)) {
+        return false;
+      }
+      load_count++;
+    } else if (current->IsStoreIndexed()) {
+      if (store != NULL) return false;
+      store = current->AsStoreIndexed();
+      if (!IsVectorizableAccess(store->array(),
+                                store->index(),
+                                store->class_id(),
+                                index,
+                                pre_header)) {
+        return false;
+      }
+    } else if (current->IsBinaryDoubleOp() || current->IsBinarySmiOp()) {
+      op_count++;
+    } else {
+      return false;
+    }
+  }
+  if (store == NULL) return false;
+
+  // The stored value is an element or the result of an operation on two
+  // elements of the same kind as the stored one.
+  const intptr_t element_cid = VectorElementCid(store->class_id());
+  Definition* value = store->value()->definition();
+  Token::Kind op_kind = Token::kILLEGAL;
+  LoadIndexedInstr* left = NULL;
+  LoadIndexedInstr* right = NULL;
+  if (value->IsLoadIndexed()) {
+    left = right = value->AsLoadIndexed();
+  } else if (IsVectorizableOp(value, element_cid)) {
+    op_kind = value->IsBinaryDoubleOp() ? value->AsBinaryDoubleOp()->op_kind()
+                                        : value->AsBinarySmiOp()->op_kind();
+    left = value->InputAt(0)->definition()->AsLoadIndexed();
+    right = value->InputAt(1)->definition()->AsLoadIndexed();
+  }
+  if ((left == NULL) || (right == NULL) ||
+      (left->GetBlock() != body) || (right->GetBlock() != body) ||
+      (VectorElementCid(left->class_id()) != element_cid) ||
+      (VectorElementCid(right->class_id()) != element_cid) ||
+      (load_count != ((left == right) ? 1 : 2)) ||
+      (op_count != ((op_kind == Token::kILLEGAL) ? 0 : 1))) {
+    return false;
+  }
+
+  // Stop the vectorized loop where the original one would, or where its
+  // bounds checks would fail.
+  Instruction* last = pre_header->last_instruction();
+  Definition* end = limit->definition();
+  for (intptr_t i = 0; i < lengths.length(); ++i) {
+    if (lengths[i] == limit->definition()) continue;
+    MathMinMaxInstr* min = new MathMinMaxInstr(MethodRecognizer::kMathMin,
+                                               new Value(end),
+                                               new Value(lengths[i]),
+                                               Isolate::kNoDeoptId,
+                                               kSmiCid);
+    flow_graph->InsertBefore(last, min, NULL, Definition::kValue);
+    end = min;
+  }
+
+  Value* start = index->InputAt(pre_header_index);
+  VectorizedLoopInstr* loop =
+      new VectorizedLoopInstr(op_kind,
+                              store->class_id(),
+                              new Value(start->definition()),
+                              new Value(end),
+                              new Value(store->array()->definition()),
+                              new Value(left->array()->definition()),
+                              new Value(right->array()->definition()));
+  flow_graph->InsertBefore(last, loop, NULL, Definition::kValue);
+  start->BindTo(loop);
+  return true;
+}
+
+
 static bool IsLoadEliminationCandidate(Definition* def) {
   return def->IsLoadField()
       || def->IsLoadIndexed()
@@ -4876,8 +5335,8 @@ class AliasedSet : public ZoneAllocated {
 
   // Returns true if the result of AllocateObject can be aliased by some
   // other SSA variable and false otherwise. Currently simply checks if
-  // this value is stored in a field, escapes to another function or
-  // participates in a phi.
+  // this value is stored in a field or an array, escapes to another function
+  // or participates in a phi.
   static bool CanBeAliased(AllocateObjectInstr* alloc) {
     if (alloc->identity() == AllocateObjectInstr::kUnknown) {
       bool escapes = false;
@@ -4888,6 +5347,8 @@ class AliasedSet : public ZoneAllocated {
         if (instr->IsPushArgument() ||
             (instr->IsStoreVMField() && (use->use_index() != 1)) ||
             (instr->IsStoreInstanceField() && (use->use_index() != 0)) ||
+            (instr->IsStoreIndexed() &&
+             (use->use_index() == StoreIndexedInstr::kValuePos)) ||
             instr->IsStoreStaticField() ||
             instr->IsPhi() ||
             instr->IsAssertAssignable() ||
@@ -6988,6 +7449,11 @@ void ConstantPropagator::VisitMergedMath(MergedMathInstr* instr) {
 }
 
 
+void ConstantPropagator::VisitVectorizedLoop(VectorizedLoopInstr* instr) {
+  SetValue(instr, non_constant_);
+}
+
+
 void ConstantPropagator::VisitConstant(ConstantInstr* instr) {
   SetValue(instr, instr->value());
 }
@@ -238,6 +238,17 @@ class LICM : public ValueObject {
 };
 
 
+// Vectorization of loops applying an element-wise operation to typed data
+// using packed SSE instructions. See VectorizedLoopInstr.
+class LoopVectorizer : public AllStatic {
+ public:
+  static void Optimize(FlowGraph* flow_graph);
+
+ private:
+  static bool TryVectorize(FlowGraph* flow_graph, BlockEntryInstr* header);
+};
+
+
 // A simple common subexpression elimination based
 // on the dominator tree.
 class DominatorBasedCSE : public AllStatic {
@@ -1219,6 +1219,11 @@ CompileType InvokeMathCFunctionInstr::ComputeType() const {
 }
 
 
+CompileType VectorizedLoopInstr::ComputeType() const {
+  return CompileType::FromCid(kSmiCid);
+}
+
+
 CompileType MergedMathInstr::ComputeType() const {
   if (kind() == MergedMathInstr::kTruncDivMod) {
     return CompileType::FromCid(kArrayCid);
@@ -88,6 +88,17 @@ uword FreeList::TryAllocate(intptr_t size) {
 }
 
 
+uword FreeList::TryAllocateLarge(intptr_t* size) {
+  FreeListElement* element = free_lists_[kNumLists];
+  if (element == NULL) {
+    return 0;
+  }
+  free_lists_[kNumLists] = element->next();
+  *size = element->Size();
+  return reinterpret_cast<uword>(element);
+}
+
+
 void FreeList::Free(uword addr, intptr_t size) {
   intptr_t index = IndexForSize(size);
   FreeListElement* element = FreeListElement::AsElement(addr, size);
@@ -103,6 +114,26 @@ void FreeList::Reset() {
 }
 
 
+void FreeList::Merge(FreeList* other) {
+  for (int i = 0; i < (kNumLists + 1); i++) {
+    FreeListElement* head = other->free_lists_[i];
+    if (head == NULL) {
+      continue;
+    }
+    FreeListElement* tail = head;
+    while (tail->next() != NULL) {
+      tail = tail->next();
+    }
+    if ((free_lists_[i] == NULL) && (i != kNumLists)) {
+      free_map_.Set(i, true);
+    }
+    tail->set_next(free_lists_[i]);
+    free_lists_[i] = head;
+  }
+  other->Reset();
+}
+
+
 intptr_t FreeList::IndexForSize(intptr_t size) {
   ASSERT(size >= kObjectAlignment);
   ASSERT(Utils::IsAligned(size, kObjectAlignment));
@@ -78,8 +78,16 @@ class FreeList {
   uword TryAllocate(intptr_t size);
   void Free(uword addr, intptr_t size);
 
+  // Removes the first element of the list of large elements without splitting
+  // it. Returns its address and stores its size in 'size', or returns 0 if
+  // there are no large elements.
+  uword TryAllocateLarge(intptr_t* size);
+
   void Reset();
 
+  // Moves all elements of 'other' into this free list. 'other' is left empty.
+  void Merge(FreeList* other);
+
   intptr_t Length(int index) const;
 
   void Print() const;
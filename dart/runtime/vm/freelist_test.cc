@@ -50,4 +50,33 @@ TEST_CASE(FreeList) {
   delete free_list;
 }
 
+
+TEST_CASE(FreeListMerge) {
+  FreeList* free_list = new FreeList();
+  FreeList* other = new FreeList();
+  intptr_t kBlobSize = 64 * KB;
+  intptr_t kSmallObjectSize = 4 * kWordSize;
+  intptr_t kLargeObjectSize = 8 * KB;
+  uword blob = reinterpret_cast<uword>(malloc(kBlobSize));
+  // A small and a large element in each list.
+  free_list->Free(blob, kSmallObjectSize);
+  free_list->Free(blob + kSmallObjectSize, kLargeObjectSize);
+  uword other_start = blob + kSmallObjectSize + kLargeObjectSize;
+  other->Free(other_start, kSmallObjectSize);
+  other->Free(other_start + kSmallObjectSize, kLargeObjectSize);
+  free_list->Merge(other);
+  // The merged elements are found first, the other list is empty.
+  EXPECT(other->TryAllocate(kSmallObjectSize) == 0);
+  EXPECT_EQ(other_start, free_list->TryAllocate(kSmallObjectSize));
+  EXPECT_EQ(blob, free_list->TryAllocate(kSmallObjectSize));
+  EXPECT_EQ(other_start + kSmallObjectSize,
+            free_list->TryAllocate(kLargeObjectSize));
+  EXPECT_EQ(blob + kSmallObjectSize, free_list->TryAllocate(kLargeObjectSize));
+  EXPECT(free_list->TryAllocate(kSmallObjectSize) == 0);
+  // Delete the memory associated with the test.
+  free(reinterpret_cast<void*>(blob));
+  delete other;
+  delete free_list;
+}
+
 }  // namespace dart
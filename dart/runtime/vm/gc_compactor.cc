@@ -0,0 +1,358 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/gc_compactor.h"
+
+#include "vm/dart_api_state.h"
+#include "vm/freelist.h"
+#include "vm/gc_sweeper.h"
+#include "vm/heap.h"
+#include "vm/isolate.h"
+#include "vm/object_id_ring.h"
+#include "vm/pages.h"
+#include "vm/raw_object.h"
+#include "vm/stack_frame.h"
+#include "vm/store_buffer.h"
+#include "vm/visitor.h"
+#include "vm/weak_table.h"
+
+namespace dart {
+
+DEFINE_FLAG(int, compaction_threshold, 0,
+            "Evacuate sparsely used old space pages in a mark-sweep when at "
+            "least this percentage of the old generation is free after "
+            "marking, 0 disables compaction.");
+
+// The header of an evacuated object holds its new address tagged with the
+// watched bit and a clear mark bit, which no object reachable after marking
+// has. Its second word holds its size, so that a page which could only be
+// partially evacuated can still be walked.
+static const uword kForwardingMask =
+    (1 << RawObject::kWatchedBit) | (1 << RawObject::kMarkBit);
+static const uword kForwarded = (1 << RawObject::kWatchedBit);
+
+
+static inline bool IsForwarded(uword header) {
+  return (header & kForwardingMask) == kForwarded;
+}
+
+
+static inline uword ForwardedAddr(uword header) {
+  return header & ~kForwardingMask;
+}
+
+
+static inline void ForwardPointer(RawObject** p) {
+  RawObject* raw_obj = *p;
+  if (!raw_obj->IsHeapObject() || raw_obj->IsNewObject()) {
+    return;
+  }
+  uword header = *reinterpret_cast<uword*>(RawObject::ToAddr(raw_obj));
+  if (IsForwarded(header)) {
+    *p = RawObject::FromAddr(ForwardedAddr(header));
+  }
+}
+
+
+class ForwardPointersVisitor : public ObjectPointerVisitor {
+ public:
+  explicit ForwardPointersVisitor(Isolate* isolate)
+      : ObjectPointerVisitor(isolate) { }
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    for (RawObject** current = first; current <= last; current++) {
+      ForwardPointer(current);
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ForwardPointersVisitor);
+};
+
+
+class ForwardHandlesVisitor : public HandleVisitor {
+ public:
+  ForwardHandlesVisitor() { }
+
+  void VisitHandle(uword addr) {
+    FinalizablePersistentHandle* handle =
+        reinterpret_cast<FinalizablePersistentHandle*>(addr);
+    ForwardPointer(handle->raw_addr());
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ForwardHandlesVisitor);
+};
+
+
+static intptr_t MarkedSize(HeapPage* page) {
+  intptr_t marked_size = 0;
+  uword current = page->object_start();
+  uword end = page->object_end();
+  while (current < end) {
+    RawObject* raw_obj = RawObject::FromAddr(current);
+    intptr_t size = raw_obj->Size();
+    if (raw_obj->IsMarked()) {
+      marked_size += size;
+    }
+    current += size;
+  }
+  ASSERT(current == end);
+  return marked_size;
+}
+
+
+// Visits the pointers of the objects left on a partially evacuated page.
+static void VisitRetainedPage(HeapPage* page, ObjectPointerVisitor* visitor) {
+  uword current = page->object_start();
+  uword end = page->object_end();
+  while (current < end) {
+    uword* header = reinterpret_cast<uword*>(current);
+    if (IsForwarded(header[0])) {
+      current += header[1];
+      continue;
+    }
+    RawObject* raw_obj = RawObject::FromAddr(current);
+    if (raw_obj->IsMarked()) {
+      current += raw_obj->VisitPointers(visitor);
+    } else {
+      current += raw_obj->Size();
+    }
+  }
+  ASSERT(current == end);
+}
+
+
+// Turns the evacuated objects of a partially evacuated page into free list
+// elements, which the sweeper will reclaim.
+static void ClearForwardedObjects(HeapPage* page) {
+  uword current = page->object_start();
+  uword end = page->object_end();
+  while (current < end) {
+    uword* header = reinterpret_cast<uword*>(current);
+    if (IsForwarded(header[0])) {
+      intptr_t size = header[1];
+      FreeListElement::AsElement(current, size);
+      current += size;
+    } else {
+      current += RawObject::FromAddr(current)->Size();
+    }
+  }
+  ASSERT(current == end);
+}
+
+
+bool GCCompactor::ShouldCompact(intptr_t capacity_in_words,
+                                intptr_t marked_words) {
+  if ((FLAG_compaction_threshold <= 0) || (capacity_in_words == 0)) {
+    return false;
+  }
+  intptr_t free_words = capacity_in_words - marked_words;
+  return (free_words * 100) >= (FLAG_compaction_threshold * capacity_in_words);
+}
+
+
+bool GCCompactor::SelectCandidates() {
+  ASSERT(candidates_ == NULL);
+  HeapPage* tail = NULL;
+  HeapPage* prev_page = NULL;
+  HeapPage* page = page_space_->pages_;
+  while (page != NULL) {
+    HeapPage* next_page = page->next();
+    intptr_t page_size = page->object_end() - page->object_start();
+    if ((page->type() == HeapPage::kData) &&
+        ((MarkedSize(page) * 100) < (kCandidateOccupancy * page_size))) {
+      // Remove the page from the page space.
+      if (prev_page != NULL) {
+        prev_page->set_next(next_page);
+      } else {
+        page_space_->pages_ = next_page;
+      }
+      if (page == page_space_->pages_tail_) {
+        page_space_->pages_tail_ = prev_page;
+      }
+      page->set_next(NULL);
+      if (tail == NULL) {
+        candidates_ = page;
+      } else {
+        tail->set_next(page);
+      }
+      tail = page;
+      num_candidates_++;
+    } else {
+      prev_page = page;
+    }
+    page = next_page;
+  }
+  return candidates_ != NULL;
+}
+
+
+uword GCCompactor::TryAllocateCopy(intptr_t size) {
+  FreeList* freelist = &page_space_->freelist_[HeapPage::kData];
+  uword addr = freelist->TryAllocate(size);
+  if ((addr == 0) &&
+      page_space_->CanIncreaseCapacityInWords(PageSpace::kPageSizeInWords)) {
+    // The capacity is given back once the evacuated pages are released.
+    HeapPage* page = page_space_->AllocatePage(HeapPage::kData);
+    addr = page->object_start();
+    uword free_start = addr + size;
+    intptr_t free_size = page->object_end() - free_start;
+    if (free_size > 0) {
+      freelist->Free(free_start, free_size);
+    }
+  }
+  return addr;
+}
+
+
+bool GCCompactor::EvacuatePage(HeapPage* page) {
+  uword current = page->object_start();
+  uword end = page->object_end();
+  while (current < end) {
+    RawObject* raw_obj = RawObject::FromAddr(current);
+    intptr_t size = raw_obj->Size();
+    if (raw_obj->IsMarked()) {
+      uword new_addr = TryAllocateCopy(size);
+      if (new_addr == 0) {
+        return false;
+      }
+      memmove(reinterpret_cast<void*>(new_addr),
+              reinterpret_cast<void*>(current),
+              size);
+      // The page space has already been swept.
+      RawObject::FromAddr(new_addr)->ClearMarkBit();
+      uword* header = reinterpret_cast<uword*>(current);
+      header[0] = new_addr | kForwarded;
+      header[1] = size;
+      moved_words_ += (size >> kWordSizeLog2);
+    }
+    current += size;
+  }
+  ASSERT(current == end);
+  return true;
+}
+
+
+void GCCompactor::UpdateWeakTables() {
+  for (int sel = 0;
+       sel < Heap::kNumWeakSelectors;
+       sel++) {
+    // Weak tables are keyed by address, so the moved entries are rehashed.
+    WeakTable* table = heap_->GetWeakTable(
+        Heap::kOld, static_cast<Heap::WeakSelector>(sel));
+    heap_->SetWeakTable(Heap::kOld,
+                        static_cast<Heap::WeakSelector>(sel),
+                        WeakTable::NewFrom(table));
+    intptr_t size = table->size();
+    for (intptr_t i = 0; i < size; i++) {
+      if (table->IsValidEntryAt(i)) {
+        RawObject* raw_obj = table->ObjectAt(i);
+        ForwardPointer(&raw_obj);
+        heap_->SetWeakEntry(raw_obj,
+                            static_cast<Heap::WeakSelector>(sel),
+                            table->ValueAt(i));
+      }
+    }
+    delete table;
+  }
+}
+
+
+void GCCompactor::UpdateReferences(Isolate* isolate) {
+  ForwardPointersVisitor visitor(isolate);
+  // The heap is updated before the roots: walking the stack frames looks up
+  // their code objects through the instructions in the executable pages.
+  page_space_->VisitObjectPointers(&visitor);
+  for (HeapPage* page = retained_; page != NULL; page = page->next()) {
+    VisitRetainedPage(page, &visitor);
+  }
+  heap_->IterateNewPointers(&visitor);
+
+  isolate->VisitObjectPointers(&visitor,
+                               true,
+                               StackFrameIterator::kDontValidateFrames);
+  ForwardHandlesVisitor handle_visitor;
+  isolate->VisitWeakPersistentHandles(&handle_visitor, false);
+  ObjectIdRing* ring = isolate->object_id_ring();
+  if (ring != NULL) {
+    ring->VisitPointers(&visitor);
+  }
+
+  StoreBuffer* store_buffer = isolate->store_buffer();
+  StoreBufferBlock* block = store_buffer->Blocks();
+  while (block != NULL) {
+    intptr_t count = block->Count();
+    for (intptr_t i = 0; i < count; i++) {
+      RawObject* raw_obj = block->At(i);
+      ForwardPointer(&raw_obj);
+      store_buffer->AddObjectGC(raw_obj);
+    }
+    StoreBufferBlock* next = block->next();
+    delete block;
+    block = next;
+  }
+
+  UpdateWeakTables();
+}
+
+
+intptr_t GCCompactor::ReleaseCandidates() {
+  intptr_t released_pages = 0;
+  while (candidates_ != NULL) {
+    HeapPage* page = candidates_;
+    candidates_ = page->next();
+    page_space_->ReleasePage(page);
+    released_pages++;
+  }
+  // Return the pages which could not be evacuated to the page space.
+  GCSweeper sweeper(heap_);
+  intptr_t used_in_words = 0;
+  while (retained_ != NULL) {
+    HeapPage* page = retained_;
+    retained_ = page->next();
+    ClearForwardedObjects(page);
+    intptr_t page_in_use =
+        sweeper.SweepPage(page, &page_space_->freelist_[HeapPage::kData]);
+    if (page_in_use == 0) {
+      page_space_->ReleasePage(page);
+      released_pages++;
+    } else {
+      page_space_->AddPage(page);
+      used_in_words += (page_in_use >> kWordSizeLog2);
+    }
+  }
+  if (FLAG_verbose_gc) {
+    OS::PrintErr("Compacted old space: %" Pd " of %" Pd " pages released, "
+                 "%" Pd " KB moved.\n",
+                 released_pages, num_candidates_,
+                 (moved_words_ << kWordSizeLog2) / KB);
+  }
+  return used_in_words;
+}
+
+
+intptr_t GCCompactor::Compact(Isolate* isolate) {
+  ASSERT(retained_ == NULL);
+  HeapPage* prev_page = NULL;
+  HeapPage* page = candidates_;
+  while (page != NULL) {
+    if (!EvacuatePage(page)) {
+      // The page space ran out of room. Keep this and the remaining pages.
+      if (prev_page != NULL) {
+        prev_page->set_next(NULL);
+      } else {
+        candidates_ = NULL;
+      }
+      retained_ = page;
+      break;
+    }
+    prev_page = page;
+    page = page->next();
+  }
+  UpdateReferences(isolate);
+  return ReleaseCandidates();
+}
+
+}  // namespace dart
@@ -0,0 +1,82 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_GC_COMPACTOR_H_
+#define VM_GC_COMPACTOR_H_
+
+#include "vm/allocation.h"
+#include "vm/flags.h"
+#include "vm/globals.h"
+
+namespace dart {
+
+DECLARE_FLAG(int, compaction_threshold);
+
+// Forward declarations.
+class Heap;
+class HeapPage;
+class Isolate;
+class PageSpace;
+
+// The class GCCompactor fights the fragmentation of the old generation. After
+// marking it evacuates the live objects of sparsely used data pages into the
+// rest of the page space, updates all references to the moved objects and
+// releases the evacuated pages. Executable and large pages are never moved.
+class GCCompactor : public ValueObject {
+ public:
+  GCCompactor(Heap* heap, PageSpace* page_space)
+      : heap_(heap),
+        page_space_(page_space),
+        candidates_(NULL),
+        retained_(NULL),
+        num_candidates_(0),
+        moved_words_(0) { }
+  ~GCCompactor() {
+    ASSERT(candidates_ == NULL);
+    ASSERT(retained_ == NULL);
+  }
+
+  // Whether the free part of the old generation after marking 'marked_words'
+  // exceeds --compaction_threshold.
+  static bool ShouldCompact(intptr_t capacity_in_words, intptr_t marked_words);
+
+  // Removes the data pages worth evacuating from the page space. Must be
+  // called after marking and before sweeping. Returns false if no page was
+  // selected.
+  bool SelectCandidates();
+
+  // Moves the marked objects of the selected pages into the page space, which
+  // must have been swept, updates the references to them and releases the
+  // evacuated pages. Returns the size of the objects left in the page space
+  // by the pages which could not be evacuated, once swept.
+  intptr_t Compact(Isolate* isolate);
+
+  intptr_t moved_words() const { return moved_words_; }
+
+ private:
+  // A page is evacuated if less than this percentage of it is in use.
+  static const intptr_t kCandidateOccupancy = 50;
+
+  uword TryAllocateCopy(intptr_t size);
+  // Returns false if the page space ran out of room for the copies.
+  bool EvacuatePage(HeapPage* page);
+  void UpdateReferences(Isolate* isolate);
+  void UpdateWeakTables();
+  intptr_t ReleaseCandidates();
+
+  Heap* heap_;
+  PageSpace* page_space_;
+  HeapPage* candidates_;
+  // The candidates which could not be fully evacuated, once the page space
+  // ran out of room.
+  HeapPage* retained_;
+  intptr_t num_candidates_;
+  intptr_t moved_words_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(GCCompactor);
+};
+
+}  // namespace dart
+
+#endif  // VM_GC_COMPACTOR_H_
@@ -9,17 +9,32 @@
 
 #include "vm/allocation.h"
 #include "vm/dart_api_state.h"
+#include "vm/flags.h"
+#include "vm/heap.h"
 #include "vm/isolate.h"
 #include "vm/pages.h"
 #include "vm/raw_object.h"
+#include "vm/runtime_entry.h"
 #include "vm/stack_frame.h"
+#include "vm/store_buffer.h"
+#include "vm/thread_pool.h"
 #include "vm/visitor.h"
 #include "vm/object_id_ring.h"
 
 namespace dart {
 
+DEFINE_FLAG(bool, concurrent_mark, false,
+            "Mark the old generation concurrently with the mutator "
+            "(ia32 and x64 only).");
+DEFINE_FLAG(int, concurrent_mark_threshold, 75,
+            "Start concurrent marking once this percentage of the old "
+            "generation limit is in use.");
+DEFINE_FLAG(int, marker_tasks, 1,
+            "Number of tasks used to mark the old generation in a mark-sweep, "
+            "e.g: --marker_tasks=4 uses the isolate thread and 3 helpers");
+
 // A simple chunked marking stack.
-class MarkingStack : public ValueObject {
+class MarkingStack {
  public:
   MarkingStack()
       : head_(new MarkingStackChunk()),
@@ -131,12 +146,16 @@ class MarkingVisitor : public ObjectPointerVisitor {
         page_space_(page_space),
         marking_stack_(marking_stack),
         visiting_old_object_(NULL),
-        visit_function_code_(visit_function_code) {
+        visit_function_code_(visit_function_code),
+        marked_words_(0) {
     ASSERT(heap_ != vm_heap_);
   }
 
   MarkingStack* marking_stack() const { return marking_stack_; }
 
+  // The size of the objects marked by this visitor.
+  intptr_t marked_words() const { return marked_words_; }
+
   void VisitPointers(RawObject** first, RawObject** last) {
     for (RawObject** current = first; current <= last; current++) {
       MarkObject(*current, current);
@@ -187,7 +206,10 @@ class MarkingVisitor : public ObjectPointerVisitor {
     ASSERT(!raw_obj->IsMarked());
     RawClass* raw_class = isolate()->class_table()->At(raw_obj->GetClassId());
     raw_obj->SetMarkBit();
-    raw_obj->ClearRememberedBit();
+    if (raw_obj->IsRemembered()) {
+      raw_obj->ClearRememberedBit();
+    }
+    marked_words_ += raw_obj->Size() >> kWordSizeLog2;
     if (raw_obj->IsWatched()) {
       std::pair<DelaySet::iterator, DelaySet::iterator> ret;
       // Visit all elements with a key equal to raw_obj.
@@ -264,6 +286,7 @@ class MarkingVisitor : public ObjectPointerVisitor {
   DelaySet delay_set_;
   const bool visit_function_code_;
   GrowableArray<RawFunction*> skipped_code_functions_;
+  intptr_t marked_words_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(MarkingVisitor);
 };
@@ -301,6 +324,374 @@ class MarkingWeakVisitor : public HandleVisitor {
   DISALLOW_COPY_AND_ASSIGN(MarkingWeakVisitor);
 };
 
+// A fixed size block of grey objects used by the tasks of a parallel marking.
+// Blocks are the unit of work shared between tasks. They are also used to
+// collect the per task remembered objects, skipped functions and delayed weak
+// properties.
+class MarkingWorkBlock {
+ public:
+  static const intptr_t kSize = 256;
+
+  MarkingWorkBlock() : next_(NULL), top_(0) {}
+
+  MarkingWorkBlock* next() const { return next_; }
+  void set_next(MarkingWorkBlock* next) { next_ = next; }
+
+  bool IsEmpty() const { return top_ == 0; }
+  bool IsFull() const { return top_ == kSize; }
+  intptr_t Count() const { return top_; }
+
+  void Push(RawObject* raw_obj) {
+    ASSERT(!IsFull());
+    objects_[top_++] = raw_obj;
+  }
+
+  RawObject* Pop() {
+    ASSERT(!IsEmpty());
+    return objects_[--top_];
+  }
+
+  // Pushes raw_obj onto a list of blocks, allocating a new head as needed.
+  static void PushToList(MarkingWorkBlock** list, RawObject* raw_obj) {
+    MarkingWorkBlock* block = *list;
+    if ((block == NULL) || block->IsFull()) {
+      block = new MarkingWorkBlock();
+      block->set_next(*list);
+      *list = block;
+    }
+    block->Push(raw_obj);
+  }
+
+ private:
+  MarkingWorkBlock* next_;
+  intptr_t top_;
+  RawObject* objects_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(MarkingWorkBlock);
+};
+
+
+// State shared by all tasks of a parallel marking: the published work blocks
+// of each task and the bookkeeping needed to detect termination.
+class ParallelMarkingState : public ValueObject {
+ public:
+  explicit ParallelMarkingState(intptr_t num_tasks)
+      : num_tasks_(num_tasks),
+        work_(new MarkingWorkBlock*[num_tasks]),
+        idle_tasks_(0),
+        running_tasks_(num_tasks - 1),
+        done_(false),
+        steals_(0) {
+    for (intptr_t i = 0; i < num_tasks_; i++) {
+      work_[i] = NULL;
+    }
+  }
+
+  ~ParallelMarkingState() {
+    ASSERT(running_tasks_ == 0);
+    for (intptr_t i = 0; i < num_tasks_; i++) {
+      ASSERT(work_[i] == NULL);
+    }
+    delete[] work_;
+  }
+
+  intptr_t steals() const { return steals_; }
+
+  // Makes a block of work available to all tasks.
+  void PublishWork(intptr_t task_id, MarkingWorkBlock* block) {
+    ScopedMonitor ml(&monitor_);
+    block->set_next(work_[task_id]);
+    work_[task_id] = block;
+    if (idle_tasks_ > 0) {
+      ml.Notify();
+    }
+  }
+
+  // Returns a block of work, preferring blocks published by the task itself
+  // over stealing from the other tasks. Returns NULL once all tasks are idle
+  // and no more work is available.
+  MarkingWorkBlock* TakeWork(intptr_t task_id) {
+    ScopedMonitor ml(&monitor_);
+    while (true) {
+      for (intptr_t i = 0; i < num_tasks_; i++) {
+        intptr_t victim = (task_id + i) % num_tasks_;
+        MarkingWorkBlock* block = work_[victim];
+        if (block != NULL) {
+          work_[victim] = block->next();
+          block->set_next(NULL);
+          if (victim != task_id) {
+            steals_++;
+          }
+          return block;
+        }
+      }
+      if (done_) {
+        return NULL;
+      }
+      idle_tasks_++;
+      if (idle_tasks_ == num_tasks_) {
+        // Every task is out of work, so nobody can produce more.
+        done_ = true;
+        ml.NotifyAll();
+        return NULL;
+      }
+      ml.Wait();
+      idle_tasks_--;
+    }
+  }
+
+  // Racy by design: only used to decide whether to share work early.
+  bool HasIdleTasks() const { return idle_tasks_ > 0; }
+
+  void TaskDone() {
+    ScopedMonitor ml(&monitor_);
+    running_tasks_--;
+    ml.NotifyAll();
+  }
+
+  void WaitForTasks() {
+    ScopedMonitor ml(&monitor_);
+    while (running_tasks_ > 0) {
+      ml.Wait();
+    }
+  }
+
+ private:
+  const intptr_t num_tasks_;
+  Monitor monitor_;
+  MarkingWorkBlock** work_;
+  intptr_t idle_tasks_;
+  intptr_t running_tasks_;
+  bool done_;
+  intptr_t steals_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarkingState);
+};
+
+
+// The visitor used by each task of a parallel marking. Objects are claimed
+// with an atomic update of the mark bit and pushed onto the task's work block.
+// Everything which needs the isolate's zone or store buffer, or which depends
+// on the final marking state, is collected in task local lists and handed to
+// the serial MarkingVisitor once all tasks are done.
+class ParallelMarkingVisitor : public ObjectPointerVisitor {
+ public:
+  ParallelMarkingVisitor(Isolate* isolate,
+                         ParallelMarkingState* state,
+                         intptr_t task_id,
+                         bool visit_function_code)
+      : ObjectPointerVisitor(isolate),
+        class_table_(isolate->class_table()),
+        state_(state),
+        task_id_(task_id),
+        visit_function_code_(visit_function_code),
+        work_(new MarkingWorkBlock()),
+        remembered_(NULL),
+        skipped_functions_(NULL),
+        delayed_weak_(NULL),
+        visiting_old_object_(NULL),
+        marked_words_(0) { }
+
+  ~ParallelMarkingVisitor() {
+    ASSERT(work_->IsEmpty());
+    ASSERT(remembered_ == NULL);
+    ASSERT(skipped_functions_ == NULL);
+    ASSERT(delayed_weak_ == NULL);
+    delete work_;
+  }
+
+  intptr_t marked_words() const { return marked_words_; }
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    for (RawObject** current = first; current <= last; current++) {
+      MarkObject(*current);
+    }
+  }
+
+  // Scans objects until all tasks have run out of work.
+  void ProcessWork() {
+    while (true) {
+      while (!work_->IsEmpty()) {
+        ScanObject(work_->Pop());
+      }
+      MarkingWorkBlock* block = state_->TakeWork(task_id_);
+      if (block == NULL) {
+        return;
+      }
+      delete work_;
+      work_ = block;
+    }
+  }
+
+  // Adds the remembered old objects to the store buffer and hands the
+  // skipped functions and the delayed weak properties to 'visitor'. Must be
+  // called after all tasks have finished.
+  void Finalize(GCMarker* marker, MarkingVisitor* visitor) {
+    StoreBuffer* store_buffer = isolate()->store_buffer();
+    while (remembered_ != NULL) {
+      MarkingWorkBlock* block = remembered_;
+      remembered_ = block->next();
+      while (!block->IsEmpty()) {
+        RawObject* raw_obj = block->Pop();
+        ASSERT(raw_obj->IsRemembered());
+        store_buffer->AddObjectGC(raw_obj);
+      }
+      delete block;
+    }
+    while (skipped_functions_ != NULL) {
+      MarkingWorkBlock* block = skipped_functions_;
+      skipped_functions_ = block->next();
+      while (!block->IsEmpty()) {
+        visitor->skipped_code_functions()->Add(
+            reinterpret_cast<RawFunction*>(block->Pop()));
+      }
+      delete block;
+    }
+    // The keys of these weak properties were not marked yet when they were
+    // scanned. The serial visitor finds out which of them stay alive.
+    while (delayed_weak_ != NULL) {
+      MarkingWorkBlock* block = delayed_weak_;
+      delayed_weak_ = block->next();
+      while (!block->IsEmpty()) {
+        RawWeakProperty* raw_weak =
+            reinterpret_cast<RawWeakProperty*>(block->Pop());
+        visitor->VisitingOldObject(raw_weak);
+        marker->ProcessWeakProperty(raw_weak, visitor);
+      }
+      delete block;
+    }
+    visitor->VisitingOldObject(NULL);
+  }
+
+ private:
+  // Publish the current work block early once it holds this many objects and
+  // another task is waiting for work.
+  static const intptr_t kPublishThreshold = 32;
+
+  void PushWork(RawObject* raw_obj) {
+    if (work_->IsFull() ||
+        ((work_->Count() >= kPublishThreshold) && state_->HasIdleTasks())) {
+      state_->PublishWork(task_id_, work_);
+      work_ = new MarkingWorkBlock();
+    }
+    work_->Push(raw_obj);
+  }
+
+  void MarkObject(RawObject* raw_obj) {
+    // Fast exit if the raw object is a Smi.
+    if (!raw_obj->IsHeapObject()) {
+      return;
+    }
+    // Remember old objects which point into new space, as the serial
+    // visitor does.
+    if (raw_obj->IsNewObject()) {
+      if ((visiting_old_object_ != NULL) &&
+          !visiting_old_object_->IsRemembered()) {
+        visiting_old_object_->SetRememberedBit();
+        MarkingWorkBlock::PushToList(&remembered_, visiting_old_object_);
+      }
+      return;
+    }
+    if (raw_obj->IsMarked() || !raw_obj->TryAcquireMarkBit()) {
+      return;
+    }
+    // Only the task which claimed the object updates its remembered bit.
+    if (raw_obj->IsRemembered()) {
+      raw_obj->ClearRememberedBit();
+    }
+    marked_words_ += raw_obj->Size() >> kWordSizeLog2;
+    PushWork(raw_obj);
+    MarkObject(class_table_->At(raw_obj->GetClassId()));
+  }
+
+  void ScanObject(RawObject* raw_obj) {
+    visiting_old_object_ = raw_obj;
+    intptr_t class_id = raw_obj->GetClassId();
+    if (class_id == kWeakPropertyCid) {
+      ProcessWeakProperty(reinterpret_cast<RawWeakProperty*>(raw_obj));
+    } else if ((class_id == kFunctionCid) && !visit_function_code_) {
+      ProcessFunction(reinterpret_cast<RawFunction*>(raw_obj));
+    } else {
+      raw_obj->VisitPointers(this);
+    }
+    visiting_old_object_ = NULL;
+  }
+
+  void ProcessWeakProperty(RawWeakProperty* raw_weak) {
+    // The fate of the weak property is determined by its key.
+    RawObject* raw_key = raw_weak->ptr()->key_;
+    if (raw_key->IsHeapObject() &&
+        raw_key->IsOldObject() &&
+        !raw_key->IsMarked()) {
+      // Key is white. Delay the weak property until all tasks are done.
+      MarkingWorkBlock::PushToList(&delayed_weak_, raw_weak);
+      return;
+    }
+    // Key is gray or black. Make the weak property black.
+    raw_weak->VisitPointers(this);
+  }
+
+  // Mirrors RawFunction::VisitFunctionPointers, which records skipped
+  // functions in a zone allocated array that cannot be shared between tasks.
+  void ProcessFunction(RawFunction* raw_func) {
+    if (!RawFunction::SkipCode(raw_func)) {
+      VisitPointers(raw_func->from(), raw_func->to());
+    } else {
+      MarkingWorkBlock::PushToList(&skipped_functions_, raw_func);
+      VisitPointers(raw_func->from(), raw_func->to_no_code());
+    }
+  }
+
+  ClassTable* class_table_;
+  ParallelMarkingState* state_;
+  const intptr_t task_id_;
+  const bool visit_function_code_;
+  MarkingWorkBlock* work_;
+  MarkingWorkBlock* remembered_;
+  MarkingWorkBlock* skipped_functions_;
+  MarkingWorkBlock* delayed_weak_;
+  RawObject* visiting_old_object_;
+  intptr_t marked_words_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(ParallelMarkingVisitor);
+};
+
+
+class ParallelMarkingTask : public ThreadPool::Task {
+ public:
+  ParallelMarkingTask(Isolate* isolate,
+                      Heap* heap,
+                      ParallelMarkingState* state,
+                      ParallelMarkingVisitor* visitor,
+                      bool visit_new_space)
+      : isolate_(isolate),
+        heap_(heap),
+        state_(state),
+        visitor_(visitor),
+        visit_new_space_(visit_new_space) { }
+
+  virtual void Run() {
+    Isolate* saved_isolate = Isolate::Current();
+    Isolate::SetCurrentGCHelper(isolate_);
+    if (visit_new_space_) {
+      heap_->IterateNewPointers(visitor_);
+    }
+    visitor_->ProcessWork();
+    Isolate::SetCurrentGCHelper(saved_isolate);
+    // The state must not be touched after signalling completion.
+    state_->TaskDone();
+  }
+
+ private:
+  Isolate* isolate_;
+  Heap* heap_;
+  ParallelMarkingState* state_;
+  ParallelMarkingVisitor* visitor_;
+  bool visit_new_space_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarkingTask);
+};
+
 
 void GCMarker::Prologue(Isolate* isolate, bool invoke_api_callbacks) {
   if (invoke_api_callbacks) {
@@ -469,6 +860,38 @@ void GCMarker::ProcessObjectIdTable(Isolate* isolate) {
 }
 
 
+void GCMarker::FinalizeMarking(Isolate* isolate,
+                               PageSpace* page_space,
+                               MarkingVisitor* visitor,
+                               bool invoke_api_callbacks) {
+  IterateWeakReferences(isolate, visitor);
+  MarkingWeakVisitor mark_weak;
+  IterateWeakRoots(isolate, &mark_weak, invoke_api_callbacks);
+  visitor->Finalize();
+  ProcessWeakTables(page_space);
+  ProcessObjectIdTable(isolate);
+}
+
+
+void GCMarker::PruneStoreBuffer(Isolate* isolate) {
+  // Drop the entries of objects which are about to be swept.
+  StoreBuffer* store_buffer = isolate->store_buffer();
+  StoreBufferBlock* block = store_buffer->Blocks();
+  while (block != NULL) {
+    intptr_t count = block->Count();
+    for (intptr_t i = 0; i < count; i++) {
+      RawObject* raw_object = block->At(i);
+      if (raw_object->IsMarked()) {
+        store_buffer->AddObjectGC(raw_object);
+      }
+    }
+    StoreBufferBlock* next = block->next();
+    delete block;
+    block = next;
+  }
+}
+
+
 void GCMarker::MarkObjects(Isolate* isolate,
                            PageSpace* page_space,
                            bool invoke_api_callbacks,
@@ -478,16 +901,379 @@ void GCMarker::MarkObjects(Isolate* isolate,
   Prologue(isolate, invoke_api_callbacks);
   MarkingVisitor mark(
       isolate, heap_, page_space, &marking_stack, visit_function_code);
+  intptr_t parallel_marked_words = 0;
+  if (FLAG_marker_tasks > 1) {
+    parallel_marked_words = ParallelMarkObjects(
+        isolate, &mark, !invoke_api_callbacks, visit_function_code);
+  } else {
+    IterateRoots(isolate, &mark, !invoke_api_callbacks);
+  }
+  DrainMarkingStack(isolate, &mark);
+  FinalizeMarking(isolate, page_space, &mark, invoke_api_callbacks);
+  marked_words_ = parallel_marked_words + mark.marked_words();
+
+  Epilogue(isolate, invoke_api_callbacks);
+}
+
+
+intptr_t GCMarker::ParallelMarkObjects(
+    Isolate* isolate,
+    MarkingVisitor* visitor,
+    bool visit_prologue_weak_persistent_handles,
+    bool visit_function_code) {
+  const intptr_t num_tasks = FLAG_marker_tasks;
+  ASSERT(num_tasks > 1);
+  ParallelMarkingState state(num_tasks);
+  ParallelMarkingVisitor** visitors = new ParallelMarkingVisitor*[num_tasks];
+  for (intptr_t i = 0; i < num_tasks; i++) {
+    visitors[i] = new ParallelMarkingVisitor(
+        isolate, &state, i, visit_function_code);
+  }
+#if defined(DEBUG)
+  isolate->IncrementGCHelperDepth();
+#endif
+  // The new space roots are visited by the first helper while the isolate's
+  // own thread visits the roots which require walking the stack.
+  for (intptr_t i = 1; i < num_tasks; i++) {
+    Dart::thread_pool()->RunHelper(new ParallelMarkingTask(
+        isolate, heap_, &state, visitors[i], (i == 1)));
+  }
+  isolate->VisitObjectPointers(visitors[0],
+                               visit_prologue_weak_persistent_handles,
+                               StackFrameIterator::kDontValidateFrames);
+  visitors[0]->ProcessWork();
+  state.WaitForTasks();
+#if defined(DEBUG)
+  isolate->DecrementGCHelperDepth();
+#endif
+
+  intptr_t marked_words = 0;
+  for (intptr_t i = 0; i < num_tasks; i++) {
+    visitors[i]->Finalize(this, visitor);
+    marked_words += visitors[i]->marked_words();
+    delete visitors[i];
+  }
+  delete[] visitors;
+  if (FLAG_verbose_gc) {
+    OS::PrintErr("Parallel marking: %" Pd " tasks, %" Pd " steals\n",
+                 num_tasks, state.steals());
+  }
+  return marked_words;
+}
+
+
+void GCMarker::FinishConcurrentMarking(Isolate* isolate,
+                                       PageSpace* page_space,
+                                       ConcurrentMarker* concurrent_marker,
+                                       bool invoke_api_callbacks,
+                                       bool collect_code) {
+  concurrent_marker->Stop();
+  if (invoke_api_callbacks) {
+    isolate->gc_prologue_callbacks().Invoke();
+  }
+  // The store buffer is not rebuilt, as the objects scanned by the concurrent
+  // marker are not visited again. Its entries may have lost their mark bit.
+  concurrent_marker->AddBarrierBlocks(isolate->marking_buffer()->Blocks());
+  concurrent_marker->MarkBlocks(concurrent_marker->barrier_blocks_);
+  concurrent_marker->barrier_blocks_ = NULL;
+  concurrent_marker->MarkStoreBuffer(isolate->store_buffer());
+
+  // Rescan the roots and finish marking with the stop-the-world visitor.
+  const bool visit_function_code = !collect_code;
+  MarkingVisitor mark(isolate,
+                      heap_,
+                      page_space,
+                      concurrent_marker->marking_stack_,
+                      visit_function_code);
   IterateRoots(isolate, &mark, !invoke_api_callbacks);
   DrainMarkingStack(isolate, &mark);
-  IterateWeakReferences(isolate, &mark);
-  MarkingWeakVisitor mark_weak;
-  IterateWeakRoots(isolate, &mark_weak, invoke_api_callbacks);
-  mark.Finalize();
-  ProcessWeakTables(page_space);
-  ProcessObjectIdTable(isolate);
+  MarkingStack* weak_properties = concurrent_marker->deferred_weak_properties_;
+  while (!weak_properties->IsEmpty()) {
+    RawWeakProperty* raw_weak =
+        reinterpret_cast<RawWeakProperty*>(weak_properties->Pop());
+    mark.VisitingOldObject(raw_weak);
+    ProcessWeakProperty(raw_weak, &mark);
+  }
+  mark.VisitingOldObject(NULL);
+  DrainMarkingStack(isolate, &mark);
+  FinalizeMarking(isolate, page_space, &mark, invoke_api_callbacks);
+  PruneStoreBuffer(isolate);
+  marked_words_ =
+      concurrent_marker->marked_words() + mark.marked_words();
 
   Epilogue(isolate, invoke_api_callbacks);
 }
 
+
+// Marks old objects on behalf of the ConcurrentMarker. As the mutator may be
+// running, it leaves the remembered and watched bits alone and claims objects
+// with an atomic update of the mark bit.
+class ConcurrentMarkingVisitor : public ObjectPointerVisitor {
+ public:
+  ConcurrentMarkingVisitor(Isolate* isolate, MarkingStack* marking_stack)
+      : ObjectPointerVisitor(isolate),
+        class_table_(isolate->class_table()),
+        marking_stack_(marking_stack),
+        marked_words_(0) {
+  }
+
+  intptr_t marked_words() const { return marked_words_; }
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    for (RawObject** current = first; current <= last; current++) {
+      MarkObject(*current);
+    }
+  }
+
+  void MarkObject(RawObject* raw_obj) {
+    if (!raw_obj->IsHeapObject() || raw_obj->IsNewObject()) {
+      return;
+    }
+    if (!raw_obj->TryAcquireMarkBit()) {
+      return;
+    }
+    marked_words_ += raw_obj->Size() >> kWordSizeLog2;
+    marking_stack_->Push(raw_obj);
+    MarkObject(class_table_->At(raw_obj->GetClassId()));
+  }
+
+ private:
+  ClassTable* class_table_;
+  MarkingStack* marking_stack_;
+  intptr_t marked_words_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(ConcurrentMarkingVisitor);
+};
+
+
+class ConcurrentMarker::MarkingTask : public ThreadPool::Task {
+ public:
+  explicit MarkingTask(ConcurrentMarker* marker) : marker_(marker) { }
+
+  virtual void Run() {
+    marker_->Run();
+  }
+
+ private:
+  ConcurrentMarker* marker_;
+
+  DISALLOW_COPY_AND_ASSIGN(MarkingTask);
+};
+
+
+ConcurrentMarker::ConcurrentMarker(Isolate* isolate, Heap* heap)
+    : isolate_(isolate),
+      heap_(heap),
+      marking_stack_(new MarkingStack()),
+      deferred_weak_properties_(new MarkingStack()),
+      visitor_(NULL),
+      barrier_blocks_(NULL),
+      pause_requests_(0),
+      paused_(false),
+      running_(false),
+      abort_(false),
+      stopped_(false) {
+  visitor_ = new ConcurrentMarkingVisitor(isolate, marking_stack_);
+}
+
+
+ConcurrentMarker::~ConcurrentMarker() {
+  Stop();
+  StoreBufferBlock* block = barrier_blocks_;
+  while (block != NULL) {
+    StoreBufferBlock* next = block->next();
+    delete block;
+    block = next;
+  }
+  // An aborted marker may leave grey objects behind.
+  while (!marking_stack_->IsEmpty()) {
+    marking_stack_->Pop();
+  }
+  while (!deferred_weak_properties_->IsEmpty()) {
+    deferred_weak_properties_->Pop();
+  }
+  delete visitor_;
+  delete marking_stack_;
+  delete deferred_weak_properties_;
+}
+
+
+bool ConcurrentMarker::IsSupported() {
+#if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+void ConcurrentMarker::Start() {
+  ASSERT(!running_ && !stopped_);
+  isolate_->set_concurrent_marking(true);
+#if defined(DEBUG)
+  isolate_->IncrementGCHelperDepth();
+#endif
+  // The mutator is stopped while the roots are marked.
+  isolate_->VisitObjectPointers(visitor_,
+                                false,
+                                StackFrameIterator::kDontValidateFrames);
+  heap_->IterateNewPointers(visitor_);
+  {
+    ScopedMonitor ml(&monitor_);
+    running_ = true;
+  }
+  Dart::thread_pool()->RunHelper(new MarkingTask(this));
+}
+
+
+void ConcurrentMarker::Stop() {
+  if (stopped_) {
+    return;
+  }
+  {
+    ScopedMonitor ml(&monitor_);
+    abort_ = true;
+    ml.NotifyAll();
+    while (running_) {
+      ml.Wait();
+    }
+  }
+  isolate_->set_concurrent_marking(false);
+#if defined(DEBUG)
+  isolate_->DecrementGCHelperDepth();
+#endif
+  stopped_ = true;
+}
+
+
+void ConcurrentMarker::Pause() {
+  ScopedMonitor ml(&monitor_);
+  pause_requests_++;
+  while (running_ && !paused_) {
+    ml.Wait();
+  }
+}
+
+
+void ConcurrentMarker::Resume() {
+  ScopedMonitor ml(&monitor_);
+  ASSERT(pause_requests_ > 0);
+  pause_requests_--;
+  if (pause_requests_ == 0) {
+    ml.NotifyAll();
+  }
+}
+
+
+void ConcurrentMarker::AddBarrierBlocks(StoreBufferBlock* blocks) {
+  ScopedMonitor ml(&monitor_);
+  while (blocks != NULL) {
+    StoreBufferBlock* next = blocks->next();
+    blocks->set_next(barrier_blocks_);
+    barrier_blocks_ = blocks;
+    blocks = next;
+  }
+}
+
+
+void ConcurrentMarker::MarkStoreBuffer(StoreBuffer* store_buffer) {
+  ASSERT(paused_ || !running_);
+  StoreBufferBlock* block = store_buffer->PeekBlocks();
+  while (block != NULL) {
+    intptr_t count = block->Count();
+    for (intptr_t i = 0; i < count; i++) {
+      visitor_->MarkObject(block->At(i));
+    }
+    block = block->next();
+  }
+}
+
+
+void ConcurrentMarker::MarkPromotedObject(RawObject* raw_obj) {
+  ASSERT(paused_ || !running_);
+  ASSERT(raw_obj->IsOldObject());
+  visitor_->MarkObject(raw_obj);
+}
+
+
+intptr_t ConcurrentMarker::marked_words() const {
+  return visitor_->marked_words();
+}
+
+
+void ConcurrentMarker::MarkBlocks(StoreBufferBlock* blocks) {
+  while (blocks != NULL) {
+    intptr_t count = blocks->Count();
+    for (intptr_t i = 0; i < count; i++) {
+      visitor_->MarkObject(blocks->At(i));
+    }
+    StoreBufferBlock* next = blocks->next();
+    delete blocks;
+    blocks = next;
+  }
+}
+
+
+void ConcurrentMarker::DrainMarkingStack(intptr_t budget) {
+  for (intptr_t i = 0; (i < budget) && !marking_stack_->IsEmpty(); i++) {
+    RawObject* raw_obj = marking_stack_->Pop();
+    if (raw_obj->GetClassId() == kWeakPropertyCid) {
+      // The key can only be checked once marking is complete.
+      deferred_weak_properties_->Push(raw_obj);
+    } else {
+      raw_obj->VisitPointers(visitor_);
+    }
+  }
+}
+
+
+void ConcurrentMarker::Run() {
+  Isolate* saved_isolate = Isolate::Current();
+  Isolate::SetCurrentGCHelper(isolate_);
+  bool done = false;
+  while (true) {
+    StoreBufferBlock* blocks = NULL;
+    {
+      ScopedMonitor ml(&monitor_);
+      if ((pause_requests_ > 0) && !abort_) {
+        paused_ = true;
+        ml.NotifyAll();
+        while ((pause_requests_ > 0) && !abort_) {
+          ml.Wait();
+        }
+        paused_ = false;
+      }
+      if (abort_) {
+        break;
+      }
+      blocks = barrier_blocks_;
+      barrier_blocks_ = NULL;
+      if ((blocks == NULL) && marking_stack_->IsEmpty()) {
+        done = true;
+        break;
+      }
+    }
+    MarkBlocks(blocks);
+    DrainMarkingStack(kMarkingBudget);
+  }
+  Isolate::SetCurrentGCHelper(saved_isolate);
+  if (done) {
+    isolate_->ScheduleInterrupts(Isolate::kConcurrentMarkingInterrupt);
+  }
+  // The marker may be deleted as soon as Stop observes that it is no longer
+  // running.
+  ScopedMonitor ml(&monitor_);
+  running_ = false;
+  ml.NotifyAll();
+}
+
+
+DEFINE_LEAF_RUNTIME_ENTRY(void,
+                          MarkingBufferBlockProcess,
+                          1,
+                          Isolate* isolate) {
+  isolate->heap()->ProcessMarkingBuffer();
+}
+END_LEAF_RUNTIME_ENTRY
+
 }  // namespace dart
@@ -6,23 +6,33 @@
 #define VM_GC_MARKER_H_
 
 #include "vm/allocation.h"
+#include "vm/flags.h"
+#include "vm/thread.h"
 
 namespace dart {
 
+DECLARE_FLAG(int, marker_tasks);
+
 // Forward declarations.
+class ConcurrentMarker;
+class ConcurrentMarkingVisitor;
 class HandleVisitor;
 class Heap;
 class Isolate;
+class MarkingStack;
 class MarkingVisitor;
 class ObjectPointerVisitor;
 class PageSpace;
+class RawObject;
 class RawWeakProperty;
+class StoreBuffer;
+class StoreBufferBlock;
 
 // The class GCMarker is used to mark reachable old generation objects as part
 // of the mark-sweep collection. The marking bit used is defined in RawObject.
 class GCMarker : public ValueObject {
  public:
-  explicit GCMarker(Heap* heap) : heap_(heap) { }
+  explicit GCMarker(Heap* heap) : heap_(heap), marked_words_(0) { }
   ~GCMarker() { }
 
   void MarkObjects(Isolate* isolate,
@@ -30,6 +40,17 @@ class GCMarker : public ValueObject {
                    bool invoke_api_callbacks,
                    bool collect_code);
 
+  // Completes the marking started by 'concurrent_marker' in a final pause.
+  void FinishConcurrentMarking(Isolate* isolate,
+                               PageSpace* page_space,
+                               ConcurrentMarker* concurrent_marker,
+                               bool invoke_api_callbacks,
+                               bool collect_code);
+
+  // The size of the objects marked by the last marking, which is what the
+  // page space will use once it is swept.
+  intptr_t marked_words() const { return marked_words_; }
+
  private:
   void Prologue(Isolate* isolate, bool invoke_api_callbacks);
   void Epilogue(Isolate* isolate, bool invoke_api_callbacks);
@@ -42,15 +63,101 @@ class GCMarker : public ValueObject {
   void IterateWeakReferences(Isolate* isolate, MarkingVisitor* visitor);
   void DrainMarkingStack(Isolate* isolate, MarkingVisitor* visitor);
   void ProcessWeakProperty(RawWeakProperty* raw_weak, MarkingVisitor* visitor);
+  // Marks the objects reachable from the roots with --marker_tasks tasks.
+  // Leaves the weak properties with unmarked keys to 'visitor' and returns
+  // the number of words marked by the tasks.
+  intptr_t ParallelMarkObjects(Isolate* isolate,
+                               MarkingVisitor* visitor,
+                               bool visit_prologue_weak_persistent_handles,
+                               bool visit_function_code);
   void ProcessWeakTables(PageSpace* page_space);
   void ProcessObjectIdTable(Isolate* isolate);
+  void FinalizeMarking(Isolate* isolate,
+                       PageSpace* page_space,
+                       MarkingVisitor* visitor,
+                       bool invoke_api_callbacks);
+  void PruneStoreBuffer(Isolate* isolate);
 
 
   Heap* heap_;
+  intptr_t marked_words_;
+
+  friend class ParallelMarkingVisitor;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(GCMarker);
 };
 
+
+// The class ConcurrentMarker marks the old generation on a thread pool task
+// while the mutator keeps running. The roots are marked when it is started.
+// Afterwards the write barrier records old objects stored into old space in
+// the isolate's marking buffer, whose full blocks are handed to the marker.
+// When no work is left the isolate is interrupted and GCMarker finishes the
+// marking in a short pause, see GCMarker::FinishConcurrentMarking.
+class ConcurrentMarker {
+ public:
+  ConcurrentMarker(Isolate* isolate, Heap* heap);
+  ~ConcurrentMarker();
+
+  // The write barrier for concurrent marking is only emitted by the ia32 and
+  // x64 assemblers.
+  static bool IsSupported();
+
+  // Marks the roots and starts the marking task.
+  void Start();
+
+  // Stops the marking task. The objects marked so far stay marked.
+  void Stop();
+
+  // While paused the marking task does not touch the heap. Pauses nest.
+  void Pause();
+  void Resume();
+
+  // Hands a list of marking buffer blocks to the marker, which takes
+  // ownership of them.
+  void AddBarrierBlocks(StoreBufferBlock* blocks);
+
+  // The following may only be called while the marker is paused. Objects in
+  // the store buffer and objects promoted by the scavenger are treated as
+  // grey, as their header or contents changed behind the marker's back.
+  void MarkStoreBuffer(StoreBuffer* store_buffer);
+  void MarkPromotedObject(RawObject* raw_obj);
+
+  // The number of words marked by the marking task so far.
+  intptr_t marked_words() const;
+
+ private:
+  class MarkingTask;
+
+  void Run();
+  void MarkBlocks(StoreBufferBlock* blocks);
+  void DrainMarkingStack(intptr_t budget);
+
+  // The number of objects scanned between checks for pause requests.
+  static const intptr_t kMarkingBudget = 256;
+
+  Isolate* isolate_;
+  Heap* heap_;
+  MarkingStack* marking_stack_;
+  MarkingStack* deferred_weak_properties_;
+  ConcurrentMarkingVisitor* visitor_;
+
+  // The following fields are protected by monitor_.
+  Monitor monitor_;
+  StoreBufferBlock* barrier_blocks_;
+  intptr_t pause_requests_;
+  bool paused_;
+  bool running_;
+  bool abort_;
+
+  bool stopped_;
+
+  friend class GCMarker;
+  friend class MarkingTask;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentMarker);
+};
+
 }  // namespace dart
 
 #endif  // VM_GC_MARKER_H_
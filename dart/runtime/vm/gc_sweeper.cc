@@ -4,10 +4,13 @@
 
 #include "vm/gc_sweeper.h"
 
+#include "vm/dart.h"
 #include "vm/freelist.h"
 #include "vm/globals.h"
 #include "vm/heap.h"
+#include "vm/isolate.h"
 #include "vm/pages.h"
+#include "vm/thread_pool.h"
 
 namespace dart {
 
@@ -26,7 +29,11 @@ intptr_t GCSweeper::SweepPage(HeapPage* page, FreeList* freelist) {
     RawObject* raw_obj = RawObject::FromAddr(current);
     if (raw_obj->IsMarked()) {
       // Found marked object. Clear the mark bit and update swept bytes.
-      raw_obj->ClearMarkBit();
+      if (is_lazy_) {
+        raw_obj->AtomicClearMarkBit();
+      } else {
+        raw_obj->ClearMarkBit();
+      }
       obj_size = raw_obj->Size();
       in_use += obj_size;
     } else {
@@ -68,4 +75,171 @@ intptr_t GCSweeper::SweepLargePage(HeapPage* page) {
   return raw_obj->Size();
 }
 
+
+class ConcurrentSweeper::SweeperTask : public ThreadPool::Task {
+ public:
+  explicit SweeperTask(ConcurrentSweeper* sweeper) : sweeper_(sweeper) { }
+
+  virtual void Run() {
+    sweeper_->Run();
+  }
+
+ private:
+  ConcurrentSweeper* sweeper_;
+
+  DISALLOW_COPY_AND_ASSIGN(SweeperTask);
+};
+
+
+ConcurrentSweeper::ConcurrentSweeper(Isolate* isolate, PageSpace* page_space)
+    : isolate_(isolate),
+      heap_(isolate->heap()),
+      page_space_(page_space),
+      has_free_(false),
+      swept_pages_(0),
+      pause_requests_(0),
+      paused_(false),
+      running_(false),
+      abort_(false),
+      stopped_(false) {
+}
+
+
+ConcurrentSweeper::~ConcurrentSweeper() {
+  Stop();
+}
+
+
+bool ConcurrentSweeper::IsSupported() {
+#if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+void ConcurrentSweeper::Start() {
+  ASSERT(!running_ && !stopped_);
+#if defined(DEBUG)
+  isolate_->IncrementGCHelperDepth();
+#endif
+  {
+    ScopedMonitor ml(&monitor_);
+    running_ = true;
+  }
+  Dart::thread_pool()->RunHelper(new SweeperTask(this));
+}
+
+
+void ConcurrentSweeper::Stop() {
+  if (stopped_) {
+    return;
+  }
+  {
+    ScopedMonitor ml(&monitor_);
+    abort_ = true;
+    ml.NotifyAll();
+    while (running_) {
+      ml.Wait();
+    }
+  }
+#if defined(DEBUG)
+  isolate_->DecrementGCHelperDepth();
+#endif
+  stopped_ = true;
+}
+
+
+void ConcurrentSweeper::Pause() {
+  ScopedMonitor ml(&monitor_);
+  pause_requests_++;
+  while (running_ && !paused_) {
+    ml.Wait();
+  }
+}
+
+
+void ConcurrentSweeper::Resume() {
+  ScopedMonitor ml(&monitor_);
+  ASSERT(pause_requests_ > 0);
+  pause_requests_--;
+  if (pause_requests_ == 0) {
+    ml.NotifyAll();
+  }
+}
+
+
+HeapPage* ConcurrentSweeper::ClaimPage() {
+  ScopedMonitor ml(&monitor_);
+  return page_space_->NextUnsweptPage();
+}
+
+
+bool ConcurrentSweeper::TakeFreeLists(FreeList* freelists) {
+  ScopedMonitor ml(&monitor_);
+  if (!has_free_) {
+    return false;
+  }
+  for (intptr_t i = 0; i < HeapPage::kNumPageTypes; i++) {
+    freelists[i].Merge(&freelist_[i]);
+  }
+  has_free_ = false;
+  return true;
+}
+
+
+bool ConcurrentSweeper::IsDone() {
+  ScopedMonitor ml(&monitor_);
+  return !running_;
+}
+
+
+intptr_t ConcurrentSweeper::swept_pages() {
+  ScopedMonitor ml(&monitor_);
+  return swept_pages_;
+}
+
+
+void ConcurrentSweeper::Run() {
+  Isolate* saved_isolate = Isolate::Current();
+  Isolate::SetCurrentGCHelper(isolate_);
+  GCSweeper sweeper(heap_, true);
+  FreeList freelist[HeapPage::kNumPageTypes];
+  while (true) {
+    HeapPage* page = NULL;
+    {
+      ScopedMonitor ml(&monitor_);
+      if ((pause_requests_ > 0) && !abort_) {
+        paused_ = true;
+        ml.NotifyAll();
+        while ((pause_requests_ > 0) && !abort_) {
+          ml.Wait();
+        }
+        paused_ = false;
+      }
+      if (abort_) {
+        break;
+      }
+      page = page_space_->NextUnsweptPage();
+      if (page == NULL) {
+        break;
+      }
+    }
+    HeapPage::PageType type = page->type();
+    intptr_t in_use = sweeper.SweepPage(page, &freelist[type]);
+    ScopedMonitor ml(&monitor_);
+    page_space_->SetSwept(page, in_use);
+    freelist_[type].Merge(&freelist[type]);
+    has_free_ = true;
+    swept_pages_++;
+  }
+  Isolate::SetCurrentGCHelper(saved_isolate);
+  // The sweeper may be deleted as soon as Stop observes that it is no longer
+  // running.
+  ScopedMonitor ml(&monitor_);
+  running_ = false;
+  ml.NotifyAll();
+}
+
 }  // namespace dart
@@ -5,20 +5,26 @@
 #ifndef VM_GC_SWEEPER_H_
 #define VM_GC_SWEEPER_H_
 
+#include "vm/freelist.h"
 #include "vm/globals.h"
+#include "vm/pages.h"
+#include "vm/thread.h"
 
 namespace dart {
 
 // Forward declarations.
-class FreeList;
 class Heap;
-class HeapPage;
+class Isolate;
 
 // The class GCSweeper is used to visit the heap after marking to reclaim unused
 // memory.
 class GCSweeper {
  public:
-  explicit GCSweeper(Heap* heap) : heap_(heap) {}
+  // A lazy sweeper runs after the mark-sweep has finished, possibly next to
+  // the mutator or another sweeper updating object headers. It clears the mark
+  // bits atomically.
+  explicit GCSweeper(Heap* heap, bool is_lazy = false)
+      : heap_(heap), is_lazy_(is_lazy) {}
   ~GCSweeper() {}
 
   // Sweep the memory area for the page while clearing the mark bits and adding
@@ -30,10 +36,76 @@ class GCSweeper {
 
  private:
   Heap* heap_;
+  const bool is_lazy_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(GCSweeper);
 };
 
+
+// The class ConcurrentSweeper sweeps the pages left unswept by a mark-sweep on
+// a thread pool task while the mutator keeps running. The mutator may sweep
+// pages on demand at the same time, so pages are claimed one at a time. The
+// free memory found by the task is handed to the page space in TakeFreeLists.
+class ConcurrentSweeper {
+ public:
+  ConcurrentSweeper(Isolate* isolate, PageSpace* page_space);
+  ~ConcurrentSweeper();
+
+  // The mutator only sets the remembered bit of an object atomically on ia32
+  // and x64.
+  static bool IsSupported();
+
+  void Start();
+
+  // Stops the sweeping task once it is done with its current page.
+  void Stop();
+
+  // While paused the sweeping task does not touch the heap. Pauses nest.
+  void Pause();
+  void Resume();
+
+  // Claims the next unswept page for the caller. Returns NULL when all pages
+  // have been claimed.
+  HeapPage* ClaimPage();
+
+  // Moves the free list elements of the pages swept by the task into
+  // 'freelists', which is indexed by page type. Returns false if there were
+  // none.
+  bool TakeFreeLists(FreeList* freelists);
+
+  // Whether the task has finished, which it does once all pages have been
+  // claimed.
+  bool IsDone();
+
+  // The number of pages swept by the task.
+  intptr_t swept_pages();
+
+ private:
+  class SweeperTask;
+
+  void Run();
+
+  Isolate* isolate_;
+  Heap* heap_;
+  PageSpace* page_space_;
+
+  // The following fields are protected by monitor_.
+  Monitor monitor_;
+  FreeList freelist_[HeapPage::kNumPageTypes];
+  bool has_free_;
+  intptr_t swept_pages_;
+  intptr_t pause_requests_;
+  bool paused_;
+  bool running_;
+  bool abort_;
+
+  bool stopped_;
+
+  friend class SweeperTask;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentSweeper);
+};
+
 }  // namespace dart
 
 #endif  // VM_GC_SWEEPER_H_
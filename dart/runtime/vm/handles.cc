@@ -109,18 +109,32 @@ HandleScope::~HandleScope() {
 
 
 #if defined(DEBUG)
-NoHandleScope::NoHandleScope(BaseIsolate* isolate) : StackResource(isolate) {
-  isolate->IncrementNoHandleScopeDepth();
+// No bookkeeping is done while GC helper threads share the isolate.
+static BaseIsolate* NoHandleScopeIsolate(BaseIsolate* isolate) {
+  return isolate->gc_helpers_active() ? NULL : isolate;
 }
 
 
-NoHandleScope::NoHandleScope() : StackResource(Isolate::Current()) {
-  isolate()->IncrementNoHandleScopeDepth();
+NoHandleScope::NoHandleScope(BaseIsolate* isolate)
+    : StackResource(NoHandleScopeIsolate(isolate)) {
+  if (this->isolate() != NULL) {
+    this->isolate()->IncrementNoHandleScopeDepth();
+  }
+}
+
+
+NoHandleScope::NoHandleScope()
+    : StackResource(NoHandleScopeIsolate(Isolate::Current())) {
+  if (isolate() != NULL) {
+    isolate()->IncrementNoHandleScopeDepth();
+  }
 }
 
 
 NoHandleScope::~NoHandleScope() {
-  isolate()->DecrementNoHandleScopeDepth();
+  if (isolate() != NULL) {
+    isolate()->DecrementNoHandleScopeDepth();
+  }
 }
 #endif  // defined(DEBUG)
 
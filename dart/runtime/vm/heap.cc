@@ -7,9 +7,12 @@
 #include "platform/assert.h"
 #include "platform/utils.h"
 #include "vm/flags.h"
+#include "vm/gc_marker.h"
+#include "vm/gc_sweeper.h"
 #include "vm/heap_histogram.h"
 #include "vm/heap_profiler.h"
 #include "vm/isolate.h"
+#include "vm/json_stream.h"
 #include "vm/object.h"
 #include "vm/object_set.h"
 #include "vm/os.h"
@@ -17,6 +20,7 @@
 #include "vm/raw_object.h"
 #include "vm/scavenger.h"
 #include "vm/stack_frame.h"
+#include "vm/store_buffer.h"
 #include "vm/verifier.h"
 #include "vm/virtual_memory.h"
 #include "vm/weak_table.h"
@@ -80,6 +84,11 @@ uword Heap::AllocateNew(intptr_t size) {
 uword Heap::AllocateOld(intptr_t size, HeapPage::PageType type) {
   ASSERT(Isolate::Current()->no_gc_scope_depth() == 0);
   uword addr = old_space_->TryAllocate(size, type);
+  if ((addr == 0) && old_space_->IsSweeping()) {
+    // Wait for the concurrent sweeper rather than collect.
+    old_space_->FinishSweeping();
+    addr = old_space_->TryAllocate(size, type);
+  }
   if (addr == 0) {
     CollectAllGarbage();
     addr = old_space_->TryAllocate(size, type, PageSpace::kForceGrowth);
@@ -136,6 +145,11 @@ void Heap::IterateOldPointers(ObjectPointerVisitor* visitor) {
 }
 
 
+void Heap::IterateRememberedCards(ObjectPointerVisitor* visitor) {
+  old_space_->VisitRememberedCards(visitor);
+}
+
+
 void Heap::IterateNewObjects(ObjectVisitor* visitor) {
   new_space_->VisitObjects(visitor);
 }
@@ -166,6 +180,12 @@ void Heap::CollectGarbage(Space space, ApiCallbacks api_callbacks) {
       if (new_space_->HadPromotionFailure()) {
         // Old collections should call the API callbacks.
         CollectGarbage(kOld, kInvokeApiCallbacks);
+      } else {
+        old_space_->TryFinishSweeping();
+        old_space_->TrimPageCache();
+        if (old_space_->ShouldStartConcurrentMarking()) {
+          StartConcurrentMarking();
+        }
       }
       break;
     }
@@ -216,6 +236,66 @@ void Heap::CollectAllGarbage() {
 }
 
 
+ConcurrentMarker* Heap::concurrent_marker() const {
+  return old_space_->concurrent_marker();
+}
+
+
+void Heap::StartConcurrentMarking() {
+  if (FLAG_verbose_gc) {
+    OS::PrintErr("Starting concurrent marking of old space.\n");
+  }
+  old_space_->StartConcurrentMarking();
+}
+
+
+void Heap::FinishConcurrentMarking() {
+  if (old_space_->concurrent_marker() == NULL) {
+    // An old space collection has already finished the marking.
+    return;
+  }
+  RecordBeforeGC(kOld, kConcurrentMarking);
+  old_space_->MarkSweep(kInvokeApiCallbacks);
+  RecordAfterGC();
+  PrintStats();
+  UpdateObjectHistogram();
+}
+
+
+ConcurrentSweeper* Heap::concurrent_sweeper() const {
+  return old_space_->concurrent_sweeper();
+}
+
+
+void Heap::FinishSweeping() {
+  old_space_->FinishSweeping();
+}
+
+
+void Heap::MarkingBarrier(RawObject* raw_obj) {
+  StoreBuffer* marking_buffer = Isolate::Current()->marking_buffer();
+  marking_buffer->AddObjectGC(raw_obj);
+  if (marking_buffer->Count() >= StoreBufferBlock::kSize) {
+    ProcessMarkingBuffer();
+  }
+}
+
+
+void Heap::ProcessMarkingBuffer() {
+  StoreBufferBlock* blocks = Isolate::Current()->marking_buffer()->Blocks();
+  ConcurrentMarker* marker = concurrent_marker();
+  if (marker != NULL) {
+    marker->AddBarrierBlocks(blocks);
+    return;
+  }
+  while (blocks != NULL) {
+    StoreBufferBlock* next = blocks->next();
+    delete blocks;
+    blocks = next;
+  }
+}
+
+
 void Heap::SetGrowthControlState(bool state) {
   old_space_->SetGrowthControlState(state);
 }
@@ -233,13 +313,35 @@ void Heap::WriteProtect(bool read_only) {
 }
 
 
-uword Heap::TopAddress() {
-  return reinterpret_cast<uword>(new_space_->TopAddress());
+uword Heap::TopAddress(Space space) {
+  switch (space) {
+    case kNew:
+      return reinterpret_cast<uword>(new_space_->TopAddress());
+    case kOld:
+      return reinterpret_cast<uword>(old_space_->TopAddress(HeapPage::kData));
+    case kCode:
+      return reinterpret_cast<uword>(
+          old_space_->TopAddress(HeapPage::kExecutable));
+    default:
+      UNREACHABLE();
+  }
+  return 0;
 }
 
 
-uword Heap::EndAddress() {
-  return reinterpret_cast<uword>(new_space_->EndAddress());
+uword Heap::EndAddress(Space space) {
+  switch (space) {
+    case kNew:
+      return reinterpret_cast<uword>(new_space_->EndAddress());
+    case kOld:
+      return reinterpret_cast<uword>(old_space_->EndAddress(HeapPage::kData));
+    case kCode:
+      return reinterpret_cast<uword>(
+          old_space_->EndAddress(HeapPage::kExecutable));
+    default:
+      UNREACHABLE();
+  }
+  return 0;
 }
 
 
@@ -302,6 +404,38 @@ void Heap::PrintSizes() const {
                (CapacityInWords(kNew) / KBInWords),
                (UsedInWords(kOld) / KBInWords),
                (CapacityInWords(kOld) / KBInWords));
+  OS::PrintErr("Page cache (%" Pd "k, %" Pd "k resident) "
+               "Pages (%" Pd " mapped, %" Pd " unmapped, %" Pd " reused)\n",
+               (old_space_->CachedInWords() / KBInWords),
+               (old_space_->ResidentCachedInWords() / KBInWords),
+               old_space_->mapped_pages(),
+               old_space_->unmapped_pages(),
+               old_space_->reused_pages());
+}
+
+
+void Heap::PrintToJSONStream(JSONStream* stream) const {
+  JSONObject jsobj(stream);
+  jsobj.AddProperty("type", "Heap");
+  {
+    JSONObject new_space(&jsobj, "newSpace");
+    new_space.AddProperty("used", RoundWordsToKB(UsedInWords(kNew)));
+    new_space.AddProperty("capacity",
+                          RoundWordsToKB(CapacityInWords(kNew)));
+  }
+  {
+    JSONObject old_space(&jsobj, "oldSpace");
+    old_space.AddProperty("used", RoundWordsToKB(UsedInWords(kOld)));
+    old_space.AddProperty("capacity",
+                          RoundWordsToKB(CapacityInWords(kOld)));
+    old_space.AddProperty("resident",
+                          RoundWordsToKB(old_space_->ResidentInWords()));
+    old_space.AddProperty("cached",
+                          RoundWordsToKB(old_space_->CachedInWords()));
+    old_space.AddProperty("mappedPages", old_space_->mapped_pages());
+    old_space.AddProperty("unmappedPages", old_space_->unmapped_pages());
+    old_space.AddProperty("reusedPages", old_space_->reused_pages());
+  }
 }
 
 
@@ -369,6 +503,8 @@ const char* Heap::GCReasonToString(GCReason gc_reason) {
       return "debugging";
     case kGCTestCase:
       return "test case";
+    case kConcurrentMarking:
+      return "concurrent marking";
     default:
       UNREACHABLE();
       return "";
@@ -513,4 +649,32 @@ NoHeapGrowthControlScope::~NoHeapGrowthControlScope() {
     heap->SetGrowthControlState(current_growth_controller_state_);
 }
 
+
+PauseConcurrentGCScope::PauseConcurrentGCScope()
+    : StackResource(Isolate::Current()),
+      marker_(NULL),
+      sweeper_(NULL) {
+  Isolate* isolate = reinterpret_cast<Isolate*>(this->isolate());
+  if ((isolate != NULL) && (isolate->heap() != NULL)) {
+    marker_ = isolate->heap()->concurrent_marker();
+    sweeper_ = isolate->heap()->concurrent_sweeper();
+  }
+  if (marker_ != NULL) {
+    marker_->Pause();
+  }
+  if (sweeper_ != NULL) {
+    sweeper_->Pause();
+  }
+}
+
+
+PauseConcurrentGCScope::~PauseConcurrentGCScope() {
+  if (sweeper_ != NULL) {
+    sweeper_->Resume();
+  }
+  if (marker_ != NULL) {
+    marker_->Resume();
+  }
+}
+
 }  // namespace dart
@@ -16,7 +16,10 @@
 namespace dart {
 
 // Forward declarations.
+class ConcurrentMarker;
+class ConcurrentSweeper;
 class Isolate;
+class JSONStream;
 class ObjectPointerVisitor;
 class ObjectSet;
 class VirtualMemory;
@@ -25,6 +28,7 @@ DECLARE_FLAG(bool, verbose_gc);
 DECLARE_FLAG(bool, verify_before_gc);
 DECLARE_FLAG(bool, verify_after_gc);
 DECLARE_FLAG(bool, gc_at_alloc);
+DECLARE_FLAG(bool, concurrent_mark);
 
 class Heap {
  public:
@@ -52,6 +56,7 @@ class Heap {
     kFull,
     kGCAtAlloc,
     kGCTestCase,
+    kConcurrentMarking,
   };
 
   // Default allocation sizes in MB for the old gen and code heaps.
@@ -116,6 +121,9 @@ class Heap {
   void IterateNewPointers(ObjectPointerVisitor* visitor);
   void IterateOldPointers(ObjectPointerVisitor* visitor);
 
+  // Visit the pointers covered by the dirty cards of the old space.
+  void IterateRememberedCards(ObjectPointerVisitor* visitor);
+
   // Visit all objects.
   void IterateObjects(ObjectVisitor* visitor);
 
@@ -137,6 +145,21 @@ class Heap {
   void CollectGarbage(Space space, ApiCallbacks api_callbacks);
   void CollectAllGarbage();
 
+  // Concurrent marking of the old generation, see --concurrent_mark. The
+  // marking is finished by a mark-sweep of the old generation.
+  ConcurrentMarker* concurrent_marker() const;
+  void StartConcurrentMarking();
+  void FinishConcurrentMarking();
+
+  // Called by the write barrier when an unmarked old object is stored into
+  // the old generation while it is being marked concurrently.
+  void MarkingBarrier(RawObject* raw_obj);
+  void ProcessMarkingBuffer();
+
+  // Lazy sweeping of the old generation, see --lazy_sweep.
+  ConcurrentSweeper* concurrent_sweeper() const;
+  void FinishSweeping();
+
   // Enables growth control on the page space heaps.  This should be
   // called before any user code is executed.
   void EnableGrowthControl() { SetGrowthControlState(true); }
@@ -147,9 +170,11 @@ class Heap {
   // Protect access to the heap.
   void WriteProtect(bool read_only);
 
-  // Accessors for inlined allocation in generated code.
-  uword TopAddress();
-  uword EndAddress();
+  // Accessors for inlined allocation in generated code. The old and code
+  // spaces bump allocate in an area carved out of their free lists, which is
+  // refilled by the runtime once exhausted.
+  uword TopAddress(Space space = kNew);
+  uword EndAddress(Space space = kNew);
   static intptr_t new_space_offset() { return OFFSET_OF(Heap, new_space_); }
 
   // Initialize the heap and register it with the isolate.
@@ -161,6 +186,10 @@ class Heap {
   // Print heap sizes.
   void PrintSizes() const;
 
+  // Print the heap sizes and the page counters of the old space for the
+  // service protocol.
+  void PrintToJSONStream(JSONStream* stream) const;
+
   // Return amount of memory used and capacity in a space.
   intptr_t UsedInWords(Space space) const;
   intptr_t CapacityInWords(Space space) const;
@@ -295,6 +324,7 @@ class Heap {
   bool gc_in_progress_;
 
   friend class GCTestHelper;
+  friend class HeapImage;
   DISALLOW_COPY_AND_ASSIGN(Heap);
 };
 
@@ -326,6 +356,19 @@ class NoHeapGrowthControlScope : public StackResource {
   DISALLOW_COPY_AND_ASSIGN(NoHeapGrowthControlScope);
 };
 
+
+// Keeps the concurrent marker or sweeper, if any, away from the heap while the
+// mutator rewrites object headers or data structures read by them.
+class PauseConcurrentGCScope : public StackResource {
+ public:
+  PauseConcurrentGCScope();
+  ~PauseConcurrentGCScope();
+ private:
+  ConcurrentMarker* marker_;
+  ConcurrentSweeper* sweeper_;
+  DISALLOW_COPY_AND_ASSIGN(PauseConcurrentGCScope);
+};
+
 }  // namespace dart
 
 #endif  // VM_HEAP_H_
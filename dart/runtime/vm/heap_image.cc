@@ -0,0 +1,734 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/heap_image.h"
+
+#include "vm/atomic.h"
+#include "vm/class_table.h"
+#include "vm/dart.h"
+#include "vm/freelist.h"
+#include "vm/heap.h"
+#include "vm/isolate.h"
+#include "vm/object.h"
+#include "vm/object_store.h"
+#include "vm/pages.h"
+#include "vm/raw_object.h"
+#include "vm/scavenger.h"
+#include "vm/snapshot.h"
+#include "vm/thread.h"
+#include "vm/thread_pool.h"
+#include "vm/virtual_memory.h"
+#include "vm/visitor.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool, clone_isolate_heap, false,
+            "Initialize an isolate created from a full snapshot which was "
+            "already read by copying the heap of the first isolate created "
+            "from it.");
+DEFINE_FLAG(int, heap_image_tasks, 1,
+            "Number of tasks used to copy and relocate the pages of a heap "
+            "image, e.g: --heap_image_tasks=4 uses the isolate thread and 3 "
+            "helpers");
+
+Mutex* HeapImage::mutex_ = NULL;
+HeapImage* HeapImage::images_ = NULL;
+
+
+// An address in the VM binary, by which the distance it moved between the
+// process which wrote a heap image snapshot and the one reading it is known.
+static uword NativeAnchor() {
+  return reinterpret_cast<uword>(&HeapImage::Capture);
+}
+
+
+template<typename T>
+static void SortByStart(T* regions, intptr_t length) {
+  for (intptr_t i = 1; i < length; i++) {
+    T region = regions[i];
+    intptr_t j = i - 1;
+    while ((j >= 0) && (regions[j].start > region.start)) {
+      regions[j + 1] = regions[j];
+      j--;
+    }
+    regions[j + 1] = region;
+  }
+}
+
+
+// Returns the index of the region containing 'addr' or -1.
+template<typename T>
+static intptr_t FindByAddress(const T* regions, intptr_t length, uword addr) {
+  intptr_t low = 0;
+  intptr_t high = length - 1;
+  while (low <= high) {
+    intptr_t mid = low + ((high - low) >> 1);
+    const T& region = regions[mid];
+    if (addr < region.start) {
+      high = mid - 1;
+    } else if (addr >= (region.start + region.size)) {
+      low = mid + 1;
+    } else {
+      return mid;
+    }
+  }
+  return -1;
+}
+
+
+class HeapImageWriter : public BaseWriter {
+ public:
+  HeapImageWriter(uint8_t** buffer, ReAlloc alloc)
+      : BaseWriter(buffer, alloc, kInitialSize) {
+    ReserveHeader();
+  }
+
+  void WriteWord(uword value) {
+    WriteIntptrValue(static_cast<intptr_t>(value));
+  }
+
+  // Pads the snapshot with zeros up to a multiple of 'alignment'.
+  void Align(intptr_t alignment) {
+    while ((BytesWritten() % alignment) != 0) {
+      Write<uint8_t>(0);
+    }
+  }
+
+  void Finish() {
+    FillHeader(Snapshot::kHeapImage);
+  }
+
+ private:
+  static const intptr_t kInitialSize = 64 * KB;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapImageWriter);
+};
+
+
+class CollectRootsVisitor : public ObjectPointerVisitor {
+ public:
+  CollectRootsVisitor(Isolate* isolate, HeapImage* image)
+      : ObjectPointerVisitor(isolate), image_(image) { }
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    intptr_t length = (last - first) + 1;
+    image_->roots_ = reinterpret_cast<RawObject**>(
+        realloc(image_->roots_,
+                (image_->num_roots_ + length) * sizeof(RawObject*)));
+    for (intptr_t i = 0; i < length; i++) {
+      image_->roots_[image_->num_roots_++] = first[i];
+    }
+  }
+
+ private:
+  HeapImage* image_;
+
+  DISALLOW_COPY_AND_ASSIGN(CollectRootsVisitor);
+};
+
+
+class RestoreRootsVisitor : public ObjectPointerVisitor {
+ public:
+  RestoreRootsVisitor(Isolate* isolate,
+                      const HeapImage* image,
+                      const intptr_t* deltas)
+      : ObjectPointerVisitor(isolate),
+        image_(image),
+        deltas_(deltas),
+        index_(0) { }
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    for (RawObject** current = first; current <= last; current++) {
+      ASSERT(index_ < image_->num_roots_);
+      *current = image_->Relocate(image_->roots_[index_++], deltas_);
+    }
+  }
+
+ private:
+  const HeapImage* image_;
+  const intptr_t* deltas_;
+  intptr_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(RestoreRootsVisitor);
+};
+
+
+class RelocatePointersVisitor : public ObjectPointerVisitor {
+ public:
+  RelocatePointersVisitor(Isolate* isolate,
+                          const HeapImage* image,
+                          const intptr_t* deltas)
+      : ObjectPointerVisitor(isolate), image_(image), deltas_(deltas) { }
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    for (RawObject** current = first; current <= last; current++) {
+      *current = image_->Relocate(*current, deltas_);
+    }
+  }
+
+ private:
+  const HeapImage* image_;
+  const intptr_t* deltas_;
+
+  DISALLOW_COPY_AND_ASSIGN(RelocatePointersVisitor);
+};
+
+
+// State shared by the tasks restoring an image. The regions are handed out
+// one at a time, first to be copied into their pages and then, once the
+// classes are registered, to have the objects in them relocated.
+class HeapImageRestorer : public ValueObject {
+ public:
+  enum Phase {
+    kCopy,
+    kRelocate
+  };
+
+  HeapImageRestorer(Isolate* isolate,
+                    const HeapImage* image,
+                    const intptr_t* deltas,
+                    intptr_t num_tasks)
+      : isolate_(isolate),
+        image_(image),
+        deltas_(deltas),
+        num_tasks_(num_tasks),
+        phase_(kCopy),
+        next_region_(0),
+        running_tasks_(0),
+        freelists_(new FreeList[num_tasks]),
+        used_(new intptr_t[num_tasks]) {
+    for (intptr_t i = 0; i < num_tasks_; i++) {
+      used_[i] = 0;
+    }
+  }
+
+  ~HeapImageRestorer() {
+    ASSERT(running_tasks_ == 0);
+    delete[] freelists_;
+    delete[] used_;
+  }
+
+  // Runs a phase on the helpers and the isolate's own thread and waits for
+  // all of them to be done.
+  void RunPhase(Phase phase);
+
+  void Work(intptr_t task_id);
+
+  void TaskDone() {
+    ScopedMonitor ml(&monitor_);
+    running_tasks_--;
+    ml.NotifyAll();
+  }
+
+  // Hands the free list elements found by the tasks over to 'freelist' and
+  // returns the size of the objects in the regions.
+  intptr_t Finish(FreeList* freelist);
+
+ private:
+  void CopyRegion(intptr_t index);
+  void RelocateRegion(intptr_t index,
+                      RelocatePointersVisitor* visitor,
+                      FreeList* freelist,
+                      intptr_t* used);
+
+  Isolate* isolate_;
+  const HeapImage* image_;
+  const intptr_t* deltas_;
+  const intptr_t num_tasks_;
+  Phase phase_;
+  uintptr_t next_region_;
+  Monitor monitor_;
+  intptr_t running_tasks_;
+  FreeList* freelists_;
+  intptr_t* used_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapImageRestorer);
+};
+
+
+class HeapImageRestoreTask : public ThreadPool::Task {
+ public:
+  HeapImageRestoreTask(Isolate* isolate,
+                       HeapImageRestorer* restorer,
+                       intptr_t task_id)
+      : isolate_(isolate), restorer_(restorer), task_id_(task_id) { }
+
+  virtual void Run() {
+    Isolate* saved_isolate = Isolate::Current();
+    Isolate::SetCurrentGCHelper(isolate_);
+    restorer_->Work(task_id_);
+    Isolate::SetCurrentGCHelper(saved_isolate);
+    // The restorer must not be touched after signalling completion.
+    restorer_->TaskDone();
+  }
+
+ private:
+  Isolate* isolate_;
+  HeapImageRestorer* restorer_;
+  intptr_t task_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapImageRestoreTask);
+};
+
+
+void HeapImageRestorer::RunPhase(Phase phase) {
+  phase_ = phase;
+  next_region_ = 0;
+  running_tasks_ = num_tasks_ - 1;
+#if defined(DEBUG)
+  if (num_tasks_ > 1) {
+    isolate_->IncrementGCHelperDepth();
+  }
+#endif
+  for (intptr_t i = 1; i < num_tasks_; i++) {
+    Dart::thread_pool()->RunHelper(new HeapImageRestoreTask(isolate_, this, i));
+  }
+  Work(0);
+  {
+    ScopedMonitor ml(&monitor_);
+    while (running_tasks_ > 0) {
+      ml.Wait();
+    }
+  }
+#if defined(DEBUG)
+  if (num_tasks_ > 1) {
+    isolate_->DecrementGCHelperDepth();
+  }
+#endif
+}
+
+
+void HeapImageRestorer::Work(intptr_t task_id) {
+  RelocatePointersVisitor visitor(isolate_, image_, deltas_);
+  while (true) {
+    intptr_t index = AtomicOperations::FetchAndIncrement(&next_region_);
+    if (index >= image_->num_regions_) {
+      return;
+    }
+    if (phase_ == kCopy) {
+      CopyRegion(index);
+    } else {
+      RelocateRegion(index, &visitor, &freelists_[task_id], &used_[task_id]);
+    }
+  }
+}
+
+
+void HeapImageRestorer::CopyRegion(intptr_t index) {
+  const HeapImage::Region& region = image_->regions_[index];
+  memmove(reinterpret_cast<void*>(region.start + deltas_[index]),
+          region.objects,
+          region.size);
+}
+
+
+void HeapImageRestorer::RelocateRegion(intptr_t index,
+                                       RelocatePointersVisitor* visitor,
+                                       FreeList* freelist,
+                                       intptr_t* used) {
+  const HeapImage::Region& region = image_->regions_[index];
+  uword current = region.start + deltas_[index];
+  uword end = current + region.size;
+  while (current < end) {
+    RawObject* raw_obj = RawObject::FromAddr(current);
+    intptr_t size = raw_obj->Size();
+    if (raw_obj->IsFreeListElement()) {
+      freelist->Free(current, size);
+    } else {
+      // The new space of the isolate is empty.
+      raw_obj->ClearRememberedBit();
+      image_->RelocateNativeFields(raw_obj);
+      raw_obj->VisitPointers(visitor);
+      *used += size;
+    }
+    current += size;
+  }
+  ASSERT(current == end);
+}
+
+
+intptr_t HeapImageRestorer::Finish(FreeList* freelist) {
+  intptr_t used = 0;
+  for (intptr_t i = 0; i < num_tasks_; i++) {
+    freelist->Merge(&freelists_[i]);
+    used += used_[i];
+  }
+  return used;
+}
+
+
+HeapImage::~HeapImage() {
+  if (owns_objects_) {
+    for (intptr_t i = 0; i < num_regions_; i++) {
+      free(const_cast<uint8_t*>(regions_[i].objects));
+    }
+  }
+  delete[] regions_;
+  free(roots_);
+  delete[] classes_;
+  delete[] vm_regions_;
+}
+
+
+HeapPage* HeapImage::NextPage(PageSpace* space, HeapPage* page) {
+  if (page == NULL) {
+    return (space->pages_ != NULL) ? space->pages_ : space->large_pages_;
+  }
+  if (page == space->pages_tail_) {
+    return space->large_pages_;
+  }
+  return page->next();
+}
+
+
+HeapImage* HeapImage::Capture(Isolate* isolate, const uint8_t* snapshot) {
+  Heap* heap = isolate->heap();
+  // Only the old generation is copied, and the weak tables are keyed by
+  // address.
+  if ((heap->new_space_->UsedInWords() != 0) ||
+      (heap->PeerCount() != 0) ||
+      (heap->HashCount() != 0)) {
+    return NULL;
+  }
+  PageSpace* old_space = heap->old_space_;
+  ASSERT(!old_space->IsSweeping());
+  ASSERT(old_space->concurrent_marker() == NULL);
+  intptr_t num_regions = 0;
+  for (HeapPage* page = NextPage(old_space, NULL);
+       page != NULL;
+       page = NextPage(old_space, page)) {
+    if (page->type() == HeapPage::kExecutable) {
+      // Code cannot be relocated by adjusting its object pointers.
+      return NULL;
+    }
+    num_regions++;
+  }
+  // The classes are registered again in the order of their ids, which
+  // requires the table to have no holes.
+  ClassTable* class_table = isolate->class_table();
+  for (intptr_t cid = kNumPredefinedCids; cid < class_table->NumCids(); cid++) {
+    if (!class_table->HasValidClassAt(cid)) {
+      return NULL;
+    }
+  }
+
+  // The unused rest of the bump allocation areas becomes a free list element
+  // so that the copied pages can be walked.
+  old_space->MakeIterable();
+  HeapImage* image = new HeapImage();
+  image->snapshot_ = snapshot;
+  // The token streams point into the snapshot.
+  image->external_start_ = reinterpret_cast<uword>(snapshot);
+  image->external_size_ = Snapshot::SetupFromBuffer(snapshot)->length();
+  image->regions_ = new Region[num_regions];
+  bool is_large = (old_space->pages_ == NULL);
+  for (HeapPage* page = NextPage(old_space, NULL);
+       page != NULL;
+       page = NextPage(old_space, page)) {
+    Region* region = &image->regions_[image->num_regions_++];
+    region->start = page->object_start();
+    region->size = page->object_end() - page->object_start();
+    uint8_t* objects = reinterpret_cast<uint8_t*>(malloc(region->size));
+    memmove(objects, reinterpret_cast<void*>(region->start), region->size);
+    region->objects = objects;
+    region->is_large = is_large;
+    if (page == old_space->pages_tail_) {
+      is_large = true;
+    }
+  }
+  ASSERT(image->num_regions_ == num_regions);
+  SortByStart(image->regions_, num_regions);
+
+  CollectRootsVisitor roots_visitor(isolate, image);
+  isolate->object_store()->VisitObjectPointers(&roots_visitor);
+  image->num_cids_ = class_table->NumCids();
+  image->classes_ = new RawClass*[image->num_cids_];
+  image->classes_[0] = NULL;
+  for (intptr_t cid = 1; cid < image->num_cids_; cid++) {
+    image->classes_[cid] =
+        class_table->HasValidClassAt(cid) ? class_table->At(cid) : NULL;
+  }
+  return image;
+}
+
+
+RawObject* HeapImage::Relocate(RawObject* raw_obj,
+                               const intptr_t* deltas) const {
+  // The other pointers refer to the VM isolate heap, which is shared.
+  if (!raw_obj->IsHeapObject() || !raw_obj->IsOldObject()) {
+    return raw_obj;
+  }
+  uword addr = RawObject::ToAddr(raw_obj);
+  intptr_t index = FindByAddress(regions_, num_regions_, addr);
+  if (index >= 0) {
+    return reinterpret_cast<RawObject*>(
+        reinterpret_cast<uword>(raw_obj) + deltas[index]);
+  }
+  index = FindByAddress(vm_regions_, num_vm_regions_, addr);
+  if (index >= 0) {
+    return reinterpret_cast<RawObject*>(
+        reinterpret_cast<uword>(raw_obj) + vm_regions_[index].delta);
+  }
+  return raw_obj;
+}
+
+
+void HeapImage::RelocateNativeFields(RawObject* raw_obj) const {
+  intptr_t cid = raw_obj->GetClassId();
+  if ((cid == kLibraryCid) && (native_delta_ != 0)) {
+    RawLibrary* raw_library = reinterpret_cast<RawLibrary*>(raw_obj);
+    uword resolver =
+        reinterpret_cast<uword>(raw_library->ptr()->native_entry_resolver_);
+    if (resolver != 0) {
+      raw_library->ptr()->native_entry_resolver_ =
+          reinterpret_cast<Dart_NativeEntryResolver>(resolver + native_delta_);
+    }
+  } else if (RawObject::IsExternalTypedDataClassId(cid) &&
+             (external_delta_ != 0)) {
+    RawExternalTypedData* raw_typed_data =
+        reinterpret_cast<RawExternalTypedData*>(raw_obj);
+    uword data = reinterpret_cast<uword>(raw_typed_data->ptr()->data_);
+    if ((data >= external_start_) &&
+        (data < (external_start_ + external_size_))) {
+      raw_typed_data->ptr()->data_ =
+          reinterpret_cast<uint8_t*>(data + external_delta_);
+    }
+  }
+}
+
+
+void HeapImage::Restore(Isolate* isolate) const {
+  Heap* heap = isolate->heap();
+  PageSpace* old_space = heap->old_space_;
+  ASSERT(old_space->pages_ == NULL);
+  ASSERT(old_space->large_pages_ == NULL);
+  intptr_t* deltas = new intptr_t[num_regions_];
+  for (intptr_t i = 0; i < num_regions_; i++) {
+    const Region& region = regions_[i];
+    HeapPage* page = region.is_large ?
+        old_space->AllocateLargePage(region.size, HeapPage::kData) :
+        old_space->AllocatePage(HeapPage::kData);
+    ASSERT(static_cast<intptr_t>(page->object_end() - page->object_start()) ==
+           region.size);
+    deltas[i] = page->object_start() - region.start;
+  }
+  // Unlike allocating the pages, copying the regions into them and
+  // relocating their objects can be spread over several threads.
+  intptr_t num_tasks = FLAG_heap_image_tasks;
+  num_tasks = Utils::Maximum(Utils::Minimum(num_tasks, num_regions_),
+                             static_cast<intptr_t>(1));
+  HeapImageRestorer restorer(isolate, this, deltas, num_tasks);
+  restorer.RunPhase(HeapImageRestorer::kCopy);
+
+  // Walking the objects looks up their classes, so the class table comes
+  // first.
+  ClassTable* class_table = isolate->class_table();
+  Class& cls = Class::Handle(isolate);
+  for (intptr_t cid = 1; cid < num_cids_; cid++) {
+    if ((classes_[cid] == NULL) ||
+        ((cid < kNumPredefinedCids) && class_table->HasValidClassAt(cid))) {
+      // The classes of the VM isolate are already in the table.
+      continue;
+    }
+    cls ^= Relocate(classes_[cid], deltas);
+    if (native_delta_ != 0) {
+      cls.set_handle_vtable(reinterpret_cast<cpp_vtable>(
+          reinterpret_cast<uword>(cls.handle_vtable()) + native_delta_));
+    }
+    if (cid >= kNumPredefinedCids) {
+      cls.set_id(kIllegalCid);
+    }
+    isolate->RegisterClass(cls);
+    ASSERT(cls.id() == cid);
+  }
+
+  restorer.RunPhase(HeapImageRestorer::kRelocate);
+  intptr_t used = restorer.Finish(&old_space->freelist_[HeapPage::kData]);
+  old_space->used_in_words_ += (used >> kWordSizeLog2);
+
+  RestoreRootsVisitor roots_visitor(isolate, this, deltas);
+  isolate->object_store()->VisitObjectPointers(&roots_visitor);
+  delete[] deltas;
+}
+
+
+intptr_t HeapImage::SizeInWords() const {
+  intptr_t size = 0;
+  for (intptr_t i = 0; i < num_regions_; i++) {
+    size += regions_[i].size;
+  }
+  return size >> kWordSizeLog2;
+}
+
+
+void HeapImage::InitOnce() {
+  ASSERT(mutex_ == NULL);
+  mutex_ = new Mutex();
+  ASSERT(mutex_ != NULL);
+}
+
+
+const HeapImage* HeapImage::Lookup(const uint8_t* snapshot) {
+  MutexLocker ml(mutex_);
+  for (HeapImage* image = images_; image != NULL; image = image->next_) {
+    if (image->snapshot_ == snapshot) {
+      return image;
+    }
+  }
+  return NULL;
+}
+
+
+const HeapImage* HeapImage::Add(HeapImage* image) {
+  ASSERT(image != NULL);
+  MutexLocker ml(mutex_);
+  for (HeapImage* current = images_;
+       current != NULL;
+       current = current->next_) {
+    if (current->snapshot_ == image->snapshot_) {
+      delete image;
+      return current;
+    }
+  }
+  image->next_ = images_;
+  images_ = image;
+  return image;
+}
+
+
+intptr_t HeapImage::WriteSnapshot(uint8_t** buffer, ReAlloc alloc) const {
+  // The roots, classes and objects of an image read from a heap image
+  // snapshot still refer to the addresses of the process which captured it.
+  ASSERT(is_captured());
+  HeapImageWriter writer(buffer, alloc);
+  const intptr_t alignment = VirtualMemory::PageSize();
+  writer.WriteWord(NativeAnchor());
+  writer.WriteIntptrValue(alignment);
+  writer.WriteWord(external_start_ + external_delta_);
+  writer.WriteIntptrValue(external_size_);
+
+  PageSpace* vm_space = Dart::vm_isolate()->heap()->old_space_;
+  intptr_t num_vm_regions = 0;
+  for (HeapPage* page = NextPage(vm_space, NULL);
+       page != NULL;
+       page = NextPage(vm_space, page)) {
+    num_vm_regions++;
+  }
+  writer.WriteIntptrValue(num_vm_regions);
+  for (HeapPage* page = NextPage(vm_space, NULL);
+       page != NULL;
+       page = NextPage(vm_space, page)) {
+    writer.WriteWord(page->object_start());
+    writer.WriteIntptrValue(page->object_end() - page->object_start());
+  }
+
+  writer.WriteIntptrValue(num_regions_);
+  for (intptr_t i = 0; i < num_regions_; i++) {
+    writer.WriteWord(regions_[i].start);
+    writer.WriteIntptrValue(regions_[i].size);
+    writer.Write<bool>(regions_[i].is_large);
+  }
+  writer.WriteIntptrValue(num_roots_);
+  for (intptr_t i = 0; i < num_roots_; i++) {
+    writer.WriteWord(reinterpret_cast<uword>(roots_[i]));
+  }
+  writer.WriteIntptrValue(num_cids_);
+  for (intptr_t i = 0; i < num_cids_; i++) {
+    writer.WriteWord(reinterpret_cast<uword>(classes_[i]));
+  }
+  writer.WriteBytes(
+      reinterpret_cast<const uint8_t*>(external_start_ + external_delta_),
+      external_size_);
+
+  // The objects of each page start at a page boundary of the snapshot.
+  for (intptr_t i = 0; i < num_regions_; i++) {
+    writer.Align(alignment);
+    writer.WriteBytes(regions_[i].objects, regions_[i].size);
+  }
+  writer.Align(alignment);
+  writer.Finish();
+  return writer.BytesWritten();
+}
+
+
+HeapImage* HeapImage::ReadSnapshot(const Snapshot* snapshot,
+                                   const uint8_t** full_snapshot) {
+  ASSERT(snapshot->kind() == Snapshot::kHeapImage);
+  const uint8_t* base = reinterpret_cast<const uint8_t*>(snapshot);
+  BaseReader reader(snapshot->content(),
+                    snapshot->length() - Snapshot::kHeaderSize);
+  HeapImage* image = new HeapImage();
+  image->snapshot_ = base;
+  image->owns_objects_ = false;
+  image->native_delta_ = NativeAnchor() - reader.Read<uword>();
+  const intptr_t alignment = reader.ReadIntptrValue();
+  image->external_start_ = reader.Read<uword>();
+  image->external_size_ = reader.ReadIntptrValue();
+
+  // The VM isolate heap is the same in every process running the same VM,
+  // but its pages may be elsewhere.
+  PageSpace* vm_space = Dart::vm_isolate()->heap()->old_space_;
+  image->num_vm_regions_ = reader.ReadIntptrValue();
+  image->vm_regions_ = new VMRegion[image->num_vm_regions_];
+  bool is_compatible = true;
+  HeapPage* page = NextPage(vm_space, NULL);
+  for (intptr_t i = 0; i < image->num_vm_regions_; i++) {
+    VMRegion* region = &image->vm_regions_[i];
+    region->start = reader.Read<uword>();
+    region->size = reader.ReadIntptrValue();
+    region->delta = 0;
+    if ((page == NULL) ||
+        (static_cast<intptr_t>(page->object_end() - page->object_start()) !=
+         region->size)) {
+      is_compatible = false;
+    } else {
+      region->delta = page->object_start() - region->start;
+      page = NextPage(vm_space, page);
+    }
+  }
+  if (page != NULL) {
+    is_compatible = false;
+  }
+  SortByStart(image->vm_regions_, image->num_vm_regions_);
+
+  image->num_regions_ = reader.ReadIntptrValue();
+  image->regions_ = new Region[image->num_regions_];
+  for (intptr_t i = 0; i < image->num_regions_; i++) {
+    Region* region = &image->regions_[i];
+    region->start = reader.Read<uword>();
+    region->size = reader.ReadIntptrValue();
+    region->objects = NULL;
+    region->is_large = reader.Read<bool>();
+  }
+  image->num_roots_ = reader.ReadIntptrValue();
+  image->roots_ = reinterpret_cast<RawObject**>(
+      malloc(image->num_roots_ * sizeof(RawObject*)));
+  for (intptr_t i = 0; i < image->num_roots_; i++) {
+    image->roots_[i] = reinterpret_cast<RawObject*>(reader.Read<uword>());
+  }
+  image->num_cids_ = reader.ReadIntptrValue();
+  image->classes_ = new RawClass*[image->num_cids_];
+  for (intptr_t i = 0; i < image->num_cids_; i++) {
+    image->classes_[i] = reinterpret_cast<RawClass*>(reader.Read<uword>());
+  }
+  const uint8_t* external = reader.CurrentBufferAddress();
+  image->external_delta_ =
+      reinterpret_cast<uword>(external) - image->external_start_;
+  *full_snapshot = external;
+  if (!is_compatible) {
+    delete image;
+    return NULL;
+  }
+  reader.Advance(image->external_size_);
+
+  for (intptr_t i = 0; i < image->num_regions_; i++) {
+    intptr_t offset = reader.CurrentBufferAddress() - base;
+    reader.Advance(Utils::RoundUp(offset, alignment) - offset);
+    image->regions_[i].objects = reader.CurrentBufferAddress();
+    reader.Advance(image->regions_[i].size);
+  }
+  return image;
+}
+
+}  // namespace dart
@@ -0,0 +1,168 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_HEAP_IMAGE_H_
+#define VM_HEAP_IMAGE_H_
+
+#include "vm/allocation.h"
+#include "vm/datastream.h"
+#include "vm/flags.h"
+#include "vm/globals.h"
+
+namespace dart {
+
+DECLARE_FLAG(bool, clone_isolate_heap);
+DECLARE_FLAG(int, heap_image_tasks);
+
+// Forward declarations.
+class HeapPage;
+class Isolate;
+class Mutex;
+class PageSpace;
+class RawClass;
+class RawObject;
+class Snapshot;
+
+// The class HeapImage is a copy of the old generation of an isolate which has
+// just read a full snapshot, together with the roots into it: the object store
+// and the class table. An isolate created from the same snapshot is
+// initialized by copying the pages of the image and relocating the pointers
+// into them, instead of reading the snapshot object by object.
+//
+// An image can be written as a heap image snapshot, whose pages are page
+// aligned so that the embedder can map the file read only. Since the process
+// reading it may have the VM binary, the VM isolate heap and the full snapshot
+// the image was captured from at other addresses, the image records where
+// they were and the pointers into them are relocated as well.
+class HeapImage {
+ public:
+  ~HeapImage();
+
+  // Copies the heap of the isolate, which must have read the full snapshot
+  // 'snapshot' and nothing else. Returns NULL if the heap cannot be copied,
+  // e.g. because it has objects in new space, executable pages or entries in
+  // weak tables.
+  static HeapImage* Capture(Isolate* isolate, const uint8_t* snapshot);
+
+  // Initializes the heap, object store and class table of the isolate, which
+  // must be freshly created, from this image. The pages are copied and
+  // relocated by --heap_image_tasks tasks.
+  void Restore(Isolate* isolate) const;
+
+  // Writes the image as a snapshot of kind Snapshot::kHeapImage and returns
+  // its size. Only captured images can be written.
+  intptr_t WriteSnapshot(uint8_t** buffer, ReAlloc alloc) const;
+  bool is_captured() const { return owns_objects_; }
+
+  // Sets up an image using the pages of a heap image snapshot, which has to
+  // stay valid as long as isolates are created from it. Returns NULL if the
+  // snapshot was written by a VM whose VM isolate heap differs. Sets
+  // 'full_snapshot' to the full snapshot the image was captured from, which
+  // is part of the heap image snapshot.
+  static HeapImage* ReadSnapshot(const Snapshot* snapshot,
+                                 const uint8_t** full_snapshot);
+
+  // The images are kept for the lifetime of the VM and are looked up by the
+  // snapshot they were captured from or read from, which already has to stay
+  // valid as long as isolates are created from it.
+  static void InitOnce();
+  static const HeapImage* Lookup(const uint8_t* snapshot);
+  // Takes ownership of the image and returns it, unless one was already
+  // added for its snapshot by another isolate, in which case it is deleted
+  // and the other one is returned.
+  static const HeapImage* Add(HeapImage* image);
+
+  intptr_t SizeInWords() const;
+
+ private:
+  // The objects of a page of the isolate the image was captured from.
+  struct Region {
+    uword start;
+    intptr_t size;
+    const uint8_t* objects;
+    bool is_large;
+  };
+
+  // A page of the VM isolate heap of the process which wrote the image, and
+  // the distance to the same page in this process.
+  struct VMRegion {
+    uword start;
+    intptr_t size;
+    intptr_t delta;
+  };
+
+  HeapImage()
+      : snapshot_(NULL),
+        next_(NULL),
+        regions_(NULL),
+        num_regions_(0),
+        owns_objects_(true),
+        roots_(NULL),
+        num_roots_(0),
+        classes_(NULL),
+        num_cids_(0),
+        vm_regions_(NULL),
+        num_vm_regions_(0),
+        native_delta_(0),
+        external_start_(0),
+        external_size_(0),
+        external_delta_(0) { }
+
+  // Iterates over the regular pages of a page space, then over its large
+  // pages. Returns the first page if 'page' is NULL.
+  static HeapPage* NextPage(PageSpace* space, HeapPage* page);
+
+  // Returns the pointer to the copy of an object of the image, 'deltas'
+  // holding the distance by which each region of the image was moved.
+  RawObject* Relocate(RawObject* raw_obj, const intptr_t* deltas) const;
+
+  // Adjusts the addresses outside of the heap held by an object of an image
+  // read from a heap image snapshot. Only touches the raw object, as it is
+  // called by the helpers restoring an image.
+  void RelocateNativeFields(RawObject* raw_obj) const;
+
+  const uint8_t* snapshot_;
+  HeapImage* next_;
+
+  // Sorted by start address.
+  Region* regions_;
+  intptr_t num_regions_;
+  // Whether the objects of the regions were copied into the image or are
+  // part of a heap image snapshot.
+  bool owns_objects_;
+
+  // The object store fields, in the order they are visited.
+  RawObject** roots_;
+  intptr_t num_roots_;
+
+  RawClass** classes_;
+  intptr_t num_cids_;
+
+  // The following fields are only set up by ReadSnapshot. The VM isolate
+  // regions are sorted by start address.
+  VMRegion* vm_regions_;
+  intptr_t num_vm_regions_;
+  // The distance by which the VM binary moved, which applies to the C++
+  // vtables of the classes and the native entry resolvers of the libraries.
+  intptr_t native_delta_;
+  // The full snapshot the image was captured from, into which the token
+  // streams point, and the distance to its copy in the heap image snapshot.
+  uword external_start_;
+  intptr_t external_size_;
+  intptr_t external_delta_;
+
+  static Mutex* mutex_;
+  static HeapImage* images_;
+
+  friend class CollectRootsVisitor;
+  friend class HeapImageRestorer;
+  friend class RelocatePointersVisitor;
+  friend class RestoreRootsVisitor;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapImage);
+};
+
+}  // namespace dart
+
+#endif  // VM_HEAP_IMAGE_H_
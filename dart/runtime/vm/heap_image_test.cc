@@ -0,0 +1,162 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/benchmark_test.h"
+#include "vm/dart_api_impl.h"
+#include "vm/globals.h"
+#include "vm/heap.h"
+#include "vm/heap_image.h"
+#include "vm/snapshot.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+// Uses classes of the core library which are not loaded by the test script.
+static const char* kCoreLibScriptChars =
+    "main() {\n"
+    "  var buffer = new StringBuffer();\n"
+    "  for (var i = 0; i < 10; i++) {\n"
+    "    buffer.write(i);\n"
+    "  }\n"
+    "  var map = {'digits': buffer.toString()};\n"
+    "  return map['digits'].length + [1, 2, 3].reversed.first;\n"
+    "}\n";
+
+
+static void RunCoreLibScript() {
+  Dart_EnterScope();
+  Dart_Handle lib = TestCase::LoadTestScript(kCoreLibScriptChars, NULL);
+  EXPECT_VALID(lib);
+  Dart_Handle result = Dart_Invoke(lib, NewString("main"), 0, NULL);
+  EXPECT_VALID(result);
+  int64_t value = 0;
+  EXPECT_VALID(Dart_IntegerToInt64(result, &value));
+  EXPECT_EQ(13, value);
+  Dart_ExitScope();
+}
+
+
+UNIT_TEST_CASE(HeapImage_CloneIsolateHeap) {
+  if (bin::snapshot_buffer == NULL) {
+    return;
+  }
+  bool saved_clone_isolate_heap = FLAG_clone_isolate_heap;
+  FLAG_clone_isolate_heap = true;
+  // The first isolate created from the snapshot reads it and captures its
+  // heap.
+  TestCase::CreateTestIsolate();
+  intptr_t num_cids = Isolate::Current()->class_table()->NumCids();
+  RunCoreLibScript();
+  Dart_ShutdownIsolate();
+  const HeapImage* image = HeapImage::Lookup(bin::snapshot_buffer);
+  EXPECT(image != NULL);
+  EXPECT_LT(0, image->SizeInWords());
+
+  // The next ones copy it.
+  for (intptr_t i = 0; i < 2; i++) {
+    TestCase::CreateTestIsolate();
+    Isolate* isolate = Isolate::Current();
+    EXPECT_EQ(num_cids, isolate->class_table()->NumCids());
+    EXPECT(isolate->heap()->Verify());
+    RunCoreLibScript();
+    isolate->heap()->CollectAllGarbage();
+    EXPECT(isolate->heap()->Verify());
+    RunCoreLibScript();
+    Dart_ShutdownIsolate();
+  }
+  FLAG_clone_isolate_heap = saved_clone_isolate_heap;
+}
+
+
+UNIT_TEST_CASE(HeapImage_RestoreWithTasks) {
+  if (bin::snapshot_buffer == NULL) {
+    return;
+  }
+  bool saved_clone_isolate_heap = FLAG_clone_isolate_heap;
+  int saved_heap_image_tasks = FLAG_heap_image_tasks;
+  FLAG_clone_isolate_heap = true;
+  TestCase::CreateTestIsolate();
+  Dart_ShutdownIsolate();
+  EXPECT(HeapImage::Lookup(bin::snapshot_buffer) != NULL);
+
+  // More tasks than pages are capped by the number of pages.
+  const int kNumTasks[] = { 2, 4, 1000 };
+  for (size_t i = 0; i < ARRAY_SIZE(kNumTasks); i++) {
+    FLAG_heap_image_tasks = kNumTasks[i];
+    TestCase::CreateTestIsolate();
+    Isolate* isolate = Isolate::Current();
+    EXPECT(isolate->heap()->Verify());
+    RunCoreLibScript();
+    isolate->heap()->CollectAllGarbage();
+    EXPECT(isolate->heap()->Verify());
+    Dart_ShutdownIsolate();
+  }
+  FLAG_heap_image_tasks = saved_heap_image_tasks;
+  FLAG_clone_isolate_heap = saved_clone_isolate_heap;
+}
+
+
+UNIT_TEST_CASE(HeapImage_HeapImageSnapshot) {
+  if (bin::snapshot_buffer == NULL) {
+    return;
+  }
+  bool saved_clone_isolate_heap = FLAG_clone_isolate_heap;
+  FLAG_clone_isolate_heap = true;
+  TestCase::CreateTestIsolate();
+  Dart_EnterScope();
+  uint8_t* buffer = NULL;
+  intptr_t size = 0;
+  // No isolate was created from the heap of another isolate.
+  uint8_t bogus_snapshot[Snapshot::kHeaderSize] = { 0 };
+  EXPECT(Dart_IsError(
+      Dart_CreateHeapImageSnapshot(bogus_snapshot, &buffer, &size)));
+  EXPECT_VALID(
+      Dart_CreateHeapImageSnapshot(bin::snapshot_buffer, &buffer, &size));
+  EXPECT(Snapshot::SetupFromBuffer(buffer)->IsHeapImageSnapshot());
+  // The buffer is scope allocated. The image read from the copy is kept for
+  // the lifetime of the VM, and so is the copy.
+  uint8_t* heap_image = reinterpret_cast<uint8_t*>(malloc(size));
+  memmove(heap_image, buffer, size);
+  Dart_ExitScope();
+  Dart_ShutdownIsolate();
+  FLAG_clone_isolate_heap = saved_clone_isolate_heap;
+
+  // Heap image snapshots are used without --clone_isolate_heap.
+  for (intptr_t i = 0; i < 2; i++) {
+    TestCase::CreateTestIsolateFromSnapshot(heap_image);
+    Isolate* isolate = Isolate::Current();
+    EXPECT(HeapImage::Lookup(heap_image) != NULL);
+    EXPECT(isolate->heap()->Verify());
+    RunCoreLibScript();
+    Dart_ShutdownIsolate();
+  }
+}
+
+
+//
+// Measure the creation of an isolate by copying the heap image captured from
+// the core snapshot.
+//
+BENCHMARK(CloneIsolateHeap) {
+  const int kNumIterations = 100;
+  bool saved_clone_isolate_heap = FLAG_clone_isolate_heap;
+  FLAG_clone_isolate_heap = true;
+  Dart_Isolate base_isolate = Dart_CurrentIsolate();
+  // Capture the image outside of the timed loop.
+  TestCase::CreateTestIsolate();
+  Dart_ShutdownIsolate();
+  Timer timer(true, "Clone isolate heap benchmark");
+  timer.Start();
+  for (int i = 0; i < kNumIterations; i++) {
+    TestCase::CreateTestIsolate();
+    Dart_ShutdownIsolate();
+  }
+  timer.Stop();
+  FLAG_clone_isolate_heap = saved_clone_isolate_heap;
+  Dart_EnterIsolate(base_isolate);
+  benchmark->set_score(timer.TotalElapsedTime() / kNumIterations);
+}
+
+}  // namespace dart
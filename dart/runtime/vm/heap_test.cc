@@ -3,6 +3,9 @@
 // BSD-style license that can be found in the LICENSE file.
 
 #include "platform/assert.h"
+#include "vm/benchmark_test.h"
+#include "vm/gc_compactor.h"
+#include "vm/gc_marker.h"
 #include "vm/globals.h"
 #include "vm/heap.h"
 #include "vm/unit_test.h"
@@ -46,4 +49,304 @@ TEST_CASE(LargeSweep) {
   Dart_ExitScope();
   heap->CollectGarbage(Heap::kOld);
 }
+
+
+// Builds two lists of old nodes. 'swap' moves the payloads of the spare list
+// into the root list and drops the spare list, so the payloads stay reachable
+// only through stores done while marking.
+static const char* kMarkingScriptChars =
+    "class Node {\n"
+    "  var next;\n"
+    "  var payload;\n"
+    "  Node(this.next, this.payload);\n"
+    "}\n"
+    "var root;\n"
+    "var spare;\n"
+    "build(n) {\n"
+    "  root = null;\n"
+    "  spare = null;\n"
+    "  for (var i = 0; i < n; i++) {\n"
+    "    root = new Node(root, [i, 0]);\n"
+    "    spare = new Node(spare, [0, i]);\n"
+    "  }\n"
+    "}\n"
+    "swap() {\n"
+    "  var node = root;\n"
+    "  var other = spare;\n"
+    "  spare = null;\n"
+    "  while (node != null) {\n"
+    "    node.payload = other.payload;\n"
+    "    node = node.next;\n"
+    "    other = other.next;\n"
+    "  }\n"
+    "}\n"
+    "sum() {\n"
+    "  var result = 0;\n"
+    "  for (var node = root; node != null; node = node.next) {\n"
+    "    result += node.payload[0] + node.payload[1];\n"
+    "  }\n"
+    "  return result;\n"
+    "}\n";
+
+
+static void BuildOldLists(Dart_Handle lib, intptr_t length) {
+  Dart_Handle args[1];
+  args[0] = Dart_NewInteger(length);
+  EXPECT_VALID(Dart_Invoke(lib, NewString("build"), 1, args));
+  // Two scavenges promote the lists.
+  Heap* heap = Isolate::Current()->heap();
+  heap->CollectGarbage(Heap::kNew);
+  heap->CollectGarbage(Heap::kNew);
+}
+
+
+TEST_CASE(ConcurrentMarking) {
+  if (!ConcurrentMarker::IsSupported()) {
+    return;
+  }
+  const intptr_t kLength = 10000;
+  const int64_t kExpectedSum =
+      static_cast<int64_t>(kLength) * (kLength - 1) / 2;
+  bool saved_concurrent_mark = FLAG_concurrent_mark;
+  FLAG_concurrent_mark = true;
+  Dart_Handle lib = TestCase::LoadTestScript(kMarkingScriptChars, NULL);
+  BuildOldLists(lib, kLength);
+  Heap* heap = Isolate::Current()->heap();
+  heap->StartConcurrentMarking();
+  EXPECT_VALID(Dart_Invoke(lib, NewString("swap"), 0, NULL));
+  // Scavenges pause the marker.
+  heap->CollectGarbage(Heap::kNew);
+  heap->FinishConcurrentMarking();
+  EXPECT(heap->concurrent_marker() == NULL);
+  Dart_Handle result = Dart_Invoke(lib, NewString("sum"), 0, NULL);
+  EXPECT_VALID(result);
+  int64_t value = 0;
+  EXPECT_VALID(Dart_IntegerToInt64(result, &value));
+  EXPECT_EQ(kExpectedSum, value);
+  FLAG_concurrent_mark = saved_concurrent_mark;
+}
+
+
+TEST_CASE(LazySweep) {
+  const intptr_t kLength = 10000;
+  const int64_t kExpectedSum =
+      static_cast<int64_t>(kLength) * (kLength - 1) / 2;
+  bool saved_lazy_sweep = FLAG_lazy_sweep;
+  FLAG_lazy_sweep = true;
+  Dart_Handle lib = TestCase::LoadTestScript(kMarkingScriptChars, NULL);
+  BuildOldLists(lib, kLength);
+  // The spare list becomes garbage on pages left unswept by the mark-sweep.
+  EXPECT_VALID(Dart_Invoke(lib, NewString("swap"), 0, NULL));
+  Heap* heap = Isolate::Current()->heap();
+  heap->CollectGarbage(Heap::kOld);
+  Dart_Handle result = Dart_Invoke(lib, NewString("sum"), 0, NULL);
+  EXPECT_VALID(result);
+  int64_t value = 0;
+  EXPECT_VALID(Dart_IntegerToInt64(result, &value));
+  EXPECT_EQ(kExpectedSum, value);
+  // Promotion sweeps pages on demand.
+  heap->CollectGarbage(Heap::kNew);
+  heap->FinishSweeping();
+  heap->CollectGarbage(Heap::kOld);
+  heap->FinishSweeping();
+  result = Dart_Invoke(lib, NewString("sum"), 0, NULL);
+  EXPECT_VALID(result);
+  EXPECT_VALID(Dart_IntegerToInt64(result, &value));
+  EXPECT_EQ(kExpectedSum, value);
+  FLAG_lazy_sweep = saved_lazy_sweep;
+}
+
+
+TEST_CASE(ParallelMarking) {
+  const intptr_t kLength = 10000;
+  const int64_t kExpectedSum =
+      static_cast<int64_t>(kLength) * (kLength - 1) / 2;
+  const intptr_t kChainLength = 100;
+  intptr_t saved_marker_tasks = FLAG_marker_tasks;
+  FLAG_marker_tasks = 4;
+  Dart_Handle lib = TestCase::LoadTestScript(kMarkingScriptChars, NULL);
+  BuildOldLists(lib, kLength);
+  Isolate* isolate = Isolate::Current();
+  // A chain of weak properties where each key is only reachable through the
+  // value of the previous weak property. The chain is stored in reverse order
+  // so most keys are still unmarked when their weak property is scanned.
+  const Array& chain = Array::Handle(Array::New(kChainLength, Heap::kOld));
+  const String& root_key =
+      String::Handle(OneByteString::New("key", Heap::kOld));
+  WeakProperty& dead = WeakProperty::Handle();
+  {
+    HANDLESCOPE(isolate);
+    String& key = String::Handle(root_key.raw());
+    WeakProperty& weak = WeakProperty::Handle();
+    for (intptr_t i = 0; i < kChainLength; i++) {
+      weak ^= WeakProperty::New(Heap::kOld);
+      weak.set_key(key);
+      key ^= OneByteString::New("value", Heap::kOld);
+      weak.set_value(key);
+      chain.SetAt(kChainLength - 1 - i, weak);
+    }
+    dead ^= WeakProperty::New(Heap::kOld);
+    key ^= OneByteString::New("dead", Heap::kOld);
+    dead.set_key(key);
+    dead.set_value(key);
+  }
+  isolate->heap()->CollectGarbage(Heap::kOld);
+  WeakProperty& weak = WeakProperty::Handle();
+  for (intptr_t i = 0; i < kChainLength; i++) {
+    weak ^= chain.At(i);
+    EXPECT(weak.key() != Object::null());
+    EXPECT(weak.value() != Object::null());
+  }
+  EXPECT(dead.key() == Object::null());
+  EXPECT(dead.value() == Object::null());
+  Dart_Handle result = Dart_Invoke(lib, NewString("sum"), 0, NULL);
+  EXPECT_VALID(result);
+  int64_t value = 0;
+  EXPECT_VALID(Dart_IntegerToInt64(result, &value));
+  EXPECT_EQ(kExpectedSum, value);
+  FLAG_marker_tasks = saved_marker_tasks;
+}
+
+
+TEST_CASE(OldSpaceCompaction) {
+  const intptr_t kNumObjects = 40000;
+  const intptr_t kElementLength = 30;
+  // Only every tenth object survives, which leaves all pages sparsely used.
+  const intptr_t kSurvivorRatio = 10;
+  const intptr_t kNumSurvivors = kNumObjects / kSurvivorRatio;
+  intptr_t saved_compaction_threshold = FLAG_compaction_threshold;
+  FLAG_compaction_threshold = 50;
+  Isolate* isolate = Isolate::Current();
+  Heap* heap = isolate->heap();
+  const Array& survivors = Array::Handle(Array::New(kNumSurvivors, Heap::kOld));
+  {
+    HANDLESCOPE(isolate);
+    Array& element = Array::Handle();
+    for (intptr_t i = 0; i < kNumObjects; i++) {
+      element = Array::New(kElementLength, Heap::kOld);
+      element.SetAt(0, Smi::Handle(Smi::New(i)));
+      if ((i % kSurvivorRatio) == 0) {
+        survivors.SetAt(i / kSurvivorRatio, element);
+      }
+    }
+  }
+  // Peers are kept in a weak table keyed by address.
+  intptr_t peer = 42;
+  heap->SetPeer(survivors.At(kNumSurvivors - 1), &peer);
+  intptr_t capacity_before = heap->CapacityInWords(Heap::kOld);
+  bool saved_verify_after_gc = FLAG_verify_after_gc;
+  FLAG_verify_after_gc = true;
+  heap->CollectGarbage(Heap::kOld);
+  FLAG_verify_after_gc = saved_verify_after_gc;
+  EXPECT_LT(heap->CapacityInWords(Heap::kOld), capacity_before);
+  Array& element = Array::Handle();
+  for (intptr_t i = 0; i < kNumSurvivors; i++) {
+    element ^= survivors.At(i);
+    EXPECT_EQ(kElementLength, element.Length());
+    EXPECT_EQ(i * kSurvivorRatio, Smi::Value(Smi::RawCast(element.At(0))));
+  }
+  EXPECT(heap->GetPeer(survivors.At(kNumSurvivors - 1)) == &peer);
+  FLAG_compaction_threshold = saved_compaction_threshold;
+}
+
+
+TEST_CASE(OldSpaceBumpAllocation) {
+  const intptr_t kMaxAllocations = 100000;
+  const uword kSize = Array::InstanceSize(1);
+  Isolate* isolate = Isolate::Current();
+  Heap* heap = isolate->heap();
+  uword* top = reinterpret_cast<uword*>(heap->TopAddress(Heap::kOld));
+  uword* end = reinterpret_cast<uword*>(heap->EndAddress(Heap::kOld));
+  // Allocate until the objects come from a bump allocation area with room
+  // for the next one.
+  {
+    HANDLESCOPE(isolate);
+    Array& array = Array::Handle();
+    for (intptr_t i = 0;
+         (i < kMaxAllocations) && ((*end - *top) < kSize);
+         i++) {
+      array = Array::New(1, Heap::kOld);
+    }
+  }
+  EXPECT((*end - *top) >= kSize);
+  uword expected = *top;
+  intptr_t used_in_words = heap->UsedInWords(Heap::kOld);
+  const Array& array = Array::Handle(Array::New(1, Heap::kOld));
+  EXPECT_EQ(expected, RawObject::ToAddr(array.raw()));
+  EXPECT_EQ(expected + kSize, *top);
+  // The area was accounted as used when it was taken from the free list.
+  EXPECT_EQ(used_in_words, heap->UsedInWords(Heap::kOld));
+  // The rest of the area can be walked.
+  EXPECT(heap->Verify());
+  // A mark-sweep retires the area.
+  heap->CollectGarbage(Heap::kOld);
+  EXPECT_EQ(*top, *end);
+  EXPECT_EQ(1, array.Length());
+}
+
+
+//
+// Measure the pause of a stop-the-world mark-sweep of a large old generation.
+//
+BENCHMARK(MarkSweepPause) {
+  const intptr_t kLength = 200000;
+  Dart_Handle lib = TestCase::LoadTestScript(kMarkingScriptChars, NULL);
+  Heap* heap = benchmark->isolate()->heap();
+  BuildOldLists(lib, kLength);
+  Timer timer(true, "Stop-the-world mark-sweep");
+  timer.Start();
+  heap->CollectGarbage(Heap::kOld);
+  timer.Stop();
+  benchmark->set_score(timer.TotalElapsedTime());
+}
+
+
+//
+// Measure the final pause of a concurrent marking cycle over the same old
+// generation, to compare with MarkSweepPause.
+//
+BENCHMARK(ConcurrentMarkingPause) {
+  if (!ConcurrentMarker::IsSupported()) {
+    return;
+  }
+  const intptr_t kLength = 200000;
+  bool saved_concurrent_mark = FLAG_concurrent_mark;
+  FLAG_concurrent_mark = true;
+  Dart_Handle lib = TestCase::LoadTestScript(kMarkingScriptChars, NULL);
+  Heap* heap = benchmark->isolate()->heap();
+  BuildOldLists(lib, kLength);
+  heap->StartConcurrentMarking();
+  // Give the marker time to drain its work before the final pause.
+  OS::Sleep(100);
+  Timer timer(true, "Concurrent marking finish");
+  timer.Start();
+  heap->FinishConcurrentMarking();
+  timer.Stop();
+  FLAG_concurrent_mark = saved_concurrent_mark;
+  benchmark->set_score(timer.TotalElapsedTime());
 }
+
+
+//
+// Measure the pause of a mark-sweep of a large old generation. Run with
+// --marker_tasks to measure a parallel marking. Sweeping is left to
+// --lazy_sweep, so the pause is dominated by the marking.
+//
+BENCHMARK(ParallelMarkingPause) {
+  const intptr_t kLength = 200000;
+  bool saved_lazy_sweep = FLAG_lazy_sweep;
+  FLAG_lazy_sweep = true;
+  Dart_Handle lib = TestCase::LoadTestScript(kMarkingScriptChars, NULL);
+  Heap* heap = benchmark->isolate()->heap();
+  BuildOldLists(lib, kLength);
+  heap->FinishSweeping();
+  Timer timer(true, "Parallel marking benchmark");
+  timer.Start();
+  heap->CollectGarbage(Heap::kOld);
+  timer.Stop();
+  heap->FinishSweeping();
+  FLAG_lazy_sweep = saved_lazy_sweep;
+  benchmark->set_score(timer.TotalElapsedTime());
+}
+
+}  // namespace dart
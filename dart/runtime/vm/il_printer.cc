@@ -826,6 +826,13 @@ void InvokeMathCFunctionInstr::PrintOperandsTo(BufferFormatter* f) const {
 }
 
 
+void VectorizedLoopInstr::PrintOperandsTo(BufferFormatter* f) const {
+  f->Print("%s, ", (op_kind() == Token::kILLEGAL) ? "copy"
+                                                   : Token::Str(op_kind()));
+  Definition::PrintOperandsTo(f);
+}
+
+
 void GraphEntryInstr::PrintTo(BufferFormatter* f) const {
   const GrowableArray<Definition*>& defns = initial_definitions_;
   f->Print("B%" Pd "[graph]:%" Pd, block_id(), GetDeoptId());
@@ -575,7 +575,13 @@ bool Value::NeedsStoreBuffer() {
     return false;
   }
 
-  return !BindsToConstant();
+  if (BindsToConstant()) {
+    // Constants are old objects, which the concurrent marker must still see
+    // when they are stored into an object it has already scanned.
+    const Object& constant = BoundConstant();
+    return FLAG_concurrent_mark && !constant.IsSmi() && !constant.InVMHeap();
+  }
+  return true;
 }
 
 
@@ -698,6 +698,7 @@ class EmbeddedArray<T, 0> {
   M(Int32x4ToFloat32x4)                                                        \
   M(BinaryInt32x4Op)                                                           \
   M(TestSmi)                                                                   \
+  M(VectorizedLoop)                                                            \
 
 
 #define FORWARD_DECLARATION(type) class type##Instr;
@@ -6111,7 +6112,8 @@ class BinaryMintOpInstr : public TemplateDefinition<2> {
 
   virtual bool CanDeoptimize() const {
     return FLAG_throw_on_javascript_int_overflow ||
-        (op_kind() == Token::kADD) || (op_kind() == Token::kSUB);
+        (op_kind() == Token::kADD) || (op_kind() == Token::kSUB) ||
+        (op_kind() == Token::kMUL);
   }
 
   virtual Representation representation() const {
@@ -6878,6 +6880,76 @@ class CheckArrayBoundInstr : public TemplateInstruction<2> {
 };
 
 
+// Runs the first iterations of a loop which applies an element-wise operation
+// to typed data (see LoopVectorizer), four elements at a time:
+//
+//   for (; index + 4 <= end; index += 4) {
+//     dest[index..index + 3] = left[index..index + 3] op right[...];
+//   }
+//
+// The start index is not negative. The arrays hold 4-byte elements, are tagged
+// and are either identical or distinct objects, so they never partially
+// overlap. Copies have the operation kILLEGAL and ignore the right array. The
+// result is the index of the first element left, which the original loop
+// processes.
+class VectorizedLoopInstr : public TemplateDefinition<5> {
+ public:
+  VectorizedLoopInstr(Token::Kind op_kind,
+                      intptr_t class_id,
+                      Value* start,
+                      Value* end,
+                      Value* dest,
+                      Value* left,
+                      Value* right)
+      : op_kind_(op_kind), class_id_(class_id) {
+    SetInputAt(kStartPos, start);
+    SetInputAt(kEndPos, end);
+    SetInputAt(kDestPos, dest);
+    SetInputAt(kLeftPos, left);
+    SetInputAt(kRightPos, right);
+  }
+
+  enum {
+    kStartPos = 0,
+    kEndPos = 1,
+    kDestPos = 2,
+    kLeftPos = 3,
+    kRightPos = 4
+  };
+
+  Value* start() const { return inputs_[kStartPos]; }
+  Value* end() const { return inputs_[kEndPos]; }
+  Value* dest() const { return inputs_[kDestPos]; }
+  Value* left() const { return inputs_[kLeftPos]; }
+  Value* right() const { return inputs_[kRightPos]; }
+
+  Token::Kind op_kind() const { return op_kind_; }
+  intptr_t class_id() const { return class_id_; }
+
+  virtual void PrintOperandsTo(BufferFormatter* f) const;
+
+  DECLARE_INSTRUCTION(VectorizedLoop)
+  virtual CompileType ComputeType() const;
+
+  virtual bool CanDeoptimize() const { return false; }
+
+  virtual Representation RequiredInputRepresentation(intptr_t idx) const {
+    ASSERT((idx >= 0) && (idx < InputCount()));
+    return kTagged;
+  }
+
+  virtual EffectSet Effects() const { return EffectSet::All(); }
+
+  virtual bool MayThrow() const { return false; }
+
+ private:
+  const Token::Kind op_kind_;
+  const intptr_t class_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(VectorizedLoopInstr);
+};
+
+
 #undef DECLARE_INSTRUCTION
 
 class Environment : public ZoneAllocated {
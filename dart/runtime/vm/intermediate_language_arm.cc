@@ -4324,6 +4324,17 @@ void CheckArrayBoundInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
 }
 
 
+LocationSummary* VectorizedLoopInstr::MakeLocationSummary() const {
+  UNIMPLEMENTED();
+  return NULL;
+}
+
+
+void VectorizedLoopInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
+  UNIMPLEMENTED();
+}
+
+
 LocationSummary* UnboxIntegerInstr::MakeLocationSummary() const {
   UNIMPLEMENTED();
   return NULL;
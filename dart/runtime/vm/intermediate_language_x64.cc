@@ -310,6 +310,17 @@ static Condition TokenKindToSmiCondition(Token::Kind kind) {
 
 LocationSummary* EqualityCompareInstr::MakeLocationSummary() const {
   const intptr_t kNumInputs = 2;
+  if (operation_cid() == kMintCid) {
+    const intptr_t kNumTemps = 2;
+    LocationSummary* locs =
+        new LocationSummary(kNumInputs, kNumTemps, LocationSummary::kNoCall);
+    locs->set_in(0, Location::RequiresFpuRegister());
+    locs->set_in(1, Location::RequiresFpuRegister());
+    locs->set_temp(0, Location::RequiresRegister());
+    locs->set_temp(1, Location::RequiresRegister());
+    locs->set_out(Location::RequiresRegister());
+    return locs;
+  }
   if (operation_cid() == kDoubleCid) {
     const intptr_t kNumTemps =  0;
     LocationSummary* locs =
@@ -419,6 +430,23 @@ static Condition EmitSmiComparisonOp(FlowGraphCompiler* compiler,
 }
 
 
+// Unboxed mints are kept in XMM registers, from which they are moved to CPU
+// registers to be compared.
+static Condition EmitUnboxedMintComparisonOp(FlowGraphCompiler* compiler,
+                                             const LocationSummary& locs,
+                                             Token::Kind kind,
+                                             BranchLabels labels) {
+  XmmRegister left = locs.in(0).fpu_reg();
+  XmmRegister right = locs.in(1).fpu_reg();
+  Register left_tmp = locs.temp(0).reg();
+  Register right_tmp = locs.temp(1).reg();
+  __ movq(left_tmp, left);
+  __ movq(right_tmp, right);
+  __ cmpq(left_tmp, right_tmp);
+  return TokenKindToSmiCondition(kind);
+}
+
+
 static Condition TokenKindToDoubleCondition(Token::Kind kind) {
   switch (kind) {
     case Token::kEQ: return EQUAL;
@@ -455,6 +483,8 @@ Condition EqualityCompareInstr::EmitComparisonCode(FlowGraphCompiler* compiler,
                                                    BranchLabels labels) {
   if (operation_cid() == kSmiCid) {
     return EmitSmiComparisonOp(compiler, *locs(), kind(), labels);
+  } else if (operation_cid() == kMintCid) {
+    return EmitUnboxedMintComparisonOp(compiler, *locs(), kind(), labels);
   } else {
     ASSERT(operation_cid() == kDoubleCid);
     return EmitDoubleComparisonOp(compiler, *locs(), kind(), labels);
@@ -538,6 +568,17 @@ void TestSmiInstr::EmitBranchCode(FlowGraphCompiler* compiler,
 LocationSummary* RelationalOpInstr::MakeLocationSummary() const {
   const intptr_t kNumInputs = 2;
   const intptr_t kNumTemps = 0;
+  if (operation_cid() == kMintCid) {
+    const intptr_t kNumTemps = 2;
+    LocationSummary* locs =
+        new LocationSummary(kNumInputs, kNumTemps, LocationSummary::kNoCall);
+    locs->set_in(0, Location::RequiresFpuRegister());
+    locs->set_in(1, Location::RequiresFpuRegister());
+    locs->set_temp(0, Location::RequiresRegister());
+    locs->set_temp(1, Location::RequiresRegister());
+    locs->set_out(Location::RequiresRegister());
+    return locs;
+  }
   if (operation_cid() == kDoubleCid) {
     LocationSummary* summary =
         new LocationSummary(kNumInputs, kNumTemps, LocationSummary::kNoCall);
@@ -564,6 +605,8 @@ Condition RelationalOpInstr::EmitComparisonCode(FlowGraphCompiler* compiler,
                                                 BranchLabels labels) {
   if (operation_cid() == kSmiCid) {
     return EmitSmiComparisonOp(compiler, *locs(), kind(), labels);
+  } else if (operation_cid() == kMintCid) {
+    return EmitUnboxedMintComparisonOp(compiler, *locs(), kind(), labels);
   } else {
     ASSERT(operation_cid() == kDoubleCid);
     return EmitDoubleComparisonOp(compiler, *locs(), kind(), labels);
@@ -1968,7 +2011,8 @@ static void EmitJavascriptOverflowCheck(FlowGraphCompiler* compiler,
                                         Range* range,
                                         Label* overflow,
                                         Register result) {
-  if (!range->IsWithin(-0x20000000000000LL, 0x20000000000000LL)) {
+  if ((range == NULL) ||
+      !range->IsWithin(-0x20000000000000LL, 0x20000000000000LL)) {
     ASSERT(overflow != NULL);
     __ CompareImmediate(result, Immediate(-0x20000000000000LL), PP);
     __ j(LESS, overflow);
@@ -4404,58 +4448,336 @@ void CheckArrayBoundInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
 }
 
 
+LocationSummary* VectorizedLoopInstr::MakeLocationSummary() const {
+  const intptr_t kNumInputs = 5;
+  const intptr_t kNumTemps = 3;
+  LocationSummary* summary =
+      new LocationSummary(kNumInputs, kNumTemps, LocationSummary::kNoCall);
+  summary->set_in(kStartPos, Location::RequiresRegister());
+  summary->set_in(kEndPos, Location::RequiresRegister());
+  summary->set_in(kDestPos, Location::RequiresRegister());
+  summary->set_in(kLeftPos, Location::RequiresRegister());
+  summary->set_in(kRightPos, Location::RequiresRegister());
+  summary->set_temp(0, Location::RequiresRegister());
+  summary->set_temp(1, Location::RequiresFpuRegister());
+  summary->set_temp(2, Location::RequiresFpuRegister());
+  summary->set_out(Location::SameAsFirstInput());
+  return summary;
+}
+
+
+void VectorizedLoopInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
+  Register index = locs()->in(kStartPos).reg();
+  Register end = locs()->in(kEndPos).reg();
+  Register dest = locs()->in(kDestPos).reg();
+  Register left = locs()->in(kLeftPos).reg();
+  Register right = locs()->in(kRightPos).reg();
+  Register limit = locs()->temp(0).reg();
+  XmmRegister value = locs()->temp(1).fpu_reg();
+  XmmRegister right_value = locs()->temp(2).fpu_reg();
+  ASSERT(locs()->out().reg() == index);
+  const intptr_t kElementSize = 4;
+  const intptr_t kElementsPerVector = 4;
+
+  // Round the number of elements left down to a multiple of four. The indices
+  // are smis, so are their differences.
+  Label loop, done;
+  __ movq(limit, end);
+  __ subq(limit, index);
+  __ j(LESS_EQUAL, &done);
+  __ andq(limit, Immediate(-Smi::RawValue(kElementsPerVector)));
+  __ j(ZERO, &done);
+  __ addq(limit, index);
+
+  __ Bind(&loop);
+  __ movups(value, FlowGraphCompiler::ElementAddressForRegIndex(
+      class_id(), kElementSize, left, index));
+  if (op_kind() != Token::kILLEGAL) {
+    __ movups(right_value, FlowGraphCompiler::ElementAddressForRegIndex(
+        class_id(), kElementSize, right, index));
+    if (class_id() == kTypedDataFloat32ArrayCid) {
+      switch (op_kind()) {
+        case Token::kADD: __ addps(value, right_value); break;
+        case Token::kSUB: __ subps(value, right_value); break;
+        case Token::kMUL: __ mulps(value, right_value); break;
+        case Token::kDIV: __ divps(value, right_value); break;
+        default: UNREACHABLE();
+      }
+    } else {
+      switch (op_kind()) {
+        case Token::kADD: __ addpl(value, right_value); break;
+        case Token::kSUB: __ subpl(value, right_value); break;
+        case Token::kBIT_AND: __ andps(value, right_value); break;
+        case Token::kBIT_OR: __ orps(value, right_value); break;
+        case Token::kBIT_XOR: __ xorps(value, right_value); break;
+        default: UNREACHABLE();
+      }
+    }
+  }
+  __ movups(FlowGraphCompiler::ElementAddressForRegIndex(
+      class_id(), kElementSize, dest, index), value);
+  __ addq(index, Immediate(Smi::RawValue(kElementsPerVector)));
+  __ cmpq(index, limit);
+  __ j(LESS, &loop);
+  __ Bind(&done);
+}
+
+
 LocationSummary* UnboxIntegerInstr::MakeLocationSummary() const {
-  UNIMPLEMENTED();
-  return NULL;
+  const intptr_t kNumInputs = 1;
+  const intptr_t kNumTemps = 0;
+  LocationSummary* summary =
+      new LocationSummary(kNumInputs, kNumTemps, LocationSummary::kNoCall);
+  const bool needs_writable_input = (value()->Type()->ToCid() != kMintCid);
+  summary->set_in(0, needs_writable_input
+                     ? Location::WritableRegister()
+                     : Location::RequiresRegister());
+  summary->set_out(Location::RequiresFpuRegister());
+  return summary;
 }
 
 
 void UnboxIntegerInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
-  UNIMPLEMENTED();
+  const intptr_t value_cid = value()->Type()->ToCid();
+  const Register value = locs()->in(0).reg();
+  const XmmRegister result = locs()->out().fpu_reg();
+
+  // Unboxed mints are kept in XMM registers, like unboxed doubles, so that
+  // they are spilled and described to the deoptimizer in the same way on all
+  // architectures.
+  if (value_cid == kMintCid) {
+    __ movsd(result, FieldAddress(value, Mint::value_offset()));
+  } else if (value_cid == kSmiCid) {
+    __ SmiUntag(value);  // Untag input before conversion.
+    __ movq(result, value);
+  } else {
+    Label* deopt = compiler->AddDeoptStub(deopt_id_, kDeoptUnboxInteger);
+    Label is_smi, done;
+    __ testq(value, Immediate(kSmiTagMask));
+    __ j(ZERO, &is_smi);
+    __ CompareClassId(value, kMintCid);
+    __ j(NOT_EQUAL, deopt);
+    __ movsd(result, FieldAddress(value, Mint::value_offset()));
+    __ jmp(&done);
+    __ Bind(&is_smi);
+    __ SmiUntag(value);
+    __ movq(result, value);
+    __ Bind(&done);
+  }
 }
 
 
 LocationSummary* BoxIntegerInstr::MakeLocationSummary() const {
-  UNIMPLEMENTED();
-  return NULL;
+  const intptr_t kNumInputs = 1;
+  const intptr_t kNumTemps = 0;
+  LocationSummary* summary =
+      new LocationSummary(kNumInputs,
+                          kNumTemps,
+                          LocationSummary::kCallOnSlowPath);
+  summary->set_in(0, Location::RequiresFpuRegister());
+  summary->set_out(Location::RequiresRegister());
+  return summary;
 }
 
 
+class BoxIntegerSlowPath : public SlowPathCode {
+ public:
+  explicit BoxIntegerSlowPath(BoxIntegerInstr* instruction)
+      : instruction_(instruction) { }
+
+  virtual void EmitNativeCode(FlowGraphCompiler* compiler) {
+    __ Comment("BoxIntegerSlowPath");
+    __ Bind(entry_label());
+    const Class& mint_class =
+        Class::ZoneHandle(Isolate::Current()->object_store()->mint_class());
+    const Code& stub =
+        Code::Handle(StubCode::GetAllocationStubForClass(mint_class));
+    const ExternalLabel label(mint_class.ToCString(), stub.EntryPoint());
+
+    LocationSummary* locs = instruction_->locs();
+    locs->live_registers()->Remove(locs->out());
+
+    compiler->SaveLiveRegisters(locs);
+    compiler->GenerateCall(Scanner::kDummyTokenIndex,  // No token position.
+                           &label,
+                           PcDescriptors::kOther,
+                           locs);
+    __ MoveRegister(locs->out().reg(), RAX);
+    compiler->RestoreLiveRegisters(locs);
+
+    __ jmp(exit_label());
+  }
+
+ private:
+  BoxIntegerInstr* instruction_;
+};
+
+
 void BoxIntegerInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
-  UNIMPLEMENTED();
+  BoxIntegerSlowPath* slow_path = new BoxIntegerSlowPath(this);
+  compiler->AddSlowPathCode(slow_path);
+
+  Register out_reg = locs()->out().reg();
+  XmmRegister value = locs()->in(0).fpu_reg();
+
+  // Unboxed operations produce smis or mint-sized values.
+  // Tagging the value overflows if it does not fit into a smi.
+  Label done;
+  __ movq(out_reg, value);
+  __ SmiTag(out_reg);
+  __ j(NO_OVERFLOW, &done);
+
+  __ TryAllocate(
+      Class::ZoneHandle(Isolate::Current()->object_store()->mint_class()),
+      slow_path->entry_label(),
+      Assembler::kFarJump,
+      out_reg,
+      PP);
+  __ Bind(slow_path->exit_label());
+  __ movsd(FieldAddress(out_reg, Mint::value_offset()), value);
+  __ Bind(&done);
 }
 
 
 LocationSummary* BinaryMintOpInstr::MakeLocationSummary() const {
-  UNIMPLEMENTED();
-  return NULL;
+  const intptr_t kNumInputs = 2;
+  const intptr_t kNumTemps = 2;
+  LocationSummary* summary =
+      new LocationSummary(kNumInputs, kNumTemps, LocationSummary::kNoCall);
+  summary->set_in(0, Location::RequiresFpuRegister());
+  summary->set_in(1, Location::RequiresFpuRegister());
+  summary->set_temp(0, Location::RequiresRegister());
+  summary->set_temp(1, Location::RequiresRegister());
+  summary->set_out(Location::SameAsFirstInput());
+  return summary;
 }
 
 
 void BinaryMintOpInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
-  UNIMPLEMENTED();
+  XmmRegister left = locs()->in(0).fpu_reg();
+  XmmRegister right = locs()->in(1).fpu_reg();
+  Register left_tmp = locs()->temp(0).reg();
+  Register right_tmp = locs()->temp(1).reg();
+
+  ASSERT(locs()->out().fpu_reg() == left);
+
+  Label* deopt = NULL;
+  if (CanDeoptimize()) {
+    deopt = compiler->AddDeoptStub(deopt_id(), kDeoptBinaryMintOp);
+  }
+  __ movq(left_tmp, left);
+  __ movq(right_tmp, right);
+  switch (op_kind()) {
+    case Token::kBIT_AND: __ andq(left_tmp, right_tmp); break;
+    case Token::kBIT_OR:  __ orq(left_tmp, right_tmp); break;
+    case Token::kBIT_XOR: __ xorq(left_tmp, right_tmp); break;
+    case Token::kADD:
+      __ addq(left_tmp, right_tmp);
+      __ j(OVERFLOW, deopt);
+      break;
+    case Token::kSUB:
+      __ subq(left_tmp, right_tmp);
+      __ j(OVERFLOW, deopt);
+      break;
+    case Token::kMUL:
+      __ imulq(left_tmp, right_tmp);
+      __ j(OVERFLOW, deopt);
+      break;
+    default: UNREACHABLE();
+  }
+  if (FLAG_throw_on_javascript_int_overflow) {
+    EmitJavascriptOverflowCheck(compiler, range(), deopt, left_tmp);
+  }
+  __ movq(left, left_tmp);
 }
 
 
 LocationSummary* UnaryMintOpInstr::MakeLocationSummary() const {
-  UNIMPLEMENTED();
-  return NULL;
+  const intptr_t kNumInputs = 1;
+  const intptr_t kNumTemps = 1;
+  LocationSummary* summary =
+      new LocationSummary(kNumInputs, kNumTemps, LocationSummary::kNoCall);
+  summary->set_in(0, Location::RequiresFpuRegister());
+  summary->set_temp(0, Location::RequiresRegister());
+  summary->set_out(Location::SameAsFirstInput());
+  return summary;
 }
 
 
 void UnaryMintOpInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
-  UNIMPLEMENTED();
+  ASSERT(op_kind() == Token::kBIT_NOT);
+  XmmRegister value = locs()->in(0).fpu_reg();
+  Register temp = locs()->temp(0).reg();
+  ASSERT(value == locs()->out().fpu_reg());
+  Label* deopt = NULL;
+  if (FLAG_throw_on_javascript_int_overflow) {
+    deopt = compiler->AddDeoptStub(deopt_id(),
+                                   kDeoptUnaryMintOp);
+  }
+  __ movq(temp, value);
+  __ notq(temp);
+  if (FLAG_throw_on_javascript_int_overflow) {
+    EmitJavascriptOverflowCheck(compiler, range(), deopt, temp);
+  }
+  __ movq(value, temp);
 }
 
 
 LocationSummary* ShiftMintOpInstr::MakeLocationSummary() const {
-  UNIMPLEMENTED();
-  return NULL;
+  const intptr_t kNumInputs = 2;
+  const intptr_t kNumTemps = (op_kind() == Token::kSHL) ? 2 : 1;
+  LocationSummary* summary =
+      new LocationSummary(kNumInputs, kNumTemps, LocationSummary::kNoCall);
+  summary->set_in(0, Location::RequiresFpuRegister());
+  summary->set_in(1, Location::RegisterLocation(RCX));
+  summary->set_temp(0, Location::RequiresRegister());
+  if (op_kind() == Token::kSHL) {
+    summary->set_temp(1, Location::RequiresRegister());
+  }
+  summary->set_out(Location::SameAsFirstInput());
+  return summary;
 }
 
 
 void ShiftMintOpInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
-  UNIMPLEMENTED();
+  XmmRegister left = locs()->in(0).fpu_reg();
+  Register value = locs()->temp(0).reg();
+  ASSERT(locs()->in(1).reg() == RCX);
+  ASSERT(locs()->out().fpu_reg() == left);
+
+  Label* deopt  = compiler->AddDeoptStub(deopt_id(),
+                                         kDeoptShiftMintOp);
+  __ movq(value, left);
+  // Deoptimize if shift count is negative or > 63, since the shift
+  // instructions mask the count to 6 bits.
+  __ SmiUntag(RCX);
+  const Immediate& kCountLimit = Immediate(63);
+  __ cmpq(RCX, kCountLimit);
+  __ j(ABOVE, deopt);
+  switch (op_kind()) {
+    case Token::kSHR:
+      __ sarq(value, RCX);  // Shift count in CL.
+      break;
+    case Token::kSHL: {
+      // Check for overflow by shifting back the result and comparing with
+      // the input.
+      Register temp = locs()->temp(1).reg();
+      __ movq(temp, value);
+      __ shlq(temp, RCX);  // Shift count in CL.
+      __ sarq(temp, RCX);
+      __ cmpq(temp, value);
+      __ j(NOT_EQUAL, deopt);
+      __ shlq(value, RCX);
+      break;
+    }
+    default:
+      UNREACHABLE();
+      break;
+  }
+  if (FLAG_throw_on_javascript_int_overflow) {
+    EmitJavascriptOverflowCheck(compiler, range(), deopt, value);
+  }
+  __ movq(left, value);
 }
 
 
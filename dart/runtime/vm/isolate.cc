@@ -9,6 +9,8 @@
 #include "platform/json.h"
 #include "lib/mirrors.h"
 #include "vm/code_observers.h"
+#include "vm/compact_message.h"
+#include "vm/compiler.h"
 #include "vm/compiler_stats.h"
 #include "vm/coverage.h"
 #include "vm/dart_api_state.h"
@@ -63,6 +65,8 @@ class IsolateMessageHandler : public MessageHandler {
 #endif
   bool IsCurrentIsolate() const;
   virtual Isolate* GetIsolate() const { return isolate_; }
+  bool HasIdleTask() const;
+  bool RunIdleTask();
   bool UnhandledExceptionCallbackHandler(const Object& message,
                                          const UnhandledException& error);
 
@@ -120,9 +124,19 @@ bool IsolateMessageHandler::HandleMessage(Message* message) {
   }
 
   // Parse the message.
-  SnapshotReader reader(message->data(), message->len(),
-                        Snapshot::kMessage, Isolate::Current());
-  const Object& msg_obj = Object::Handle(reader.ReadObject());
+  Object& msg_obj = Object::Handle();
+  if (message->is_compact()) {
+    CompactMessageReader reader(message->data(), message->len());
+    msg_obj = reader.ReadMessage();
+  } else {
+    SnapshotReader reader(message->data(), message->len(),
+                          Snapshot::kMessage, Isolate::Current());
+    msg_obj = reader.ReadObject();
+    // The isolate now owns the external data read from the message. If
+    // reading failed, the data which was not read is finalized with the
+    // message.
+    message->AdoptTransfers(reader.num_transfers());
+  }
   if (msg_obj.IsError()) {
     // An error occurred while reading the message.
     return ProcessUnhandledException(Object::null_instance(),
@@ -236,6 +250,23 @@ bool IsolateMessageHandler::IsCurrentIsolate() const {
 }
 
 
+bool IsolateMessageHandler::HasIdleTask() const {
+  return isolate_->optimization_queue() != GrowableObjectArray::null();
+}
+
+
+bool IsolateMessageHandler::RunIdleTask() {
+  StartIsolateScope start_scope(isolate_);
+  StackZone zone(isolate_);
+  HandleScope handle_scope(isolate_);
+  const Error& error = Error::Handle(Compiler::CompileQueuedFunction());
+  if (!error.IsNull()) {
+    return ProcessUnhandledException(Object::null_instance(), error);
+  }
+  return true;
+}
+
+
 bool IsolateMessageHandler::ProcessUnhandledException(
     const Object& message, const Error& result) {
   if (result.IsUnhandledException()) {
@@ -276,6 +307,8 @@ void BaseIsolate::AssertCurrent(BaseIsolate* isolate) {
 
 Isolate::Isolate()
     : store_buffer_(),
+      marking_buffer_(),
+      concurrent_marking_(0),
       message_notify_callback_(NULL),
       name_(NULL),
       start_time_(OS::GetCurrentTimeMicros()),
@@ -306,6 +339,8 @@ Isolate::Isolate()
       gc_epilogue_callbacks_(),
       defer_finalization_count_(0),
       deopt_context_(NULL),
+      optimization_queue_(GrowableObjectArray::null()),
+      optimization_queue_head_(0),
       stacktrace_(NULL),
       stack_frame_index_(-1),
       object_histogram_(NULL),
@@ -808,6 +843,9 @@ void Isolate::VisitObjectPointers(ObjectPointerVisitor* visitor,
   if (deopt_context() != NULL) {
     deopt_context()->VisitObjectPointers(visitor);
   }
+
+  // Visit the functions queued for optimization.
+  visitor->VisitPointer(reinterpret_cast<RawObject**>(&optimization_queue_));
 }
 
 
@@ -50,6 +50,7 @@ class RawObject;
 class RawInteger;
 class RawError;
 class RawFloat32x4;
+class RawGrowableObjectArray;
 class RawInt32x4;
 class SampleBuffer;
 class Simulator;
@@ -84,6 +85,13 @@ class Isolate : public BaseIsolate {
 
   static void SetCurrent(Isolate* isolate);
 
+  // Makes the isolate current on a GC helper thread so that raw object
+  // accessors can reach its class table. Unlike SetCurrent the thread is not
+  // scheduled with the profiler.
+  static void SetCurrentGCHelper(Isolate* isolate) {
+    Thread::SetThreadLocal(isolate_key, reinterpret_cast<uword>(isolate));
+  }
+
   static void InitOnce();
   static Isolate* Init(const char* name_prefix);
   void Shutdown();
@@ -105,6 +113,23 @@ class Isolate : public BaseIsolate {
     return OFFSET_OF(Isolate, store_buffer_);
   }
 
+  // Old objects stored into old space while concurrent marking is in
+  // progress. Full blocks are handed to the concurrent marker.
+  StoreBuffer* marking_buffer() { return &marking_buffer_; }
+  static intptr_t marking_buffer_offset() {
+    return OFFSET_OF(Isolate, marking_buffer_);
+  }
+
+  // Set while a concurrent marker is running, enables the marking part of
+  // the write barrier.
+  bool concurrent_marking() const { return concurrent_marking_ != 0; }
+  void set_concurrent_marking(bool value) {
+    concurrent_marking_ = value ? 1 : 0;
+  }
+  static intptr_t concurrent_marking_offset() {
+    return OFFSET_OF(Isolate, concurrent_marking_);
+  }
+
   ClassTable* class_table() { return &class_table_; }
   static intptr_t class_table_offset() {
     return OFFSET_OF(Isolate, class_table_);
@@ -217,12 +242,14 @@ class Isolate : public BaseIsolate {
     kMessageInterrupt = 0x2,  // An interrupt to process an out of band message.
     kStoreBufferInterrupt = 0x4,  // An interrupt to process the store buffer.
     kVmStatusInterrupt = 0x8,     // An interrupt to process a status request.
+    kConcurrentMarkingInterrupt = 0x10,  // An interrupt to finish marking.
 
     kInterruptsMask =
         kApiInterrupt |
         kMessageInterrupt |
         kStoreBufferInterrupt |
-        kVmStatusInterrupt,
+        kVmStatusInterrupt |
+        kConcurrentMarkingInterrupt,
   };
 
   void ScheduleInterrupts(uword interrupt_bits);
@@ -371,6 +398,22 @@ class Isolate : public BaseIsolate {
     deopt_context_ = value;
   }
 
+  // Functions whose optimizing compilation is deferred until the isolate has
+  // no messages to handle, or null.
+  RawGrowableObjectArray* optimization_queue() const {
+    return optimization_queue_;
+  }
+  void set_optimization_queue(RawGrowableObjectArray* value) {
+    optimization_queue_ = value;
+  }
+  // Index of the first entry of the optimization queue not yet compiled.
+  intptr_t optimization_queue_head() const {
+    return optimization_queue_head_;
+  }
+  void set_optimization_queue_head(intptr_t value) {
+    optimization_queue_head_ = value;
+  }
+
   static char* GetStatus(const char* request);
 
   intptr_t BlockClassFinalization() {
@@ -417,6 +460,8 @@ class Isolate : public BaseIsolate {
   static ThreadLocalKey isolate_key;
 
   StoreBuffer store_buffer_;
+  StoreBuffer marking_buffer_;
+  uword concurrent_marking_;
   ClassTable class_table_;
   MegamorphicCacheTable megamorphic_cache_table_;
   Dart_MessageNotifyCallback message_notify_callback_;
@@ -449,6 +494,8 @@ class Isolate : public BaseIsolate {
   GcEpilogueCallbacks gc_epilogue_callbacks_;
   intptr_t defer_finalization_count_;
   DeoptContext* deopt_context_;
+  RawGrowableObjectArray* optimization_queue_;
+  intptr_t optimization_queue_head_;
 
   // Status support.
   char* stacktrace_;
@@ -6,6 +6,38 @@
 
 namespace dart {
 
+Message::~Message() {
+  for (intptr_t i = 0; i < num_transfers_; i++) {
+    (*transfers_[i].callback)(NULL, transfers_[i].peer);
+  }
+  free(transfers_);
+  free(data_);
+}
+
+
+void Message::AddTransfer(void* peer,
+                          Dart_WeakPersistentHandleFinalizer callback) {
+  ASSERT(callback != NULL);
+  transfers_ = reinterpret_cast<Transfer*>(
+      realloc(transfers_, (num_transfers_ + 1) * sizeof(Transfer)));
+  transfers_[num_transfers_].peer = peer;
+  transfers_[num_transfers_].callback = callback;
+  num_transfers_++;
+}
+
+
+void Message::AdoptTransfers(intptr_t count) {
+  ASSERT((count >= 0) && (count <= num_transfers_));
+  // The data is read in the order it was written, so the transfers which
+  // were not read before a failure are the last ones.
+  if (count == 0) {
+    return;
+  }
+  num_transfers_ -= count;
+  memmove(transfers_, transfers_ + count, num_transfers_ * sizeof(Transfer));
+}
+
+
 MessageQueue::MessageQueue() {
   head_ = NULL;
   tail_ = NULL;
@@ -53,6 +85,21 @@ Message* MessageQueue::Dequeue() {
 }
 
 
+void MessageQueue::Append(MessageQueue* other) {
+  if (other->head_ == NULL) {
+    return;
+  }
+  if (head_ == NULL) {
+    head_ = other->head_;
+  } else {
+    tail_->next_ = other->head_;
+  }
+  tail_ = other->tail_;
+  other->head_ = NULL;
+  other->tail_ = NULL;
+}
+
+
 void MessageQueue::Clear() {
   Message* cur = head_;
   head_ = NULL;
@@ -9,6 +9,10 @@
 
 // Duplicated from dart_api.h to avoid including the whole header.
 typedef int64_t Dart_Port;
+typedef struct _Dart_WeakPersistentHandle* Dart_WeakPersistentHandle;
+typedef void (*Dart_WeakPersistentHandleFinalizer)(
+    Dart_WeakPersistentHandle handle,
+    void* peer);
 
 namespace dart {
 
@@ -38,10 +42,11 @@ class Message {
         reply_port_(reply_port),
         data_(data),
         len_(len),
-        priority_(priority) {}
-  ~Message() {
-    free(data_);
-  }
+        priority_(priority),
+        transfers_(NULL),
+        num_transfers_(0),
+        is_compact_(false) {}
+  ~Message();
 
   Dart_Port dest_port() const { return dest_port_; }
   Dart_Port reply_port() const { return reply_port_; }
@@ -51,15 +56,36 @@ class Message {
 
   bool IsOOB() const { return priority_ == Message::kOOBPriority; }
 
+  // Whether the data is a compact message instead of a message snapshot.
+  bool is_compact() const { return is_compact_; }
+  void set_is_compact(bool value) { is_compact_ = value; }
+
+  // The external data transferred by this message is owned by the message
+  // until the receiving isolate adopts it. The finalizers of the data which
+  // has not been adopted are called with a NULL handle when the message is
+  // destructed.
+  void AddTransfer(void* peer, Dart_WeakPersistentHandleFinalizer callback);
+  // Adopts the first 'count' transfers, which the receiver has read.
+  void AdoptTransfers(intptr_t count);
+  intptr_t num_transfers() const { return num_transfers_; }
+
  private:
   friend class MessageQueue;
 
+  struct Transfer {
+    void* peer;
+    Dart_WeakPersistentHandleFinalizer callback;
+  };
+
   Message* next_;
   Dart_Port dest_port_;
   Dart_Port reply_port_;
   uint8_t* data_;
   intptr_t len_;
   Priority priority_;
+  Transfer* transfers_;
+  intptr_t num_transfers_;
+  bool is_compact_;
 
   DISALLOW_COPY_AND_ASSIGN(Message);
 };
@@ -76,6 +102,11 @@ class MessageQueue {
   // message is available.  This function will not block.
   Message* Dequeue();
 
+  // Moves all the messages of 'other' to the end of this queue.
+  void Append(MessageQueue* other);
+
+  bool IsEmpty() const { return head_ == NULL; }
+
   // Clear all messages from the message queue.
   void Clear();
 
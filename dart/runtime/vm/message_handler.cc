@@ -3,11 +3,16 @@
 // BSD-style license that can be found in the LICENSE file.
 
 #include "vm/message_handler.h"
+#include "vm/atomic.h"
 #include "vm/port.h"
 #include "vm/dart.h"
 
 namespace dart {
 
+DEFINE_FLAG(int, message_batch_size, 64,
+            "Maximum number of normal messages handled without reacquiring the "
+            "lock of the message queue. With 1 the messages are dequeued one "
+            "at a time.");
 DECLARE_FLAG(bool, trace_isolates);
 
 
@@ -34,6 +39,8 @@ MessageHandler::MessageHandler()
       oob_queue_(new MessageQueue()),
       control_ports_(0),
       live_ports_(0),
+      batch_interrupts_(0),
+      close_all_ports_count_(0),
       pool_(NULL),
       task_(NULL),
       start_callback_(NULL),
@@ -106,11 +113,14 @@ void MessageHandler::PostMessage(Message* message) {
   Message::Priority saved_priority = message->priority();
   if (message->IsOOB()) {
     oob_queue_->Enqueue(message);
+    AtomicOperations::FetchAndIncrement(&batch_interrupts_);
   } else {
     queue_->Enqueue(message);
   }
   message = NULL;  // Do not access message.  May have been deleted.
 
+  // A burst of messages is dispatched to a single task, which handles all the
+  // messages queued up before it finishes.
   if (pool_ != NULL && task_ == NULL) {
     task_ = new MessageHandlerTask(this);
     pool_->Run(task_);
@@ -134,24 +144,21 @@ Message* MessageHandler::DequeueMessage(Message::Priority min_priority) {
 bool MessageHandler::HandleMessages(bool allow_normal_messages,
                                     bool allow_multiple_normal_messages) {
   // TODO(turnidge): Add assert that monitor_ is held here.
+  if (allow_normal_messages && allow_multiple_normal_messages &&
+      (FLAG_message_batch_size > 1)) {
+    return HandleMessageBatches();
+  }
   bool result = true;
   Message::Priority min_priority = (allow_normal_messages
                                     ? Message::kNormalPriority
                                     : Message::kOOBPriority);
   Message* message = DequeueMessage(min_priority);
   while (message) {
-    if (FLAG_trace_isolates) {
-      OS::Print("[<] Handling message:\n"
-                "\thandler:    %s\n"
-                "\tport:       %" Pd64 "\n",
-                name(), message->dest_port());
-    }
-
     // Release the monitor_ temporarily while we handle the message.
     // The monitor was acquired in MessageHandler::TaskCallback().
     monitor_.Exit();
     Message::Priority saved_priority = message->priority();
-    result = HandleMessage(message);
+    result = DispatchMessage(message);
     monitor_.Enter();
     if (!result) {
       // If we hit an error, we're done processing messages.
@@ -168,6 +175,61 @@ bool MessageHandler::HandleMessages(bool allow_normal_messages,
 }
 
 
+bool MessageHandler::DispatchMessage(Message* message) {
+  if (FLAG_trace_isolates) {
+    OS::Print("[<] Handling message:\n"
+              "\thandler:    %s\n"
+              "\tport:       %" Pd64 "\n",
+              name(), message->dest_port());
+  }
+  return HandleMessage(message);
+}
+
+
+bool MessageHandler::HandleMessageBatches() {
+  // Normal messages are taken off the queue all at once instead of one at a
+  // time, and up to FLAG_message_batch_size of them are handled before the
+  // monitor is reacquired. A batch stops early when an OOB message arrives
+  // or all ports are closed.
+  bool result = HandleMessages(false, false);
+  while (result && !queue_->IsEmpty()) {
+    MessageQueue batch;
+    batch.Append(queue_);
+    uintptr_t interrupts = batch_interrupts_;
+    intptr_t close_all_ports_count = close_all_ports_count_;
+    // Release the monitor_ temporarily while we handle the messages.
+    // The monitor was acquired in MessageHandler::TaskCallback().
+    monitor_.Exit();
+    for (intptr_t i = 0; i < FLAG_message_batch_size; i++) {
+      Message* message = batch.Dequeue();
+      if (message == NULL) {
+        break;
+      }
+      result = DispatchMessage(message);
+      // The monitor is not held here, so the counter is read atomically.
+      if (!result ||
+          (AtomicOperations::FetchAndAdd(&batch_interrupts_, 0) !=
+           interrupts)) {
+        break;
+      }
+    }
+    monitor_.Enter();
+    if (close_all_ports_count_ != close_all_ports_count) {
+      // CloseAllPorts cleared the queue but could not reach the batch.
+      batch.Clear();
+    } else {
+      // The messages left in the batch go back to the front of the queue.
+      batch.Append(queue_);
+      queue_->Append(&batch);
+    }
+    if (result) {
+      result = HandleMessages(false, false);
+    }
+  }
+  return result;
+}
+
+
 bool MessageHandler::HandleNextMessage() {
   // We can only call HandleNextMessage when this handler is not
   // assigned to a thread pool.
@@ -176,7 +238,17 @@ bool MessageHandler::HandleNextMessage() {
 #if defined(DEBUG)
   CheckAccess();
 #endif
-  return HandleMessages(true, false);
+  bool result = HandleMessages(true, false);
+  // Like TaskCallback, run the idle tasks while no message is pending.
+  while (result &&
+         queue_->IsEmpty() &&
+         oob_queue_->IsEmpty() &&
+         HasIdleTask()) {
+    monitor_.Exit();
+    result = RunIdleTask();
+    monitor_.Enter();
+  }
+  return result;
 }
 
 
@@ -210,6 +282,17 @@ void MessageHandler::TaskCallback() {
     if (ok) {
       ok = HandleMessages(true, true);
     }
+
+    // Run the idle tasks, handling the messages which arrive meanwhile
+    // before the next one.
+    while (ok && HasLivePorts() && HasIdleTask()) {
+      monitor_.Exit();
+      ok = RunIdleTask();
+      monitor_.Enter();
+      if (ok) {
+        ok = HandleMessages(true, true);
+      }
+    }
     task_ = NULL;  // No task in queue.
 
     if (!ok || !HasLivePorts()) {
@@ -250,6 +333,8 @@ void MessageHandler::CloseAllPorts() {
   }
   queue_->Clear();
   oob_queue_->Clear();
+  close_all_ports_count_++;
+  AtomicOperations::FetchAndIncrement(&batch_interrupts_);
 }
 
 
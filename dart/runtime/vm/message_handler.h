@@ -42,7 +42,8 @@ class MessageHandler {
 
   // Handles the next message for this message handler.  Should only
   // be used when not running the handler on the thread pool (via Run
-  // or RunBlocking).
+  // or RunBlocking).  If no other message is pending afterwards, the
+  // idle tasks are run until one arrives.
   //
   // Returns true on success.
   bool HandleNextMessage();
@@ -108,6 +109,14 @@ class MessageHandler {
   // Returns true on success.
   virtual bool HandleMessage(Message* message) = 0;
 
+  // Work deferred until there are no messages to handle, which is run one
+  // task at a time by TaskCallback and HandleNextMessage.  Optionally
+  // provided by subclass.
+  //
+  // RunIdleTask returns true on success.
+  virtual bool HasIdleTask() const { return false; }
+  virtual bool RunIdleTask() { return true; }
+
  private:
   friend class PortMap;
   friend class MessageHandlerTestPeer;
@@ -124,11 +133,24 @@ class MessageHandler {
   bool HandleMessages(bool allow_normal_messages,
                       bool allow_multiple_normal_messages);
 
+  // Traces 'message' and hands it to HandleMessage. Called without holding
+  // monitor_.
+  bool DispatchMessage(Message* message);
+
+  // Handles all pending messages, taking the normal messages off the queue
+  // in batches.
+  bool HandleMessageBatches();
+
   Monitor monitor_;  // Protects all fields in MessageHandler.
   MessageQueue* queue_;
   MessageQueue* oob_queue_;
   intptr_t control_ports_;  // The number of open control ports usually 0 or 1.
   intptr_t live_ports_;  // The number of open ports, including control ports.
+  // Changed when an OOB message is queued or all ports are closed, which
+  // stops the handling of a batch of normal messages. Updated and read with
+  // AtomicOperations, as batches read it without holding the monitor_.
+  uintptr_t batch_interrupts_;
+  intptr_t close_all_ports_count_;  // The number of calls to CloseAllPorts.
   ThreadPool* pool_;
   ThreadPool::Task* task_;
   StartCallback start_callback_;
@@ -2,12 +2,15 @@
 // for details. All rights reserved. Use of this source code is governed by a
 // BSD-style license that can be found in the LICENSE file.
 
+#include "vm/benchmark_test.h"
 #include "vm/message_handler.h"
 #include "vm/port.h"
 #include "vm/unit_test.h"
 
 namespace dart {
 
+DECLARE_FLAG(int, message_batch_size);
+
 class MessageHandlerTestPeer {
  public:
   explicit MessageHandlerTestPeer(MessageHandler* handler)
@@ -20,6 +23,11 @@ class MessageHandlerTestPeer {
   void increment_live_ports() { handler_->increment_live_ports(); }
   void decrement_live_ports() { handler_->decrement_live_ports(); }
 
+  bool HandleAllMessages() {
+    MonitorLocker ml(&handler_->monitor_);
+    return handler_->HandleMessages(true, true);
+  }
+
   MessageQueue* queue() const { return handler_->queue_; }
   MessageQueue* oob_queue() const { return handler_->oob_queue_; }
 
@@ -107,6 +115,66 @@ class TestMessageHandler : public MessageHandler {
 };
 
 
+// Posts an OOB message, or closes all ports if there is no OOB port, after
+// handling a message to the interrupt port.
+class InterruptingMessageHandler : public TestMessageHandler {
+ public:
+  InterruptingMessageHandler()
+      : interrupt_port_(Message::kIllegalPort),
+        oob_port_(Message::kIllegalPort) {
+  }
+
+  bool HandleMessage(Message* message) {
+    Dart_Port port = message->dest_port();
+    bool result = TestMessageHandler::HandleMessage(message);
+    if (port == interrupt_port_) {
+      MessageHandlerTestPeer handler_peer(this);
+      if (oob_port_ != Message::kIllegalPort) {
+        handler_peer.PostMessage(
+            new Message(oob_port_, 0, NULL, 0, Message::kOOBPriority));
+      } else {
+        handler_peer.CloseAllPorts();
+      }
+    }
+    return result;
+  }
+
+  void set_interrupt(Dart_Port interrupt_port, Dart_Port oob_port) {
+    interrupt_port_ = interrupt_port;
+    oob_port_ = oob_port;
+  }
+
+ private:
+  Dart_Port interrupt_port_;
+  Dart_Port oob_port_;
+
+  DISALLOW_COPY_AND_ASSIGN(InterruptingMessageHandler);
+};
+
+
+// Has a fixed number of idle tasks to run.
+class IdleTaskMessageHandler : public TestMessageHandler {
+ public:
+  explicit IdleTaskMessageHandler(intptr_t idle_tasks)
+      : idle_tasks_(idle_tasks) {
+  }
+
+  bool HasIdleTask() const { return idle_tasks_ > 0; }
+
+  bool RunIdleTask() {
+    idle_tasks_--;
+    return true;
+  }
+
+  intptr_t idle_tasks() const { return idle_tasks_; }
+
+ private:
+  intptr_t idle_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(IdleTaskMessageHandler);
+};
+
+
 bool TestStartFunction(uword data) {
   return (reinterpret_cast<TestMessageHandler*>(data))->Start();
 }
@@ -207,6 +275,28 @@ UNIT_TEST_CASE(MessageHandler_HandleNextMessage) {
 }
 
 
+UNIT_TEST_CASE(MessageHandler_HandleNextMessageIdleTasks) {
+  IdleTaskMessageHandler handler(2);
+  MessageHandlerTestPeer handler_peer(&handler);
+  Dart_Port port1 = PortMap::CreatePort(&handler);
+  Message* message1 = new Message(port1, 0, NULL, 0, Message::kNormalPriority);
+  handler_peer.PostMessage(message1);
+  Message* message2 = new Message(port1, 0, NULL, 0, Message::kNormalPriority);
+  handler_peer.PostMessage(message2);
+
+  // The idle tasks wait while a message is pending.
+  EXPECT(handler.HandleNextMessage());
+  EXPECT_EQ(1, handler.message_count());
+  EXPECT_EQ(2, handler.idle_tasks());
+
+  // They run once the queue is empty.
+  EXPECT(handler.HandleNextMessage());
+  EXPECT_EQ(2, handler.message_count());
+  EXPECT_EQ(0, handler.idle_tasks());
+  PortMap::ClosePorts(&handler);
+}
+
+
 UNIT_TEST_CASE(MessageHandler_HandleOOBMessages) {
   TestMessageHandler handler;
   MessageHandlerTestPeer handler_peer(&handler);
@@ -233,6 +323,87 @@ UNIT_TEST_CASE(MessageHandler_HandleOOBMessages) {
 }
 
 
+UNIT_TEST_CASE(MessageHandler_HandleMessageBatches) {
+  intptr_t saved_message_batch_size = FLAG_message_batch_size;
+  FLAG_message_batch_size = 2;
+  TestMessageHandler handler;
+  MessageHandlerTestPeer handler_peer(&handler);
+  Dart_Port ports[5];
+  for (intptr_t i = 0; i < 5; i++) {
+    ports[i] = PortMap::CreatePort(&handler);
+    Message::Priority priority =
+        (i == 4) ? Message::kOOBPriority : Message::kNormalPriority;
+    handler_peer.PostMessage(new Message(ports[i], 0, NULL, 0, priority));
+  }
+
+  // The oob message is handled first, then the normal messages in order.
+  EXPECT(handler_peer.HandleAllMessages());
+  EXPECT_EQ(5, handler.message_count());
+  Dart_Port* handled_ports = handler.port_buffer();
+  EXPECT_EQ(ports[4], handled_ports[0]);
+  for (intptr_t i = 0; i < 4; i++) {
+    EXPECT_EQ(ports[i], handled_ports[i + 1]);
+  }
+
+  // After an error the messages left in the batch stay queued in order.
+  for (intptr_t i = 0; i < 3; i++) {
+    handler_peer.PostMessage(
+        new Message(ports[i], 0, NULL, 0, Message::kNormalPriority));
+  }
+  handler.set_result(false);
+  EXPECT(!handler_peer.HandleAllMessages());
+  EXPECT_EQ(6, handler.message_count());
+  Message* message = handler_peer.queue()->Dequeue();
+  EXPECT_EQ(ports[1], message->dest_port());
+  delete message;
+  message = handler_peer.queue()->Dequeue();
+  EXPECT_EQ(ports[2], message->dest_port());
+  delete message;
+  EXPECT(handler_peer.queue()->IsEmpty());
+  PortMap::ClosePorts(&handler);
+  FLAG_message_batch_size = saved_message_batch_size;
+}
+
+
+UNIT_TEST_CASE(MessageHandler_HandleMessageBatchesInterrupted) {
+  intptr_t saved_message_batch_size = FLAG_message_batch_size;
+  FLAG_message_batch_size = 64;
+  InterruptingMessageHandler handler;
+  MessageHandlerTestPeer handler_peer(&handler);
+  Dart_Port ports[4];
+  for (intptr_t i = 0; i < 4; i++) {
+    ports[i] = PortMap::CreatePort(&handler);
+  }
+  for (intptr_t i = 0; i < 3; i++) {
+    handler_peer.PostMessage(
+        new Message(ports[i], 0, NULL, 0, Message::kNormalPriority));
+  }
+
+  // An oob message arriving during a batch is handled before the next
+  // message of the batch.
+  handler.set_interrupt(ports[0], ports[3]);
+  EXPECT(handler_peer.HandleAllMessages());
+  EXPECT_EQ(4, handler.message_count());
+  Dart_Port* handled_ports = handler.port_buffer();
+  EXPECT_EQ(ports[0], handled_ports[0]);
+  EXPECT_EQ(ports[3], handled_ports[1]);
+  EXPECT_EQ(ports[1], handled_ports[2]);
+  EXPECT_EQ(ports[2], handled_ports[3]);
+
+  // Closing all ports during a batch drops the rest of the batch.
+  for (intptr_t i = 0; i < 3; i++) {
+    handler_peer.PostMessage(
+        new Message(ports[i], 0, NULL, 0, Message::kNormalPriority));
+  }
+  handler.set_interrupt(ports[0], Message::kIllegalPort);
+  EXPECT(handler_peer.HandleAllMessages());
+  EXPECT_EQ(5, handler.message_count());
+  EXPECT(handler_peer.queue()->IsEmpty());
+  PortMap::ClosePorts(&handler);
+  FLAG_message_batch_size = saved_message_batch_size;
+}
+
+
 struct ThreadStartInfo {
   MessageHandler* handler;
   Dart_Port* ports;
@@ -308,4 +479,110 @@ UNIT_TEST_CASE(MessageHandler_Run) {
   PortMap::ClosePorts(&handler);
 }
 
+
+// Counts the messages it handles on the thread pool and signals when it is
+// done with the expected ones and when it has stopped.
+class CountingMessageHandler : public MessageHandler {
+ public:
+  CountingMessageHandler(Monitor* monitor, intptr_t expected)
+      : monitor_(monitor),
+        expected_(expected),
+        count_(0),
+        done_(false),
+        ended_(false) { }
+
+  bool HandleMessage(Message* message) {
+    delete message;
+    if (++count_ == expected_) {
+      MonitorLocker ml(monitor_);
+      done_ = true;
+      ml.Notify();
+    }
+    return true;
+  }
+
+  static void End(uword data) {
+    CountingMessageHandler* handler =
+        reinterpret_cast<CountingMessageHandler*>(data);
+    MonitorLocker ml(handler->monitor_);
+    handler->ended_ = true;
+    ml.Notify();
+  }
+
+  bool done() const { return done_; }
+  bool ended() const { return ended_; }
+
+ private:
+  Monitor* monitor_;
+  intptr_t expected_;
+  intptr_t count_;
+  bool done_;
+  bool ended_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingMessageHandler);
+};
+
+
+struct PostMessagesInfo {
+  Dart_Port port;
+  intptr_t count;
+};
+
+
+static void PostMessages(uword param) {
+  PostMessagesInfo* info = reinterpret_cast<PostMessagesInfo*>(param);
+  for (intptr_t i = 0; i < info->count; i++) {
+    PortMap::PostMessage(
+        new Message(info->port, 0, NULL, 0, Message::kNormalPriority));
+  }
+}
+
+
+//
+// Measure the number of messages per second a handler running on the thread
+// pool gets through while several threads post to it. Run with
+// --message_batch_size to measure batched handling.
+//
+BENCHMARK(MessageHandlerThroughput) {
+  const intptr_t kMessagesPerThread = 50000;
+  const intptr_t kThreads = 4;
+  ThreadPool pool;
+  Monitor monitor;
+  CountingMessageHandler handler(&monitor, kThreads * kMessagesPerThread);
+  MessageHandlerTestPeer handler_peer(&handler);
+  PostMessagesInfo info;
+  info.port = PortMap::CreatePort(&handler);
+  info.count = kMessagesPerThread;
+  handler.Run(&pool, NULL, CountingMessageHandler::End,
+              reinterpret_cast<uword>(&handler));
+  Timer timer(true, "Message handler throughput benchmark");
+  timer.Start();
+  for (intptr_t i = 0; i < kThreads; i++) {
+    int result = Thread::Start(PostMessages, reinterpret_cast<uword>(&info));
+    EXPECT_EQ(0, result);
+  }
+  {
+    MonitorLocker ml(&monitor);
+    while (!handler.done()) {
+      ml.Wait();
+    }
+  }
+  timer.Stop();
+  int64_t elapsed_time = timer.TotalElapsedTime();
+  int64_t messages_per_second = (elapsed_time > 0)
+      ? (kThreads * kMessagesPerThread * kMicrosecondsPerSecond) / elapsed_time
+      : 0;
+  // Without live ports the handler stops after the next message.
+  PortMap::ClosePorts(&handler);
+  handler_peer.PostMessage(
+      new Message(info.port, 0, NULL, 0, Message::kNormalPriority));
+  {
+    MonitorLocker ml(&monitor);
+    while (!handler.ended()) {
+      ml.Wait();
+    }
+  }
+  benchmark->set_score(messages_per_second);
+}
+
 }  // namespace dart
@@ -5,6 +5,7 @@
 #include "include/dart_native_api.h"
 
 #include "platform/assert.h"
+#include "vm/compact_message.h"
 #include "vm/dart_api_impl.h"
 #include "vm/dart_api_message.h"
 #include "vm/dart_api_state.h"
@@ -23,6 +24,11 @@ static uint8_t* allocator(uint8_t* ptr, intptr_t old_size, intptr_t new_size) {
 
 
 DART_EXPORT bool Dart_PostCObject(Dart_Port port_id, Dart_CObject* message) {
+  Message* compact_message = CompactMessage::New(port_id, message);
+  if (compact_message != NULL) {
+    return PortMap::PostMessage(compact_message);
+  }
+
   uint8_t* buffer = NULL;
   ApiMessageWriter writer(&buffer, allocator);
   bool success = writer.WriteCMessage(message);
@@ -4,6 +4,7 @@
 
 #include "vm/native_message_handler.h"
 
+#include "vm/compact_message.h"
 #include "vm/dart_api_message.h"
 #include "vm/isolate.h"
 #include "vm/message.h"
@@ -49,8 +50,15 @@ bool NativeMessageHandler::HandleMessage(Message* message) {
   // Enter a native scope for handling the message. This will create a
   // zone for allocating the objects for decoding the message.
   ApiNativeScope scope;
-  ApiMessageReader reader(message->data(), message->len(), zone_allocator);
-  Dart_CObject* object = reader.ReadMessage();
+  Dart_CObject* object;
+  if (message->is_compact()) {
+    CompactApiMessageReader reader(message->data(), message->len(),
+                                   zone_allocator);
+    object = reader.ReadMessage();
+  } else {
+    ApiMessageReader reader(message->data(), message->len(), zone_allocator);
+    object = reader.ReadMessage();
+  }
   (*func())(message->dest_port(), object);
   delete message;
   return true;
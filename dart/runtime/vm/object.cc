@@ -1404,6 +1404,11 @@ void Object::InitializeObject(uword address, intptr_t class_id, intptr_t size) {
   ASSERT(class_id != kIllegalCid);
   tags = RawObject::ClassIdTag::update(class_id, tags);
   tags = RawObject::SizeTag::update(size, tags);
+  if (((class_id == kArrayCid) || (class_id == kImmutableArrayCid)) &&
+      (size >= PageSpace::kAllocatablePageSize)) {
+    // Arrays of this size always get a large page of their own in old space.
+    tags = RawObject::CardRememberedBit::update(true, tags);
+  }
   reinterpret_cast<RawObject*>(address)->tags_ = tags;
 }
 
@@ -1468,6 +1473,10 @@ class StoreBufferUpdateVisitor : public ObjectPointerVisitor {
     for (RawObject** curr = first; curr <= last; ++curr) {
       RawObject* raw_obj = *curr;
       if (raw_obj->IsHeapObject() && raw_obj->IsNewObject()) {
+        if (old_obj_->IsCardRemembered()) {
+          HeapPage::RememberCard(old_obj_, curr);
+          continue;
+        }
         old_obj_->SetRememberedBit();
         isolate()->store_buffer()->AddObject(old_obj_);
         // Remembered this object. There is no need to continue searching.
@@ -1500,6 +1509,11 @@ RawObject* Object::Clone(const Object& src, Heap::Space space) {
   RawObject* raw_obj = Object::Allocate(cls.id(), size, space);
   NoGCScope no_gc;
   memmove(raw_obj->ptr(), src.raw()->ptr(), size);
+  if (RawObject::IsExternalTypedDataClassId(cls.id())) {
+    // The finalizer of a transferable object only owns the original's data.
+    reinterpret_cast<RawExternalTypedData*>(raw_obj)->ptr()->transfer_handle_ =
+        NULL;
+  }
   if ((space == Heap::kOld) && !raw_obj->IsRemembered()) {
     StoreBufferUpdateVisitor visitor(Isolate::Current(), raw_obj);
     raw_obj->VisitPointers(&visitor);
@@ -2725,6 +2739,12 @@ void Class::set_allocation_stub(const Code& value) const {
 }
 
 
+void Class::DisableAllocationStub() const {
+  // The code already calling the stub keeps using it.
+  StorePointer(&raw_ptr()->allocation_stub_, Code::null());
+}
+
+
 bool Class::IsFunctionClass() const {
   return raw() == Type::Handle(Type::Function()).type_class();
 }
@@ -4502,7 +4522,7 @@ void Function::set_token_pos(intptr_t value) const {
 
 
 void Function::set_kind_tag(intptr_t value) const {
-  raw_ptr()->kind_tag_ = static_cast<uint16_t>(value);
+  raw_ptr()->kind_tag_ = static_cast<uint32_t>(value);
 }
 
 
@@ -4555,6 +4575,11 @@ void Function::set_is_optimizable(bool value) const {
 }
 
 
+void Function::set_is_optimization_queued(bool value) const {
+  set_kind_tag(OptimizationQueuedBit::update(value, raw_ptr()->kind_tag_));
+}
+
+
 void Function::set_has_finally(bool value) const {
   set_kind_tag(HasFinallyBit::update(value, raw_ptr()->kind_tag_));
 }
@@ -5949,7 +5974,7 @@ RawArray* Field::dependent_code() const {
 
 
 void Field::set_dependent_code(const Array& array) const {
-  raw_ptr()->dependent_code_ = array.raw();
+  StorePointer(&raw_ptr()->dependent_code_, array.raw());
 }
 
 
@@ -14257,6 +14282,7 @@ RawString* String::MakeExternal(void* array,
                                 void* peer,
                                 Dart_PeerFinalizer cback) const {
   NoGCScope no_gc;
+  PauseConcurrentGCScope pause_gc;
   ASSERT(array != NULL);
   intptr_t str_length = this->Length();
   ASSERT(length >= (str_length * this->CharSize()));
@@ -15049,6 +15075,7 @@ RawArray* Array::New(intptr_t class_id, intptr_t len, Heap::Space space) {
 
 void Array::MakeImmutable() const {
   NoGCScope no_gc;
+  PauseConcurrentGCScope pause_gc;
   uword tags = raw_ptr()->tags_;
   tags = RawObject::ClassIdTag::update(kImmutableArrayCid, tags);
   raw_ptr()->tags_ = tags;
@@ -15104,11 +15131,17 @@ RawArray* Array::MakeArray(const GrowableObjectArray& growable_array) {
   intptr_t capacity_size = Array::InstanceSize(capacity_len);
   intptr_t used_size = Array::InstanceSize(used_len);
   NoGCScope no_gc;
+  PauseConcurrentGCScope pause_gc;
 
   // Update the size in the header field and length of the array object.
   uword tags = array.raw_ptr()->tags_;
   ASSERT(kArrayCid == RawObject::ClassIdTag::decode(tags));
   tags = RawObject::SizeTag::update(used_size, tags);
+  if (array.raw()->IsNewObject() &&
+      (used_size < PageSpace::kAllocatablePageSize)) {
+    // Once promoted the shrunk array would not get a large page.
+    tags = RawObject::CardRememberedBit::update(false, tags);
+  }
   array.raw_ptr()->tags_ = tags;
   array.SetLength(used_len);
 
@@ -15553,6 +15586,26 @@ FinalizablePersistentHandle* ExternalTypedData::AddFinalizer(
 }
 
 
+void ExternalTypedData::MakeTransferable(
+    void* peer, Dart_WeakPersistentHandleFinalizer callback) const {
+  ASSERT(!IsTransferable());
+  ASSERT((peer != NULL) && (callback != NULL));
+  SetTransferHandle(AddFinalizer(peer, callback));
+}
+
+
+void ExternalTypedData::Detach() const {
+  ASSERT(IsTransferable());
+  ApiState* state = Isolate::Current()->api_state();
+  ASSERT(state != NULL);
+  state->weak_persistent_handles().FreeHandle(transfer_handle());
+  SetTransferHandle(NULL);
+  SetPeer(NULL);
+  SetData(NULL);
+  SetLength(0);
+}
+
+
 RawExternalTypedData* ExternalTypedData::New(intptr_t class_id,
                                              uint8_t* data,
                                              intptr_t len,
@@ -15566,6 +15619,7 @@ RawExternalTypedData* ExternalTypedData::New(intptr_t class_id,
     result ^= raw;
     result.SetLength(len);
     result.SetData(data);
+    result.SetTransferHandle(NULL);
   }
   return result.raw();
 }
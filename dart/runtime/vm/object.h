@@ -521,10 +521,27 @@ class Object {
     *addr = value;
     // Filter stores based on source and target.
     if (!value->IsHeapObject()) return;
-    if (value->IsNewObject() && raw()->IsOldObject() &&
-        !raw()->IsRemembered()) {
-      raw()->SetRememberedBit();
-      Isolate::Current()->store_buffer()->AddObject(raw());
+    if (value->IsNewObject() && raw()->IsOldObject()) {
+      if (raw()->IsCardRemembered()) {
+        HeapPage::RememberCard(raw(), reinterpret_cast<RawObject**>(addr));
+      } else if (!raw()->IsRemembered()) {
+        raw()->SetRememberedBit();
+        Isolate::Current()->store_buffer()->AddObject(raw());
+      }
+    }
+    if (FLAG_concurrent_mark) {
+      MarkingBarrier(raw(), value);
+    }
+  }
+
+  // Greys old objects stored into old space while the old generation is being
+  // marked concurrently.
+  static void MarkingBarrier(RawObject* target, RawObject* value) {
+    if (value->IsOldObject() && target->IsOldObject() && !value->IsMarked()) {
+      Isolate* isolate = Isolate::Current();
+      if (isolate->concurrent_marking()) {
+        isolate->heap()->MarkingBarrier(value);
+      }
     }
   }
 
@@ -981,6 +998,7 @@ class Class : public Object {
     return raw_ptr()->allocation_stub_;
   }
   void set_allocation_stub(const Code& value) const;
+  void DisableAllocationStub() const;
 
   RawArray* constants() const;
 
@@ -1730,6 +1748,13 @@ class Function : public Object {
   bool is_optimizable() const;
   void set_is_optimizable(bool value) const;
 
+  // True while the function waits in the optimization queue of the isolate
+  // (see Compiler::QueueOptimizedCompilation). Not written to snapshots.
+  bool is_optimization_queued() const {
+    return OptimizationQueuedBit::decode(raw_ptr()->kind_tag_);
+  }
+  void set_is_optimization_queued(bool value) const;
+
   bool has_finally() const {
     return HasFinallyBit::decode(raw_ptr()->kind_tag_);
   }
@@ -1935,6 +1960,7 @@ class Function : public Object {
     kNativeBit = 13,
     kRedirectingBit = 14,
     kExternalBit = 15,
+    kOptimizationQueuedBit = 16,
   };
   class KindBits :
     public BitField<RawFunction::Kind, kKindTagBit, kKindTagSize> {};  // NOLINT
@@ -1950,6 +1976,8 @@ class Function : public Object {
   class NativeBit : public BitField<bool, kNativeBit, 1> {};
   class ExternalBit : public BitField<bool, kExternalBit, 1> {};
   class RedirectingBit : public BitField<bool, kRedirectingBit, 1> {};
+  class OptimizationQueuedBit :
+    public BitField<bool, kOptimizationQueuedBit, 1> {};  // NOLINT
 
   void set_name(const String& value) const;
   void set_kind(RawFunction::Kind value) const;
@@ -5139,6 +5167,7 @@ class OneByteString : public AllStatic {
                                     Snapshot::Kind kind);
 
   friend class Class;
+  friend class CompactMessageWriter;
   friend class String;
   friend class ExternalOneByteString;
   friend class SnapshotReader;
@@ -5657,10 +5686,16 @@ class GrowableObjectArray : public Instance {
     *addr = value;
     // Filter stores based on source and target.
     if (!value->IsHeapObject()) return;
-    if (value->IsNewObject() && data()->IsOldObject() &&
-        !data()->IsRemembered()) {
-      data()->SetRememberedBit();
-      Isolate::Current()->store_buffer()->AddObject(data());
+    if (value->IsNewObject() && data()->IsOldObject()) {
+      if (data()->IsCardRemembered()) {
+        HeapPage::RememberCard(data(), addr);
+      } else if (!data()->IsRemembered()) {
+        data()->SetRememberedBit();
+        Isolate::Current()->store_buffer()->AddObject(data());
+      }
+    }
+    if (FLAG_concurrent_mark) {
+      MarkingBarrier(data(), value);
     }
   }
 
@@ -5928,6 +5963,21 @@ class ExternalTypedData : public Instance {
   FinalizablePersistentHandle* AddFinalizer(
       void* peer, Dart_WeakPersistentHandleFinalizer callback) const;
 
+  // A transferable object hands its data and finalizer over to the isolate
+  // receiving it in a message instead of having its data copied.
+  void MakeTransferable(void* peer,
+                        Dart_WeakPersistentHandleFinalizer callback) const;
+  bool IsTransferable() const {
+    return raw_ptr()->transfer_handle_ != NULL;
+  }
+  FinalizablePersistentHandle* transfer_handle() const {
+    return raw_ptr()->transfer_handle_;
+  }
+
+  // Gives up the ownership of the data of a transferable object, which is
+  // left empty. The finalizer is deleted without being called.
+  void Detach() const;
+
   static intptr_t length_offset() {
     return OFFSET_OF(RawExternalTypedData, length_);
   }
@@ -5980,6 +6030,10 @@ class ExternalTypedData : public Instance {
     raw_ptr()->peer_ = peer;
   }
 
+  void SetTransferHandle(FinalizablePersistentHandle* handle) const {
+    raw_ptr()->transfer_handle_ = handle;
+  }
+
  private:
   FINAL_HEAP_OBJECT_IMPLEMENTATION(ExternalTypedData, Instance);
   friend class Class;
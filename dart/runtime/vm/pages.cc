@@ -6,6 +6,7 @@
 
 #include "platform/assert.h"
 #include "vm/compiler_stats.h"
+#include "vm/gc_compactor.h"
 #include "vm/gc_marker.h"
 #include "vm/gc_sweeper.h"
 #include "vm/object.h"
@@ -19,6 +20,22 @@ DEFINE_FLAG(int, heap_growth_time_ratio, 3,
             "The desired maximum percentage of time spent in GC");
 DEFINE_FLAG(int, heap_growth_rate, 4,
             "The size the heap is grown, in heap pages");
+DEFINE_FLAG(bool, adaptive_heap_sizing, false,
+            "Size the generations from their survival rates and GC times to "
+            "meet --gc_pause_target and --gc_time_target. The old generation "
+            "grows starting from --heap_growth_space_ratio and the semi spaces "
+            "of the new generation are at most --new_gen_heap_size");
+DEFINE_FLAG(int, gc_pause_target, 10,
+            "The desired maximum scavenge pause in milliseconds with "
+            "--adaptive_heap_sizing");
+DEFINE_FLAG(int, gc_time_target, 5,
+            "The desired maximum percentage of time spent in GC with "
+            "--adaptive_heap_sizing, replaces --heap_growth_time_ratio");
+DEFINE_FLAG(int, page_cache_size, 8,
+            "Maximum number of freed old space pages kept for reuse.");
+DEFINE_FLAG(int, page_cache_delay, 1000,
+            "Milliseconds after which the memory of a cached old space page "
+            "is given back to the OS.");
 DEFINE_FLAG(bool, print_free_list_before_gc, false,
             "Print free list statistics before a GC");
 DEFINE_FLAG(bool, print_free_list_after_gc, false,
@@ -31,16 +48,45 @@ DEFINE_FLAG(bool, log_code_drop, false,
             "Emit a log message when pointers to unused code are dropped.");
 DEFINE_FLAG(bool, always_drop_code, false,
             "Always try to drop code if the function's usage counter is >= 0");
+DEFINE_FLAG(bool, lazy_sweep, false,
+            "Sweep old space pages on demand after a mark-sweep.");
+DEFINE_FLAG(bool, concurrent_sweep, false,
+            "Sweep the pages left by --lazy_sweep on a background task.");
+DECLARE_FLAG(int, concurrent_mark_threshold);
+
+
+// Keeps the concurrent sweeper, if any, from changing pages while they are
+// walked.
+class PauseSweeperScope : public ValueObject {
+ public:
+  explicit PauseSweeperScope(ConcurrentSweeper* sweeper) : sweeper_(sweeper) {
+    if (sweeper_ != NULL) {
+      sweeper_->Pause();
+    }
+  }
+
+  ~PauseSweeperScope() {
+    if (sweeper_ != NULL) {
+      sweeper_->Resume();
+    }
+  }
+
+ private:
+  ConcurrentSweeper* sweeper_;
+
+  DISALLOW_COPY_AND_ASSIGN(PauseSweeperScope);
+};
+
 
 HeapPage* HeapPage::Initialize(VirtualMemory* memory, PageType type) {
   ASSERT(memory->size() > VirtualMemory::PageSize());
   bool is_executable = (type == kExecutable);
-  memory->Commit(is_executable);
-
   HeapPage* result = reinterpret_cast<HeapPage*>(memory->address());
   result->memory_ = memory;
   result->next_ = NULL;
+  result->card_table_ = NULL;
   result->executable_ = is_executable;
+  result->sweep_state_ = kSwept;
   return result;
 }
 
@@ -48,22 +94,31 @@ HeapPage* HeapPage::Initialize(VirtualMemory* memory, PageType type) {
 HeapPage* HeapPage::Allocate(intptr_t size_in_words, PageType type) {
   VirtualMemory* memory =
       VirtualMemory::Reserve(size_in_words << kWordSizeLog2);
+  memory->Commit(type == kExecutable);
   return Initialize(memory, type);
 }
 
 
 void HeapPage::Deallocate() {
+  free(card_table_);
   // The memory for this object will become unavailable after the delete below.
   delete memory_;
 }
 
 
 void HeapPage::VisitObjects(ObjectVisitor* visitor) const {
+  if (sweep_state_ == kSweptEmpty) {
+    return;
+  }
+  // The unmarked objects of an unswept page are garbage.
+  const bool live_only = !is_swept();
   uword obj_addr = object_start();
   uword end_addr = object_end();
   while (obj_addr < end_addr) {
     RawObject* raw_obj = RawObject::FromAddr(obj_addr);
-    visitor->VisitObject(raw_obj);
+    if (!live_only || raw_obj->IsMarked()) {
+      visitor->VisitObject(raw_obj);
+    }
     obj_addr += raw_obj->Size();
   }
   ASSERT(obj_addr == end_addr);
@@ -71,22 +126,70 @@ void HeapPage::VisitObjects(ObjectVisitor* visitor) const {
 
 
 void HeapPage::VisitObjectPointers(ObjectPointerVisitor* visitor) const {
+  if (sweep_state_ == kSweptEmpty) {
+    return;
+  }
+  const bool live_only = !is_swept();
   uword obj_addr = object_start();
   uword end_addr = object_end();
   while (obj_addr < end_addr) {
     RawObject* raw_obj = RawObject::FromAddr(obj_addr);
-    obj_addr += raw_obj->VisitPointers(visitor);
+    if (!live_only || raw_obj->IsMarked()) {
+      obj_addr += raw_obj->VisitPointers(visitor);
+    } else {
+      obj_addr += raw_obj->Size();
+    }
   }
   ASSERT(obj_addr == end_addr);
 }
 
 
+void HeapPage::VisitRememberedCards(ObjectPointerVisitor* visitor) {
+  ASSERT(card_table_ != NULL);
+  RawObject* raw_obj = RawObject::FromAddr(object_start());
+  if (!raw_obj->IsCardRemembered()) {
+    return;
+  }
+  // All the words following the header of an array are pointers.
+  uword obj_first = object_start() + sizeof(RawObject);
+  uword obj_end = object_start() + raw_obj->Size();
+  uword page = reinterpret_cast<uword>(this);
+  intptr_t num_cards = card_table_size();
+  for (intptr_t i = 0; i < num_cards; i++) {
+    if (card_table_[i] == 0) {
+      continue;
+    }
+    card_table_[i] = 0;
+    uword card_start = page + (i << kCardSizeLog2);
+    uword first = Utils::Maximum(card_start, obj_first);
+    uword end = Utils::Minimum(card_start + kCardSize, obj_end);
+    if (first >= end) {
+      continue;
+    }
+    RawObject** first_slot = reinterpret_cast<RawObject**>(first);
+    RawObject** last_slot = reinterpret_cast<RawObject**>(end - kWordSize);
+    visitor->VisitPointers(first_slot, last_slot);
+    for (RawObject** slot = first_slot; slot <= last_slot; slot++) {
+      RawObject* value = *slot;
+      if (value->IsHeapObject() && value->IsNewObject()) {
+        card_table_[i] = 1;
+        break;
+      }
+    }
+  }
+}
+
+
 RawObject* HeapPage::FindObject(FindObjectVisitor* visitor) const {
+  if (sweep_state_ == kSweptEmpty) {
+    return Object::null();
+  }
+  const bool live_only = !is_swept();
   uword obj_addr = object_start();
   uword end_addr = object_end();
   while (obj_addr < end_addr) {
     RawObject* raw_obj = RawObject::FromAddr(obj_addr);
-    if (raw_obj->FindObject(visitor)) {
+    if ((!live_only || raw_obj->IsMarked()) && raw_obj->FindObject(visitor)) {
       return raw_obj;  // Found object, return it.
     }
     obj_addr += raw_obj->Size();
@@ -124,14 +227,32 @@ PageSpace::PageSpace(Heap* heap, intptr_t max_capacity_in_words)
       max_capacity_in_words_(max_capacity_in_words),
       capacity_in_words_(0),
       used_in_words_(0),
+      mapped_pages_(0),
+      unmapped_pages_(0),
+      reused_pages_(0),
       sweeping_(false),
+      concurrent_marker_(NULL),
+      lazy_sweeping_(false),
+      next_unswept_page_(NULL),
+      last_unswept_page_(NULL),
+      pages_swept_on_demand_(0),
+      concurrent_sweeper_(NULL),
       page_space_controller_(FLAG_heap_growth_space_ratio,
                              FLAG_heap_growth_rate,
-                             FLAG_heap_growth_time_ratio) {
+                             FLAG_adaptive_heap_sizing ?
+                                 FLAG_gc_time_target :
+                                 FLAG_heap_growth_time_ratio) {
+  for (intptr_t i = 0; i < HeapPage::kNumPageTypes; i++) {
+    bump_top_[i] = 0;
+    bump_end_[i] = 0;
+  }
 }
 
 
 PageSpace::~PageSpace() {
+  // Stops the marking and sweeping tasks before the pages go away.
+  delete concurrent_marker_;
+  delete concurrent_sweeper_;
   FreePages(pages_);
   FreePages(large_pages_);
 }
@@ -145,13 +266,17 @@ intptr_t PageSpace::LargePageSizeInWordsFor(intptr_t size) {
 
 
 HeapPage* PageSpace::AllocatePage(HeapPage::PageType type) {
-  HeapPage* page = HeapPage::Allocate(kPageSizeInWords, type);
-  if (pages_ == NULL) {
-    pages_ = page;
+  HeapPage* page;
+  VirtualMemory* memory = page_cache_.Take(type);
+  if (memory != NULL) {
+    // The cached memory is still committed with the protection of its type.
+    page = HeapPage::Initialize(memory, type);
+    reused_pages_++;
   } else {
-    pages_tail_->set_next(page);
+    page = HeapPage::Allocate(kPageSizeInWords, type);
+    mapped_pages_++;
   }
-  pages_tail_ = page;
+  AddPage(page);
   capacity_in_words_ += kPageSizeInWords;
   page->set_object_end(page->memory_->end());
   return page;
@@ -161,6 +286,11 @@ HeapPage* PageSpace::AllocatePage(HeapPage::PageType type) {
 HeapPage* PageSpace::AllocateLargePage(intptr_t size, HeapPage::PageType type) {
   intptr_t page_size_in_words = LargePageSizeInWordsFor(size);
   HeapPage* page = HeapPage::Allocate(page_size_in_words, type);
+  mapped_pages_++;
+  if (type == HeapPage::kData) {
+    page->card_table_ =
+        reinterpret_cast<uint8_t*>(calloc(page->card_table_size(), 1));
+  }
   page->set_next(large_pages_);
   large_pages_ = page;
   capacity_in_words_ += page_size_in_words;
@@ -170,8 +300,34 @@ HeapPage* PageSpace::AllocateLargePage(intptr_t size, HeapPage::PageType type) {
 }
 
 
-void PageSpace::FreePage(HeapPage* page, HeapPage* previous_page) {
+void PageSpace::AddPage(HeapPage* page) {
+  page->set_next(NULL);
+  if (pages_ == NULL) {
+    pages_ = page;
+  } else {
+    pages_tail_->set_next(page);
+  }
+  pages_tail_ = page;
+}
+
+
+void PageSpace::ReleasePage(HeapPage* page) {
   capacity_in_words_ -= (page->memory_->size() >> kWordSizeLog2);
+  int64_t now = OS::GetCurrentTimeMillis();
+  if (!page_cache_.Add(page->memory_, page->type(), now)) {
+    page->Deallocate();
+    unmapped_pages_++;
+  }
+  page_cache_.Trim(now);
+}
+
+
+void PageSpace::TrimPageCache() {
+  page_cache_.Trim(OS::GetCurrentTimeMillis());
+}
+
+
+void PageSpace::FreePage(HeapPage* page, HeapPage* previous_page) {
   // Remove the page from the list.
   if (previous_page != NULL) {
     previous_page->set_next(page->next());
@@ -181,8 +337,7 @@ void PageSpace::FreePage(HeapPage* page, HeapPage* previous_page) {
   if (page == pages_tail_) {
     pages_tail_ = previous_page;
   }
-  // TODO(iposva): Consider adding to a pool of empty pages.
-  page->Deallocate();
+  ReleasePage(page);
 }
 
 
@@ -195,6 +350,7 @@ void PageSpace::FreeLargePage(HeapPage* page, HeapPage* previous_page) {
     large_pages_ = page->next();
   }
   page->Deallocate();
+  unmapped_pages_++;
 }
 
 
@@ -214,8 +370,21 @@ uword PageSpace::TryAllocate(intptr_t size,
   ASSERT(size >= kObjectAlignment);
   ASSERT(Utils::IsAligned(size, kObjectAlignment));
   uword result = 0;
+  bool is_bump_allocated = false;
   if (size < kAllocatablePageSize) {
-    result = freelist_[type].TryAllocate(size);
+    result = TryBumpAllocate(size, type);
+    if ((result == 0) &&
+        (size <= kMaxBumpAllocationSize) &&
+        RefillBumpArea(type)) {
+      result = TryBumpAllocate(size, type);
+    }
+    is_bump_allocated = (result != 0);
+    if (result == 0) {
+      result = freelist_[type].TryAllocate(size);
+    }
+    if ((result == 0) && lazy_sweeping_) {
+      result = TryAllocateSweeping(size, type);
+    }
     if ((result == 0) &&
         (page_space_controller_.CanGrowPageSpace(size) ||
          growth_policy == kForceGrowth) &&
@@ -224,12 +393,10 @@ uword PageSpace::TryAllocate(intptr_t size,
       ASSERT(page != NULL);
       // Start of the newly allocated page is the allocated object.
       result = page->object_start();
-      // Enqueue the remainder in the free list.
+      // The remainder becomes the bump allocation area.
+      RetireBumpArea(type);
       uword free_start = result + size;
-      intptr_t free_size = page->object_end() - free_start;
-      if (free_size > 0) {
-        freelist_[type].Free(free_start, free_size);
-      }
+      SetBumpArea(free_start, page->object_end() - free_start, type);
     }
   } else {
     // Large page allocation.
@@ -248,7 +415,10 @@ uword PageSpace::TryAllocate(intptr_t size,
     }
   }
   if (result != 0) {
-    used_in_words_ += (size >> kWordSizeLog2);
+    if (!is_bump_allocated) {
+      // The bump allocation area is accounted as used when it is set up.
+      used_in_words_ += (size >> kWordSizeLog2);
+    }
     if (FLAG_compiler_stats && (type == HeapPage::kExecutable)) {
       CompilerStats::code_allocated += size;
     }
@@ -258,6 +428,50 @@ uword PageSpace::TryAllocate(intptr_t size,
 }
 
 
+void PageSpace::SetBumpArea(uword start,
+                            intptr_t size,
+                            HeapPage::PageType type) {
+  ASSERT(bump_top_[type] == bump_end_[type]);
+  ASSERT(size >= 0);
+  bump_top_[type] = start;
+  bump_end_[type] = start + size;
+  used_in_words_ += (size >> kWordSizeLog2);
+}
+
+
+void PageSpace::RetireBumpArea(HeapPage::PageType type) {
+  intptr_t free_size = bump_end_[type] - bump_top_[type];
+  if (free_size > 0) {
+    freelist_[type].Free(bump_top_[type], free_size);
+    used_in_words_ -= (free_size >> kWordSizeLog2);
+  }
+  bump_top_[type] = 0;
+  bump_end_[type] = 0;
+}
+
+
+bool PageSpace::RefillBumpArea(HeapPage::PageType type) {
+  RetireBumpArea(type);
+  intptr_t size = 0;
+  uword start = freelist_[type].TryAllocateLarge(&size);
+  if (start == 0) {
+    return false;
+  }
+  SetBumpArea(start, size, type);
+  return true;
+}
+
+
+void PageSpace::MakeIterable() const {
+  for (intptr_t i = 0; i < HeapPage::kNumPageTypes; i++) {
+    intptr_t free_size = bump_end_[i] - bump_top_[i];
+    if (free_size > 0) {
+      FreeListElement::AsElement(bump_top_[i], free_size);
+    }
+  }
+}
+
+
 bool PageSpace::Contains(uword addr) const {
   HeapPage* page = pages_;
   while (page != NULL) {
@@ -316,6 +530,8 @@ void PageSpace::StartEndAddress(uword* start, uword* end) const {
 
 
 void PageSpace::VisitObjects(ObjectVisitor* visitor) const {
+  MakeIterable();
+  PauseSweeperScope pause_sweeper(concurrent_sweeper_);
   HeapPage* page = pages_;
   while (page != NULL) {
     page->VisitObjects(visitor);
@@ -331,6 +547,8 @@ void PageSpace::VisitObjects(ObjectVisitor* visitor) const {
 
 
 void PageSpace::VisitObjectPointers(ObjectPointerVisitor* visitor) const {
+  MakeIterable();
+  PauseSweeperScope pause_sweeper(concurrent_sweeper_);
   HeapPage* page = pages_;
   while (page != NULL) {
     page->VisitObjectPointers(visitor);
@@ -345,9 +563,20 @@ void PageSpace::VisitObjectPointers(ObjectPointerVisitor* visitor) const {
 }
 
 
+void PageSpace::VisitRememberedCards(ObjectPointerVisitor* visitor) const {
+  for (HeapPage* page = large_pages_; page != NULL; page = page->next()) {
+    if (page->card_table_ != NULL) {
+      page->VisitRememberedCards(visitor);
+    }
+  }
+}
+
+
 RawObject* PageSpace::FindObject(FindObjectVisitor* visitor,
                                  HeapPage::PageType type) const {
   ASSERT(Isolate::Current()->no_gc_scope_depth() != 0);
+  MakeIterable();
+  PauseSweeperScope pause_sweeper(concurrent_sweeper_);
   HeapPage* page = pages_;
   while (page != NULL) {
     if (page->type() == type) {
@@ -406,6 +635,9 @@ bool PageSpace::ShouldCollectCode() {
 
 
 void PageSpace::MarkSweep(bool invoke_api_callbacks) {
+  // The mark bits left by the last collection need to be cleared first.
+  FinishSweeping();
+
   // MarkSweep is not reentrant. Make sure that is the case.
   ASSERT(!sweeping_);
   sweeping_ = true;
@@ -423,6 +655,9 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
   if (FLAG_verify_before_gc) {
     OS::PrintErr("Verifying before MarkSweep...");
     heap_->Verify();
+    if (concurrent_marker_ == NULL) {
+      VerifySweepState();
+    }
     OS::PrintErr(" done.\n");
   }
 
@@ -431,12 +666,24 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
   // Mark all reachable old-gen objects.
   bool collect_code = FLAG_collect_code && ShouldCollectCode();
   GCMarker marker(heap_);
-  marker.MarkObjects(isolate, this, invoke_api_callbacks, collect_code);
+  if (concurrent_marker_ != NULL) {
+    marker.FinishConcurrentMarking(isolate,
+                                   this,
+                                   concurrent_marker_,
+                                   invoke_api_callbacks,
+                                   collect_code);
+    delete concurrent_marker_;
+    concurrent_marker_ = NULL;
+  } else {
+    marker.MarkObjects(isolate, this, invoke_api_callbacks, collect_code);
+  }
 
   int64_t mid1 = OS::GetCurrentTimeMicros();
 
-  // Reset the bump allocation page to unused.
+  // Reset the bump allocation areas to unused.
   // Reset the freelists and setup sweeping.
+  RetireBumpArea(HeapPage::kData);
+  RetireBumpArea(HeapPage::kExecutable);
   freelist_[HeapPage::kData].Reset();
   freelist_[HeapPage::kExecutable].Reset();
 
@@ -444,20 +691,43 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
 
   GCSweeper sweeper(heap_);
   intptr_t used_in_words = 0;
+  intptr_t unswept_pages = 0;
+
+  // Take the sparsely used pages out of a fragmented old generation to be
+  // evacuated once the rest has been swept. Compaction implies eager sweeping.
+  GCCompactor compactor(heap_, this);
+  const bool compact =
+      GCCompactor::ShouldCompact(capacity_in_words_, marker.marked_words()) &&
+      compactor.SelectCandidates();
+  const bool sweep_lazily = FLAG_lazy_sweep && !compact;
 
   HeapPage* prev_page = NULL;
   HeapPage* page = pages_;
-  while (page != NULL) {
-    HeapPage* next_page = page->next();
-    intptr_t page_in_use = sweeper.SweepPage(page, &freelist_[page->type()]);
-    if (page_in_use == 0) {
-      FreePage(page, prev_page);
-    } else {
-      used_in_words += (page_in_use >> kWordSizeLog2);
-      prev_page = page;
+  if (sweep_lazily) {
+    // Leave the regular pages to be swept when the free lists run dry, or by
+    // the concurrent sweeper.
+    while (page != NULL) {
+      page->set_sweep_state(HeapPage::kUnswept);
+      unswept_pages++;
+      page = page->next();
+    }
+    lazy_sweeping_ = (unswept_pages > 0);
+    next_unswept_page_ = pages_;
+    last_unswept_page_ = pages_tail_;
+    pages_swept_on_demand_ = 0;
+  } else {
+    while (page != NULL) {
+      HeapPage* next_page = page->next();
+      intptr_t page_in_use = sweeper.SweepPage(page, &freelist_[page->type()]);
+      if (page_in_use == 0) {
+        FreePage(page, prev_page);
+      } else {
+        used_in_words += (page_in_use >> kWordSizeLog2);
+        prev_page = page;
+      }
+      // Advance to the next page.
+      page = next_page;
     }
-    // Advance to the next page.
-    page = next_page;
   }
 
   int64_t mid3 = OS::GetCurrentTimeMicros();
@@ -477,6 +747,15 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
     page = next_page;
   }
 
+  if (compact) {
+    used_in_words += compactor.Compact(isolate) + compactor.moved_words();
+  }
+
+  if (sweep_lazily) {
+    // The unswept pages will hold the marked objects once swept.
+    used_in_words = marker.marked_words();
+  }
+
   // Record data and print if requested.
   intptr_t used_before_in_words = used_in_words_;
   used_in_words_ = used_in_words;
@@ -503,21 +782,203 @@ void PageSpace::MarkSweep(bool invoke_api_callbacks) {
   if (FLAG_verify_after_gc) {
     OS::PrintErr("Verifying after MarkSweep...");
     heap_->Verify();
-    OS::PrintErr(" done.\n");
+    OS::PrintErr(" done, %" Pd " pages unswept.\n", VerifySweepState());
+  }
+
+  if (lazy_sweeping_) {
+    bool concurrent = FLAG_concurrent_sweep && ConcurrentSweeper::IsSupported();
+    if (FLAG_verbose_gc) {
+      OS::PrintErr("Lazy sweeping %" Pd " pages of old space%s.\n",
+                   unswept_pages, concurrent ? " concurrently" : "");
+    }
+    if (concurrent) {
+      concurrent_sweeper_ = new ConcurrentSweeper(isolate, this);
+      concurrent_sweeper_->Start();
+    }
   }
 
+  TrimPageCache();
+
   // Done, reset the marker.
   ASSERT(sweeping_);
   sweeping_ = false;
 }
 
 
+HeapPage* PageSpace::NextUnsweptPage() {
+  HeapPage* page = next_unswept_page_;
+  if (page != NULL) {
+    // The next field of last_unswept_page_ is not read, as the mutator may be
+    // appending a new page to it.
+    next_unswept_page_ = (page == last_unswept_page_) ? NULL : page->next();
+  }
+  return page;
+}
+
+
+void PageSpace::SetSwept(HeapPage* page, intptr_t in_use) {
+  ASSERT(!page->is_swept());
+  // An empty page is not added to the free lists, it is freed by
+  // FinishSweeping instead.
+  page->set_sweep_state((in_use == 0) ? HeapPage::kSweptEmpty
+                                      : HeapPage::kSwept);
+}
+
+
+bool PageSpace::SweepNextPage() {
+  HeapPage* page = NULL;
+  if (concurrent_sweeper_ != NULL) {
+    page = concurrent_sweeper_->ClaimPage();
+  } else {
+    page = NextUnsweptPage();
+  }
+  if (page == NULL) {
+    return false;
+  }
+  GCSweeper sweeper(heap_, true);
+  intptr_t in_use = sweeper.SweepPage(page, &freelist_[page->type()]);
+  SetSwept(page, in_use);
+  pages_swept_on_demand_++;
+  return true;
+}
+
+
+uword PageSpace::TryAllocateSweeping(intptr_t size, HeapPage::PageType type) {
+  uword result = 0;
+  if ((concurrent_sweeper_ != NULL) &&
+      concurrent_sweeper_->TakeFreeLists(freelist_)) {
+    result = freelist_[type].TryAllocate(size);
+  }
+  while ((result == 0) && SweepNextPage()) {
+    result = freelist_[type].TryAllocate(size);
+  }
+  return result;
+}
+
+
+void PageSpace::FinishSweeping() {
+  if (!lazy_sweeping_) {
+    return;
+  }
+  while (SweepNextPage()) {
+    // Sweep the remaining pages on the mutator.
+  }
+  intptr_t pages_swept_concurrently = 0;
+  if (concurrent_sweeper_ != NULL) {
+    // Wait for the page the sweeping task is working on.
+    concurrent_sweeper_->Stop();
+    concurrent_sweeper_->TakeFreeLists(freelist_);
+    pages_swept_concurrently = concurrent_sweeper_->swept_pages();
+    delete concurrent_sweeper_;
+    concurrent_sweeper_ = NULL;
+  }
+  ASSERT(next_unswept_page_ == NULL);
+  intptr_t freed_pages = 0;
+  HeapPage* prev_page = NULL;
+  HeapPage* page = pages_;
+  while (page != NULL) {
+    HeapPage* next_page = page->next();
+    if (page->sweep_state() == HeapPage::kSweptEmpty) {
+      FreePage(page, prev_page);
+      freed_pages++;
+    } else {
+      ASSERT(page->is_swept());
+      prev_page = page;
+    }
+    page = next_page;
+  }
+  lazy_sweeping_ = false;
+  if (FLAG_verbose_gc) {
+    OS::PrintErr("Finished lazy sweeping of old space: %" Pd " pages swept "
+                 "on demand, %" Pd " concurrently, %" Pd " freed.\n",
+                 pages_swept_on_demand_, pages_swept_concurrently, freed_pages);
+  }
+}
+
+
+void PageSpace::TryFinishSweeping() {
+  if (!lazy_sweeping_) {
+    return;
+  }
+  if (concurrent_sweeper_ != NULL) {
+    if (!concurrent_sweeper_->IsDone()) {
+      return;
+    }
+  } else if (next_unswept_page_ != NULL) {
+    return;
+  }
+  FinishSweeping();
+}
+
+
+static void VerifyUnmarked(HeapPage* page) {
+  uword obj_addr = page->object_start();
+  uword end_addr = page->object_end();
+  while (obj_addr < end_addr) {
+    RawObject* raw_obj = RawObject::FromAddr(obj_addr);
+    if (raw_obj->IsMarked()) {
+      FATAL1("Marked object encountered on swept page %#" Px "\n", obj_addr);
+    }
+    obj_addr += raw_obj->Size();
+  }
+}
+
+
+intptr_t PageSpace::VerifySweepState() const {
+  ASSERT(concurrent_marker_ == NULL);
+  MakeIterable();
+  PauseSweeperScope pause_sweeper(concurrent_sweeper_);
+  intptr_t unswept_pages = 0;
+  for (HeapPage* page = pages_; page != NULL; page = page->next()) {
+    switch (page->sweep_state()) {
+      case HeapPage::kSwept:
+        VerifyUnmarked(page);
+        break;
+      case HeapPage::kUnswept:
+        unswept_pages++;
+        break;
+      case HeapPage::kSweptEmpty:
+        break;
+    }
+  }
+  for (HeapPage* page = large_pages_; page != NULL; page = page->next()) {
+    ASSERT(page->is_swept());
+    VerifyUnmarked(page);
+  }
+  return unswept_pages;
+}
+
+
+bool PageSpace::ShouldStartConcurrentMarking() const {
+  // Marking waits for the lazy sweeping to finish.
+  if (!FLAG_concurrent_mark ||
+      !ConcurrentMarker::IsSupported() ||
+      (concurrent_marker_ != NULL) ||
+      lazy_sweeping_) {
+    return false;
+  }
+  return page_space_controller_.ShouldStartConcurrentMarking(
+      used_in_words_, capacity_in_words_);
+}
+
+
+void PageSpace::StartConcurrentMarking() {
+  ASSERT(ConcurrentMarker::IsSupported());
+  ASSERT(concurrent_marker_ == NULL);
+  ASSERT(!sweeping_);
+  FinishSweeping();
+  concurrent_marker_ = new ConcurrentMarker(Isolate::Current(), heap_);
+  concurrent_marker_->Start();
+}
+
+
 PageSpaceController::PageSpaceController(int heap_growth_ratio,
                                          int heap_growth_rate,
                                          int garbage_collection_time_ratio)
     : is_enabled_(false),
       grow_heap_(heap_growth_rate),
       heap_growth_ratio_(heap_growth_ratio),
+      min_heap_growth_ratio_(heap_growth_ratio),
       desired_utilization_((100.0 - heap_growth_ratio) / 100.0),
       heap_growth_rate_(heap_growth_rate),
       garbage_collection_time_ratio_(garbage_collection_time_ratio),
@@ -546,6 +1007,20 @@ bool PageSpaceController::CanGrowPageSpace(intptr_t size_in_bytes) {
 }
 
 
+bool PageSpaceController::ShouldStartConcurrentMarking(
+    intptr_t used_in_words, intptr_t capacity_in_words) const {
+  if (!is_enabled_ || (heap_growth_ratio_ == 100)) {
+    return false;
+  }
+  intptr_t grow_heap = (grow_heap_ > 0) ? grow_heap_ : 0;
+  intptr_t limit_in_words =
+      capacity_in_words + (grow_heap * PageSpace::kPageSizeInWords);
+  return (static_cast<int64_t>(used_in_words) * 100) >=
+         (static_cast<int64_t>(limit_in_words) *
+          FLAG_concurrent_mark_threshold);
+}
+
+
 void PageSpaceController::EvaluateGarbageCollection(
     intptr_t used_before_in_words, intptr_t used_after_in_words,
     int64_t start, int64_t end) {
@@ -561,6 +1036,9 @@ void PageSpaceController::EvaluateGarbageCollection(
       (collected_garbage_ratio >= heap_growth_ratio_);
   int garbage_collection_time_fraction =
       history_.GarbageCollectionTimeFraction();
+  if (FLAG_adaptive_heap_sizing) {
+    AdaptHeapGrowthRatio(garbage_collection_time_fraction);
+  }
   bool enough_free_time =
       (garbage_collection_time_fraction <= garbage_collection_time_ratio_);
 
@@ -585,6 +1063,98 @@ void PageSpaceController::EvaluateGarbageCollection(
 }
 
 
+void PageSpaceController::AdaptHeapGrowthRatio(
+    int garbage_collection_time_fraction) {
+  if (heap_growth_ratio_ == 100) {
+    // The heap grows without limit.
+    return;
+  }
+  // Trade space for time while collections take too large a share of the run
+  // time, and give the space back once they take less than half of it.
+  if (garbage_collection_time_fraction > garbage_collection_time_ratio_) {
+    heap_growth_ratio_ = Utils::Minimum(
+        heap_growth_ratio_ + kHeapGrowthRatioStep,
+        Utils::Maximum(kMaxHeapGrowthRatio, min_heap_growth_ratio_));
+  } else if ((2 * garbage_collection_time_fraction) <
+             garbage_collection_time_ratio_) {
+    heap_growth_ratio_ = Utils::Maximum(
+        heap_growth_ratio_ - kHeapGrowthRatioStep,
+        min_heap_growth_ratio_);
+  }
+  desired_utilization_ = (100.0 - heap_growth_ratio_) / 100.0;
+}
+
+
+PageCache::PageCache()
+    : entries_(NULL),
+      capacity_(Utils::Maximum(FLAG_page_cache_size, 0)),
+      length_(0) {
+  if (capacity_ > 0) {
+    entries_ = new Entry[capacity_];
+  }
+}
+
+
+PageCache::~PageCache() {
+  for (intptr_t i = 0; i < length_; i++) {
+    delete entries_[i].memory;
+  }
+  delete[] entries_;
+}
+
+
+VirtualMemory* PageCache::Take(HeapPage::PageType type) {
+  for (intptr_t i = length_ - 1; i >= 0; i--) {
+    if (entries_[i].type == type) {
+      VirtualMemory* memory = entries_[i].memory;
+      for (intptr_t j = i + 1; j < length_; j++) {
+        entries_[j - 1] = entries_[j];
+      }
+      length_--;
+      return memory;
+    }
+  }
+  return NULL;
+}
+
+
+bool PageCache::Add(VirtualMemory* memory,
+                    HeapPage::PageType type,
+                    int64_t now) {
+  if (length_ == capacity_) {
+    return false;
+  }
+  Entry* entry = &entries_[length_++];
+  entry->memory = memory;
+  entry->type = type;
+  entry->cached_at = now;
+  entry->is_discarded = false;
+  return true;
+}
+
+
+void PageCache::Trim(int64_t now) {
+  for (intptr_t i = 0; i < length_; i++) {
+    Entry* entry = &entries_[i];
+    if (!entry->is_discarded &&
+        ((now - entry->cached_at) >= FLAG_page_cache_delay)) {
+      entry->is_discarded = entry->memory->Discard();
+    }
+  }
+}
+
+
+intptr_t PageCache::resident_length() const {
+  intptr_t result = 0;
+  for (intptr_t i = 0; i < length_; i++) {
+    if (!entries_[i].is_discarded) {
+      result++;
+    }
+  }
+  return result;
+}
+
+
 PageSpaceGarbageCollectionHistory::PageSpaceGarbageCollectionHistory()
     : index_(0) {
   for (intptr_t i = 0; i < kHistoryLength; i++) {
@@ -14,8 +14,16 @@ namespace dart {
 DECLARE_FLAG(bool, collect_code);
 DECLARE_FLAG(bool, log_code_drop);
 DECLARE_FLAG(bool, always_drop_code);
+DECLARE_FLAG(bool, lazy_sweep);
+DECLARE_FLAG(bool, adaptive_heap_sizing);
+DECLARE_FLAG(int, gc_pause_target);
+DECLARE_FLAG(int, gc_time_target);
+DECLARE_FLAG(int, page_cache_size);
+DECLARE_FLAG(int, page_cache_delay);
 
 // Forward declarations.
+class ConcurrentMarker;
+class ConcurrentSweeper;
 class Heap;
 class ObjectPointerVisitor;
 
@@ -28,6 +36,15 @@ class HeapPage {
     kNumPageTypes
   };
 
+  // With --lazy_sweep a mark-sweep leaves the regular pages unswept. Only the
+  // marked objects of an unswept page are live. A page found empty by a lazy
+  // sweep is skipped until it is freed once sweeping has finished.
+  enum SweepState {
+    kSwept = 0,
+    kUnswept,
+    kSweptEmpty
+  };
+
   HeapPage* next() const { return next_; }
   void set_next(HeapPage* next) { next_ = next; }
 
@@ -46,8 +63,13 @@ class HeapPage {
     return executable_ ? kExecutable : kData;
   }
 
+  SweepState sweep_state() const { return sweep_state_; }
+  bool is_swept() const { return sweep_state_ != kUnswept; }
+
   void VisitObjects(ObjectVisitor* visitor) const;
   void VisitObjectPointers(ObjectPointerVisitor* visitor) const;
+  // Visits the dirty cards of the large pages. Used by the scavenger.
+  void VisitRememberedCards(ObjectPointerVisitor* visitor) const;
 
   RawObject* FindObject(FindObjectVisitor* visitor) const;
 
@@ -57,12 +79,38 @@ class HeapPage {
     return Utils::RoundUp(sizeof(HeapPage), OS::kMaxPreferredCodeAlignment);
   }
 
+  // A large data page keeps a card table with one byte per card of
+  // kCardSize bytes. The write barrier dirties the card of a slot of a card
+  // remembered array into which it stores a new object, and a scavenge only
+  // scans the slots of the dirty cards.
+  static const intptr_t kCardSizeLog2 = 9;
+  static const intptr_t kCardSize = 1 << kCardSizeLog2;
+
+  static void RememberCard(RawObject* raw_obj, RawObject** slot) {
+    ASSERT(raw_obj->IsOldObject() && raw_obj->IsCardRemembered());
+    // A card remembered array is the only object of its large page.
+    uword page = RawObject::ToAddr(raw_obj) - ObjectStartOffset();
+    uint8_t* card_table = reinterpret_cast<HeapPage*>(page)->card_table_;
+    ASSERT(card_table != NULL);
+    card_table[(reinterpret_cast<uword>(slot) - page) >> kCardSizeLog2] = 1;
+  }
+
+  // Clears the dirty cards and visits the slots they cover. Cards still
+  // holding pointers into new space afterwards are dirtied again.
+  void VisitRememberedCards(ObjectPointerVisitor* visitor);
+
+  static intptr_t card_table_offset() {
+    return OFFSET_OF(HeapPage, card_table_);
+  }
+
  private:
   void set_object_end(uword val) {
     ASSERT((val & kObjectAlignmentMask) == kOldObjectAlignmentOffset);
     object_end_ = val;
   }
 
+  void set_sweep_state(SweepState state) { sweep_state_ = state; }
+
   static HeapPage* Initialize(VirtualMemory* memory, PageType type);
   static HeapPage* Allocate(intptr_t size_in_words, PageType type);
 
@@ -70,10 +118,16 @@ class HeapPage {
   // page becomes immediately inaccessible.
   void Deallocate();
 
+  intptr_t card_table_size() const {
+    return (memory_->size() + kCardSize - 1) >> kCardSizeLog2;
+  }
+
   VirtualMemory* memory_;
   HeapPage* next_;
   uword object_end_;
+  uint8_t* card_table_;
   bool executable_;
+  SweepState sweep_state_;
 
   friend class PageSpace;
 
@@ -82,6 +136,46 @@ class HeapPage {
 };
 
 
+// The page cache keeps a bounded number of the regular pages freed by a page
+// space, so that new pages can reuse their mapping instead of mapping fresh
+// memory. The memory of a page which stays cached for longer than
+// --page_cache_delay milliseconds is discarded, giving its physical memory
+// back to the OS while keeping it mapped.
+class PageCache {
+ public:
+  PageCache();
+  ~PageCache();
+
+  // Returns the memory of a cached page of the given type, preferring the
+  // most recently cached one, or NULL if there is none.
+  VirtualMemory* Take(HeapPage::PageType type);
+
+  // Returns false if the cache is full.
+  bool Add(VirtualMemory* memory, HeapPage::PageType type, int64_t now);
+
+  // Discards the memory of the pages cached before 'now' minus the delay.
+  void Trim(int64_t now);
+
+  intptr_t length() const { return length_; }
+  // The number of cached pages whose memory has not been discarded.
+  intptr_t resident_length() const;
+
+ private:
+  struct Entry {
+    VirtualMemory* memory;
+    HeapPage::PageType type;
+    int64_t cached_at;
+    bool is_discarded;
+  };
+
+  Entry* entries_;
+  intptr_t capacity_;
+  intptr_t length_;
+
+  DISALLOW_COPY_AND_ASSIGN(PageCache);
+};
+
+
 // The history holds the timing information of the last garbage collection
 // runs.
 class PageSpaceGarbageCollectionHistory {
@@ -107,7 +201,9 @@ class PageSpaceGarbageCollectionHistory {
 // If GC is able to reclaim more than heap_growth_ratio (in percent) memory
 // and if the relative GC time is below a given threshold,
 // then the heap is not grown when the next GC decision is made.
-// PageSpaceController controls the heap size.
+// PageSpaceController controls the heap size. With --adaptive_heap_sizing the
+// heap_growth_ratio is raised while the relative GC time exceeds
+// --gc_time_target and lowered again once it is well below.
 class PageSpaceController {
  public:
   PageSpaceController(int heap_growth_ratio,
@@ -117,6 +213,12 @@ class PageSpaceController {
 
   bool CanGrowPageSpace(intptr_t size_in_bytes);
 
+  // Concurrent marking is started once the page space has used up
+  // --concurrent_mark_threshold percent of what it may grow to before the
+  // next collection.
+  bool ShouldStartConcurrentMarking(intptr_t used_in_words,
+                                    intptr_t capacity_in_words) const;
+
   // A garbage collection is considered as successful if more than
   // heap_growth_ratio % of memory got deallocated by the garbage collector.
   // In this case garbage collection will be performed next time. Otherwise
@@ -125,6 +227,8 @@ class PageSpaceController {
                                  intptr_t used_after_in_words,
                                  int64_t start, int64_t end);
 
+  int heap_growth_ratio() const { return heap_growth_ratio_; }
+
   int64_t last_code_collection_in_us() { return last_code_collection_in_us_; }
   void set_last_code_collection_in_us(int64_t t) {
     last_code_collection_in_us_ = t;
@@ -138,6 +242,13 @@ class PageSpaceController {
   }
 
  private:
+  // The step by which --adaptive_heap_sizing changes heap_growth_ratio_, and
+  // the ratio it stops at.
+  static const int kHeapGrowthRatioStep = 10;
+  static const int kMaxHeapGrowthRatio = 90;
+
+  void AdaptHeapGrowthRatio(int garbage_collection_time_fraction);
+
   bool is_enabled_;
 
   // Heap growth control variable.
@@ -147,6 +258,10 @@ class PageSpaceController {
   // memory, then the heap is grown. Otherwise garbage collection is performed.
   int heap_growth_ratio_;
 
+  // The heap_growth_ratio_ the controller was created with, below which
+  // --adaptive_heap_sizing does not lower it.
+  int min_heap_growth_ratio_;
+
   // The desired percent of heap in-use after a garbage collection.
   // Equivalent to \frac{100-heap_growth_ratio_}{100}.
   double desired_utilization_;
@@ -172,6 +287,8 @@ class PageSpace {
  public:
   // TODO(iposva): Determine heap sizes and tune the page size accordingly.
   static const intptr_t kPageSizeInWords = 256 * KBInWords;
+  // Objects of at least this size get a large page of their own.
+  static const intptr_t kAllocatablePageSize = 64 * KB;
 
   enum GrowthPolicy {
     kControlGrowth,
@@ -188,6 +305,35 @@ class PageSpace {
   intptr_t UsedInWords() const { return used_in_words_; }
   intptr_t CapacityInWords() const { return capacity_in_words_; }
 
+  // The memory of the freed pages kept for reuse, and the part of it which
+  // has not been given back to the OS yet.
+  intptr_t CachedInWords() const {
+    return page_cache_.length() * kPageSizeInWords;
+  }
+  intptr_t ResidentCachedInWords() const {
+    return page_cache_.resident_length() * kPageSizeInWords;
+  }
+  // The memory resident for this page space: its capacity and the cached
+  // pages which have not been discarded yet.
+  intptr_t ResidentInWords() const {
+    return capacity_in_words_ + ResidentCachedInWords();
+  }
+  // The number of pages mapped and unmapped by this page space, and of the
+  // pages reused from the page cache instead of being mapped.
+  intptr_t mapped_pages() const { return mapped_pages_; }
+  intptr_t unmapped_pages() const { return unmapped_pages_; }
+  intptr_t reused_pages() const { return reused_pages_; }
+
+  // Gives the memory of the pages idle in the page cache for longer than
+  // --page_cache_delay back to the OS.
+  void TrimPageCache();
+
+  // Accessors for inlined allocation in generated code. Objects are bump
+  // allocated in an area taken from the free list of the page type, which
+  // counts as used until it is retired. An empty area has top == end.
+  uword* TopAddress(HeapPage::PageType type) { return &bump_top_[type]; }
+  uword* EndAddress(HeapPage::PageType type) { return &bump_end_[type]; }
+
   bool Contains(uword addr) const;
   bool Contains(uword addr, HeapPage::PageType type) const;
   bool IsValidAddress(uword addr) const {
@@ -196,6 +342,8 @@ class PageSpace {
 
   void VisitObjects(ObjectVisitor* visitor) const;
   void VisitObjectPointers(ObjectPointerVisitor* visitor) const;
+  // Visits the dirty cards of the large pages. Used by the scavenger.
+  void VisitRememberedCards(ObjectPointerVisitor* visitor) const;
 
   RawObject* FindObject(FindObjectVisitor* visitor,
                         HeapPage::PageType type) const;
@@ -204,9 +352,27 @@ class PageSpace {
   // code.
   bool ShouldCollectCode();
 
-  // Collect the garbage in the page space using mark-sweep.
+  // Collect the garbage in the page space using mark-sweep. Finishes the
+  // concurrent marking if it is in progress, and the lazy sweeping of the
+  // previous collection.
   void MarkSweep(bool invoke_api_callbacks);
 
+  // Sweeps the pages left unswept by the last mark-sweep, waiting for the
+  // concurrent sweeper if needed, and frees the pages found empty.
+  void FinishSweeping();
+  // Finishes the lazy sweeping if no page is left to sweep.
+  void TryFinishSweeping();
+  bool IsSweeping() const { return lazy_sweeping_; }
+  ConcurrentSweeper* concurrent_sweeper() const { return concurrent_sweeper_; }
+
+  // Checks that only unswept pages contain marked objects, which does not
+  // hold while marking. Returns the number of unswept pages.
+  intptr_t VerifySweepState() const;
+
+  bool ShouldStartConcurrentMarking() const;
+  void StartConcurrentMarking();
+  ConcurrentMarker* concurrent_marker() const { return concurrent_marker_; }
+
   void StartEndAddress(uword* start, uword* end) const;
 
   void SetGrowthControlState(bool state) {
@@ -234,14 +400,45 @@ class PageSpace {
     kAllowedGrowth = 3
   };
 
-  static const intptr_t kAllocatablePageSize = 64 * KB;
+  // Larger objects are allocated from the free list directly instead of
+  // retiring a bump allocation area they do not fit in.
+  static const intptr_t kMaxBumpAllocationSize = 4 * KB;
 
   HeapPage* AllocatePage(HeapPage::PageType type);
+  // Appends a page to the list of regular pages.
+  void AddPage(HeapPage* page);
+  // Releases a page which is not in any page list.
+  void ReleasePage(HeapPage* page);
   void FreePage(HeapPage* page, HeapPage* previous_page);
   HeapPage* AllocateLargePage(intptr_t size, HeapPage::PageType type);
   void FreeLargePage(HeapPage* page, HeapPage* previous_page);
   void FreePages(HeapPage* pages);
 
+  // Lazy sweeping. NextUnsweptPage and SetSwept are called with the monitor of
+  // the concurrent sweeper held, if there is one.
+  HeapPage* NextUnsweptPage();
+  void SetSwept(HeapPage* page, intptr_t in_use);
+  bool SweepNextPage();
+  uword TryAllocateSweeping(intptr_t size, HeapPage::PageType type);
+
+  // Bump allocation.
+  uword TryBumpAllocate(intptr_t size, HeapPage::PageType type) {
+    uword top = bump_top_[type];
+    if ((bump_end_[type] - top) < static_cast<uword>(size)) {
+      return 0;
+    }
+    bump_top_[type] = top + size;
+    return top;
+  }
+  void SetBumpArea(uword start, intptr_t size, HeapPage::PageType type);
+  // Returns the unused rest of the bump allocation area to the free list.
+  void RetireBumpArea(HeapPage::PageType type);
+  // Takes a new bump allocation area from the free list.
+  bool RefillBumpArea(HeapPage::PageType type);
+  // Turns the unused rest of the bump allocation areas into free list
+  // elements so that the pages can be walked.
+  void MakeIterable() const;
+
   static intptr_t LargePageSizeInWordsFor(intptr_t size);
 
   bool CanIncreaseCapacityInWords(intptr_t increase_in_words) {
@@ -251,6 +448,10 @@ class PageSpace {
 
   FreeList freelist_[HeapPage::kNumPageTypes];
 
+  // The bump allocation area of each page type.
+  uword bump_top_[HeapPage::kNumPageTypes];
+  uword bump_end_[HeapPage::kNumPageTypes];
+
   Heap* heap_;
 
   HeapPage* pages_;
@@ -262,11 +463,31 @@ class PageSpace {
   intptr_t capacity_in_words_;
   intptr_t used_in_words_;
 
+  PageCache page_cache_;
+  intptr_t mapped_pages_;
+  intptr_t unmapped_pages_;
+  intptr_t reused_pages_;
+
   // Keep track whether a MarkSweep is currently running.
   bool sweeping_;
 
+  // The marker of a concurrent marking cycle in progress, or NULL.
+  ConcurrentMarker* concurrent_marker_;
+
+  // Keep track whether pages are left unswept by the last MarkSweep. The pages
+  // from next_unswept_page_ to last_unswept_page_ have not been claimed by a
+  // sweeper yet.
+  bool lazy_sweeping_;
+  HeapPage* next_unswept_page_;
+  HeapPage* last_unswept_page_;
+  intptr_t pages_swept_on_demand_;
+  ConcurrentSweeper* concurrent_sweeper_;
+
   PageSpaceController page_space_controller_;
 
+  friend class ConcurrentSweeper;
+  friend class GCCompactor;
+  friend class HeapImage;
   friend class PageSpaceController;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(PageSpace);
@@ -5,6 +5,7 @@
 #include "platform/assert.h"
 #include "vm/pages.h"
 #include "vm/unit_test.h"
+#include "vm/virtual_memory.h"
 
 namespace dart {
 
@@ -31,4 +32,66 @@ TEST_CASE(Pages) {
   delete space;
 }
 
+
+TEST_CASE(AdaptiveHeapGrowth) {
+  const int kHeapGrowthRatio = 10;
+  bool saved_adaptive_heap_sizing = FLAG_adaptive_heap_sizing;
+  FLAG_adaptive_heap_sizing = true;
+  PageSpaceController controller(kHeapGrowthRatio, 4, 5);
+  controller.set_is_enabled(true);
+  // Collections taking half of the run time raise the growth ratio up to its
+  // maximum.
+  int64_t time = 1000;
+  for (intptr_t i = 0; i < 10; i++) {
+    controller.EvaluateGarbageCollection(100, 50, time, time + 500);
+    time += 1000;
+  }
+  EXPECT_EQ(90, controller.heap_growth_ratio());
+  // Short collections lower it back to the initial ratio.
+  for (intptr_t i = 0; i < 10; i++) {
+    controller.EvaluateGarbageCollection(100, 50, time, time + 1);
+    time += 1000;
+  }
+  EXPECT_EQ(kHeapGrowthRatio, controller.heap_growth_ratio());
+  FLAG_adaptive_heap_sizing = saved_adaptive_heap_sizing;
+}
+
+
+TEST_CASE(PageCache) {
+  const intptr_t kPageSize = PageSpace::kPageSizeInWords << kWordSizeLog2;
+  intptr_t saved_page_cache_size = FLAG_page_cache_size;
+  intptr_t saved_page_cache_delay = FLAG_page_cache_delay;
+  FLAG_page_cache_size = 2;
+  FLAG_page_cache_delay = 1000;
+  PageCache* cache = new PageCache();
+  VirtualMemory* memory[3];
+  for (intptr_t i = 0; i < 3; i++) {
+    memory[i] = VirtualMemory::Reserve(kPageSize);
+    memory[i]->Commit(false);
+  }
+  EXPECT(cache->Add(memory[0], HeapPage::kData, 0));
+  EXPECT(cache->Add(memory[1], HeapPage::kExecutable, 0));
+  EXPECT(!cache->Add(memory[2], HeapPage::kData, 0));
+  delete memory[2];
+  EXPECT_EQ(2, cache->resident_length());
+  // The memory of the pages is given back once they are idle for the delay.
+  cache->Trim(999);
+  EXPECT_EQ(2, cache->resident_length());
+  cache->Trim(1000);
+  EXPECT_EQ(0, cache->resident_length());
+  EXPECT_EQ(2, cache->length());
+  // Discarded pages stay usable.
+  EXPECT(cache->Take(HeapPage::kData) == memory[0]);
+  EXPECT(cache->Take(HeapPage::kData) == NULL);
+  EXPECT_EQ(1, cache->length());
+  char* buf = reinterpret_cast<char*>(memory[0]->address());
+  buf[kPageSize - 1] = 'a';
+  EXPECT_EQ('a', buf[kPageSize - 1]);
+  delete memory[0];
+  // The cache unmaps the pages it still holds.
+  delete cache;
+  FLAG_page_cache_size = saved_page_cache_size;
+  FLAG_page_cache_delay = saved_page_cache_delay;
+}
+
 }  // namespace dart
@@ -61,28 +61,42 @@ class PortMap: public AllStatic {
     bool live;
   } Entry;
 
+  // The ports are spread over a fixed number of shards by their id, so that
+  // operations on ports of different shards do not contend for a lock. Each
+  // shard is a hashmap of its ports protected by its own lock.
+  static const intptr_t kNumShards = 16;
+
+  typedef struct {
+    Mutex* mutex;
+    Entry* map;
+    intptr_t capacity;
+    intptr_t used;
+    intptr_t deleted;
+  } Shard;
+
+  // The low bits of a port select its shard, the remaining ones its slot.
+  static Shard* ShardFor(Dart_Port port) {
+    return &shards_[port & (kNumShards - 1)];
+  }
+  static intptr_t SlotIndex(Dart_Port port, intptr_t capacity) {
+    return (port / kNumShards) % capacity;
+  }
+
   // Allocate a new unique port.
   static Dart_Port AllocatePort();
 
   static bool IsActivePort(Dart_Port id);
   static bool IsLivePort(Dart_Port id);
 
-  static intptr_t FindPort(Dart_Port port);
-  static void Rehash(intptr_t new_capacity);
-
-  static void MaintainInvariants();
-
-  // Lock protecting access to the port map.
-  static Mutex* mutex_;
+  // The following are called with the lock of the shard held.
+  static intptr_t FindPort(Shard* shard, Dart_Port port);
+  static void Rehash(Shard* shard, intptr_t new_capacity);
+  static void MaintainInvariants(Shard* shard);
 
-  // Hashmap of ports.
-  static Entry* map_;
+  static Shard* shards_;
   static MessageHandler* deleted_entry_;
-  static intptr_t capacity_;
-  static intptr_t used_;
-  static intptr_t deleted_;
 
-  static Dart_Port next_port_;
+  static uintptr_t next_port_;
 };
 
 }  // namespace dart
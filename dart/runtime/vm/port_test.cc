@@ -3,9 +3,11 @@
 // BSD-style license that can be found in the LICENSE file.
 
 #include "platform/assert.h"
+#include "vm/benchmark_test.h"
 #include "vm/message_handler.h"
 #include "vm/os.h"
 #include "vm/port.h"
+#include "vm/thread.h"
 #include "vm/unit_test.h"
 
 namespace dart {
@@ -14,17 +16,19 @@ namespace dart {
 class PortMapTestPeer {
  public:
   static bool IsActivePort(Dart_Port port) {
-    MutexLocker ml(PortMap::mutex_);
-    return (PortMap::FindPort(port) >= 0);
+    PortMap::Shard* shard = PortMap::ShardFor(port);
+    MutexLocker ml(shard->mutex);
+    return (PortMap::FindPort(shard, port) >= 0);
   }
 
   static bool IsLivePort(Dart_Port port) {
-    MutexLocker ml(PortMap::mutex_);
-    intptr_t index = PortMap::FindPort(port);
+    PortMap::Shard* shard = PortMap::ShardFor(port);
+    MutexLocker ml(shard->mutex);
+    intptr_t index = PortMap::FindPort(shard, port);
     if (index < 0) {
       return false;
     }
-    return PortMap::map_[index].live;
+    return shard->map[index].live;
   }
 };
 
@@ -143,4 +147,64 @@ TEST_CASE(PortMap_PostMessageInvalidPort) {
       Message::kNormalPriority)));
 }
 
+
+struct PostMessagesInfo {
+  Dart_Port port;
+  intptr_t count;
+  Monitor* monitor;
+  intptr_t* pending;
+};
+
+
+static void PostMessages(uword parameter) {
+  PostMessagesInfo* info = reinterpret_cast<PostMessagesInfo*>(parameter);
+  for (intptr_t i = 0; i < info->count; i++) {
+    PortMap::PostMessage(
+        new Message(info->port, 0, NULL, 0, Message::kNormalPriority));
+  }
+  MonitorLocker ml(info->monitor);
+  (*info->pending)--;
+  ml.Notify();
+}
+
+
+//
+// Measure the time taken by several threads each posting messages to a port
+// of its own.
+//
+BENCHMARK(PortMapPostMessage) {
+  const intptr_t kMessages = 50000;
+  const intptr_t kThreads = 4;
+  PortTestMessageHandler handlers[kThreads];
+  PostMessagesInfo infos[kThreads];
+  Monitor monitor;
+  intptr_t pending = kThreads;
+  for (intptr_t i = 0; i < kThreads; i++) {
+    infos[i].port = PortMap::CreatePort(&handlers[i]);
+    infos[i].count = kMessages;
+    infos[i].monitor = &monitor;
+    infos[i].pending = &pending;
+  }
+  Timer timer(true, "PortMap post message benchmark");
+  timer.Start();
+  for (intptr_t i = 0; i < kThreads; i++) {
+    int result = Thread::Start(PostMessages,
+                               reinterpret_cast<uword>(&infos[i]));
+    EXPECT_EQ(0, result);
+  }
+  {
+    MonitorLocker ml(&monitor);
+    while (pending > 0) {
+      ml.Wait();
+    }
+  }
+  timer.Stop();
+  for (intptr_t i = 0; i < kThreads; i++) {
+    EXPECT_EQ(kMessages, handlers[i].notify_count);
+    // Drops the queued messages.
+    PortMap::ClosePorts(&handlers[i]);
+  }
+  benchmark->set_score(timer.TotalElapsedTime());
+}
+
 }  // namespace dart
@@ -6,6 +6,7 @@
 #define VM_RAW_OBJECT_H_
 
 #include "platform/assert.h"
+#include "vm/atomic.h"
 #include "vm/globals.h"
 #include "vm/token.h"
 #include "vm/snapshot.h"
@@ -112,6 +113,7 @@ namespace dart {
 
 
 // Forward declarations.
+class FinalizablePersistentHandle;
 class Isolate;
 #define DEFINE_FORWARD_DECLARATION(clazz)                                      \
   class Raw##clazz;
@@ -228,8 +230,9 @@ class RawObject {
     kCanonicalBit = 2,
     kFromSnapshotBit = 3,
     kRememberedBit = 4,
-    kReservedTagBit = 5,  // kReservedBit{10K,100K,1M,10M}
-    kReservedTagSize = 3,
+    kCardRememberedBit = 5,
+    kReservedTagBit = 6,  // kReservedBit{1M,10M}
+    kReservedTagSize = 2,
     kSizeTagBit = 8,
     kSizeTagSize = 8,
     kClassIdTagBit = kSizeTagBit + kSizeTagSize,
@@ -302,6 +305,27 @@ class RawObject {
     uword tags = ptr()->tags_;
     ptr()->tags_ = MarkBit::update(false, tags);
   }
+  // Used by the concurrent and parallel markers, which race with the mutator
+  // or with each other updating tag bits. Returns false if the object was already marked.
+  bool TryAcquireMarkBit() {
+    uword tags = ptr()->tags_;
+    uword old_tags;
+    do {
+      if (MarkBit::decode(tags)) {
+        return false;
+      }
+      old_tags = tags;
+      tags = AtomicOperations::CompareAndSwapWord(
+          &ptr()->tags_, old_tags, MarkBit::update(true, old_tags));
+    } while (tags != old_tags);
+    return true;
+  }
+  // Used by the lazy sweeper, which may run on a background task while the
+  // mutator updates other tag bits.
+  void AtomicClearMarkBit() {
+    ASSERT(IsMarked());
+    UpdateTagBit<MarkBit>(false);
+  }
 
   // Support for GC watched bit.
   bool IsWatched() const {
@@ -323,29 +347,35 @@ class RawObject {
     return CanonicalObjectTag::decode(ptr()->tags_);
   }
   void SetCanonical() {
-    uword tags = ptr()->tags_;
-    ptr()->tags_ = CanonicalObjectTag::update(true, tags);
+    UpdateTagBit<CanonicalObjectTag>(true);
   }
   bool IsCreatedFromSnapshot() const {
     return CreatedFromSnapshotTag::decode(ptr()->tags_);
   }
   void SetCreatedFromSnapshot() {
-    uword tags = ptr()->tags_;
-    ptr()->tags_ = CreatedFromSnapshotTag::update(true, tags);
+    UpdateTagBit<CreatedFromSnapshotTag>(true);
   }
 
   // Support for GC remembered bit.
   bool IsRemembered() const {
     return RememberedBit::decode(ptr()->tags_);
   }
+  // The remembered bit is updated atomically, as the lazy sweeper may be
+  // clearing the mark bit of the same object.
   void SetRememberedBit() {
     ASSERT(!IsRemembered());
-    uword tags = ptr()->tags_;
-    ptr()->tags_ = RememberedBit::update(true, tags);
+    UpdateTagBit<RememberedBit>(true);
   }
   void ClearRememberedBit() {
-    uword tags = ptr()->tags_;
-    ptr()->tags_ = RememberedBit::update(false, tags);
+    UpdateTagBit<RememberedBit>(false);
+  }
+
+  // Support for the card remembered bit. Stores of new objects into a large
+  // pointer array with this bit set dirty a card of its large page instead of
+  // remembering the whole array, so that a scavenge only scans the dirty
+  // cards. The bit is set when the array is initialized and never changes.
+  bool IsCardRemembered() const {
+    return CardRememberedBit::decode(ptr()->tags_);
   }
 
   bool IsDartInstance() {
@@ -414,6 +444,8 @@ class RawObject {
 
   class RememberedBit : public BitField<bool, kRememberedBit, 1> {};
 
+  class CardRememberedBit : public BitField<bool, kCardRememberedBit, 1> {};
+
   class CanonicalObjectTag : public BitField<bool, kCanonicalBit, 1> {};
 
   class CreatedFromSnapshotTag : public BitField<bool, kFromSnapshotBit, 1> {};
@@ -430,6 +462,20 @@ class RawObject {
 
   intptr_t SizeFromClass() const;
 
+  // Tag bits set by the mutator are updated atomically so that they cannot
+  // drop the mark bit set by a concurrent marker or cleared by a concurrent
+  // sweeper at the same time.
+  template<class TagBitField>
+  void UpdateTagBit(bool value) {
+    uword tags = ptr()->tags_;
+    uword old_tags;
+    do {
+      old_tags = tags;
+      tags = AtomicOperations::CompareAndSwapWord(
+          &ptr()->tags_, old_tags, TagBitField::update(value, old_tags));
+    } while (tags != old_tags);
+  }
+
   intptr_t GetClassId() const {
     uword tags = ptr()->tags_;
     return ClassIdTag::decode(tags);
@@ -437,15 +483,20 @@ class RawObject {
 
   friend class Api;
   friend class Array;
+  friend class ConcurrentMarker;
+  friend class ConcurrentMarkingVisitor;
   friend class FreeListElement;
   friend class GCMarker;
   friend class ExternalTypedData;
   friend class Heap;
+  friend class HeapImage;
   friend class HeapProfiler;
   friend class HeapProfilerRootVisitor;
   friend class MarkingVisitor;
   friend class Object;
   friend class ObjectHistogram;
+  friend class ParallelMarkingVisitor;
+  friend class ParallelScavengerVisitor;
   friend class RawExternalTypedData;
   friend class RawInstructions;
   friend class RawInstance;
@@ -454,6 +505,7 @@ class RawObject {
   friend class SnapshotReader;
   friend class SnapshotWriter;
   friend class String;
+  friend class Symbols;
   friend class TypedData;
   friend class TypedDataView;
 
@@ -612,6 +664,7 @@ class RawFunction : public RawObject {
  private:
   // So that the MarkingVisitor::DetachCode can null out the code fields.
   friend class MarkingVisitor;
+  friend class ParallelMarkingVisitor;
   friend class Class;
   RAW_HEAP_OBJECT_IMPLEMENTATION(Function);
   static bool SkipCode(RawFunction* raw_fun);
@@ -639,7 +692,7 @@ class RawFunction : public RawObject {
   int16_t num_fixed_parameters_;
   int16_t num_optional_parameters_;  // > 0: positional; < 0: named.
   int16_t deoptimization_counter_;
-  uint16_t kind_tag_;  // See Function::KindTagBits.
+  uint32_t kind_tag_;  // See Function::KindTagBits.
   uint16_t optimized_instruction_count_;
   uint16_t optimized_call_site_count_;
 };
@@ -795,6 +848,7 @@ class RawLibrary : public RawObject {
   bool debuggable_;              // True if debugger can stop in library.
   int8_t load_state_;            // Of type LibraryState.
 
+  friend class HeapImage;
   friend class Isolate;
 };
 
@@ -1300,6 +1354,7 @@ class RawOneByteString : public RawString {
 
   friend class ApiMessageReader;
   friend class SnapshotReader;
+  friend class Symbols;
 };
 
 
@@ -1475,7 +1530,11 @@ class RawExternalTypedData : public RawInstance {
 
   uint8_t* data_;
   void* peer_;
+  // The finalizer owning the data of a transferable object, NULL otherwise.
+  FinalizablePersistentHandle* transfer_handle_;
 
+  friend class HeapImage;
+  friend class Object;
   friend class TokenStream;
   friend class RawTokenStream;
 };
@@ -1539,6 +1598,8 @@ class RawWeakProperty : public RawInstance {
 
   friend class GCMarker;
   friend class MarkingVisitor;
+  friend class ParallelMarkingVisitor;
+  friend class ParallelScavengerVisitor;
   friend class Scavenger;
   friend class ScavengerVisitor;
 };
@@ -3,6 +3,7 @@
 // BSD-style license that can be found in the LICENSE file.
 
 #include "vm/bigint_operations.h"
+#include "vm/dart_api_state.h"
 #include "vm/object.h"
 #include "vm/object_store.h"
 #include "vm/snapshot.h"
@@ -11,6 +12,8 @@
 
 namespace dart {
 
+DECLARE_FLAG(bool, share_snapshot_symbols);
+
 DECLARE_FLAG(bool, error_on_bad_type);
 
 
@@ -804,7 +807,9 @@ void RawFunction::WriteTo(SnapshotWriter* writer,
   writer->WriteIntptrValue(ptr()->num_fixed_parameters_);
   writer->WriteIntptrValue(ptr()->num_optional_parameters_);
   writer->WriteIntptrValue(ptr()->deoptimization_counter_);
-  writer->Write<uint16_t>(ptr()->kind_tag_);
+  // Only the low 16 bits are written, leaving out the transient
+  // OptimizationQueuedBit.
+  writer->Write<uint16_t>(static_cast<uint16_t>(ptr()->kind_tag_));
   writer->Write<uint16_t>(ptr()->optimized_instruction_count_);
   writer->Write<uint16_t>(ptr()->optimized_call_site_count_);
 
@@ -1897,6 +1902,20 @@ RawOneByteString* OneByteString::ReadFrom(SnapshotReader* reader,
 
   if (kind == Snapshot::kFull) {
     ASSERT(reader->isolate()->no_gc_scope_depth() != 0);
+    if (FLAG_share_snapshot_symbols && RawObject::IsCanonical(tags)) {
+      // Refer to the copy of the symbol shared by the isolates created from
+      // this snapshot.
+      const uint8_t* characters = reader->CurrentBufferAddress();
+      if (hash == 0) {
+        hash = String::Hash(characters, len);
+      }
+      str_obj = Symbols::LookupOrAddShared(characters, len, hash);
+      if (!str_obj.IsNull()) {
+        reader->Advance(len);
+        reader->AddBackRef(object_id, &str_obj, kIsDeserialized);
+        return raw(str_obj);
+      }
+    }
     RawOneByteString* obj = reader->NewOneByteString(len);
     str_obj = obj;
     str_obj.set_tags(tags);
@@ -2362,6 +2381,7 @@ RawExternalTypedData* ExternalTypedData::ReadFrom(SnapshotReader* reader,
       reinterpret_cast<Dart_WeakPersistentHandleFinalizer>(
           reader->ReadIntptrValue());
   obj.AddFinalizer(peer, callback);
+  reader->AddTransfer();
   return obj.raw();
 }
 
@@ -2452,6 +2472,20 @@ void RawExternalTypedData::WriteTo(SnapshotWriter* writer,
   // Write out the serialization header value for this object.
   writer->WriteInlinedObjectHeader(object_id);
 
+  FinalizablePersistentHandle* handle = ptr()->transfer_handle_;
+  if (writer->can_transfer() && (handle != NULL)) {
+    // The data is not copied but moves with its finalizer into the message,
+    // see MessageWriter::TransferTo.
+    writer->WriteIndexedObject(cid);
+    writer->WriteIntptrValue(tags);
+    writer->Write<RawObject*>(ptr()->length_);
+    writer->WriteIntptrValue(reinterpret_cast<intptr_t>(ptr()->data_));
+    writer->WriteIntptrValue(reinterpret_cast<intptr_t>(handle->peer()));
+    writer->WriteIntptrValue(reinterpret_cast<intptr_t>(handle->callback()));
+    writer->AddTransfer(this);
+    return;
+  }
+
   switch (cid) {
     case kExternalTypedDataInt8ArrayCid:
       EXT_TYPED_DATA_WRITE(kTypedDataInt8ArrayCid, int8_t);
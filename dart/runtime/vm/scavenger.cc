@@ -8,12 +8,16 @@
 #include <map>
 #include <utility>
 
+#include "vm/atomic.h"
 #include "vm/dart.h"
 #include "vm/dart_api_state.h"
+#include "vm/freelist.h"
+#include "vm/gc_marker.h"
 #include "vm/isolate.h"
 #include "vm/object.h"
 #include "vm/stack_frame.h"
 #include "vm/store_buffer.h"
+#include "vm/thread_pool.h"
 #include "vm/verifier.h"
 #include "vm/visitor.h"
 #include "vm/weak_table.h"
@@ -21,6 +25,10 @@
 
 namespace dart {
 
+DEFINE_FLAG(int, scavenger_tasks, 1,
+            "Number of tasks used to scavenge new space, "
+            "e.g: --scavenger_tasks=4 uses the isolate thread and 3 helpers");
+
 // Scavenger uses RawObject::kMarkBit to distinguish forwaded and non-forwarded
 // objects. The kMarkBit does not intersect with the target address because of
 // object alignment.
@@ -51,6 +59,20 @@ static inline void ForwardTo(uword orignal, uword target) {
 }
 
 
+// During a parallel scavenge a task claims a from space object before copying
+// it by setting RawObject::kRememberedBit in its header. New objects never
+// have this bit set otherwise. Other tasks reaching a claimed object wait
+// until the forwarding address has been installed.
+enum {
+  kClaimedMask = 1 << RawObject::kRememberedBit,
+};
+
+
+static inline bool IsClaimed(uword header) {
+  return (header & kClaimedMask) != 0;
+}
+
+
 class BoolScope : public ValueObject {
  public:
   BoolScope(bool* addr, bool value) : _addr(addr), _value(*addr) {
@@ -119,6 +141,12 @@ class ScavengerVisitor : public ObjectPointerVisitor {
   intptr_t handled_count() const { return handled_count_; }
   intptr_t bytes_promoted() const { return bytes_promoted_; }
 
+  // Promotions after a failed promotion during a parallel scavenge need to
+  // force growth as well.
+  void set_growth_policy(PageSpace::GrowthPolicy policy) {
+    growth_policy_ = policy;
+  }
+
  private:
   void UpdateStoreBuffer(RawObject** p, RawObject* obj) {
     uword ptr = reinterpret_cast<uword>(p);
@@ -127,7 +155,14 @@ class ScavengerVisitor : public ObjectPointerVisitor {
     ASSERT(!heap_->CodeContains(ptr));
     ASSERT(heap_->Contains(ptr));
     // If the newly written object is not a new object, drop it immediately.
-    if (!obj->IsNewObject() || visiting_old_object_->IsRemembered()) {
+    if (!obj->IsNewObject()) {
+      return;
+    }
+    if (visiting_old_object_->IsCardRemembered()) {
+      HeapPage::RememberCard(visiting_old_object_, p);
+      return;
+    }
+    if (visiting_old_object_->IsRemembered()) {
       return;
     }
     visiting_old_object_->SetRememberedBit();
@@ -303,6 +338,610 @@ class VerifyStoreBufferPointerVisitor : public ObjectPointerVisitor {
 };
 
 
+// A fixed size block of objects which still need to be scanned during a
+// parallel scavenge. Blocks are the unit of work shared between tasks. They
+// are also used to collect the per task remembered and delayed objects.
+class ScavengerWorkBlock {
+ public:
+  static const intptr_t kSize = 256;
+
+  ScavengerWorkBlock() : next_(NULL), top_(0) {}
+
+  ScavengerWorkBlock* next() const { return next_; }
+  void set_next(ScavengerWorkBlock* next) { next_ = next; }
+
+  intptr_t Count() const { return top_; }
+  bool IsEmpty() const { return top_ == 0; }
+  bool IsFull() const { return top_ == kSize; }
+
+  void Push(RawObject* raw_obj) {
+    ASSERT(!IsFull());
+    objects_[top_++] = raw_obj;
+  }
+
+  RawObject* Pop() {
+    ASSERT(!IsEmpty());
+    return objects_[--top_];
+  }
+
+  // Pushes raw_obj onto a list of blocks, allocating a new head as needed.
+  static void PushToList(ScavengerWorkBlock** list, RawObject* raw_obj) {
+    ScavengerWorkBlock* block = *list;
+    if ((block == NULL) || block->IsFull()) {
+      block = new ScavengerWorkBlock();
+      block->set_next(*list);
+      *list = block;
+    }
+    block->Push(raw_obj);
+  }
+
+ private:
+  ScavengerWorkBlock* next_;
+  intptr_t top_;
+  RawObject* objects_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(ScavengerWorkBlock);
+};
+
+
+// State shared by all tasks of a parallel scavenge: the remaining store
+// buffer blocks, the published work blocks of each task and the bookkeeping
+// needed to detect termination.
+// Helpers are not guaranteed to be scheduled while the scavenge runs, so only
+// the tasks that have actually started take part in the termination protocol.
+// The state is reference counted as a helper may start after the scavenge has
+// finished without it.
+class ParallelScavengerState {
+ public:
+  ParallelScavengerState(intptr_t num_tasks, StoreBufferBlock* blocks)
+      : num_tasks_(num_tasks),
+        work_(new ScavengerWorkBlock*[num_tasks]),
+        started_tasks_(1),
+        idle_tasks_(0),
+        running_tasks_(0),
+        references_(num_tasks),
+        done_(false),
+        steals_(0),
+        pending_blocks_(blocks),
+        growth_policy_(PageSpace::kControlGrowth) {
+    for (intptr_t i = 0; i < num_tasks_; i++) {
+      work_[i] = NULL;
+    }
+  }
+
+  ~ParallelScavengerState() {
+    ASSERT(running_tasks_ == 0);
+    ASSERT(pending_blocks_ == NULL);
+    for (intptr_t i = 0; i < num_tasks_; i++) {
+      ASSERT(work_[i] == NULL);
+    }
+    delete[] work_;
+  }
+
+  intptr_t steals() const { return steals_; }
+
+  // Store buffer blocks are handed out one at a time to balance the scanning
+  // of the remembered old objects.
+  StoreBufferBlock* TakeStoreBufferBlock() {
+    ScopedMonitor ml(&monitor_);
+    StoreBufferBlock* block = pending_blocks_;
+    if (block != NULL) {
+      pending_blocks_ = block->next();
+    }
+    return block;
+  }
+
+  // Makes a block of work available to all tasks.
+  void PublishWork(intptr_t task_id, ScavengerWorkBlock* block) {
+    ScopedMonitor ml(&monitor_);
+    block->set_next(work_[task_id]);
+    work_[task_id] = block;
+    if (idle_tasks_ > 0) {
+      ml.Notify();
+    }
+  }
+
+  // Returns a block of work, preferring blocks published by the task itself
+  // over stealing from the other tasks. Returns NULL once all tasks are idle
+  // and no more work is available.
+  ScavengerWorkBlock* TakeWork(intptr_t task_id) {
+    ScopedMonitor ml(&monitor_);
+    while (true) {
+      for (intptr_t i = 0; i < num_tasks_; i++) {
+        intptr_t victim = (task_id + i) % num_tasks_;
+        ScavengerWorkBlock* block = work_[victim];
+        if (block != NULL) {
+          work_[victim] = block->next();
+          block->set_next(NULL);
+          if (victim != task_id) {
+            steals_++;
+          }
+          return block;
+        }
+      }
+      if (done_) {
+        return NULL;
+      }
+      idle_tasks_++;
+      if (idle_tasks_ == started_tasks_) {
+        // Every task is out of work, so nobody can produce more.
+        done_ = true;
+        ml.NotifyAll();
+        return NULL;
+      }
+      ml.Wait();
+      idle_tasks_--;
+    }
+  }
+
+  // Racy by design: only used to decide whether to share work early.
+  bool HasIdleTasks() const { return idle_tasks_ > 0; }
+
+  // Called by a helper when it starts running. Returns false if the scavenge
+  // has already finished without the helper, which then must not touch its
+  // visitor.
+  bool TaskStarted() {
+    ScopedMonitor ml(&monitor_);
+    if (done_) {
+      return false;
+    }
+    started_tasks_++;
+    running_tasks_++;
+    return true;
+  }
+
+  void TaskDone() {
+    ScopedMonitor ml(&monitor_);
+    running_tasks_--;
+    ml.NotifyAll();
+  }
+
+  // Waits for the started helpers to finish. No helper can start once the
+  // isolate thread has run out of work.
+  void WaitForTasks() {
+    ScopedMonitor ml(&monitor_);
+    ASSERT(done_);
+    while (running_tasks_ > 0) {
+      ml.Wait();
+    }
+  }
+
+  // Drops a reference held by the isolate thread or a helper. The last one
+  // deletes the state.
+  void Release() {
+    bool is_last;
+    {
+      ScopedMonitor ml(&monitor_);
+      is_last = (--references_ == 0);
+    }
+    if (is_last) {
+      delete this;
+    }
+  }
+
+  // The promotion lock protects old space allocation and the growth policy.
+  Mutex* promotion_mutex() { return &promotion_mutex_; }
+  PageSpace::GrowthPolicy growth_policy() const { return growth_policy_; }
+  void set_growth_policy(PageSpace::GrowthPolicy policy) {
+    growth_policy_ = policy;
+  }
+
+ private:
+  const intptr_t num_tasks_;
+  Monitor monitor_;
+  ScavengerWorkBlock** work_;
+  intptr_t started_tasks_;
+  intptr_t idle_tasks_;
+  intptr_t running_tasks_;
+  intptr_t references_;
+  bool done_;
+  intptr_t steals_;
+  StoreBufferBlock* pending_blocks_;
+
+  Mutex promotion_mutex_;
+  PageSpace::GrowthPolicy growth_policy_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavengerState);
+};
+
+
+// The visitor used by each task of a parallel scavenge. Objects are copied
+// into task local allocation buffers in the to space or in old space, and
+// pushed onto the task's work list to be scanned later. Old objects which
+// still point into new space after being scanned are collected in a task
+// local remembered list and added to the store buffer once all tasks are done.
+class ParallelScavengerVisitor : public ObjectPointerVisitor {
+ public:
+  ParallelScavengerVisitor(Isolate* isolate,
+                           Scavenger* scavenger,
+                           ParallelScavengerState* state,
+                           intptr_t task_id)
+      : ObjectPointerVisitor(isolate),
+        scavenger_(scavenger),
+        heap_(scavenger->heap_),
+        state_(state),
+        task_id_(task_id),
+        work_(new ScavengerWorkBlock()),
+        remembered_(NULL),
+        promoted_(NULL),
+        delayed_weak_(NULL),
+        new_top_(0),
+        new_end_(0),
+        promoted_top_(0),
+        promoted_end_(0),
+        visited_count_(0),
+        handled_count_(0),
+        store_buffer_visited_count_(0),
+        store_buffer_handled_count_(0),
+        bytes_promoted_(0),
+        visiting_old_object_(NULL) { }
+
+  ~ParallelScavengerVisitor() {
+    ASSERT(work_->IsEmpty());
+    ASSERT(remembered_ == NULL);
+    ASSERT(promoted_ == NULL);
+    ASSERT(delayed_weak_ == NULL);
+    delete work_;
+  }
+
+  void VisitPointers(RawObject** first, RawObject** last) {
+    for (RawObject** current = first; current <= last; current++) {
+      ScavengePointer(current);
+    }
+  }
+
+  void VisitingOldObject(RawObject* obj) {
+    ASSERT((obj == NULL) || obj->IsOldObject());
+    visiting_old_object_ = obj;
+  }
+
+  // Scans the old objects in the store buffer blocks claimed by this task.
+  void IterateStoreBuffers() {
+    intptr_t visited_count_before = visited_count_;
+    intptr_t handled_count_before = handled_count_;
+    StoreBufferBlock* block = state_->TakeStoreBufferBlock();
+    while (block != NULL) {
+      intptr_t count = block->Count();
+      for (intptr_t i = 0; i < count; i++) {
+        RawObject* raw_object = block->At(i);
+        ASSERT(raw_object->IsRemembered());
+        raw_object->ClearRememberedBit();
+        VisitingOldObject(raw_object);
+        raw_object->VisitPointers(this);
+      }
+      delete block;
+      block = state_->TakeStoreBufferBlock();
+    }
+    VisitingOldObject(NULL);
+    store_buffer_visited_count_ += visited_count_ - visited_count_before;
+    store_buffer_handled_count_ += handled_count_ - handled_count_before;
+  }
+
+  // Scans objects until all tasks have run out of work.
+  void ProcessWork() {
+    while (true) {
+      while (!work_->IsEmpty()) {
+        RawObject* raw_obj = work_->Pop();
+        if (raw_obj->IsOldObject()) {
+          // Promoted objects are scanned strongly, as in ProcessToSpace.
+          if (heap_->concurrent_marker() != NULL) {
+            ScavengerWorkBlock::PushToList(&promoted_, raw_obj);
+          }
+          VisitingOldObject(raw_obj);
+          raw_obj->VisitPointers(this);
+          VisitingOldObject(NULL);
+        } else if (raw_obj->GetClassId() == kWeakPropertyCid) {
+          ProcessWeakProperty(reinterpret_cast<RawWeakProperty*>(raw_obj));
+        } else {
+          raw_obj->VisitPointers(this);
+        }
+      }
+      ScavengerWorkBlock* block = state_->TakeWork(task_id_);
+      if (block == NULL) {
+        return;
+      }
+      delete work_;
+      work_ = block;
+    }
+  }
+
+  // Makes the partially used allocation buffers parseable, hands the
+  // remembered old objects to the store buffer and the promoted objects to the
+  // concurrent marker, if any. Must be called after all tasks have finished.
+  void Finalize(StoreBuffer* store_buffer, ConcurrentMarker* marker) {
+    RetireNewBuffer();
+    RetirePromotionBuffer();
+    while (promoted_ != NULL) {
+      ScavengerWorkBlock* block = promoted_;
+      promoted_ = block->next();
+      while (!block->IsEmpty()) {
+        marker->MarkPromotedObject(block->Pop());
+      }
+      delete block;
+    }
+    while (remembered_ != NULL) {
+      ScavengerWorkBlock* block = remembered_;
+      remembered_ = block->next();
+      while (!block->IsEmpty()) {
+        RawObject* raw_obj = block->Pop();
+        ASSERT(raw_obj->IsRemembered());
+        store_buffer->AddObjectGC(raw_obj);
+      }
+      delete block;
+    }
+  }
+
+  // Weak properties whose keys had not been reached while scanning them.
+  ScavengerWorkBlock* TakeDelayedWeakProperties() {
+    ScavengerWorkBlock* result = delayed_weak_;
+    delayed_weak_ = NULL;
+    return result;
+  }
+
+  intptr_t store_buffer_visited_count() const {
+    return store_buffer_visited_count_;
+  }
+  intptr_t store_buffer_handled_count() const {
+    return store_buffer_handled_count_;
+  }
+  intptr_t bytes_promoted() const { return bytes_promoted_; }
+
+ private:
+  // Size of the task local allocation buffers.
+  static const intptr_t kNewBufferSize = 32 * KB;
+  static const intptr_t kPromotionBufferSize = 16 * KB;
+  // Publish the current work block early once it holds this many objects and
+  // another task is waiting for work.
+  static const intptr_t kPublishThreshold = 32;
+
+  void PushWork(RawObject* raw_obj) {
+    if (work_->IsFull() ||
+        ((work_->Count() >= kPublishThreshold) && state_->HasIdleTasks())) {
+      state_->PublishWork(task_id_, work_);
+      work_ = new ScavengerWorkBlock();
+    }
+    work_->Push(raw_obj);
+  }
+
+  void ProcessWeakProperty(RawWeakProperty* raw_weak) {
+    // The fate of the weak property is determined by its key.
+    RawObject* raw_key = raw_weak->ptr()->key_;
+    if (raw_key->IsHeapObject() && raw_key->IsNewObject()) {
+      uword header = *reinterpret_cast<volatile uword*>(
+          RawObject::ToAddr(raw_key));
+      if (!IsForwarding(header) && !IsClaimed(header)) {
+        // Key is white. Delay the weak property until all tasks are done.
+        ScavengerWorkBlock::PushToList(&delayed_weak_, raw_weak);
+        return;
+      }
+    }
+    // Key is gray or black. Make the weak property black.
+    raw_weak->VisitPointers(this);
+  }
+
+  void RetireNewBuffer() {
+    if (new_top_ < new_end_) {
+      FreeListElement::AsElement(new_top_, new_end_ - new_top_);
+    }
+    new_top_ = new_end_ = 0;
+  }
+
+  void RetirePromotionBuffer() {
+    // The unused remainder is reclaimed by the next mark-sweep.
+    if (promoted_top_ < promoted_end_) {
+      FreeListElement::AsElement(promoted_top_, promoted_end_ - promoted_top_);
+    }
+    promoted_top_ = promoted_end_ = 0;
+  }
+
+  uword TryAllocateNew(intptr_t size) {
+    intptr_t remaining = new_end_ - new_top_;
+    if (remaining >= size) {
+      uword result = new_top_;
+      new_top_ += size;
+      return result;
+    }
+    if (size > (kNewBufferSize >> 2)) {
+      // Large objects are allocated directly in the to space.
+      return scavenger_->TryAllocateShared(size);
+    }
+    RetireNewBuffer();
+    uword buffer = scavenger_->TryAllocateShared(kNewBufferSize);
+    if (buffer == 0) {
+      return scavenger_->TryAllocateShared(size);
+    }
+    new_top_ = buffer + size;
+    new_end_ = buffer + kNewBufferSize;
+    return buffer;
+  }
+
+  // Must be called with the promotion lock held. Mirrors the promotion
+  // failure handling of the ScavengerVisitor.
+  uword TryPromoteLocked(intptr_t size) {
+    uword addr = heap_->TryAllocate(size, Heap::kOld, state_->growth_policy());
+    if ((addr == 0) && !scavenger_->had_promotion_failure_) {
+      scavenger_->had_promotion_failure_ = true;
+      state_->set_growth_policy(PageSpace::kForceGrowth);
+      addr = heap_->TryAllocate(size, Heap::kOld, PageSpace::kForceGrowth);
+    }
+    return addr;
+  }
+
+  uword TryPromote(intptr_t size) {
+    intptr_t remaining = promoted_end_ - promoted_top_;
+    if (remaining >= size) {
+      uword result = promoted_top_;
+      promoted_top_ += size;
+      return result;
+    }
+    if (size > (kPromotionBufferSize >> 2)) {
+      ScopedMutex ml(state_->promotion_mutex());
+      return TryPromoteLocked(size);
+    }
+    RetirePromotionBuffer();
+    ScopedMutex ml(state_->promotion_mutex());
+    uword buffer = heap_->TryAllocate(kPromotionBufferSize,
+                                      Heap::kOld,
+                                      state_->growth_policy());
+    if (buffer == 0) {
+      return TryPromoteLocked(size);
+    }
+    promoted_top_ = buffer + size;
+    promoted_end_ = buffer + kPromotionBufferSize;
+    return buffer;
+  }
+
+  // Copies a claimed object and installs its forwarding address.
+  uword CopyObject(RawObject* raw_obj, uword header) {
+    uword raw_addr = RawObject::ToAddr(raw_obj);
+    intptr_t size = raw_obj->Size();
+    uword new_addr = 0;
+    if (scavenger_->survivor_end_ <= raw_addr) {
+      // Not a survivor of a previous scavenge. Copy it into the to space
+      // unless the to space has been used up by partially filled buffers.
+      new_addr = TryAllocateNew(size);
+      if (new_addr == 0) {
+        new_addr = TryPromote(size);
+        if (new_addr != 0) {
+          bytes_promoted_ += size;
+        }
+      }
+    } else {
+      // This object is a survivor of a previous scavenge. Attempt to promote
+      // the object.
+      new_addr = TryPromote(size);
+      if (new_addr != 0) {
+        bytes_promoted_ += size;
+      } else {
+        new_addr = TryAllocateNew(size);
+      }
+    }
+    if (new_addr == 0) {
+      FATAL("Out of memory during parallel scavenge.\n");
+    }
+    memmove(reinterpret_cast<void*>(new_addr),
+            reinterpret_cast<void*>(raw_addr),
+            size);
+    // Restore the header as it was before the object was claimed.
+    *reinterpret_cast<uword*>(new_addr) = header;
+    PushWork(RawObject::FromAddr(new_addr));
+    // The compare and swap also orders the copy before the forwarding.
+    uword old_header = AtomicOperations::CompareAndSwapWord(
+        reinterpret_cast<uword*>(raw_addr),
+        header | kClaimedMask,
+        new_addr | kForwarded);
+    ASSERT(old_header == (header | kClaimedMask));
+    return new_addr;
+  }
+
+  uword WaitForForwarding(uword raw_addr) {
+    uword header = *reinterpret_cast<volatile uword*>(raw_addr);
+    while (!IsForwarding(header)) {
+      ASSERT(IsClaimed(header));
+      header = *reinterpret_cast<volatile uword*>(raw_addr);
+    }
+    return ForwardedAddr(header);
+  }
+
+  void ScavengePointer(RawObject** p) {
+    visited_count_++;
+    RawObject* raw_obj = *p;
+
+    // Fast exit if the raw object is a Smi or an old object.
+    if (!raw_obj->IsHeapObject() || raw_obj->IsOldObject()) {
+      return;
+    }
+
+    uword raw_addr = RawObject::ToAddr(raw_obj);
+    // The scavenger is only interested in objects located in the from space.
+    if (!scavenger_->from_->Contains(raw_addr)) {
+      return;
+    }
+
+    handled_count_++;
+    uword header = *reinterpret_cast<volatile uword*>(raw_addr);
+    uword new_addr = 0;
+    if (IsForwarding(header)) {
+      new_addr = ForwardedAddr(header);
+    } else if (!IsClaimed(header) &&
+               (AtomicOperations::CompareAndSwapWord(
+                   reinterpret_cast<uword*>(raw_addr),
+                   header,
+                   header | kClaimedMask) == header)) {
+      new_addr = CopyObject(raw_obj, header);
+    } else {
+      // Another task is copying this object.
+      new_addr = WaitForForwarding(raw_addr);
+    }
+    // Update the reference.
+    RawObject* new_obj = RawObject::FromAddr(new_addr);
+    *p = new_obj;
+    // Remember old objects which keep pointing into new space.
+    if ((visiting_old_object_ != NULL) && new_obj->IsNewObject()) {
+      if (visiting_old_object_->IsCardRemembered()) {
+        // Tasks racing to dirty the same card all store the same value.
+        HeapPage::RememberCard(visiting_old_object_, p);
+      } else if (!visiting_old_object_->IsRemembered()) {
+        visiting_old_object_->SetRememberedBit();
+        ScavengerWorkBlock::PushToList(&remembered_, visiting_old_object_);
+      }
+    }
+  }
+
+  Scavenger* scavenger_;
+  Heap* heap_;
+  ParallelScavengerState* state_;
+  const intptr_t task_id_;
+  ScavengerWorkBlock* work_;
+  ScavengerWorkBlock* remembered_;
+  ScavengerWorkBlock* promoted_;
+  ScavengerWorkBlock* delayed_weak_;
+  uword new_top_;
+  uword new_end_;
+  uword promoted_top_;
+  uword promoted_end_;
+  intptr_t visited_count_;
+  intptr_t handled_count_;
+  intptr_t store_buffer_visited_count_;
+  intptr_t store_buffer_handled_count_;
+  intptr_t bytes_promoted_;
+  RawObject* visiting_old_object_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavengerVisitor);
+};
+
+
+class ScavengerTask : public ThreadPool::Task {
+ public:
+  ScavengerTask(Isolate* isolate,
+                ParallelScavengerState* state,
+                ParallelScavengerVisitor* visitor)
+      : isolate_(isolate),
+        state_(state),
+        visitor_(visitor) { }
+
+  virtual void Run() {
+    if (state_->TaskStarted()) {
+      Isolate* saved_isolate = Isolate::Current();
+      Isolate::SetCurrentGCHelper(isolate_);
+      visitor_->IterateStoreBuffers();
+      visitor_->ProcessWork();
+      Isolate::SetCurrentGCHelper(saved_isolate);
+      // The visitor must not be touched after signalling completion.
+      state_->TaskDone();
+    }
+    state_->Release();
+  }
+
+ private:
+  Isolate* isolate_;
+  ParallelScavengerState* state_;
+  ParallelScavengerVisitor* visitor_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScavengerTask);
+};
+
+
 Scavenger::Scavenger(Heap* heap,
                      intptr_t max_capacity_in_words,
                      uword object_alignment)
@@ -328,6 +967,8 @@ Scavenger::Scavenger(Heap* heap,
   to_ = new MemoryRegion(space_->address(), semi_space_size);
   uword middle = space_->start() + semi_space_size;
   from_ = new MemoryRegion(reinterpret_cast<void*>(middle), semi_space_size);
+  semi_space_size_ = semi_space_size;
+  max_semi_space_size_ = semi_space_size;
 
   // Make sure that the two semi-spaces are aligned properly.
   ASSERT(Utils::IsAligned(to_->start(), kObjectAlignment));
@@ -363,6 +1004,13 @@ void Scavenger::Prologue(Isolate* isolate, bool invoke_api_callbacks) {
   MemoryRegion* temp = from_;
   from_ = to_;
   to_ = temp;
+  if (to_->size() != semi_space_size_) {
+    // The new to space is empty and may be resized within its half of the
+    // reserved space.
+    ASSERT(semi_space_size_ <= max_semi_space_size_);
+    to_ = new MemoryRegion(temp->pointer(), semi_space_size_);
+    delete temp;
+  }
   top_ = FirstObjectStart();
   resolved_top_ = top_;
   end_ = to_->end();
@@ -386,6 +1034,77 @@ void Scavenger::Epilogue(Isolate* isolate, bool invoke_api_callbacks) {
 }
 
 
+void Scavenger::RecordSurvival(Isolate* isolate, uword start, uword end) {
+  ClassTable* class_table = isolate->class_table();
+  const intptr_t num_cids = class_table->NumCids();
+  intptr_t* allocated = reinterpret_cast<intptr_t*>(
+      calloc(num_cids, sizeof(intptr_t)));  // NOLINT
+  intptr_t* survived = reinterpret_cast<intptr_t*>(
+      calloc(num_cids, sizeof(intptr_t)));  // NOLINT
+  uword current = start;
+  while (current < end) {
+    uword header = *reinterpret_cast<uword*>(current);
+    const bool is_survivor = IsForwarding(header);
+    RawObject* raw_obj = is_survivor ?
+        RawObject::FromAddr(ForwardedAddr(header)) :
+        RawObject::FromAddr(current);
+    // Only the instances of the classes with an allocation stub are tracked.
+    intptr_t cid = raw_obj->GetClassId();
+    if (cid >= kNumPredefinedCids) {
+      allocated[cid]++;
+      if (is_survivor) {
+        survived[cid]++;
+      }
+    }
+    current += raw_obj->Size();
+  }
+  ASSERT(current == end);
+  for (intptr_t cid = kNumPredefinedCids; cid < num_cids; cid++) {
+    if (allocated[cid] > 0) {
+      class_table->UpdateSurvival(cid, allocated[cid], survived[cid]);
+    }
+  }
+  free(allocated);
+  free(survived);
+}
+
+
+void Scavenger::AdaptSemiSpaceSize(int64_t start,
+                                   int64_t end,
+                                   intptr_t used_before_in_words) {
+  history_.AddGarbageCollectionTime(start, end);
+  const int64_t pause = end - start;
+  const int64_t pause_target =
+      static_cast<int64_t>(FLAG_gc_pause_target) * kMicrosecondsPerMillisecond;
+  // The objects left in the to space have survived this scavenge.
+  const intptr_t survived_in_words = UsedInWords();
+  const bool high_survival_rate =
+      (2 * survived_in_words) > used_before_in_words;
+  uword size = semi_space_size_;
+  if (pause > pause_target) {
+    // The fewer objects are allocated between two scavenges, the fewer of
+    // them are still alive and need to be copied.
+    size = size / 2;
+  } else if ((2 * pause) < pause_target) {
+    if ((history_.GarbageCollectionTimeFraction() > FLAG_gc_time_target) ||
+        high_survival_rate) {
+      size = size * 2;
+    }
+  }
+  size = Utils::RoundUp(size, VirtualMemory::PageSize());
+  size = Utils::Maximum(size, static_cast<uword>(kMinSemiSpaceSize));
+  size = Utils::Minimum(size, max_semi_space_size_);
+  if (size != semi_space_size_) {
+    if (FLAG_verbose_gc) {
+      OS::PrintErr("Resizing the semi spaces from %" Pd " KB to "
+                   "%" Pd " KB.\n",
+                   semi_space_size_ / KB, size / KB);
+    }
+    semi_space_size_ = size;
+  }
+}
+
+
 void Scavenger::IterateStoreBuffers(Isolate* isolate,
                                     ScavengerVisitor* visitor) {
   StoreBuffer* buffer = isolate->store_buffer();
@@ -439,6 +1158,7 @@ void Scavenger::IterateRoots(Isolate* isolate,
                                StackFrameIterator::kDontValidateFrames);
   int64_t middle = OS::GetCurrentTimeMicros();
   IterateStoreBuffers(isolate, visitor);
+  heap_->IterateRememberedCards(visitor);
   IterateObjectIdTable(isolate, visitor);
   int64_t end = OS::GetCurrentTimeMicros();
   heap_->RecordData(kToKBAfterStoreBuffer, RoundWordsToKB(UsedInWords()));
@@ -531,6 +1251,7 @@ void Scavenger::IterateWeakRoots(Isolate* isolate,
 
 void Scavenger::ProcessToSpace(ScavengerVisitor* visitor) {
   GrowableArray<RawObject*>* delayed_weak_stack = visitor->DelayedWeakStack();
+  ConcurrentMarker* marker = heap_->concurrent_marker();
 
   // Iterate until all work has been drained.
   while ((resolved_top_ < top_) ||
@@ -553,6 +1274,10 @@ void Scavenger::ProcessToSpace(ScavengerVisitor* visitor) {
         // can potentially push more objects on this stack as well as add more
         // objects to be resolved in the to space.
         ASSERT(!raw_object->IsRemembered());
+        if (marker != NULL) {
+          // Old objects already scanned by the marker may refer to it.
+          marker->MarkPromotedObject(raw_object);
+        }
         visitor->VisitingOldObject(raw_object);
         raw_object->VisitPointers(visitor);
       }
@@ -567,6 +1292,122 @@ void Scavenger::ProcessToSpace(ScavengerVisitor* visitor) {
 }
 
 
+uword Scavenger::TryAllocateShared(intptr_t size) {
+  ASSERT(Utils::IsAligned(size, kObjectAlignment));
+  uword top = top_;
+  while (true) {
+    intptr_t remaining = end_ - top;
+    if (remaining < size) {
+      return 0;
+    }
+    uword old_top =
+        AtomicOperations::CompareAndSwapWord(&top_, top, top + size);
+    if (old_top == top) {
+      return top;
+    }
+    top = old_top;
+  }
+}
+
+
+void Scavenger::ParallelScavenge(Isolate* isolate,
+                                 ScavengerVisitor* visitor,
+                                 bool visit_prologue_weak_persistent_handles) {
+  const intptr_t num_tasks = FLAG_scavenger_tasks;
+  ASSERT(num_tasks > 1);
+  StoreBuffer* store_buffer = isolate->store_buffer();
+  heap_->RecordData(kStoreBufferEntries, store_buffer->Count());
+
+  ParallelScavengerState* state =
+      new ParallelScavengerState(num_tasks, store_buffer->Blocks());
+  ParallelScavengerVisitor** visitors =
+      new ParallelScavengerVisitor*[num_tasks];
+  for (intptr_t i = 0; i < num_tasks; i++) {
+    visitors[i] = new ParallelScavengerVisitor(isolate, this, state, i);
+  }
+#if defined(DEBUG)
+  isolate->IncrementGCHelperDepth();
+#endif
+  for (intptr_t i = 1; i < num_tasks; i++) {
+    Dart::thread_pool()->RunHelper(
+        new ScavengerTask(isolate, state, visitors[i]));
+  }
+  // Roots which require walking the stack are visited on the isolate's own
+  // thread, which then joins the helpers in scanning the store buffers and
+  // draining the work lists. The isolate thread also scans all roots that
+  // are not shared out, as the helpers may never get to run.
+  int64_t start = OS::GetCurrentTimeMicros();
+  isolate->VisitObjectPointers(visitors[0],
+                               visit_prologue_weak_persistent_handles,
+                               StackFrameIterator::kDontValidateFrames);
+  int64_t middle = OS::GetCurrentTimeMicros();
+  visitors[0]->IterateStoreBuffers();
+  heap_->IterateRememberedCards(visitors[0]);
+  ObjectIdRing* ring = isolate->object_id_ring();
+  if (ring != NULL) {
+    ring->VisitPointers(visitors[0]);
+  } else {
+    // --gc_at_alloc can get us here before the ring has been initialized.
+    ASSERT(FLAG_gc_at_alloc);
+  }
+  int64_t end = OS::GetCurrentTimeMicros();
+  // Only the share of the isolate thread is known before all survivors have
+  // been copied.
+  heap_->RecordData(kToKBAfterStoreBuffer, RoundWordsToKB(UsedInWords()));
+  heap_->RecordTime(kVisitIsolateRoots, middle - start);
+  heap_->RecordTime(kIterateStoreBuffers, end - middle);
+  visitors[0]->ProcessWork();
+  state->WaitForTasks();
+#if defined(DEBUG)
+  isolate->DecrementGCHelperDepth();
+#endif
+
+  intptr_t store_buffer_visited = 0;
+  intptr_t store_buffer_handled = 0;
+  ScavengerWorkBlock* delayed_weak = NULL;
+  ConcurrentMarker* marker = heap_->concurrent_marker();
+  for (intptr_t i = 0; i < num_tasks; i++) {
+    ParallelScavengerVisitor* task_visitor = visitors[i];
+    task_visitor->Finalize(store_buffer, marker);
+    store_buffer_visited += task_visitor->store_buffer_visited_count();
+    store_buffer_handled += task_visitor->store_buffer_handled_count();
+    ScavengerWorkBlock* block = task_visitor->TakeDelayedWeakProperties();
+    while (block != NULL) {
+      ScavengerWorkBlock* next = block->next();
+      block->set_next(delayed_weak);
+      delayed_weak = block;
+      block = next;
+    }
+    delete task_visitor;
+  }
+  delete[] visitors;
+  state->Release();
+  heap_->RecordData(kStoreBufferVisited, store_buffer_visited);
+  heap_->RecordData(kStoreBufferPointers, store_buffer_handled);
+
+  // Everything copied so far has been scanned by the tasks.
+  resolved_top_ = top_;
+  if (had_promotion_failure_) {
+    visitor->set_growth_policy(PageSpace::kForceGrowth);
+  }
+
+  // Finish the weak properties whose keys were not reached by any task on
+  // this thread. Their keys are either known to be live by now, or the
+  // properties are delayed until their keys get scavenged.
+  while (delayed_weak != NULL) {
+    ScavengerWorkBlock* block = delayed_weak;
+    delayed_weak = block->next();
+    while (!block->IsEmpty()) {
+      RawWeakProperty* raw_weak =
+          reinterpret_cast<RawWeakProperty*>(block->Pop());
+      ProcessWeakProperty(raw_weak, visitor);
+    }
+    delete block;
+  }
+  ProcessToSpace(visitor);
+}
+
+
 uword Scavenger::ProcessWeakProperty(RawWeakProperty* raw_weak,
                                      ScavengerVisitor* visitor) {
   // The fate of the weak property is determined by its key.
@@ -658,22 +1499,54 @@ void Scavenger::Scavenge(bool invoke_api_callbacks) {
     OS::PrintErr(" done.\n");
   }
 
+  // The concurrent marker must not see objects while they are moved. Store
+  // buffer entries are treated as grey as setting the remembered bit may have
+  // cleared the mark bit.
+  ConcurrentMarker* marker = heap_->concurrent_marker();
+  if (marker != NULL) {
+    marker->Pause();
+    marker->MarkStoreBuffer(isolate->store_buffer());
+  }
+
   // Setup the visitor and run a scavenge.
+  const int64_t pause_start = OS::GetCurrentTimeMicros();
+  const intptr_t used_before_in_words = UsedInWords();
+  // The objects allocated since the last scavenge.
+  const uword allocated_start = survivor_end_;
+  const uword allocated_end = top_;
   ScavengerVisitor visitor(isolate, this);
   Prologue(isolate, invoke_api_callbacks);
-  IterateRoots(isolate, &visitor, !invoke_api_callbacks);
-  int64_t start = OS::GetCurrentTimeMicros();
-  ProcessToSpace(&visitor);
+  int64_t start;
+  if (FLAG_scavenger_tasks > 1) {
+    // The roots are scanned by the tasks while copying.
+    start = OS::GetCurrentTimeMicros();
+    ParallelScavenge(isolate, &visitor, !invoke_api_callbacks);
+  } else {
+    IterateRoots(isolate, &visitor, !invoke_api_callbacks);
+    start = OS::GetCurrentTimeMicros();
+    ProcessToSpace(&visitor);
+  }
   int64_t middle = OS::GetCurrentTimeMicros();
   IterateWeakReferences(isolate, &visitor);
   ScavengerWeakVisitor weak_visitor(this);
   IterateWeakRoots(isolate, &weak_visitor, invoke_api_callbacks);
   visitor.Finalize();
   ProcessWeakTables();
+  if (FLAG_pretenure) {
+    RecordSurvival(isolate, allocated_start, allocated_end);
+  }
   int64_t end = OS::GetCurrentTimeMicros();
   heap_->RecordTime(kProcessToSpace, middle - start);
   heap_->RecordTime(kIterateWeaks, end - middle);
   Epilogue(isolate, invoke_api_callbacks);
+  if (marker != NULL) {
+    marker->Resume();
+  }
+  if (FLAG_adaptive_heap_sizing) {
+    AdaptSemiSpaceSize(pause_start,
+                       OS::GetCurrentTimeMicros(),
+                       used_before_in_words);
+  }
 
   if (FLAG_verify_after_gc) {
     OS::PrintErr("Verifying after Scavenge...");
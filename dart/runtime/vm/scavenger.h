@@ -9,6 +9,7 @@
 #include "platform/utils.h"
 #include "vm/flags.h"
 #include "vm/globals.h"
+#include "vm/pages.h"
 #include "vm/raw_object.h"
 #include "vm/virtual_memory.h"
 #include "vm/visitor.h"
@@ -18,9 +19,11 @@ namespace dart {
 // Forward declarations.
 class Heap;
 class Isolate;
+class ParallelScavengerVisitor;
 class ScavengerVisitor;
 
 DECLARE_FLAG(bool, gc_at_alloc);
+DECLARE_FLAG(int, scavenger_tasks);
 
 class Scavenger {
  public:
@@ -72,7 +75,9 @@ class Scavenger {
   intptr_t UsedInWords() const {
     return (top_ - FirstObjectStart()) >> kWordSizeLog2;
   }
-  intptr_t CapacityInWords() const { return space_->size() >> kWordSizeLog2; }
+  intptr_t CapacityInWords() const {
+    return (to_->size() + from_->size()) >> kWordSizeLog2;
+  }
 
   void VisitObjects(ObjectVisitor* visitor) const;
   void VisitObjectPointers(ObjectPointerVisitor* visitor) const;
@@ -104,7 +109,17 @@ class Scavenger {
     kToKBAfterStoreBuffer = 3
   };
 
+  // With --adaptive_heap_sizing the semi spaces only use part of their half of
+  // the reserved space. It starts out fully used.
+  static const intptr_t kMinSemiSpaceSize = 256 * KB;
+
   uword FirstObjectStart() const { return to_->start() | object_alignment_; }
+  // Halves the size of the to space after the next flip if the scavenge
+  // exceeded --gc_pause_target, or doubles it if the GC time exceeds
+  // --gc_time_target or most of the objects survived.
+  void AdaptSemiSpaceSize(int64_t start,
+                          int64_t end,
+                          intptr_t used_before_in_words);
   void Prologue(Isolate* isolate, bool invoke_api_callbacks);
   void IterateStoreBuffers(Isolate* isolate, ScavengerVisitor* visitor);
   void IterateObjectIdTable(Isolate* isolate, ScavengerVisitor* visitor);
@@ -117,6 +132,9 @@ class Scavenger {
                         HandleVisitor* visitor,
                         bool visit_prologue_weak_persistent_handles);
   void ProcessToSpace(ScavengerVisitor* visitor);
+  void ParallelScavenge(Isolate* isolate,
+                        ScavengerVisitor* visitor,
+                        bool visit_prologue_weak_persistent_handles);
   uword ProcessWeakProperty(RawWeakProperty* raw_weak,
                             ScavengerVisitor* visitor);
   void Epilogue(Isolate* isolate, bool invoke_api_callbacks);
@@ -142,8 +160,17 @@ class Scavenger {
     return end_ < to_->end();
   }
 
+  // Used by the tasks of a parallel scavenge to carve allocation buffers out
+  // of the to space. The promoted stack is not used during a parallel
+  // scavenge, so end_ is stable while the tasks are running.
+  uword TryAllocateShared(intptr_t size);
+
   void ProcessWeakTables();
 
+  // Reports the survival of the objects allocated in [start, end) of the from
+  // space since the last scavenge to the class table, see --pretenure.
+  void RecordSurvival(Isolate* isolate, uword start, uword end);
+
   VirtualMemory* space_;
   MemoryRegion* to_;
   MemoryRegion* from_;
@@ -165,11 +192,18 @@ class Scavenger {
   // All object are aligned to this value.
   uword object_alignment_;
 
+  // The size of the to space after the next flip, and the size of each half of
+  // the reserved space.
+  uword semi_space_size_;
+  uword max_semi_space_size_;
+  PageSpaceGarbageCollectionHistory history_;
+
   // Keep track whether a scavenge is currently running.
   bool scavenging_;
   // Keep track whether the scavenge had a promotion failure.
   bool had_promotion_failure_;
 
+  friend class ParallelScavengerVisitor;
   friend class ScavengerVisitor;
   friend class ScavengerWeakVisitor;
 
@@ -0,0 +1,189 @@
+// Copyright (c) 2013, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "platform/assert.h"
+#include "vm/benchmark_test.h"
+#include "vm/dart_api_impl.h"
+#include "vm/globals.h"
+#include "vm/heap.h"
+#include "vm/scavenger.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+// Builds a list of nodes reachable from a static field, so that all of them
+// survive the next scavenges.
+static const char* kSurvivorScriptChars =
+    "class Node {\n"
+    "  var next;\n"
+    "  var payload;\n"
+    "  Node(this.next, this.payload);\n"
+    "}\n"
+    "var root;\n"
+    "build(n) {\n"
+    "  var list = null;\n"
+    "  for (var i = 0; i < n; i++) {\n"
+    "    list = new Node(list, [i, i + 1]);\n"
+    "  }\n"
+    "  root = list;\n"
+    "}\n"
+    "sum() {\n"
+    "  var result = 0;\n"
+    "  for (var node = root; node != null; node = node.next) {\n"
+    "    result += node.payload[0] + node.payload[1];\n"
+    "  }\n"
+    "  return result;\n"
+    "}\n";
+
+
+static void BuildSurvivors(Dart_Handle lib, intptr_t length) {
+  Dart_Handle args[1];
+  args[0] = Dart_NewInteger(length);
+  Dart_Handle result = Dart_Invoke(lib, NewString("build"), 1, args);
+  EXPECT_VALID(result);
+}
+
+
+static int64_t SumSurvivors(Dart_Handle lib) {
+  Dart_Handle result = Dart_Invoke(lib, NewString("sum"), 0, NULL);
+  EXPECT_VALID(result);
+  int64_t value = 0;
+  EXPECT_VALID(Dart_IntegerToInt64(result, &value));
+  return value;
+}
+
+
+TEST_CASE(ParallelScavenge) {
+  const intptr_t kLength = 10000;
+  const int64_t kExpectedSum = static_cast<int64_t>(kLength) * kLength;
+  intptr_t saved_scavenger_tasks = FLAG_scavenger_tasks;
+  FLAG_scavenger_tasks = 4;
+  Dart_Handle lib = TestCase::LoadTestScript(kSurvivorScriptChars, NULL);
+  BuildSurvivors(lib, kLength);
+  Heap* heap = Isolate::Current()->heap();
+  // The first scavenge copies the nodes into the to space, the second one
+  // promotes them.
+  heap->CollectGarbage(Heap::kNew);
+  EXPECT_EQ(kExpectedSum, SumSurvivors(lib));
+  heap->CollectGarbage(Heap::kNew);
+  EXPECT_EQ(kExpectedSum, SumSurvivors(lib));
+  heap->CollectGarbage(Heap::kOld);
+  EXPECT_EQ(kExpectedSum, SumSurvivors(lib));
+  FLAG_scavenger_tasks = saved_scavenger_tasks;
+}
+
+
+TEST_CASE(AdaptiveSemiSpaceSize) {
+  bool saved_adaptive_heap_sizing = FLAG_adaptive_heap_sizing;
+  intptr_t saved_gc_pause_target = FLAG_gc_pause_target;
+  intptr_t saved_gc_time_target = FLAG_gc_time_target;
+  FLAG_adaptive_heap_sizing = true;
+  Heap* heap = Isolate::Current()->heap();
+  intptr_t capacity = heap->CapacityInWords(Heap::kNew);
+  // Every scavenge misses a pause target of 0 milliseconds. A new size takes
+  // effect when the semi spaces are flipped by the next scavenge.
+  FLAG_gc_pause_target = 0;
+  heap->CollectGarbage(Heap::kNew);
+  heap->CollectGarbage(Heap::kNew);
+  EXPECT_LT(heap->CapacityInWords(Heap::kNew), capacity);
+  // Back to back scavenges exceed any GC time target, which grows the semi
+  // spaces again up to their reserved size.
+  FLAG_gc_pause_target = 1000000;
+  FLAG_gc_time_target = 0;
+  for (intptr_t i = 0; i < 4; i++) {
+    heap->CollectGarbage(Heap::kNew);
+  }
+  EXPECT_EQ(capacity, heap->CapacityInWords(Heap::kNew));
+  FLAG_adaptive_heap_sizing = saved_adaptive_heap_sizing;
+  FLAG_gc_pause_target = saved_gc_pause_target;
+  FLAG_gc_time_target = saved_gc_time_target;
+}
+
+
+// Builds a list of nodes which all survive their first scavenge.
+static const char* kPretenureScriptChars =
+    "class Node {\n"
+    "  var next;\n"
+    "  Node(this.next);\n"
+    "}\n"
+    "var root;\n"
+    "build(n) {\n"
+    "  for (var i = 0; i < n; i++) {\n"
+    "    root = new Node(root);\n"
+    "  }\n"
+    "}\n"
+    "allocate() => new Node(null);\n";
+
+
+TEST_CASE(Pretenuring) {
+  bool saved_pretenure = FLAG_pretenure;
+  FLAG_pretenure = true;
+  Dart_Handle lib = TestCase::LoadTestScript(kPretenureScriptChars, NULL);
+  Dart_Handle args[1];
+  args[0] = Dart_NewInteger(10000);
+  EXPECT_VALID(Dart_Invoke(lib, NewString("build"), 1, args));
+  Dart_Handle root = Dart_GetField(lib, NewString("root"));
+  EXPECT_VALID(root);
+  Isolate* isolate = Isolate::Current();
+  ClassTable* class_table = isolate->class_table();
+  const intptr_t cid = Object::Handle(Api::UnwrapHandle(root)).GetClassId();
+  EXPECT(!class_table->ShouldPretenure(cid));
+  isolate->heap()->CollectGarbage(Heap::kNew);
+  EXPECT(class_table->ShouldPretenure(cid));
+  // Code compiled from now on allocates the nodes in the old space.
+  Dart_Handle result = Dart_Invoke(lib, NewString("allocate"), 0, NULL);
+  EXPECT_VALID(result);
+  EXPECT(Api::UnwrapHandle(result)->IsOldObject());
+  FLAG_pretenure = saved_pretenure;
+}
+
+
+TEST_CASE(CardRememberedArray) {
+  const intptr_t kLength = 64 * KB;
+  const Array& array = Array::Handle(Array::New(kLength, Heap::kOld));
+  EXPECT(array.raw()->IsCardRemembered());
+  const Array& small = Array::Handle(Array::New(16, Heap::kOld));
+  EXPECT(!small.raw()->IsCardRemembered());
+  // Storing new objects dirties the cards of the slots instead of
+  // remembering the array.
+  for (intptr_t i = 0; i < kLength; i += kLength / 8) {
+    array.SetAt(i, String::Handle(String::New("card", Heap::kNew)));
+  }
+  EXPECT(!array.raw()->IsRemembered());
+  Heap* heap = Isolate::Current()->heap();
+  // The first scavenge copies the strings, which keep their cards dirty, the
+  // second one promotes them.
+  for (intptr_t j = 0; j < 2; j++) {
+    heap->CollectGarbage(Heap::kNew);
+    for (intptr_t i = 0; i < kLength; i += kLength / 8) {
+      String& str = String::Handle();
+      str ^= array.At(i);
+      EXPECT(str.Equals("card"));
+    }
+  }
+  EXPECT(array.At(1) == Object::null());
+  heap->CollectGarbage(Heap::kOld);
+}
+
+
+//
+// Measure the pause of a scavenge copying a large number of survivors. Run
+// with --scavenger_tasks to measure a parallel scavenge.
+//
+BENCHMARK(ScavengePause) {
+  const intptr_t kLength = 100000;
+  Dart_Handle lib = TestCase::LoadTestScript(kSurvivorScriptChars, NULL);
+  Heap* heap = benchmark->isolate()->heap();
+  // Start from an empty new space, then time the scavenge copying the
+  // freshly built list.
+  heap->CollectGarbage(Heap::kNew);
+  BuildSurvivors(lib, kLength);
+  Timer timer(true, "Scavenge pause benchmark");
+  timer.Start();
+  heap->CollectGarbage(Heap::kNew);
+  timer.Stop();
+  benchmark->set_score(timer.TotalElapsedTime());
+}
+
+}  // namespace dart
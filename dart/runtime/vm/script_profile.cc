@@ -0,0 +1,135 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/script_profile.h"
+
+#include "vm/isolate.h"
+#include "vm/object.h"
+#include "vm/object_store.h"
+#include "vm/snapshot.h"
+#include "vm/symbols.h"
+
+namespace dart {
+
+DEFINE_FLAG(int, script_profile_warmup, 100,
+            "Number of invocations after which a function which was hot in "
+            "the training run of a script profile is optimized.");
+DECLARE_FLAG(int, optimization_counter_threshold);
+
+
+static void AddFunction(const GrowableObjectArray& profile,
+                        const Library& lib,
+                        const Class& cls,
+                        const Function& func) {
+  intptr_t usage_counter = func.usage_counter();
+  if (func.HasOptimizedCode() &&
+      (usage_counter < FLAG_optimization_counter_threshold)) {
+    // The counter restarts when the function is optimized.
+    usage_counter = FLAG_optimization_counter_threshold;
+  }
+  if ((usage_counter == 0) &&
+      (func.deoptimization_counter() == 0) &&
+      func.is_optimizable()) {
+    return;
+  }
+  profile.Add(String::Handle(lib.url()));
+  if (cls.IsTopLevel()) {
+    profile.Add(String::Handle());
+  } else {
+    profile.Add(String::Handle(cls.Name()));
+  }
+  profile.Add(String::Handle(func.name()));
+  profile.Add(Smi::Handle(Smi::New(usage_counter)));
+  profile.Add(Smi::Handle(Smi::New(func.deoptimization_counter())));
+  profile.Add(Bool::Get(func.is_optimizable()));
+}
+
+
+intptr_t ScriptProfile::Write(uint8_t** buffer, ReAlloc alloc) {
+  Isolate* isolate = Isolate::Current();
+  const GrowableObjectArray& libs = GrowableObjectArray::Handle(
+      isolate, isolate->object_store()->libraries());
+  const GrowableObjectArray& profile =
+      GrowableObjectArray::Handle(isolate, GrowableObjectArray::New());
+  Library& lib = Library::Handle(isolate);
+  String& url = String::Handle(isolate);
+  Class& cls = Class::Handle(isolate);
+  Array& functions = Array::Handle(isolate);
+  Function& func = Function::Handle(isolate);
+  for (intptr_t i = 0; i < libs.Length(); i++) {
+    lib ^= libs.At(i);
+    url = lib.url();
+    if (url.StartsWith(Symbols::DartScheme())) {
+      // The functions of the dart: libraries are part of the full snapshot.
+      continue;
+    }
+    ClassDictionaryIterator it(lib, ClassDictionaryIterator::kIteratePrivate);
+    while (it.HasNext()) {
+      cls = it.GetNextClass();
+      functions = cls.functions();
+      for (intptr_t j = 0; j < functions.Length(); j++) {
+        func ^= functions.At(j);
+        AddFunction(profile, lib, cls, func);
+      }
+    }
+  }
+  MessageWriter writer(buffer, alloc);
+  writer.WriteMessage(Array::Handle(isolate, Array::MakeArray(profile)));
+  return writer.BytesWritten();
+}
+
+
+bool ScriptProfile::Apply(const uint8_t* buffer, intptr_t size) {
+  Isolate* isolate = Isolate::Current();
+  SnapshotReader reader(buffer, size, Snapshot::kMessage, isolate);
+  const Object& obj = Object::Handle(isolate, reader.ReadObject());
+  if (!obj.IsArray() || ((Array::Cast(obj).Length() % kEntrySize) != 0)) {
+    return false;
+  }
+  const Array& profile = Array::Cast(obj);
+  // Leave the hot functions a few invocations to collect type feedback in
+  // unoptimized code before they are optimized.
+  const intptr_t warm_counter = Utils::Maximum(
+      static_cast<intptr_t>(FLAG_optimization_counter_threshold -
+                            FLAG_script_profile_warmup),
+      static_cast<intptr_t>(0));
+  String& url = String::Handle(isolate);
+  String& class_name = String::Handle(isolate);
+  String& name = String::Handle(isolate);
+  Library& lib = Library::Handle(isolate);
+  Class& cls = Class::Handle(isolate);
+  Function& func = Function::Handle(isolate);
+  Smi& counter = Smi::Handle(isolate);
+  for (intptr_t i = 0; i < profile.Length(); i += kEntrySize) {
+    url ^= profile.At(i + kLibraryUrlIndex);
+    lib = Library::LookupLibrary(url);
+    if (lib.IsNull()) {
+      continue;
+    }
+    class_name ^= profile.At(i + kClassNameIndex);
+    name ^= profile.At(i + kFunctionNameIndex);
+    if (class_name.IsNull()) {
+      func = lib.LookupLocalFunction(name);
+    } else {
+      cls = lib.LookupClassAllowPrivate(class_name);
+      if (cls.IsNull() || (cls.library() != lib.raw())) {
+        continue;
+      }
+      func = cls.LookupFunctionAllowPrivate(name);
+    }
+    if (func.IsNull()) {
+      continue;
+    }
+    counter ^= profile.At(i + kUsageCounterIndex);
+    func.set_usage_counter(Utils::Minimum(counter.Value(), warm_counter));
+    counter ^= profile.At(i + kDeoptimizationCounterIndex);
+    func.set_deoptimization_counter(counter.Value());
+    if (profile.At(i + kIsOptimizableIndex) == Bool::False().raw()) {
+      func.set_is_optimizable(false);
+    }
+  }
+  return true;
+}
+
+}  // namespace dart
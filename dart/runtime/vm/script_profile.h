@@ -0,0 +1,55 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef VM_SCRIPT_PROFILE_H_
+#define VM_SCRIPT_PROFILE_H_
+
+#include "vm/allocation.h"
+#include "vm/datastream.h"
+#include "vm/flags.h"
+#include "vm/globals.h"
+
+namespace dart {
+
+DECLARE_FLAG(int, script_profile_warmup);
+
+// The class ScriptProfile records how often the functions of the libraries
+// loaded in an isolate were invoked during a training run, and whether the
+// optimizer gave up on them. Applied to another isolate which loaded the same
+// libraries but did not run any code, e.g. before writing a script snapshot,
+// it presets the usage and deoptimization counters of the functions, which
+// are part of script snapshots. The functions which were hot in the training
+// run are then optimized after --script_profile_warmup invocations instead of
+// after --optimization_counter_threshold invocations.
+class ScriptProfile : public AllStatic {
+ public:
+  // Writes the profile of the functions of the libraries of the current
+  // isolate, except the ones of the dart: libraries, as a message and returns
+  // its size.
+  static intptr_t Write(uint8_t** buffer, ReAlloc alloc);
+
+  // Sets the counters of the functions of the current isolate from a profile.
+  // Functions which are not found, e.g. because the implicit getters and the
+  // closures are only created on demand, are skipped. Returns false if the
+  // buffer does not hold a profile.
+  static bool Apply(const uint8_t* buffer, intptr_t size);
+
+ private:
+  // Every function of the profile is written as the url of its library, the
+  // name of its class, or null for top level functions, its name, its usage
+  // counter, its deoptimization counter and whether it is optimizable.
+  enum {
+    kLibraryUrlIndex = 0,
+    kClassNameIndex,
+    kFunctionNameIndex,
+    kUsageCounterIndex,
+    kDeoptimizationCounterIndex,
+    kIsOptimizableIndex,
+    kEntrySize
+  };
+};
+
+}  // namespace dart
+
+#endif  // VM_SCRIPT_PROFILE_H_
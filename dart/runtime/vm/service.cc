@@ -199,6 +199,11 @@ static void HandleObjectHistogram(Isolate* isolate, JSONStream* js) {
 }
 
 
+static void HandleHeap(Isolate* isolate, JSONStream* js) {
+  isolate->heap()->PrintToJSONStream(js);
+}
+
+
 static void HandleEcho(Isolate* isolate, JSONStream* js) {
   JSONObject jsobj(js);
   jsobj.AddProperty("type", "message");
@@ -261,6 +266,7 @@ static ServiceMessageHandlerEntry __message_handlers[] = {
   { "library", HandleLibrary },
   { "classes", HandleClasses },
   { "objects", HandleObjects },
+  { "heap", HandleHeap },
   { "_echo", HandleEcho },
 };
 
@@ -8,9 +8,13 @@
 #include "vm/bigint_operations.h"
 #include "vm/bootstrap.h"
 #include "vm/class_finalizer.h"
+#include "vm/dart_api_state.h"
 #include "vm/exceptions.h"
+#include "vm/gc_marker.h"
+#include "vm/gc_sweeper.h"
 #include "vm/heap.h"
 #include "vm/longjump.h"
+#include "vm/message.h"
 #include "vm/object.h"
 #include "vm/object_store.h"
 #include "vm/snapshot_ids.h"
@@ -119,8 +123,9 @@ const Snapshot* Snapshot::SetupFromBuffer(const void* raw_memory) {
   ASSERT(kLengthIndex == length_offset());
   ASSERT((kSnapshotFlagIndex * sizeof(int32_t)) == kind_offset());
   ASSERT((kHeapObjectTag & kInlined));
-  // The kWatchedBit and kMarkBit are only set during GC operations. This
-  // allows the two low bits in the header to be used for snapshotting.
+  // The kWatchedBit is only set during GC operations and the kMarkBit only
+  // outlives them on pages left for lazy sweeping. This allows the two low
+  // bits in the header to be used for snapshotting.
   ASSERT(kObjectId ==
          ((1 << RawObject::kWatchedBit) | (1 << RawObject::kMarkBit)));
   ASSERT((kObjectAlignmentMask & kObjectId) == kObjectId);
@@ -162,7 +167,8 @@ SnapshotReader::SnapshotReader(const uint8_t* buffer,
       error_(UnhandledException::Handle()),
       backward_references_((kind == Snapshot::kFull) ?
                            kNumInitialReferencesInFullSnapshot :
-                           kNumInitialReferences) {
+                           kNumInitialReferences),
+      num_transfers_(0) {
 }
 
 
@@ -446,6 +452,7 @@ RawTokenStream* SnapshotReader::NewTokenStream(intptr_t len) {
       AllocateUninitialized(cls_, ExternalTypedData::InstanceSize()));
   data_.SetData(array);
   data_.SetLength(len);
+  data_.SetTransferHandle(NULL);
   stream_.SetStream(data_);
   return stream_.raw();
 }
@@ -735,6 +742,20 @@ RawObject* SnapshotReader::ReadVMIsolateObject(intptr_t header_value) {
   if (object_id == kFalseValue) {
     return Bool::False().raw();
   }
+  if (object_id == kSharedSymbolObject) {
+    ASSERT(kind_ != Snapshot::kFull);
+    intptr_t len = ReadIntptrValue();
+    const uint8_t* characters = CurrentBufferAddress();
+    // The symbol is shared by the isolates of this VM, unless a script
+    // snapshot is read by another one.
+    String& symbol = String::Handle(isolate(), Symbols::LookupShared(
+        characters, len, String::Hash(characters, len)));
+    if (symbol.IsNull()) {
+      symbol = Symbols::FromLatin1(characters, len);
+    }
+    Advance(len);
+    return symbol.raw();
+  }
   intptr_t class_id = ClassIdFromObjectId(object_id);
   if (IsSingletonClassId(class_id)) {
     return isolate()->class_table()->At(class_id);  // get singleton class.
@@ -892,8 +913,12 @@ SnapshotWriter::SnapshotWriter(Snapshot::Kind kind,
       object_store_(Isolate::Current()->object_store()),
       class_table_(Isolate::Current()->class_table()),
       forward_list_(),
+      paused_marker_(NULL),
+      paused_sweeper_(NULL),
       exception_type_(Exceptions::kNone),
-      exception_msg_(NULL) {
+      exception_msg_(NULL),
+      can_transfer_(false),
+      transfers_() {
 }
 
 
@@ -966,6 +991,22 @@ void SnapshotWriter::HandleVMIsolateObject(RawObject* rawobj) {
     return;
   }
 
+  // Check it is a symbol shared through the VM isolate, which is written by
+  // its characters. A full snapshot refers to the symbols of its isolate.
+  if (Symbols::IsSharedSymbol(rawobj)) {
+    if (kind_ == Snapshot::kFull) {
+      SetWriteException(Exceptions::kUnsupported,
+                        "Full snapshots cannot be written from an isolate "
+                        "sharing symbols (--share_snapshot_symbols)");
+    }
+    RawOneByteString* str = reinterpret_cast<RawOneByteString*>(rawobj);
+    intptr_t len = Smi::Value(str->ptr()->length_);
+    WriteVMIsolateObject(kSharedSymbolObject);
+    WriteIntptrValue(len);
+    WriteBytes(str->ptr()->data_, len);
+    return;
+  }
+
   UNREACHABLE();
 }
 
@@ -1118,6 +1159,21 @@ uword SnapshotWriter::GetObjectTags(RawObject* raw) {
 
 intptr_t SnapshotWriter::MarkObject(RawObject* raw, SerializeState state) {
   NoGCScope no_gc;
+  if (paused_marker_ == NULL) {
+    // The concurrent marker reads the headers overwritten below. It stays
+    // paused until they are restored by UnmarkAll.
+    paused_marker_ = Isolate::Current()->heap()->concurrent_marker();
+    if (paused_marker_ != NULL) {
+      paused_marker_->Pause();
+    }
+  }
+  if (paused_sweeper_ == NULL) {
+    // The concurrent sweeper also reads the headers.
+    paused_sweeper_ = Isolate::Current()->heap()->concurrent_sweeper();
+    if (paused_sweeper_ != NULL) {
+      paused_sweeper_->Pause();
+    }
+  }
   intptr_t object_id = forward_list_.length() + kMaxPredefinedObjectIds;
   ASSERT(object_id <= kMaxObjectId);
   uword value = 0;
@@ -1139,6 +1195,14 @@ void SnapshotWriter::UnmarkAll() {
     RawObject* raw = forward_list_[i]->raw();
     raw->ptr()->tags_ = forward_list_[i]->tags();  // Restore original tags.
   }
+  if (paused_marker_ != NULL) {
+    paused_marker_->Resume();
+    paused_marker_ = NULL;
+  }
+  if (paused_sweeper_ != NULL) {
+    paused_sweeper_->Resume();
+    paused_sweeper_ = NULL;
+  }
 }
 
 
@@ -1522,4 +1586,21 @@ void MessageWriter::WriteMessage(const Object& obj) {
 }
 
 
+void SnapshotWriter::AddTransfer(RawExternalTypedData* raw) {
+  ASSERT(can_transfer());
+  transfers_.Add(&ExternalTypedData::ZoneHandle(raw));
+}
+
+
+void MessageWriter::TransferTo(Message* message) {
+  for (intptr_t i = 0; i < transfers_.length(); i++) {
+    const ExternalTypedData& obj = *transfers_[i];
+    FinalizablePersistentHandle* handle = obj.transfer_handle();
+    message->AddTransfer(handle->peer(), handle->callback());
+    obj.Detach();
+  }
+  transfers_.Clear();
+}
+
+
 }  // namespace dart
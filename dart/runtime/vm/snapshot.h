@@ -23,11 +23,14 @@ class AbstractTypeArguments;
 class Array;
 class Class;
 class ClassTable;
+class ConcurrentMarker;
+class ConcurrentSweeper;
 class ExternalTypedData;
 class GrowableObjectArray;
 class Heap;
 class LanguageError;
 class Library;
+class Message;
 class Object;
 class ObjectStore;
 class RawAbstractTypeArguments;
@@ -39,6 +42,7 @@ class RawMixinAppType;
 class RawClass;
 class RawContext;
 class RawDouble;
+class RawExternalTypedData;
 class RawField;
 class RawClosureData;
 class RawRedirectionData;
@@ -126,6 +130,7 @@ class Snapshot {
     kFull = 0,  // Full snapshot of the current dart heap.
     kScript,    // A partial snapshot of only the application script.
     kMessage,   // A partial snapshot used only for isolate messaging.
+    kHeapImage,  // The pages of an isolate which read a full snapshot.
   };
 
   static const int kHeaderSize = 2 * sizeof(int32_t);
@@ -142,6 +147,7 @@ class Snapshot {
   bool IsMessageSnapshot() const { return kind_ == kMessage; }
   bool IsScriptSnapshot() const { return kind_ == kScript; }
   bool IsFullSnapshot() const { return kind_ == kFull; }
+  bool IsHeapImageSnapshot() const { return kind_ == kHeapImage; }
   uint8_t* Addr() { return reinterpret_cast<uint8_t*>(this); }
 
   static intptr_t length_offset() { return OFFSET_OF(Snapshot, length_); }
@@ -231,6 +237,11 @@ class SnapshotReader : public BaseReader {
   // Reads an object.
   RawObject* ReadObject();
 
+  // The number of external typed data objects transferred by a message which
+  // have been read so far. Their data is owned by the reading isolate.
+  intptr_t num_transfers() const { return num_transfers_; }
+  void AddTransfer() { num_transfers_++; }
+
   // Add object to backward references.
   void AddBackRef(intptr_t id, Object* obj, DeserializeState state);
 
@@ -331,6 +342,7 @@ class SnapshotReader : public BaseReader {
   ExternalTypedData& data_;  // Temporary stream data handle.
   UnhandledException& error_;  // Error handle.
   GrowableArray<BackRefNode*> backward_references_;
+  intptr_t num_transfers_;  // Transferred external typed data read so far.
 
   friend class ApiError;
   friend class Array;
@@ -471,6 +483,11 @@ class SnapshotWriter : public BaseWriter {
   }
   void ThrowException(Exceptions::ExceptionType type, const char* msg);
 
+  // Whether transferable external typed data is written by reference, to be
+  // moved into the message instead of being copied.
+  bool can_transfer() const { return can_transfer_; }
+  void AddTransfer(RawExternalTypedData* raw);
+
  protected:
   class ForwardObjectNode : public ZoneAllocated {
    public:
@@ -521,9 +538,14 @@ class SnapshotWriter : public BaseWriter {
   ObjectStore* object_store_;  // Object store for common classes.
   ClassTable* class_table_;  // Class table for the class index to class lookup.
   GrowableArray<ForwardObjectNode*> forward_list_;
+  ConcurrentMarker* paused_marker_;  // Paused while headers are overwritten.
+  ConcurrentSweeper* paused_sweeper_;  // Likewise.
   Exceptions::ExceptionType exception_type_;  // Exception type.
   const char* exception_msg_;  // Message associated with exception.
+  bool can_transfer_;
+  GrowableArray<const ExternalTypedData*> transfers_;
 
+  friend class MessageWriter;
   friend class RawArray;
   friend class RawClass;
   friend class RawClosureData;
@@ -581,15 +603,20 @@ class ScriptSnapshotWriter : public SnapshotWriter {
 class MessageWriter : public SnapshotWriter {
  public:
   static const intptr_t kInitialSize = 512;
-  MessageWriter(uint8_t** buffer, ReAlloc alloc)
+  MessageWriter(uint8_t** buffer, ReAlloc alloc, bool can_transfer = false)
       : SnapshotWriter(Snapshot::kMessage, buffer, alloc, kInitialSize) {
     ASSERT(buffer != NULL);
     ASSERT(alloc != NULL);
+    can_transfer_ = can_transfer;
   }
   ~MessageWriter() { }
 
   void WriteMessage(const Object& obj);
 
+  // Detaches the transferable external typed data written by reference from
+  // the sending isolate and hands their finalizers over to 'message'.
+  void TransferTo(Message* message);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(MessageWriter);
 };
@@ -35,6 +35,9 @@ enum {
   kStringType,
   kArrayType,
 
+  // A symbol shared through the VM isolate heap, written by its characters.
+  kSharedSymbolObject,
+
   kInstanceObjectId,
   kMaxPredefinedObjectIds,
   kInvalidIndex = -1,
@@ -4,12 +4,16 @@
 
 #include "include/dart_debugger_api.h"
 #include "platform/assert.h"
+#include "vm/benchmark_test.h"
 #include "vm/bigint_operations.h"
 #include "vm/class_finalizer.h"
 #include "vm/dart_api_impl.h"
 #include "vm/dart_api_message.h"
 #include "vm/dart_api_state.h"
 #include "vm/flags.h"
+#include "vm/heap_image.h"
+#include "vm/message.h"
+#include "vm/script_profile.h"
 #include "vm/snapshot.h"
 #include "vm/symbols.h"
 #include "vm/unicode.h"
@@ -18,6 +22,8 @@
 namespace dart {
 
 DECLARE_FLAG(bool, enable_type_checks);
+DECLARE_FLAG(int, optimization_counter_threshold);
+DECLARE_FLAG(bool, share_snapshot_symbols);
 
 // Check if serialized and deserialized objects are equal.
 static bool Equals(const Object& expected, const Object& actual) {
@@ -782,6 +788,72 @@ TEST_CASE(SerializeExternalTypedArray) {
 }
 
 
+static intptr_t transfer_finalizer_calls = 0;
+
+
+static void TransferFinalizer(Dart_WeakPersistentHandle handle, void* peer) {
+  free(peer);
+  if (handle != NULL) {
+    Dart_DeleteWeakPersistentHandle(handle);
+  }
+  transfer_finalizer_calls++;
+}
+
+
+static Message* TransferMessage(const ExternalTypedData& array) {
+  uint8_t* buffer = NULL;
+  MessageWriter writer(&buffer, &malloc_allocator, true);
+  writer.WriteMessage(array);
+  Message* message = new Message(Message::kIllegalPort, Message::kIllegalPort,
+                                 buffer, writer.BytesWritten(),
+                                 Message::kNormalPriority);
+  writer.TransferTo(message);
+  return message;
+}
+
+
+TEST_CASE(TransferExternalTypedArray) {
+  StackZone zone(Isolate::Current());
+  const intptr_t kLength = 1 * MB;
+  uint8_t* data = reinterpret_cast<uint8_t*>(malloc(kLength));
+  for (intptr_t i = 0; i < kLength; i++) {
+    data[i] = i & 0xff;
+  }
+  ExternalTypedData& array = ExternalTypedData::Handle(
+      ExternalTypedData::New(kExternalTypedDataUint8ArrayCid, data, kLength));
+  array.MakeTransferable(data, TransferFinalizer);
+  Message* message = TransferMessage(array);
+  // Only a reference to the data is written, which the sender gives up.
+  EXPECT_LT(message->len(), 64);
+  EXPECT_EQ(1, message->num_transfers());
+  EXPECT_EQ(0, array.Length());
+  EXPECT(!array.IsTransferable());
+
+  // The receiver adopts the data without copying it.
+  SnapshotReader reader(message->data(), message->len(),
+                        Snapshot::kMessage, Isolate::Current());
+  ExternalTypedData& received = ExternalTypedData::Handle();
+  received ^= reader.ReadObject();
+  message->AdoptTransfers();
+  delete message;
+  EXPECT_EQ(kLength, received.Length());
+  EXPECT_EQ(data, reinterpret_cast<uint8_t*>(received.DataAddr(0)));
+  EXPECT_EQ(0, transfer_finalizer_calls);
+  received ^= Object::null();
+  Isolate::Current()->heap()->CollectAllGarbage();
+  EXPECT_EQ(1, transfer_finalizer_calls);
+
+  // The data of a message which is never delivered is finalized with the
+  // message.
+  data = reinterpret_cast<uint8_t*>(malloc(kLength));
+  array ^= ExternalTypedData::New(kExternalTypedDataUint8ArrayCid,
+                                  data, kLength);
+  array.MakeTransferable(data, TransferFinalizer);
+  delete TransferMessage(array);
+  EXPECT_EQ(2, transfer_finalizer_calls);
+}
+
+
 TEST_CASE(SerializeEmptyByteArray) {
   StackZone zone(Isolate::Current());
 
@@ -1424,6 +1496,147 @@ UNIT_TEST_CASE(ScriptSnapshot2) {
 }
 
 
+static intptr_t UsageCounter(Dart_Handle lib, const char* name) {
+  const Library& library = Library::CheckedHandle(Api::UnwrapHandle(lib));
+  const Function& func = Function::Handle(
+      library.LookupLocalFunction(String::Handle(Symbols::New(name))));
+  EXPECT(!func.IsNull());
+  return func.usage_counter();
+}
+
+
+UNIT_TEST_CASE(ScriptSnapshotProfile) {
+  const char* kScriptChars =
+      "hot(i) {"
+      "  return i + 1;"
+      "}"
+      "cold() {"
+      "  return 0;"
+      "}"
+      "unused() {"
+      "  return 0;"
+      "}"
+      "main() {"
+      "  var sum = cold();"
+      "  for (var i = 0; i < 1000; i++) {"
+      "    sum = hot(sum);"
+      "  }"
+      "  return sum;"
+      "}";
+  Dart_Handle result;
+
+  uint8_t* buffer;
+  intptr_t size;
+  uint8_t* full_snapshot = NULL;
+  uint8_t* profile = NULL;
+  intptr_t profile_size = 0;
+  uint8_t* script_snapshot = NULL;
+
+  int saved_threshold = FLAG_optimization_counter_threshold;
+  int saved_warmup = FLAG_script_profile_warmup;
+  FLAG_optimization_counter_threshold = 100;
+  FLAG_script_profile_warmup = 10;
+
+  {
+    // Start an Isolate, and create a full snapshot of it.
+    TestIsolateScope __test_isolate__;
+    Dart_EnterScope();  // Start a Dart API scope for invoking API functions.
+
+    // Write out the script snapshot.
+    result = Dart_CreateSnapshot(&buffer, &size);
+    EXPECT_VALID(result);
+    full_snapshot = reinterpret_cast<uint8_t*>(malloc(size));
+    memmove(full_snapshot, buffer, size);
+    Dart_ExitScope();
+  }
+
+  {
+    // Create an Isolate using the full snapshot, run a script in it and
+    // create a profile of the run.
+    TestCase::CreateTestIsolateFromSnapshot(full_snapshot);
+    Dart_EnterScope();  // Start a Dart API scope for invoking API functions.
+    Dart_Handle lib = TestCase::LoadTestScript(kScriptChars, NULL);
+    EXPECT_VALID(lib);
+    result = Dart_Invoke(lib, NewString("main"), 0, NULL);
+    EXPECT_VALID(result);
+    result = Dart_CreateScriptProfile(&buffer, &profile_size);
+    EXPECT_VALID(result);
+    profile = reinterpret_cast<uint8_t*>(malloc(profile_size));
+    memmove(profile, buffer, profile_size);
+    Dart_ExitScope();
+    Dart_ShutdownIsolate();
+  }
+
+  {
+    // Load the same script in a fresh Isolate, apply the profile and create
+    // a script snapshot of the script.
+    TestCase::CreateTestIsolateFromSnapshot(full_snapshot);
+    Dart_EnterScope();  // Start a Dart API scope for invoking API functions.
+    Dart_Handle lib = TestCase::LoadTestScript(kScriptChars, NULL);
+    EXPECT_VALID(lib);
+    EXPECT_VALID(Api::CheckIsolateState(Isolate::Current()));
+    result = Dart_ApplyScriptProfile(profile, profile_size);
+    EXPECT_VALID(result);
+    result = Dart_CreateScriptSnapshot(&buffer, &size);
+    EXPECT_VALID(result);
+    script_snapshot = reinterpret_cast<uint8_t*>(malloc(size));
+    memmove(script_snapshot, buffer, size);
+    Dart_ExitScope();
+    Dart_ShutdownIsolate();
+  }
+
+  {
+    // Load the script snapshot, whose functions start with the counters of
+    // the training run, hot ones being a warmup short of being optimized.
+    TestCase::CreateTestIsolateFromSnapshot(full_snapshot);
+    Dart_EnterScope();  // Start a Dart API scope for invoking API functions.
+    Dart_Handle lib = Dart_LoadScriptFromSnapshot(script_snapshot, size);
+    EXPECT_VALID(lib);
+    EXPECT_EQ(90, UsageCounter(lib, "hot"));
+    EXPECT_EQ(1, UsageCounter(lib, "cold"));
+    EXPECT_EQ(0, UsageCounter(lib, "unused"));
+    result = Dart_Invoke(lib, NewString("main"), 0, NULL);
+    EXPECT_VALID(result);
+    int64_t value = 0;
+    EXPECT_VALID(Dart_IntegerToInt64(result, &value));
+    EXPECT_EQ(1000, value);
+    Dart_ExitScope();
+  }
+  Dart_ShutdownIsolate();
+  FLAG_optimization_counter_threshold = saved_threshold;
+  FLAG_script_profile_warmup = saved_warmup;
+  free(full_snapshot);
+  free(profile);
+  free(script_snapshot);
+}
+
+
+//
+// Measure the creation of an isolate from the heap image of the core
+// snapshot. Run with --heap_image_tasks to measure pages being copied and
+// relocated in parallel.
+//
+BENCHMARK(HeapImageSnapshotLoad) {
+  const int kNumIterations = 100;
+  bool saved_clone_isolate_heap = FLAG_clone_isolate_heap;
+  Dart_Isolate base_isolate = Dart_CurrentIsolate();
+  FLAG_clone_isolate_heap = true;
+  // Capture the image outside of the timed loop.
+  TestCase::CreateTestIsolate();
+  Dart_ShutdownIsolate();
+  Timer timer(true, "Heap image snapshot load benchmark");
+  timer.Start();
+  for (int i = 0; i < kNumIterations; i++) {
+    TestCase::CreateTestIsolate();
+    Dart_ShutdownIsolate();
+  }
+  timer.Stop();
+  FLAG_clone_isolate_heap = saved_clone_isolate_heap;
+  Dart_EnterIsolate(base_isolate);
+  benchmark->set_score(timer.TotalElapsedTime() / kNumIterations);
+}
+
+
 TEST_CASE(IntArrayMessage) {
   StackZone zone(Isolate::Current());
   uint8_t* buffer = NULL;
@@ -2693,4 +2906,51 @@ UNIT_TEST_CASE(PostCObject) {
   Dart_ExitScope();
 }
 
+
+UNIT_TEST_CASE(ShareSnapshotSymbols) {
+  if (bin::snapshot_buffer == NULL) {
+    return;
+  }
+  bool saved_share_snapshot_symbols = FLAG_share_snapshot_symbols;
+  FLAG_share_snapshot_symbols = true;
+  // The first isolate created from the snapshot promotes its symbols to the
+  // VM isolate heap, the next one refers to them.
+  RawString* shared = String::null();
+  for (intptr_t i = 0; i < 2; i++) {
+    TestCase::CreateTestIsolate();
+    Isolate* isolate = Isolate::Current();
+    EXPECT_LT(0, Symbols::NumSharedSymbols());
+    {
+      StackZone zone(isolate);
+      HandleScope scope(isolate);
+      const String& name = String::Handle(Symbols::New("StringBuffer"));
+      EXPECT(name.InVMHeap());
+      if (i == 0) {
+        shared = name.raw();
+      } else {
+        EXPECT(name.raw() == shared);
+      }
+
+      // Messages refer to the shared symbol.
+      uint8_t* buffer;
+      MessageWriter writer(&buffer, &zone_allocator);
+      writer.WriteMessage(name);
+      intptr_t buffer_len = writer.BytesWritten();
+      SnapshotReader reader(buffer, buffer_len, Snapshot::kMessage, isolate);
+      EXPECT(reader.ReadObject() == name.raw());
+      ApiNativeScope api_scope;
+      ApiMessageReader api_reader(buffer, buffer_len, &zone_allocator);
+      Dart_CObject* root = api_reader.ReadMessage();
+      EXPECT_EQ(Dart_CObject_kString, root->type);
+      EXPECT_STREQ("StringBuffer", root->value.as_string);
+
+      isolate->heap()->CollectAllGarbage();
+      EXPECT(isolate->heap()->Verify());
+      EXPECT(name.raw() == Symbols::New("StringBuffer"));
+    }
+    Dart_ShutdownIsolate();
+  }
+  FLAG_share_snapshot_symbols = saved_share_snapshot_symbols;
+}
+
 }  // namespace dart
@@ -24,6 +24,7 @@ class StoreBufferBlock {
   void Reset() { top_ = 0; }
 
   StoreBufferBlock* next() const { return next_; }
+  void set_next(StoreBufferBlock* next) { next_ = next; }
 
   intptr_t Count() const { return top_; }
 
@@ -78,6 +79,9 @@ class StoreBuffer {
     }
   }
 
+  // Returns the blocks without taking them out of the store buffer.
+  StoreBufferBlock* PeekBlocks() const { return blocks_; }
+
   StoreBufferBlock* Blocks() {
     StoreBufferBlock* result = blocks_;
     blocks_ = new StoreBufferBlock(NULL);
@@ -100,6 +100,13 @@ RawCode* StubCode::GetAllocationStubForClass(const Class& cls) {
   const Error& error = Error::Handle(isolate, cls.EnsureIsFinalized(isolate));
   ASSERT(error.IsNull());
   Code& stub = Code::Handle(isolate, cls.allocation_stub());
+  if (!stub.IsNull() &&
+      isolate->class_table()->TakeStaleAllocationStub(cls.id())) {
+    // The class is pretenured now, code compiled from now on uses a new stub
+    // allocating in the old space.
+    cls.DisableAllocationStub();
+    stub = Code::null();
+  }
   if (stub.IsNull()) {
     Assembler assembler;
     const char* name = cls.ToCString();
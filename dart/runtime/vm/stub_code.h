@@ -50,12 +50,23 @@ class RawCode;
 // using Smi 0 instead of Object::null() is slightly more efficient, since a Smi
 // does not require relocation.
 
+// The write barrier for concurrent marking is only emitted on ia32 and x64,
+// see ConcurrentMarker::IsSupported.
+#if defined(TARGET_ARCH_IA32) || defined(TARGET_ARCH_X64)
+#define MARKING_STUB_CODE_LIST(V)                                              \
+  V(UpdateMarkingBuffer)                                                       \
+
+#else
+#define MARKING_STUB_CODE_LIST(V)
+#endif
+
 // List of stubs created per isolate, these stubs could potentially contain
 // embedded objects and hence cannot be shared across isolates.
 #define STUB_CODE_LIST(V)                                                      \
   V(InvokeDartCode)                                                            \
   V(AllocateContext)                                                           \
   V(UpdateStoreBuffer)                                                         \
+  MARKING_STUB_CODE_LIST(V)                                                    \
   V(OneArgCheckInlineCache)                                                    \
   V(TwoArgsCheckInlineCache)                                                   \
   V(ThreeArgsCheckInlineCache)                                                 \
@@ -25,6 +25,8 @@ namespace dart {
 DEFINE_FLAG(bool, inline_alloc, true, "Inline allocation of objects.");
 DEFINE_FLAG(bool, use_slow_path, false,
     "Set to true for debugging & verifying the slow paths.");
+DECLARE_FLAG(bool, concurrent_mark);
+DECLARE_FLAG(bool, concurrent_sweep);
 DECLARE_FLAG(int, optimization_counter_threshold);
 DECLARE_FLAG(bool, trace_optimized_ic_calls);
 
@@ -1018,26 +1020,53 @@ DECLARE_LEAF_RUNTIME_ENTRY(void, StoreBufferBlockProcess, Isolate* isolate);
 // Helper stub to implement Assembler::StoreIntoObject.
 // Input parameters:
 //   EAX: Address being stored
+//   Stack: the updated slot, above the return address
 void StubCode::GenerateUpdateStoreBufferStub(Assembler* assembler) {
   // Save values being destroyed.
   __ pushl(EDX);
   __ pushl(ECX);
 
-  Label add_to_buffer;
-  // Check whether this object has already been remembered. Skip adding to the
-  // store buffer if the object is in the store buffer already.
+  Label add_to_buffer, mark_card;
+  // Check whether the stores into this object are remembered in the card
+  // table of its large page.
   // Spilled: EDX, ECX
   // EAX: Address being stored
   __ movl(ECX, FieldAddress(EAX, Object::tags_offset()));
+  __ testl(ECX, Immediate(1 << RawObject::kCardRememberedBit));
+  __ j(NOT_ZERO, &mark_card, Assembler::kNearJump);
+
+  // Check whether this object has already been remembered. Skip adding to the
+  // store buffer if the object is in the store buffer already.
   __ testl(ECX, Immediate(1 << RawObject::kRememberedBit));
   __ j(EQUAL, &add_to_buffer, Assembler::kNearJump);
   __ popl(ECX);
   __ popl(EDX);
   __ ret();
 
+  // Dirty the card of the updated slot, passed above the return address. A
+  // card remembered array is the only object of its large page.
+  __ Bind(&mark_card);
+  __ leal(ECX, FieldAddress(EAX, -HeapPage::ObjectStartOffset()));
+  __ movl(EDX, Address(ESP, 3 * kWordSize));
+  __ subl(EDX, ECX);
+  __ shrl(EDX, Immediate(HeapPage::kCardSizeLog2));
+  __ movl(ECX, Address(ECX, HeapPage::card_table_offset()));
+  __ movb(Address(ECX, EDX, TIMES_1, 0), Immediate(1));
+  __ popl(ECX);
+  __ popl(EDX);
+  __ ret();
+
   __ Bind(&add_to_buffer);
-  __ orl(ECX, Immediate(1 << RawObject::kRememberedBit));
-  __ movl(FieldAddress(EAX, Object::tags_offset()), ECX);
+  if (FLAG_concurrent_sweep || FLAG_concurrent_mark) {
+    // The concurrent sweeper or marker may be updating the mark bit of this
+    // object.
+    __ lock();
+    __ orl(FieldAddress(EAX, Object::tags_offset()),
+           Immediate(1 << RawObject::kRememberedBit));
+  } else {
+    __ orl(ECX, Immediate(1 << RawObject::kRememberedBit));
+    __ movl(FieldAddress(EAX, Object::tags_offset()), ECX);
+  }
 
   // Load the isolate out of the context.
   // Spilled: EDX, ECX
@@ -1082,6 +1111,72 @@ void StubCode::GenerateUpdateStoreBufferStub(Assembler* assembler) {
 }
 
 
+DECLARE_LEAF_RUNTIME_ENTRY(void, MarkingBufferBlockProcess, Isolate* isolate);
+
+// Helper stub to implement the concurrent marking part of
+// Assembler::StoreIntoObject, see --concurrent_mark.
+// Input parameters:
+//   EAX: Old object being stored
+void StubCode::GenerateUpdateMarkingBufferStub(Assembler* assembler) {
+  // Save values being destroyed.
+  __ pushl(EDX);
+  __ pushl(ECX);
+
+  // Skip adding to the marking buffer if no concurrent marking is in progress
+  // or if the object has already been marked.
+  // Spilled: EDX, ECX
+  // EAX: Address being stored
+  Label add_to_buffer, skip;
+  __ movl(EDX, FieldAddress(CTX, Context::isolate_offset()));
+  __ cmpl(Address(EDX, Isolate::concurrent_marking_offset()), Immediate(0));
+  __ j(EQUAL, &skip, Assembler::kNearJump);
+  __ movl(ECX, FieldAddress(EAX, Object::tags_offset()));
+  __ testl(ECX, Immediate(1 << RawObject::kMarkBit));
+  __ j(ZERO, &add_to_buffer, Assembler::kNearJump);
+  __ Bind(&skip);
+  __ popl(ECX);
+  __ popl(EDX);
+  __ ret();
+
+  // Load the marking buffer block out of the isolate. Then load top_ out of
+  // the StoreBufferBlock and add the address to the pointers_.
+  // Spilled: EDX, ECX
+  // EAX: Address being stored
+  // EDX: Isolate
+  __ Bind(&add_to_buffer);
+  __ movl(EDX, Address(EDX, Isolate::marking_buffer_offset()));
+  __ movl(ECX, Address(EDX, StoreBufferBlock::top_offset()));
+  __ movl(Address(EDX, ECX, TIMES_4, StoreBufferBlock::pointers_offset()), EAX);
+
+  // Increment top_ and check for overflow.
+  // Spilled: EDX, ECX
+  // ECX: top_
+  // EDX: StoreBufferBlock
+  Label L;
+  __ incl(ECX);
+  __ movl(Address(EDX, StoreBufferBlock::top_offset()), ECX);
+  __ cmpl(ECX, Immediate(StoreBufferBlock::kSize));
+  // Restore values.
+  // Spilled: EDX, ECX
+  __ popl(ECX);
+  __ popl(EDX);
+  __ j(EQUAL, &L, Assembler::kNearJump);
+  __ ret();
+
+  // Handle overflow: Hand the block to the concurrent marker.
+  __ Bind(&L);
+  // Setup frame, push callee-saved registers.
+
+  __ EnterCallRuntimeFrame(1 * kWordSize);
+  __ movl(EAX, FieldAddress(CTX, Context::isolate_offset()));
+  __ movl(Address(ESP, 0), EAX);  // Push the isolate as the only argument.
+  __ CallRuntime(kMarkingBufferBlockProcessRuntimeEntry, 1);
+  // Restore callee-saved registers, tear down frame.
+  __ LeaveCallRuntimeFrame();
+  __ ret();
+}
+
+
 // Called for inline allocation of objects.
 // Input parameters:
 //   ESP + 8 : type arguments object (only if class is parameterized).
@@ -1108,8 +1203,17 @@ void StubCode::GenerateAllocationStubForClass(Assembler* assembler,
   if (FLAG_inline_alloc &&
       Heap::IsAllocatableInNewSpace(instance_size + type_args_size)) {
     Label slow_case;
-    Heap* heap = Isolate::Current()->heap();
-    __ movl(EAX, Address::Absolute(heap->TopAddress()));
+    Isolate* isolate = Isolate::Current();
+    Heap* heap = isolate->heap();
+    // The instances of classes found to survive scavenges are bump allocated
+    // in the old space, see --pretenure. Their fields are initialized to null,
+    // which needs no store barrier. The type arguments of a parameterized
+    // class may be new objects.
+    const Heap::Space space =
+        (!is_cls_parameterized &&
+         isolate->class_table()->ShouldPretenure(cls.id())) ?
+            Heap::kOld : Heap::kNew;
+    __ movl(EAX, Address::Absolute(heap->TopAddress(space)));
     __ leal(EBX, Address(EAX, instance_size));
     if (is_cls_parameterized) {
       __ movl(ECX, EBX);
@@ -1127,7 +1231,7 @@ void StubCode::GenerateAllocationStubForClass(Assembler* assembler,
     // Check if the allocation fits into the remaining space.
     // EAX: potential new object start.
     // EBX: potential next object start.
-    __ cmpl(EBX, Address::Absolute(heap->EndAddress()));
+    __ cmpl(EBX, Address::Absolute(heap->EndAddress(space)));
     if (FLAG_use_slow_path) {
       __ jmp(&slow_case);
     } else {
@@ -1136,7 +1240,7 @@ void StubCode::GenerateAllocationStubForClass(Assembler* assembler,
 
     // Successfully allocated the object(s), now update top to point to
     // next object start and initialize the object.
-    __ movl(Address::Absolute(heap->TopAddress()), EBX);
+    __ movl(Address::Absolute(heap->TopAddress(space)), EBX);
 
     if (is_cls_parameterized) {
       // Initialize the type arguments field in the object.
@@ -25,6 +25,8 @@ namespace dart {
 DEFINE_FLAG(bool, inline_alloc, true, "Inline allocation of objects.");
 DEFINE_FLAG(bool, use_slow_path, false,
     "Set to true for debugging & verifying the slow paths.");
+DECLARE_FLAG(bool, concurrent_mark);
+DECLARE_FLAG(bool, concurrent_sweep);
 DECLARE_FLAG(int, optimization_counter_threshold);
 DECLARE_FLAG(bool, trace_optimized_ic_calls);
 
@@ -1021,26 +1023,53 @@ DECLARE_LEAF_RUNTIME_ENTRY(void, StoreBufferBlockProcess, Isolate* isolate);
 // Helper stub to implement Assembler::StoreIntoObject.
 // Input parameters:
 //   RAX: Address being stored
+//   Stack: the updated slot, above the return address
 void StubCode::GenerateUpdateStoreBufferStub(Assembler* assembler) {
   // Save registers being destroyed.
   __ pushq(RDX);
   __ pushq(RCX);
 
-  Label add_to_buffer;
-  // Check whether this object has already been remembered. Skip adding to the
-  // store buffer if the object is in the store buffer already.
+  Label add_to_buffer, mark_card;
+  // Check whether the stores into this object are remembered in the card
+  // table of its large page.
   // Spilled: RDX, RCX
   // RAX: Address being stored
   __ movq(RCX, FieldAddress(RAX, Object::tags_offset()));
+  __ testq(RCX, Immediate(1 << RawObject::kCardRememberedBit));
+  __ j(NOT_ZERO, &mark_card, Assembler::kNearJump);
+
+  // Check whether this object has already been remembered. Skip adding to the
+  // store buffer if the object is in the store buffer already.
   __ testq(RCX, Immediate(1 << RawObject::kRememberedBit));
   __ j(EQUAL, &add_to_buffer, Assembler::kNearJump);
   __ popq(RCX);
   __ popq(RDX);
   __ ret();
 
+  // Dirty the card of the updated slot, passed above the return address. A
+  // card remembered array is the only object of its large page.
+  __ Bind(&mark_card);
+  __ leaq(RCX, FieldAddress(RAX, -HeapPage::ObjectStartOffset()));
+  __ movq(RDX, Address(RSP, 3 * kWordSize));
+  __ subq(RDX, RCX);
+  __ shrq(RDX, Immediate(HeapPage::kCardSizeLog2));
+  __ movq(RCX, Address(RCX, HeapPage::card_table_offset()));
+  __ movb(Address(RCX, RDX, TIMES_1, 0), Immediate(1));
+  __ popq(RCX);
+  __ popq(RDX);
+  __ ret();
+
   __ Bind(&add_to_buffer);
-  __ orq(RCX, Immediate(1 << RawObject::kRememberedBit));
-  __ movq(FieldAddress(RAX, Object::tags_offset()), RCX);
+  if (FLAG_concurrent_sweep || FLAG_concurrent_mark) {
+    // The concurrent sweeper or marker may be updating the mark bit of this
+    // object.
+    __ lock();
+    __ orq(FieldAddress(RAX, Object::tags_offset()),
+           Immediate(1 << RawObject::kRememberedBit));
+  } else {
+    __ orq(RCX, Immediate(1 << RawObject::kRememberedBit));
+    __ movq(FieldAddress(RAX, Object::tags_offset()), RCX);
+  }
 
   // Load the isolate out of the context.
   // RAX: Address being stored
@@ -1078,6 +1107,66 @@ void StubCode::GenerateUpdateStoreBufferStub(Assembler* assembler) {
 }
 
 
+DECLARE_LEAF_RUNTIME_ENTRY(void, MarkingBufferBlockProcess, Isolate* isolate);
+
+// Helper stub to implement the concurrent marking part of
+// Assembler::StoreIntoObject, see --concurrent_mark.
+// Input parameters:
+//   RAX: Old object being stored
+void StubCode::GenerateUpdateMarkingBufferStub(Assembler* assembler) {
+  // Save registers being destroyed.
+  __ pushq(RDX);
+  __ pushq(RCX);
+
+  // Skip adding to the marking buffer if no concurrent marking is in progress
+  // or if the object has already been marked.
+  // Spilled: RDX, RCX
+  // RAX: Address being stored
+  Label add_to_buffer, skip;
+  __ movq(RDX, FieldAddress(CTX, Context::isolate_offset()));
+  __ cmpq(Address(RDX, Isolate::concurrent_marking_offset()), Immediate(0));
+  __ j(EQUAL, &skip, Assembler::kNearJump);
+  __ movq(RCX, FieldAddress(RAX, Object::tags_offset()));
+  __ testq(RCX, Immediate(1 << RawObject::kMarkBit));
+  __ j(ZERO, &add_to_buffer, Assembler::kNearJump);
+  __ Bind(&skip);
+  __ popq(RCX);
+  __ popq(RDX);
+  __ ret();
+
+  // Load the marking buffer block out of the isolate. Then load top_ out of
+  // the StoreBufferBlock and add the address to the pointers_.
+  // RAX: Address being stored
+  // RDX: Isolate
+  __ Bind(&add_to_buffer);
+  __ movq(RDX, Address(RDX, Isolate::marking_buffer_offset()));
+  __ movl(RCX, Address(RDX, StoreBufferBlock::top_offset()));
+  __ movq(Address(RDX, RCX, TIMES_8, StoreBufferBlock::pointers_offset()), RAX);
+
+  // Increment top_ and check for overflow.
+  // RCX: top_
+  // RDX: StoreBufferBlock
+  Label L;
+  __ incq(RCX);
+  __ movl(Address(RDX, StoreBufferBlock::top_offset()), RCX);
+  __ cmpl(RCX, Immediate(StoreBufferBlock::kSize));
+  // Restore values.
+  __ popq(RCX);
+  __ popq(RDX);
+  __ j(EQUAL, &L, Assembler::kNearJump);
+  __ ret();
+
+  // Handle overflow: Hand the block to the concurrent marker.
+  __ Bind(&L);
+  // Setup frame, push callee-saved registers.
+  __ EnterCallRuntimeFrame(0);
+  __ movq(RDI, FieldAddress(CTX, Context::isolate_offset()));
+  __ CallRuntime(kMarkingBufferBlockProcessRuntimeEntry, 1);
+  __ LeaveCallRuntimeFrame();
+  __ ret();
+}
+
+
 // Called for inline allocation of objects.
 // Input parameters:
 //   RSP + 16 : type arguments object (only if class is parameterized).
@@ -1102,8 +1191,17 @@ void StubCode::GenerateAllocationStubForClass(Assembler* assembler,
   if (FLAG_inline_alloc &&
       Heap::IsAllocatableInNewSpace(instance_size + type_args_size)) {
     Label slow_case;
-    Heap* heap = Isolate::Current()->heap();
-    __ movq(RAX, Immediate(heap->TopAddress()));
+    Isolate* isolate = Isolate::Current();
+    Heap* heap = isolate->heap();
+    // The instances of classes found to survive scavenges are bump allocated
+    // in the old space, see --pretenure. Their fields are initialized to null,
+    // which needs no store barrier. The type arguments of a parameterized
+    // class may be new objects.
+    const Heap::Space space =
+        (!is_cls_parameterized &&
+         isolate->class_table()->ShouldPretenure(cls.id())) ?
+            Heap::kOld : Heap::kNew;
+    __ movq(RAX, Immediate(heap->TopAddress(space)));
     __ movq(RAX, Address(RAX, 0));
     __ leaq(RBX, Address(RAX, instance_size));
     if (is_cls_parameterized) {
@@ -1122,7 +1220,7 @@ void StubCode::GenerateAllocationStubForClass(Assembler* assembler,
     // Check if the allocation fits into the remaining space.
     // RAX: potential new object start.
     // RBX: potential next object start.
-    __ movq(RDI, Immediate(heap->EndAddress()));
+    __ movq(RDI, Immediate(heap->EndAddress(space)));
     __ cmpq(RBX, Address(RDI, 0));
     if (FLAG_use_slow_path) {
       __ jmp(&slow_case);
@@ -1132,7 +1230,7 @@ void StubCode::GenerateAllocationStubForClass(Assembler* assembler,
 
     // Successfully allocated the object(s), now update top to point to
     // next object start and initialize the object.
-    __ movq(RDI, Immediate(heap->TopAddress()));
+    __ movq(RDI, Immediate(heap->TopAddress(space)));
     __ movq(Address(RDI, 0), RBX);
 
     if (is_cls_parameterized) {
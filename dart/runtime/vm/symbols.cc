@@ -6,11 +6,13 @@
 
 #include "vm/handles.h"
 #include "vm/handles_impl.h"
+#include "vm/heap.h"
 #include "vm/isolate.h"
 #include "vm/object.h"
 #include "vm/object_store.h"
 #include "vm/raw_object.h"
 #include "vm/snapshot_ids.h"
+#include "vm/thread.h"
 #include "vm/unicode.h"
 #include "vm/visitor.h"
 
@@ -39,6 +41,39 @@ intptr_t Symbols::num_of_grows_;
 intptr_t Symbols::collision_count_[kMaxCollisionBuckets];
 
 DEFINE_FLAG(bool, dump_symbol_stats, false, "Dump symbol table statistics");
+DEFINE_FLAG(bool, share_snapshot_symbols, false,
+            "Allocate the one byte symbols of a full snapshot in the VM "
+            "isolate heap, shared by all isolates created from it.");
+
+
+// Open addressing hash table of the shared symbols, whose capacity is a power
+// of two.
+struct SharedSymbolTable {
+  intptr_t capacity;
+  intptr_t used;
+  RawString* symbols[1];
+};
+
+
+// A full snapshot whose symbols were promoted.
+struct SharedSnapshot {
+  const uint8_t* snapshot;
+  SharedSnapshot* next;
+};
+
+
+static const intptr_t kInitialSharedTableCapacity = 4096;
+
+// Held by the isolate promoting the symbols of a snapshot.
+static Mutex* shared_mutex = NULL;
+// The table looked up by all isolates, which is only replaced and never
+// modified once published.
+static SharedSymbolTable* shared_table = NULL;
+// The copy of the table the promoting isolate adds symbols to.
+static SharedSymbolTable* promoted_table = NULL;
+static Isolate* promoting_isolate = NULL;
+static const uint8_t* promoted_snapshot = NULL;
+static SharedSnapshot* shared_snapshots = NULL;
 
 
 const char* Symbols::Name(SymbolId symbol) {
@@ -68,6 +103,9 @@ void Symbols::InitOnce(Isolate* isolate) {
     }
   }
 
+  ASSERT(shared_mutex == NULL);
+  shared_mutex = new Mutex();
+
   // Create and setup a symbol table in the vm isolate.
   SetupSymbolTable(isolate);
 
@@ -321,6 +359,7 @@ void Symbols::DumpStats() {
     used ^= symbol_table.At(table_size);
     OS::Print("Isolate: Number of symbols : %" Pd "\n", used.Value());
     OS::Print("Isolate: Symbol table capacity : %" Pd "\n", table_size);
+    OS::Print("Number of shared symbols : %" Pd "\n", NumSharedSymbols());
 
     // Dump overall collision and growth counts.
     OS::Print("Number of symbol table grows = %" Pd "\n", num_of_grows_);
@@ -479,4 +518,199 @@ RawObject* Symbols::GetVMSymbol(intptr_t object_id) {
   return Object::null();
 }
 
+
+static SharedSymbolTable* NewSharedTable(intptr_t capacity) {
+  ASSERT(Utils::IsPowerOfTwo(capacity));
+  const intptr_t size = sizeof(SharedSymbolTable) +
+      ((capacity - 1) * sizeof(RawString*));  // NOLINT
+  SharedSymbolTable* table =
+      reinterpret_cast<SharedSymbolTable*>(calloc(1, size));
+  table->capacity = capacity;
+  table->used = 0;
+  return table;
+}
+
+
+void Symbols::CopySharedTable(const SharedSymbolTable* from,
+                              SharedSymbolTable* to) {
+  const intptr_t mask = to->capacity - 1;
+  for (intptr_t i = 0; i < from->capacity; i++) {
+    RawOneByteString* symbol =
+        reinterpret_cast<RawOneByteString*>(from->symbols[i]);
+    if (symbol != NULL) {
+      intptr_t index = Smi::Value(symbol->ptr()->hash_) & mask;
+      while (to->symbols[index] != NULL) {
+        index = (index + 1) & mask;
+      }
+      to->symbols[index] = symbol;
+      to->used++;
+    }
+  }
+}
+
+
+intptr_t Symbols::FindSharedIndex(const SharedSymbolTable* table,
+                                  const uint8_t* characters,
+                                  intptr_t len,
+                                  intptr_t hash) {
+  const intptr_t mask = table->capacity - 1;
+  intptr_t index = hash & mask;
+  RawString* symbol = table->symbols[index];
+  while (symbol != NULL) {
+    RawOneByteString* str = reinterpret_cast<RawOneByteString*>(symbol);
+    if ((Smi::Value(str->ptr()->hash_) == hash) &&
+        (Smi::Value(str->ptr()->length_) == len) &&
+        (memcmp(str->ptr()->data_, characters, len) == 0)) {
+      break;
+    }
+    index = (index + 1) & mask;  // Move to next element.
+    symbol = table->symbols[index];
+  }
+  return index;  // Index of symbol if found or slot into which to add symbol.
+}
+
+
+RawString* Symbols::AllocateShared(const uint8_t* characters,
+                                   intptr_t len,
+                                   intptr_t hash) {
+  const intptr_t size = OneByteString::InstanceSize(len);
+  uword address = Dart::vm_isolate()->heap()->TryAllocate(
+      size, Heap::kOld, PageSpace::kForceGrowth);
+  if (address == 0) {
+    return String::null();
+  }
+  RawOneByteString* symbol =
+      reinterpret_cast<RawOneByteString*>(address + kHeapObjectTag);
+  // Like the other objects of the VM isolate the symbol is premarked, so
+  // that it is neither visited nor collected by the GC of any isolate.
+  uword tags = 0;
+  tags = RawObject::ClassIdTag::update(kOneByteStringCid, tags);
+  tags = RawObject::SizeTag::update(size, tags);
+  tags = RawObject::MarkBit::update(true, tags);
+  tags = RawObject::CanonicalObjectTag::update(true, tags);
+  symbol->ptr()->tags_ = tags;
+  symbol->ptr()->length_ = Smi::New(len);
+  symbol->ptr()->hash_ = Smi::New(hash);
+  memmove(symbol->ptr()->data_, characters, len);
+  return symbol;
+}
+
+
+void Symbols::BeginSharing(const uint8_t* snapshot) {
+  shared_mutex->Lock();
+  for (SharedSnapshot* shared = shared_snapshots;
+       shared != NULL;
+       shared = shared->next) {
+    if (shared->snapshot == snapshot) {
+      // Only look up the symbols promoted by the first reader.
+      shared_mutex->Unlock();
+      return;
+    }
+  }
+  // The lock is held until the snapshot is read, so that the isolates which
+  // are created from it meanwhile wait for its symbols.
+  ASSERT(promoting_isolate == NULL);
+  promoting_isolate = Isolate::Current();
+  promoted_snapshot = snapshot;
+  intptr_t capacity = kInitialSharedTableCapacity;
+  if (shared_table != NULL) {
+    capacity = shared_table->capacity;
+  }
+  promoted_table = NewSharedTable(capacity);
+  if (shared_table != NULL) {
+    CopySharedTable(shared_table, promoted_table);
+  }
+  Dart::vm_isolate()->heap()->WriteProtect(false);
+}
+
+
+void Symbols::EndSharing() {
+  if (promoting_isolate != Isolate::Current()) {
+    return;
+  }
+  Dart::vm_isolate()->heap()->WriteProtect(true);
+  SharedSnapshot* shared = new SharedSnapshot();
+  shared->snapshot = promoted_snapshot;
+  shared->next = shared_snapshots;
+  shared_snapshots = shared;
+  // Isolates may still be looking up the previous table, which is therefore
+  // never freed.
+  shared_table = promoted_table;
+  promoted_table = NULL;
+  promoted_snapshot = NULL;
+  promoting_isolate = NULL;
+  shared_mutex->Unlock();
+}
+
+
+RawString* Symbols::LookupShared(const uint8_t* characters,
+                                 intptr_t len,
+                                 intptr_t hash) {
+  const SharedSymbolTable* table = shared_table;
+  if (table == NULL) {
+    return String::null();
+  }
+  return table->symbols[FindSharedIndex(table, characters, len, hash)];
+}
+
+
+RawString* Symbols::LookupOrAddShared(const uint8_t* characters,
+                                      intptr_t len,
+                                      intptr_t hash) {
+  if (promoting_isolate != Isolate::Current()) {
+    return LookupShared(characters, len, hash);
+  }
+  intptr_t index = FindSharedIndex(promoted_table, characters, len, hash);
+  RawString* symbol = promoted_table->symbols[index];
+  if (symbol == NULL) {
+    symbol = AllocateShared(characters, len, hash);
+    if (symbol == String::null()) {
+      return String::null();
+    }
+    promoted_table->symbols[index] = symbol;
+    promoted_table->used++;
+    // Grow the table if it is half full.
+    if (promoted_table->used > (promoted_table->capacity / 2)) {
+      SharedSymbolTable* grown =
+          NewSharedTable(promoted_table->capacity * 2);
+      CopySharedTable(promoted_table, grown);
+      free(promoted_table);
+      promoted_table = grown;
+    }
+  }
+  return symbol;
+}
+
+
+bool Symbols::IsSharedSymbol(RawObject* obj) {
+  if ((shared_table == NULL) || (obj->GetClassId() != kOneByteStringCid)) {
+    return false;
+  }
+  RawOneByteString* str = reinterpret_cast<RawOneByteString*>(obj);
+  return LookupShared(str->ptr()->data_,
+                      Smi::Value(str->ptr()->length_),
+                      Smi::Value(str->ptr()->hash_)) == obj;
+}
+
+
+intptr_t Symbols::NumSharedSymbols() {
+  const SharedSymbolTable* table = shared_table;
+  return (table == NULL) ? 0 : table->used;
+}
+
+
+SharedSymbolsScope::SharedSymbolsScope(const uint8_t* snapshot)
+    : is_sharing_(FLAG_share_snapshot_symbols) {
+  if (is_sharing_) {
+    Symbols::BeginSharing(snapshot);
+  }
+}
+
+
+SharedSymbolsScope::~SharedSymbolsScope() {
+  if (is_sharing_) {
+    Symbols::EndSharing();
+  }
+}
+
 }  // namespace dart
@@ -13,6 +13,7 @@ namespace dart {
 // Forward declarations.
 class Isolate;
 class ObjectPointerVisitor;
+struct SharedSymbolTable;
 
 #define PREDEFINED_SYMBOLS_LIST(V)                                             \
   V(Empty, "")                                                                 \
@@ -449,6 +450,10 @@ PREDEFINED_SYMBOLS_LIST(DEFINE_SYMBOL_HANDLE_ACCESSOR)
 
   static void DumpStats();
 
+  // Returns the number of symbols of full snapshots shared by the isolates
+  // created from them, see SharedSymbolsScope.
+  static intptr_t NumSharedSymbols();
+
  private:
   enum {
     kInitialVMIsolateSymtabSize = 512,
@@ -491,6 +496,35 @@ PREDEFINED_SYMBOLS_LIST(DEFINE_SYMBOL_HANDLE_ACCESSOR)
             object_id < (kMaxPredefinedObjectIds + kMaxPredefinedId));
   }
 
+  // Shared symbols are one byte symbols of full snapshots allocated in the
+  // VM isolate heap, where they are premarked and write protected like the
+  // predefined symbols.
+  // Starts reading a full snapshot into the current isolate. Unless it was
+  // read before, the isolate promotes its one byte symbols until
+  // EndSharing() while other isolates wait to read the same snapshot.
+  static void BeginSharing(const uint8_t* snapshot);
+  static void EndSharing();
+
+  // Returns the shared symbol with these characters, allocating it if the
+  // current isolate is promoting the symbols of its snapshot, or null.
+  static RawString* LookupShared(const uint8_t* characters,
+                                 intptr_t len,
+                                 intptr_t hash);
+  static RawString* LookupOrAddShared(const uint8_t* characters,
+                                      intptr_t len,
+                                      intptr_t hash);
+  static bool IsSharedSymbol(RawObject* obj);
+
+  static intptr_t FindSharedIndex(const SharedSymbolTable* table,
+                                  const uint8_t* characters,
+                                  intptr_t len,
+                                  intptr_t hash);
+  static void CopySharedTable(const SharedSymbolTable* from,
+                              SharedSymbolTable* to);
+  static RawString* AllocateShared(const uint8_t* characters,
+                                   intptr_t len,
+                                   intptr_t hash);
+
   // List of Latin1 characters stored in the vm isolate as symbols
   // in order to make Symbols::FromCharCode fast. This structure is
   // used in generated dart code for direct access to these objects.
@@ -505,6 +539,8 @@ PREDEFINED_SYMBOLS_LIST(DEFINE_SYMBOL_HANDLE_ACCESSOR)
   static intptr_t collision_count_[kMaxCollisionBuckets];
 
   friend class String;
+  friend class OneByteString;
+  friend class SharedSymbolsScope;
   friend class SnapshotReader;
   friend class SnapshotWriter;
   friend class ApiMessageReader;
@@ -512,6 +548,22 @@ PREDEFINED_SYMBOLS_LIST(DEFINE_SYMBOL_HANDLE_ACCESSOR)
   DISALLOW_COPY_AND_ASSIGN(Symbols);
 };
 
+
+// Shares the one byte symbols of the full snapshot read in this scope with
+// the other isolates created from it if --share_snapshot_symbols is set.
+// All these isolates refer to the same strings in the VM isolate heap, which
+// are never collected, instead of allocating their own copies.
+class SharedSymbolsScope : public ValueObject {
+ public:
+  explicit SharedSymbolsScope(const uint8_t* snapshot);
+  ~SharedSymbolsScope();
+
+ private:
+  bool is_sharing_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedSymbolsScope);
+};
+
 }  // namespace dart
 
 #endif  // VM_SYMBOLS_H_
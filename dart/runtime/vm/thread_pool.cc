@@ -8,7 +8,12 @@ namespace dart {
 
 DEFINE_FLAG(int, worker_timeout_millis, 5000,
             "Free workers when they have been idle for this amount of time.");
+DEFINE_FLAG(int, worker_max_count, 0,
+            "Maximum number of workers of a thread pool, 0 for no limit. Tasks "
+            "wait in queues while that many workers are busy. Helper tasks of "
+            "the garbage collector and of isolate creation are not limited.");
 
+ThreadLocalKey ThreadPool::worker_key_ = Thread::kUnsetThreadLocalKey;
 Monitor* ThreadPool::exit_monitor_ = NULL;
 int* ThreadPool::exit_count_ = NULL;
 
@@ -16,10 +21,14 @@ ThreadPool::ThreadPool()
   : shutting_down_(false),
     all_workers_(NULL),
     idle_workers_(NULL),
+    injected_tasks_(),
     count_started_(0),
     count_stopped_(0),
     count_running_(0),
-    count_idle_(0) {
+    count_idle_(0),
+    count_queued_(0),
+    max_queued_(0),
+    count_stolen_(0) {
 }
 
 
@@ -28,7 +37,66 @@ ThreadPool::~ThreadPool() {
 }
 
 
+void ThreadPool::InitOnce() {
+  ASSERT(worker_key_ == Thread::kUnsetThreadLocalKey);
+  worker_key_ = Thread::CreateThreadLocal();
+  ASSERT(worker_key_ != Thread::kUnsetThreadLocalKey);
+}
+
+
+void ThreadPool::TaskQueue::PushBack(Task* task) {
+  task->next_ = NULL;
+  task->prev_ = tail_;
+  if (tail_ == NULL) {
+    head_ = task;
+  } else {
+    tail_->next_ = task;
+  }
+  tail_ = task;
+}
+
+
+ThreadPool::Task* ThreadPool::TaskQueue::PopFront() {
+  Task* task = head_;
+  if (task != NULL) {
+    head_ = task->next_;
+    if (head_ == NULL) {
+      tail_ = NULL;
+    } else {
+      head_->prev_ = NULL;
+    }
+    task->next_ = NULL;
+  }
+  return task;
+}
+
+
+ThreadPool::Task* ThreadPool::TaskQueue::PopBack() {
+  Task* task = tail_;
+  if (task != NULL) {
+    tail_ = task->prev_;
+    if (tail_ == NULL) {
+      head_ = NULL;
+    } else {
+      tail_->next_ = NULL;
+    }
+    task->prev_ = NULL;
+  }
+  return task;
+}
+
+
 void ThreadPool::Run(Task* task) {
+  RunTask(task, true);
+}
+
+
+void ThreadPool::RunHelper(Task* task) {
+  RunTask(task, false);
+}
+
+
+void ThreadPool::RunTask(Task* task, bool can_queue) {
   Worker* worker = NULL;
   bool new_worker = false;
   {
@@ -38,6 +106,29 @@ void ThreadPool::Run(Task* task) {
     if (shutting_down_) {
       return;
     }
+    uint64_t live_workers = count_started_ - count_stopped_;
+    if (can_queue &&
+        (idle_workers_ == NULL) &&
+        (FLAG_worker_max_count > 0) &&
+        (live_workers >= static_cast<uint64_t>(FLAG_worker_max_count))) {
+      // All workers are busy. A task spawned by a task of this pool is
+      // most likely to be picked up by the same worker.
+      Worker* current = NULL;
+      if (worker_key_ != Thread::kUnsetThreadLocalKey) {
+        current =
+            reinterpret_cast<Worker*>(Thread::GetThreadLocal(worker_key_));
+      }
+      if ((current != NULL) && current->owned_ && (current->pool_ == this)) {
+        current->tasks_.PushBack(task);
+      } else {
+        injected_tasks_.PushBack(task);
+      }
+      count_queued_++;
+      if (count_queued_ > max_queued_) {
+        max_queued_ = count_queued_;
+      }
+      return;
+    }
     if (idle_workers_ == NULL) {
       worker = new Worker(this);
       ASSERT(worker != NULL);
@@ -75,15 +166,18 @@ void ThreadPool::Shutdown() {
     saved = all_workers_;
     all_workers_ = NULL;
     idle_workers_ = NULL;
+    DeleteQueuedTasks(&injected_tasks_);
 
     Worker* current = saved;
     while (current != NULL) {
       Worker* next = current->all_next_;
       current->idle_next_ = NULL;
       current->owned_ = false;
+      DeleteQueuedTasks(&current->tasks_);
       current = next;
       count_stopped_++;
     }
+    ASSERT(count_queued_ == 0);
 
     count_idle_ = 0;
     count_running_ = 0;
@@ -171,16 +265,56 @@ bool ThreadPool::RemoveWorkerFromAllList(Worker* worker) {
 }
 
 
-void ThreadPool::SetIdle(Worker* worker) {
+void ThreadPool::DeleteQueuedTasks(TaskQueue* queue) {
+  Task* task = queue->PopFront();
+  while (task != NULL) {
+    delete task;
+    count_queued_--;
+    task = queue->PopFront();
+  }
+}
+
+
+ThreadPool::Task* ThreadPool::StealTask(Worker* thief) {
+  for (Worker* victim = all_workers_;
+       victim != NULL;
+       victim = victim->all_next_) {
+    if (victim != thief) {
+      Task* task = victim->tasks_.PopFront();
+      if (task != NULL) {
+        count_stolen_++;
+        return task;
+      }
+    }
+  }
+  return NULL;
+}
+
+
+ThreadPool::Task* ThreadPool::NextTaskOrSetIdle(Worker* worker) {
   MutexLocker ml(&mutex_);
   if (shutting_down_) {
-    return;
+    return NULL;
   }
   ASSERT(worker->owned_ && !IsIdle(worker));
+  // The newest task of the worker's own queue is the most likely to find
+  // its data in the caches, the oldest tasks are the ones to steal.
+  Task* task = worker->tasks_.PopBack();
+  if (task == NULL) {
+    task = injected_tasks_.PopFront();
+  }
+  if (task == NULL) {
+    task = StealTask(worker);
+  }
+  if (task != NULL) {
+    count_queued_--;
+    return task;
+  }
   worker->idle_next_ = idle_workers_;
   idle_workers_ = worker;
   count_idle_++;
   count_running_--;
+  return NULL;
 }
 
 
@@ -203,7 +337,7 @@ bool ThreadPool::ReleaseIdleWorker(Worker* worker) {
 }
 
 
-ThreadPool::Task::Task() {
+ThreadPool::Task::Task() : next_(NULL), prev_(NULL) {
 }
 
 
@@ -280,7 +414,10 @@ void ThreadPool::Worker::Loop() {
       return;
     }
     ASSERT(pool_ != NULL);
-    pool_->SetIdle(this);
+    task_ = pool_->NextTaskOrSetIdle(this);
+    if (task_ != NULL) {
+      continue;
+    }
     idle_start = OS::GetCurrentTimeMillis();
     while (true) {
       Monitor::WaitResult result = ml.Wait(ComputeTimeout(idle_start));
@@ -312,6 +449,9 @@ void ThreadPool::Worker::Shutdown() {
 // static
 void ThreadPool::Worker::Main(uword args) {
   Worker* worker = reinterpret_cast<Worker*>(args);
+  if (worker_key_ != Thread::kUnsetThreadLocalKey) {
+    Thread::SetThreadLocal(worker_key_, args);
+  }
   worker->Loop();
 
   // It should be okay to access these unlocked here in this assert.
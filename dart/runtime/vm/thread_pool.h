@@ -10,6 +10,9 @@
 namespace dart {
 
 class ThreadPool {
+ private:
+  class TaskQueue;
+
  public:
   // Subclasses of Task are able to run on a ThreadPool.
   class Task {
@@ -23,27 +26,69 @@ class ThreadPool {
     virtual void Run() = 0;
 
    private:
+    friend class TaskQueue;
+
+    // Links of the queue holding the task until a worker picks it up.
+    Task* next_;
+    Task* prev_;
+
     DISALLOW_COPY_AND_ASSIGN(Task);
   };
 
   ThreadPool();
 
   // Shuts down this thread pool.  Causes workers to terminate
-  // themselves when they are active again.
+  // themselves when they are active again.  Tasks still queued are
+  // deleted without being run.
   ~ThreadPool();
 
-  // Runs a task on the thread pool.
+  static void InitOnce();
+
+  // Runs a task on the thread pool.  The task is handed to an idle worker
+  // or to a new one.  Once --worker_max_count workers are busy, it is
+  // queued instead: on the queue of the calling worker if the caller is
+  // a task of this pool, otherwise on the injection queue of the pool.
+  // Workers take tasks from their own queue first, then from the
+  // injection queue, and finally steal the oldest task of another worker.
   void Run(Task* task);
 
+  // Runs a task which the caller waits for, such as a GC helper. It always
+  // gets a worker, even when --worker_max_count workers are busy: those
+  // could be waiting for the caller, which is waiting for the task.
+  void RunHelper(Task* task);
+
   // Some simple stats.
   uint64_t workers_running() const { return count_running_; }
   uint64_t workers_idle() const { return count_idle_; }
   uint64_t workers_started() const { return count_started_; }
   uint64_t workers_stopped() const { return count_stopped_; }
+  uint64_t tasks_queued() const { return count_queued_; }
+  uint64_t max_tasks_queued() const { return max_queued_; }
+  uint64_t tasks_stolen() const { return count_stolen_; }
 
  private:
   friend class ThreadPoolTestPeer;
 
+  // A double ended queue of tasks.  Protected by ThreadPool::mutex_.
+  class TaskQueue {
+   public:
+    TaskQueue() : head_(NULL), tail_(NULL) { }
+
+    bool IsEmpty() const { return head_ == NULL; }
+
+    void PushBack(Task* task);
+    Task* PopFront();
+    Task* PopBack();
+
+   private:
+    Task* head_;
+    Task* tail_;
+
+    DISALLOW_COPY_AND_ASSIGN(TaskQueue);
+  };
+
+  void RunTask(Task* task, bool can_queue);
+
   class Worker {
    public:
     explicit Worker(ThreadPool* pool);
@@ -79,6 +124,7 @@ class ThreadPool {
     bool owned_;         // Protected by ThreadPool::mutex_
     Worker* all_next_;   // Protected by ThreadPool::mutex_
     Worker* idle_next_;  // Protected by ThreadPool::mutex_
+    TaskQueue tasks_;    // Protected by ThreadPool::mutex_
 
     DISALLOW_COPY_AND_ASSIGN(Worker);
   };
@@ -91,18 +137,30 @@ class ThreadPool {
   bool RemoveWorkerFromIdleList(Worker* worker);
   bool RemoveWorkerFromAllList(Worker* worker);
 
+  // Returns the next queued task for the worker, or NULL after adding the
+  // worker to the idle list.
+  Task* NextTaskOrSetIdle(Worker* worker);
+  Task* StealTask(Worker* thief);
+  void DeleteQueuedTasks(TaskQueue* queue);
+
   // Worker operations.
-  void SetIdle(Worker* worker);
   bool ReleaseIdleWorker(Worker* worker);
 
   Mutex mutex_;
   bool shutting_down_;
   Worker* all_workers_;
   Worker* idle_workers_;
+  TaskQueue injected_tasks_;
   uint64_t count_started_;
   uint64_t count_stopped_;
   uint64_t count_running_;
   uint64_t count_idle_;
+  uint64_t count_queued_;
+  uint64_t max_queued_;
+  uint64_t count_stolen_;
+
+  // The worker running on the current thread, if any.
+  static ThreadLocalKey worker_key_;
 
   static Monitor* exit_monitor_;  // Used only in testing.
   static int* exit_count_;        // Used only in testing.
@@ -9,6 +9,7 @@
 
 namespace dart {
 
+DECLARE_FLAG(int, worker_max_count);
 DECLARE_FLAG(int, worker_timeout_millis);
 
 
@@ -215,4 +216,128 @@ UNIT_TEST_CASE(ThreadPool_RecursiveSpawn) {
 }
 
 
+class BlockingTask : public ThreadPool::Task {
+ public:
+  BlockingTask(Monitor* sync, bool* started, bool* released)
+      : sync_(sync), started_(started), released_(released) {
+  }
+
+  void Run() {
+    MonitorLocker ml(sync_);
+    *started_ = true;
+    ml.NotifyAll();
+    while (!*released_) {
+      ml.Wait();
+    }
+  }
+
+ private:
+  Monitor* sync_;
+  bool* started_;
+  bool* released_;
+};
+
+
+UNIT_TEST_CASE(ThreadPool_MaxWorkers) {
+  int saved_max_count = FLAG_worker_max_count;
+  FLAG_worker_max_count = 1;
+  ThreadPool thread_pool;
+  Monitor sync;
+  bool started = false;
+  bool released = false;
+  thread_pool.Run(new BlockingTask(&sync, &started, &released));
+  {
+    MonitorLocker ml(&sync);
+    while (!started) {
+      ml.Wait();
+    }
+  }
+
+  // The only worker is busy, so the next tasks wait in the injection queue.
+  const int kTaskCount = 3;
+  Monitor task_sync[kTaskCount];
+  bool done[kTaskCount];
+  for (int i = 0; i < kTaskCount; i++) {
+    done[i] = false;
+    thread_pool.Run(new TestTask(&task_sync[i], &done[i]));
+  }
+  EXPECT_EQ(1U, thread_pool.workers_started());
+  EXPECT_EQ(3U, thread_pool.tasks_queued());
+
+  {
+    MonitorLocker ml(&sync);
+    released = true;
+    ml.NotifyAll();
+  }
+  for (int i = 0; i < kTaskCount; i++) {
+    MonitorLocker ml(&task_sync[i]);
+    while (!done[i]) {
+      ml.Wait();
+    }
+  }
+  EXPECT_EQ(1U, thread_pool.workers_started());
+  EXPECT_EQ(0U, thread_pool.tasks_queued());
+  EXPECT_EQ(3U, thread_pool.max_tasks_queued());
+  FLAG_worker_max_count = saved_max_count;
+}
+
+
+UNIT_TEST_CASE(ThreadPool_MaxWorkersHelper) {
+  int saved_max_count = FLAG_worker_max_count;
+  FLAG_worker_max_count = 1;
+  ThreadPool thread_pool;
+  Monitor sync;
+  bool started = false;
+  bool released = false;
+  thread_pool.Run(new BlockingTask(&sync, &started, &released));
+  {
+    MonitorLocker ml(&sync);
+    while (!started) {
+      ml.Wait();
+    }
+  }
+
+  // A helper task gets a worker of its own although the only worker allowed
+  // is busy.
+  Monitor helper_sync;
+  bool done = false;
+  thread_pool.RunHelper(new TestTask(&helper_sync, &done));
+  {
+    MonitorLocker ml(&helper_sync);
+    while (!done) {
+      ml.Wait();
+    }
+  }
+  EXPECT_EQ(2U, thread_pool.workers_started());
+  EXPECT_EQ(0U, thread_pool.max_tasks_queued());
+
+  {
+    MonitorLocker ml(&sync);
+    released = true;
+    ml.NotifyAll();
+  }
+  FLAG_worker_max_count = saved_max_count;
+}
+
+
+UNIT_TEST_CASE(ThreadPool_MaxWorkersRecursiveSpawn) {
+  int saved_max_count = FLAG_worker_max_count;
+  FLAG_worker_max_count = 2;
+  ThreadPool thread_pool;
+  Monitor sync;
+  const int kTotalTasks = 500;
+  int done = 0;
+  thread_pool.Run(
+      new SpawnTask(&thread_pool, &sync, kTotalTasks, kTotalTasks, &done));
+  {
+    MonitorLocker ml(&sync);
+    while (done < kTotalTasks) {
+      ml.Wait();
+    }
+  }
+  EXPECT_EQ(kTotalTasks, done);
+  EXPECT(thread_pool.workers_started() <= 2U);
+  FLAG_worker_max_count = saved_max_count;
+}
+
 }  // namespace dart
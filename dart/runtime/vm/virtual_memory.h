@@ -43,6 +43,10 @@ class VirtualMemory {
   // Changes the protection of the virtual memory area.
   bool Protect(Protection mode);
 
+  // Gives the physical memory backing the committed area back to the OS. The
+  // area stays accessible, but its contents are undefined afterwards.
+  bool Discard();
+
   // Reserves a virtual memory segment with size. If a segment of the requested
   // size cannot be allocated NULL is returned.
   static VirtualMemory* Reserve(intptr_t size);
@@ -76,6 +76,11 @@ bool VirtualMemory::Commit(uword addr, intptr_t size, bool executable) {
 }
 
 
+bool VirtualMemory::Discard() {
+  return (madvise(address(), size(), MADV_DONTNEED) == 0);
+}
+
+
 bool VirtualMemory::Protect(Protection mode) {
   int prot = 0;
   switch (mode) {
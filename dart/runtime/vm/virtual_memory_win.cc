@@ -63,6 +63,12 @@ bool VirtualMemory::Commit(uword addr, intptr_t size, bool executable) {
 }
 
 
+bool VirtualMemory::Discard() {
+  // The protection is ignored when resetting memory, but has to be valid.
+  return (VirtualAlloc(address(), size(), MEM_RESET, PAGE_NOACCESS) != NULL);
+}
+
+
 bool VirtualMemory::Protect(Protection mode) {
   DWORD prot = 0;
   switch (mode) {
@@ -69,6 +69,166 @@ test_or_1() {
   } finally { }
 }
 
+test_mul_1() {
+  try {  // Avoid optimizing this function.
+    f(a, b) {
+      return a * b;
+    }
+    var x = 0x100000000;
+    for (var i = 0; i < 20; i++) f(x, 3);
+    Expect.equals(0x300000000, f(x, 3));
+    Expect.equals(-0x100000000, f(x, -1));
+    Expect.equals(6, f(2, 3));
+    Expect.equals(0x10000000000000000, f(x, x));  // Triggers deoptimization.
+  } finally { }
+}
+
+test_mul_2() {
+  try {  // Avoid optimizing this function.
+    f(a, b) {
+      return a * b;
+    }
+    // Smi multiplications that overflow into mints.
+    var x = 0x80000000;
+    for (var i = 0; i < 20; i++) f(i, i);
+    Expect.equals(0x4000000000000000, f(x, x));
+    for (var i = 0; i < 20; i++) f(x, x);
+    Expect.equals(0x4000000000000000, f(x, x));
+    Expect.equals(-0x4000000000000000, f(x, -x));
+    // Triggers deoptimization.
+    Expect.equals(0x40000000000000000, f(x * 2, x * 8));
+  } finally { }
+}
+
+test_loop_1() {
+  try {  // Avoid optimizing this function.
+    f(n) {
+      var h = 0;
+      for (var i = 0; i < n; i++) {
+        h = (h * 31 + i) & 0xffffffffffff;
+      }
+      return h;
+    }
+    for (var i = 0; i < 20; i++) f(20);
+    var h = 0;
+    for (var i = 0; i < 100; i++) {
+      h = (h * 31 + i) & 0xffffffffffff;
+    }
+    Expect.equals(h, f(100));
+  } finally { }
+}
+
+// Operands and results beyond the 62-bit smi range of 64-bit platforms.
+test_bit_ops_3() {
+  try {  // Avoid optimizing this function.
+    and(a, b) => a & b;
+    or(a, b) => a | b;
+    xor(a, b) => a ^ b;
+    var x = 0x7fffffffffffffff;
+    var y = 0x4000000000000001;
+    for (var i = 0; i < 20; i++) {
+      and(x, y);
+      or(y, i);
+      xor(x, y);
+    }
+    Expect.equals(0x4000000000000001, and(x, y));
+    Expect.equals(0x4000000000000003, or(y, 2));
+    Expect.equals(0x3ffffffffffffffe, xor(x, y));
+    Expect.equals(-0x8000000000000000, and(-0x8000000000000000, -1));
+    Expect.equals(-1, or(-0x8000000000000000, x));
+    Expect.equals(-1, xor(-0x8000000000000000, x));
+    // Triggers deoptimization.
+    Expect.equals(0x8000000000000000, and(0xffffffffffffffff, 1 << 63));
+    Expect.equals(0x8000000000000001, or(1 << 63, 1));
+    Expect.equals(0xffffffffffffffff, xor(0x8000000000000000, x));
+  } finally { }
+}
+
+test_shift_3() {
+  try {  // Avoid optimizing this function.
+    shl(a, b) => a << b;
+    shr(a, b) => a >> b;
+    var x = 0x1000000000000000;
+    for (var i = 0; i < 20; i++) {
+      shl(x, 2);
+      shr(0x7000000000000000, 4);
+    }
+    Expect.equals(0x4000000000000000, shl(x, 2));
+    Expect.equals(-0x8000000000000000, shl(-x, 3));
+    Expect.equals(0x0700000000000000, shr(0x7000000000000000, 4));
+    Expect.equals(-1, shr(-0x8000000000000000, 63));
+    Expect.equals(0, shr(0x7fffffffffffffff, 63));
+    Expect.equals(0x8000000000000000, shl(x, 3));  // Triggers deoptimization.
+    Expect.equals(1, shr(0x8000000000000000, 63));  // Triggers deoptimization.
+  } finally { }
+}
+
+test_negate_3() {
+  try {  // Avoid optimizing this function.
+    neg(a) => -a;
+    not(a) => ~a;
+    var x = 0x4000000000000000;
+    for (var i = 0; i < 20; i++) {
+      neg(x);
+      not(x);
+    }
+    Expect.equals(-0x4000000000000000, neg(x));
+    Expect.equals(-0x4000000000000001, not(x));
+    Expect.equals(-0x7fffffffffffffff, neg(0x7fffffffffffffff));
+    Expect.equals(0x7fffffffffffffff, not(-0x8000000000000000));
+    // Triggers deoptimization.
+    Expect.equals(0x8000000000000000, neg(-0x8000000000000000));
+    Expect.equals(-0x8000000000000001, not(0x8000000000000000));
+  } finally { }
+}
+
+test_mul_3() {
+  try {  // Avoid optimizing this function.
+    f(a, b) {
+      return a * b;
+    }
+    var x = 0x4000000000000000;
+    for (var i = 0; i < 20; i++) f(x + 1, 1);
+    Expect.equals(0x4000000000000001, f(x + 1, 1));
+    Expect.equals(-0x4000000000000001, f(x + 1, -1));
+    Expect.equals(-0x8000000000000000, f(x, -2));
+    Expect.equals(0x8000000000000000, f(x, 2));  // imulq overflow deopt.
+    for (var i = 0; i < 20; i++) f(x + 1, 1);
+    Expect.equals(-0x8000000000000000, f(-x, 2));
+    Expect.equals(0x8000000000000000, f(-x, -2));  // imulq overflow deopt.
+  } finally { }
+}
+
+// The loop phis merge a smi or mint constant with the unboxed result of the
+// mint operation in the loop body.
+test_loop_2() {
+  try {  // Avoid optimizing this function.
+    f(n) {
+      var h = 0;
+      for (var i = 0; i < n; i++) {
+        h = h + 0x1000000000000000;
+      }
+      return h;
+    }
+    g(n, mask) {
+      var h = 0x4000000000000000;
+      for (var i = 0; i < n; i++) {
+        h = (h ^ (i * 0x10000000000)) | mask;
+      }
+      return h;
+    }
+    for (var i = 0; i < 20; i++) {
+      f(7);
+      g(20, 0x4000000000000000);
+    }
+    Expect.equals(0x7000000000000000, f(7));
+    Expect.equals(0x4000000000000000 | (1 << 40), g(2, 0x4000000000000000));
+    Expect.equals(0x8000000000000000, f(8));  // Overflow in the loop.
+    // Triggers deoptimization.
+    Expect.equals(0xc000000000000000 | (1 << 40), g(2, 0x8000000000000000));
+  } finally { }
+}
+
 test_func(x, y) => (x & y) + 1.0;
 
 test_mint_double_op() {
@@ -82,6 +242,14 @@ main() {
     test_and_2();
     test_xor_1();
     test_or_1();
+    test_mul_1();
+    test_mul_2();
+    test_bit_ops_3();
+    test_shift_3();
+    test_negate_3();
+    test_mul_3();
+    test_loop_1();
+    test_loop_2();
     test_mint_double_op();
   }
 }
@@ -139,6 +139,26 @@ testVMField() {
   Expect.equals(84, test_vm_field());
 }
 
+modifyFirst(list) {
+  // This function should not be inlinable.
+  try { list[0].x = 42; } catch (e) { }
+}
+
+test_stored_in_list() {
+  var a = new V();
+  var list = [null];
+  list[0] = a;
+  modifyFirst(list);
+  // The object escapes through the list: the call can modify its field.
+  return a.x;
+}
+
+testStoredInList() {
+  for (var i = 0; i < 100; i++) {
+    Expect.equals(42, test_stored_in_list());
+  }
+}
+
 main() {
   var c = new C(new Point(0.1, 0.2));
 
@@ -186,4 +206,5 @@ main() {
 
   testFinalField();
   testVMField();
+  testStoredInList();
 }
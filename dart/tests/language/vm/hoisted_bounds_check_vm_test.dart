@@ -0,0 +1,80 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+// Test bounds checks hoisted out of loops with an arbitrary limit.
+
+// VMOptions=--optimization-counter-threshold=10 --no-use-osr
+
+import "package:expect/expect.dart";
+
+sum(List list, int start, int n) {
+  var result = 0;
+  for (var i = start; i < n; i++) result += list[i];
+  return result;
+}
+
+copy(List to, List from, int n) {
+  for (var i = 0; n > i; i++) to[i] = from[i];
+}
+
+sumFromZero(List list, int n) {
+  var result = 0;
+  for (var i = 0; i < n; i++) result += list[i];
+  return result;
+}
+
+copyFromZero(List to, List from, int n) {
+  for (var i = 0; i < n; i++) to[i] = from[i];
+}
+
+// Only called with valid limits until optimized, then the hoisted checks
+// fail and deoptimize to the loop entry.
+testDeoptimization() {
+  var list = [1, 2, 3, 4];
+  var to = new List(4);
+  for (var i = 0; i < 20; i++) {
+    Expect.equals(10, sumFromZero(list, 4));
+    copyFromZero(to, list, 4);
+  }
+  Expect.equals(0, sumFromZero(list, -1));
+  Expect.equals(0, sumFromZero(list, -0x40000000));
+  Expect.throws(() => sumFromZero(list, 5), (e) => e is RangeError);
+  // The elements before the failing index are copied by the unoptimized loop.
+  var short = new List(2);
+  Expect.throws(() => copyFromZero(short, list, 4), (e) => e is RangeError);
+  Expect.listEquals([1, 2], short);
+  copyFromZero(to, list, -1);
+  Expect.listEquals(list, to);
+  for (var i = 0; i < 20; i++) {
+    Expect.equals(10, sumFromZero(list, 4));
+    Expect.equals(6, sumFromZero(list, 3));
+  }
+}
+
+test(int length) {
+  var list = new List.generate(length, (i) => i);
+  Expect.equals(length * (length - 1) ~/ 2, sum(list, 0, length));
+  Expect.equals(0, sum(list, 0, 0));
+  Expect.equals(0, sum(list, 0, -1));
+  Expect.equals(0, sum(list, length + 1, length));
+  var to = new List(length);
+  copy(to, list, length);
+  Expect.listEquals(list, to);
+}
+
+main() {
+  for (var i = 0; i < 20; i++) {
+    test(0);
+    test(1);
+    test(10);
+  }
+  var list = [1, 2, 3];
+  Expect.throws(() => sum(list, 0, 4), (e) => e is RangeError);
+  Expect.throws(() => copy(new List(2), list, 3), (e) => e is RangeError);
+  Expect.throws(() => copy(list, new List(2), 3), (e) => e is RangeError);
+  for (var i = 0; i < 20; i++) {
+    Expect.equals(6, sum(list, 0, 3));
+    Expect.equals(5, sum(list, 1, 3));
+  }
+  testDeoptimization();
+}
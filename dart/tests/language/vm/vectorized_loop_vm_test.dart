@@ -0,0 +1,116 @@
+// Copyright (c) 2014, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+// Test vectorization of loops applying element-wise operations to typed data.
+
+// VMOptions=--optimization-counter-threshold=10 --no-use-osr
+
+import "package:expect/expect.dart";
+import "dart:typed_data";
+
+addFloat32(Float32List c, Float32List a, Float32List b, int n) {
+  for (var i = 0; i < n; i++) c[i] = a[i] + b[i];
+}
+
+divFloat32(Float32List c, Float32List a, Float32List b, int start, int n) {
+  for (var i = start; i < n; i++) c[i] = a[i] / b[i];
+}
+
+subInt32(Int32List c, Int32List a, Int32List b, int n) {
+  for (var i = 0; i < n; i++) c[i] = a[i] - b[i];
+}
+
+xorUint32(Uint32List c, Uint32List a, Uint32List b, int n) {
+  for (var i = 0; i < n; i++) c[i] = a[i] ^ b[i];
+}
+
+copyInt32(Int32List c, Int32List a, int n) {
+  for (var i = 0; n > i; i++) c[i] = a[i];
+}
+
+squareFloat32(Float32List a, int n) {
+  for (var i = 0; i < n; i++) a[i] = a[i] * a[i];
+}
+
+double float32(double value) => new Float32List.fromList([value])[0];
+
+Float32List float32s(int length, double offset) {
+  var list = new Float32List(length);
+  for (var i = 0; i < length; i++) list[i] = i * 1.1 + offset;
+  return list;
+}
+
+Int32List int32s(int length, int offset) {
+  var list = new Int32List(length);
+  for (var i = 0; i < length; i++) list[i] = (i - 8) * 0x10001 + offset;
+  return list;
+}
+
+Uint32List uint32s(int length, int offset) {
+  var list = new Uint32List(length);
+  for (var i = 0; i < length; i++) list[i] = i * 0x10001000 + offset;
+  return list;
+}
+
+testFloat32(int length) {
+  var a = float32s(length, 0.3);
+  var b = float32s(length, 7.0);
+  var c = new Float32List(length + 1);
+  addFloat32(c, a, b, length);
+  for (var i = 0; i < length; i++) {
+    Expect.equals(float32(a[i] + b[i]), c[i]);
+  }
+  Expect.equals(0.0, c[length]);
+
+  c = new Float32List(length);
+  divFloat32(c, a, b, 3, length);
+  for (var i = 0; i < length; i++) {
+    var expected = (i < 3) ? 0.0 : float32(a[i] / b[i]);
+    Expect.equals(expected, c[i]);
+  }
+
+  var squares = float32s(length, 0.5);
+  squareFloat32(squares, length);
+  var values = float32s(length, 0.5);
+  for (var i = 0; i < length; i++) {
+    Expect.equals(float32(values[i] * values[i]), squares[i]);
+  }
+}
+
+testInt32(int length) {
+  var a = int32s(length, 3);
+  var b = int32s(length, -0x7fffffff);
+  var c = new Int32List(length);
+  subInt32(c, a, b, length);
+  for (var i = 0; i < length; i++) {
+    Expect.equals(new Int32List.fromList([a[i] - b[i]])[0], c[i]);
+  }
+  copyInt32(c, a, length);
+  for (var i = 0; i < length; i++) Expect.equals(a[i], c[i]);
+
+  var ua = uint32s(length, 5);
+  var ub = uint32s(length, 0xf0f0f0f0);
+  var uc = new Uint32List(length);
+  xorUint32(uc, ua, ub, length);
+  for (var i = 0; i < length; i++) Expect.equals(ua[i] ^ ub[i], uc[i]);
+}
+
+testOutOfBounds() {
+  var a = float32s(10, 1.0);
+  var b = float32s(10, 2.0);
+  var c = new Float32List(6);
+  Expect.throws(() => addFloat32(c, a, b, 10), (e) => e is RangeError);
+  for (var i = 0; i < 6; i++) Expect.equals(float32(a[i] + b[i]), c[i]);
+}
+
+main() {
+  for (var i = 0; i < 20; i++) {
+    for (var length = 0; length < 12; length++) {
+      testFloat32(length);
+      testInt32(length);
+    }
+    testFloat32(1001);
+    testInt32(1001);
+  }
+  testOutOfBounds();
+}